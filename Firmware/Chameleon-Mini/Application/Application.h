@@ -16,12 +16,13 @@
 #include "MifareUltralight.h"
 #include "MifareClassic.h"
 #include "Reader14443A.h"
-#include "Vicinity.h"
-#include "Sl2s2002.h"
-#include "TITagitstandard.h"
+#include "ISO15693Tag.h"
 #include "Sniff14443A.h"
+#include "Sniff15693.h"
 #include "EM4233.h"
-#include "NTAG215.h"
+#include "Slix2.h"
+#include "NTAG21x.h"
+#include "MifareDESFire.h"
 
 /* Function wrappers */
 INLINE void ApplicationInit(void) {
@@ -29,45 +30,45 @@ INLINE void ApplicationInit(void) {
 }
 
 INLINE void ApplicationTask(void) {
-    ActiveConfiguration.ApplicationTaskFunc();
+    APPLICATION_HOOK(Task)();
 }
 
 INLINE void ApplicationTick(void) {
-    ActiveConfiguration.ApplicationTickFunc();
+    APPLICATION_HOOK(Tick)();
 }
 
 INLINE uint16_t ApplicationProcess(uint8_t *ByteBuffer, uint16_t ByteCount) {
-    return ActiveConfiguration.ApplicationProcessFunc(ByteBuffer, ByteCount);
+    return APPLICATION_HOOK(Process)(ByteBuffer, ByteCount);
 }
 
 INLINE void ApplicationReset(void) {
-    ActiveConfiguration.ApplicationResetFunc();
+    APPLICATION_HOOK(Reset)();
     //LogEntry(LOG_INFO_RESET_APP, NULL, 0);
 }
 
 INLINE void ApplicationGetUid(ConfigurationUidType Uid) {
-    ActiveConfiguration.ApplicationGetUidFunc(Uid);
+    APPLICATION_HOOK(GetUid)(Uid);
 }
 
 INLINE void ApplicationSetUid(ConfigurationUidType Uid) {
-    ActiveConfiguration.ApplicationSetUidFunc(Uid);
+    APPLICATION_HOOK(SetUid)(Uid);
     LogEntry(LOG_INFO_UID_SET, Uid, ActiveConfiguration.UidSize);
 }
 
 INLINE void ApplicationGetSak(uint8_t * Sak) {
-	ActiveConfiguration.ApplicationGetSakFunc(Sak);
+	APPLICATION_HOOK(GetSak)(Sak);
 }
 
 INLINE void ApplicationSetSak(uint8_t Sak) {
-	ActiveConfiguration.ApplicationSetSakFunc(Sak);
+	APPLICATION_HOOK(SetSak)(Sak);
 }
 
 INLINE void ApplicationGetAtqa(uint16_t * Atqa) {
-	ActiveConfiguration.ApplicationGetAtqaFunc(Atqa);
+	APPLICATION_HOOK(GetAtqa)(Atqa);
 }
 
 INLINE void ApplicationSetAtqa(uint16_t Atqa) {
-	ActiveConfiguration.ApplicationSetAtqaFunc(Atqa);
+	APPLICATION_HOOK(SetAtqa)(Atqa);
 }
 
 #endif /* APPLICATION_H_ */
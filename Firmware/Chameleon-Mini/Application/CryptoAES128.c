@@ -0,0 +1,91 @@
+/*
+ * CryptoAES128.c
+ *
+ *  AES-128 using the xmega's AES crypto engine, see CryptoAES128.h
+ */
+
+#include "CryptoAES128.h"
+#include <avr/io.h>
+#include <string.h>
+
+INLINE void LoadKey(const uint8_t *Key) {
+    for (uint8_t i = 0; i < CRYPTO_AES_KEY_SIZE; i++)
+        AES.KEY = Key[i];
+}
+
+/* Loads the state, runs the engine and reads the result back. The key has to be loaded before. */
+static void RunEngine(const uint8_t *Input, uint8_t *Output, uint8_t Mode) {
+    for (uint8_t i = 0; i < CRYPTO_AES_BLOCK_SIZE; i++)
+        AES.STATE = Input[i];
+
+    AES.CTRL = AES_START_bm | Mode;
+
+    while (!(AES.STATUS & (AES_SRIF_bm | AES_ERROR_bm)))
+        ;
+
+    /* Reading the state memory clears the flag */
+    for (uint8_t i = 0; i < CRYPTO_AES_BLOCK_SIZE; i++)
+        Output[i] = AES.STATE;
+}
+
+INLINE void XorBlock(uint8_t *Block, const uint8_t *Mask) {
+    for (uint8_t i = 0; i < CRYPTO_AES_BLOCK_SIZE; i++)
+        Block[i] ^= Mask[i];
+}
+
+void CryptoAESInitContext(CryptoAESContextType *Context, const uint8_t *Key) {
+    uint8_t Dummy[CRYPTO_AES_BLOCK_SIZE] = { 0 };
+
+    AES.CTRL = AES_RESET_bm;
+    memcpy(Context->EncryptKey, Key, CRYPTO_AES_KEY_SIZE);
+
+    /* Run the key expansion once, the key memory holds the last subkey afterwards */
+    LoadKey(Key);
+    RunEngine(Dummy, Dummy, 0);
+
+    for (uint8_t i = 0; i < CRYPTO_AES_KEY_SIZE; i++)
+        Context->DecryptKey[i] = AES.KEY;
+}
+
+void CryptoAESEncryptBlock(const CryptoAESContextType *Context, const void *Input, void *Output) {
+    LoadKey(Context->EncryptKey);
+    RunEngine(Input, Output, 0);
+}
+
+void CryptoAESDecryptBlock(const CryptoAESContextType *Context, const void *Input, void *Output) {
+    LoadKey(Context->DecryptKey);
+    RunEngine(Input, Output, AES_DECRYPT_bm);
+}
+
+void CryptoAESEncrypt_CBCSend(uint16_t Count, const void *Plaintext, void *Ciphertext, void *IV, const CryptoAESContextType *Context) {
+    const uint8_t *Input = Plaintext;
+    uint8_t *Output = Ciphertext;
+    uint8_t *Chain = IV;
+
+    while (Count--) {
+        XorBlock(Chain, Input);
+        CryptoAESEncryptBlock(Context, Chain, Chain);
+        memcpy(Output, Chain, CRYPTO_AES_BLOCK_SIZE);
+
+        Input += CRYPTO_AES_BLOCK_SIZE;
+        Output += CRYPTO_AES_BLOCK_SIZE;
+    }
+}
+
+void CryptoAESDecrypt_CBCReceive(uint16_t Count, const void *Ciphertext, void *Plaintext, void *IV, const CryptoAESContextType *Context) {
+    const uint8_t *Input = Ciphertext;
+    uint8_t *Output = Plaintext;
+    uint8_t *Chain = IV;
+    uint8_t Block[CRYPTO_AES_BLOCK_SIZE];
+
+    while (Count--) {
+        /* Input and Output may overlap, keep the ciphertext for chaining */
+        CryptoAESDecryptBlock(Context, Input, Block);
+        XorBlock(Block, Chain);
+        memcpy(Chain, Input, CRYPTO_AES_BLOCK_SIZE);
+        memcpy(Output, Block, CRYPTO_AES_BLOCK_SIZE);
+
+        Input += CRYPTO_AES_BLOCK_SIZE;
+        Output += CRYPTO_AES_BLOCK_SIZE;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * CryptoAES128.h
+ *
+ *  AES-128 using the xmega's AES crypto engine
+ */
+
+#ifndef CRYPTOAES128_H_
+#define CRYPTOAES128_H_
+
+#include <stdint.h>
+#include "../Common.h"
+
+/* Notes on the AES engine
+
+The engine en/deciphers one 16 byte block in 375 clock cycles, the CPU only
+loads the key and the state and reads back the result. After every run the
+key memory holds the last subkey of the key expansion, so the key has to be
+reloaded before each block. Deciphering starts from this last subkey, it is
+computed once per key by CryptoAESInitContext.
+
+CBC uses the same "send mode" and "receive mode" naming as CryptoTDEA.h. For
+AES, DESFire EV1 uses conventional CBC: the PICC enciphers in send mode and
+deciphers in receive mode.
+
+*/
+
+#define CRYPTO_AES_KEY_SIZE         16 /* Bytes */
+#define CRYPTO_AES_BLOCK_SIZE       16 /* Bytes */
+
+/* Clock cycles the engine takes for one block, without loading and reading back */
+#define CRYPTO_AES_ENGINE_CYCLES    375
+
+typedef struct {
+    uint8_t EncryptKey[CRYPTO_AES_KEY_SIZE];
+    uint8_t DecryptKey[CRYPTO_AES_KEY_SIZE]; /* Last subkey of EncryptKey */
+} CryptoAESContextType;
+
+/** Prepares a key for en- and deciphering
+ *
+ * \param Context       Context to initialize
+ * \param Key           Key (CRYPTO_AES_KEY_SIZE)
+ */
+void CryptoAESInitContext(CryptoAESContextType *Context, const uint8_t *Key);
+
+/** Performs the AES-128 en/deciphering in ECB mode (single block)
+ *
+ * \param Context       Key context
+ * \param Input         Source buffer
+ * \param Output        Destination buffer, may be the same as Input
+ */
+void CryptoAESEncryptBlock(const CryptoAESContextType *Context, const void *Input, void *Output);
+void CryptoAESDecryptBlock(const CryptoAESContextType *Context, const void *Input, void *Output);
+
+/** Performs the AES-128 enciphering in the CBC "send" mode (xor-then-crypt)
+ *
+ * \param Count         Block count, expected to be >= 1
+ * \param Plaintext     Source buffer with plaintext
+ * \param Ciphertext    Destination buffer to contain ciphertext, may be the same as Plaintext
+ * \param IV            Initialization vector buffer, will be updated
+ * \param Context       Key context
+ */
+void CryptoAESEncrypt_CBCSend(uint16_t Count, const void *Plaintext, void *Ciphertext, void *IV, const CryptoAESContextType *Context);
+
+/** Performs the AES-128 deciphering in the CBC "receive" mode (crypt-then-xor)
+ *
+ * \param Count         Block count, expected to be >= 1
+ * \param Ciphertext    Source buffer with ciphertext
+ * \param Plaintext     Destination buffer to contain plaintext, may be the same as Ciphertext
+ * \param IV            Initialization vector buffer, will be updated
+ * \param Context       Key context
+ */
+void CryptoAESDecrypt_CBCReceive(uint16_t Count, const void *Ciphertext, void *Plaintext, void *IV, const CryptoAESContextType *Context);
+
+#endif /* CRYPTOAES128_H_ */
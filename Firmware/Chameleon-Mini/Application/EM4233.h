@@ -27,6 +27,7 @@
 #define EM4233_MEM_LSM_ADDRESS          0xE0        // From 0xE0   to 0x0113 - Lock status masks
 #define EM4233_MEM_PSW_ADDRESS          0x0114      // From 0x0114 to 0x0117 - 32 bit Password
 #define EM4233_MEM_KEY_ADDRESS          0x0118      // From 0x0118 to 0x0123 - 96 bit Encryption Key
+#define EM4233_MEM_SIZE                 0x0124      // Everything above, the size of a slot
 
 #define EM4233_SYSINFO_BYTE             0x0F        // == DSFID - AFI - VICC mem size - IC ref are present
 
@@ -67,13 +68,8 @@
  */
 #define EM4233_LOGIN_YES_CARD
 
-void EM4233AppInit(void);
-void EM4233AppReset(void);
-void EM4233AppTask(void);
-void EM4233AppTick(void);
-uint16_t EM4233AppProcess(uint8_t *FrameBuf, uint16_t FrameBytes);
-void EM4233GetUid(ConfigurationUidType Uid);
-void EM4233SetUid(ConfigurationUidType Uid);
-void EM4233FlipUid(ConfigurationUidType Uid);
+/* Hooks for the ISO15693 tag engine */
+void EM4233Reset(void);
+uint16_t EM4233CustomCommand(uint8_t *FrameBuf, uint16_t FrameBytes);
 
 #endif /* EM4233_H_ */
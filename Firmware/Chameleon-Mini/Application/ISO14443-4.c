@@ -0,0 +1,309 @@
+/*
+ * ISO14443-4.c
+ *
+ *  ISO14443-4 block transmission protocol for emulated cards, see ISO14443-4.h
+ */
+
+#include "ISO14443-4.h"
+#include <string.h>
+
+#define CMD_PPS                     0xD0
+#define CMD_PPS_MASK                0xF0
+#define PPS0_PPS1_PRESENT           0x10
+#define PPS1_DSI_SHIFT              2
+#define PPS1_D_MASK                 0x03
+
+#define PCB_BLOCK_MASK              0xC0
+#define PCB_I_BLOCK                 0x00
+#define PCB_R_BLOCK                 0x80
+#define PCB_S_BLOCK                 0xC0
+#define PCB_BLOCK_NUMBER            0x01
+#define PCB_NAD_FOLLOWING           0x04
+#define PCB_CID_FOLLOWING           0x08
+#define PCB_CHAINING                0x10
+#define PCB_R_NAK                   0x10
+#define PCB_S_TYPE_MASK             0x30
+#define PCB_S_DESELECT              0x00
+#define PCB_S_WTX                   0x30
+#define PCB_I_BLOCK_VALUE           0x02
+#define PCB_R_BLOCK_VALUE           0xA2
+#define PCB_S_BLOCK_VALUE           0xC2
+#define CID_MASK                    0x0F
+
+#define ATS_HEADER_SIZE             5 /* TL, T0, TA, TB, TC */
+#define ATS_T0_INTERFACE_BYTES      0x70 /* TA, TB and TC follow */
+#define ATS_FSCI                    7 /* 128 bytes, ISO14443_4_MAX_RX_FRAME_SIZE */
+#define ATS_TA_SAME_D               0x80
+#define ATS_TA_DS_BIT(Dsi)          (0x08 << (Dsi)) /* DS 2, 4, 8 (card to reader) */
+#define ATS_TA_DR_BIT(Dri)          (0x01 << ((Dri) - 1)) /* DR 2, 4, 8 (reader to card) */
+#define ATS_TA_DS_SUPPORTED         (((1 << ISO14443A_MAX_DSI) - 1) << 4)
+#define ATS_TA_DR_SUPPORTED         ((1 << ISO14443A_MAX_DRI) - 1)
+#define ATS_TA_VALUE                (ATS_TA_DS_SUPPORTED | ATS_TA_DR_SUPPORTED) /* As fast as the codec gets */
+#define ATS_TC_CID_SUPPORTED        0x02
+
+/* Frame sizes for FSDI 0..7, larger FSDI are limited by the codec buffer */
+static const uint8_t PROGMEM FrameSizeTable[] = { 16, 24, 32, 40, 48, 64, 96, 128 };
+
+static ISO14443_4ConfigType Config;
+
+static uint8_t Cid;
+static uint16_t Fsd;
+static uint8_t BlockNumber;
+static bool CidFollowing;
+static bool PpsAllowed;
+static bool Deselected;
+static bool Chaining; /* Receiving a chained APDU */
+static uint8_t Wtxm;
+
+/* Holds the APDU while it is received, then the response while it is sent */
+static uint8_t ApduBuffer[ISO14443_4_APDU_BUFFER_SIZE];
+static uint16_t ApduSize;
+static uint16_t ResponseOffset; /* Data sent in the last I-block */
+static uint16_t ResponseChunk;
+
+/* Kept for retransmission */
+static enum {
+    LAST_NONE,
+    LAST_I_BLOCK,
+    LAST_R_ACK,
+    LAST_S_WTX
+} LastBlock;
+
+static uint8_t BlockHeader(uint8_t *Buffer, uint8_t Pcb) {
+    Buffer[0] = Pcb;
+
+    if (CidFollowing) {
+        Buffer[0] |= PCB_CID_FOLLOWING;
+        Buffer[1] = Cid;
+        return 2;
+    }
+
+    return 1;
+}
+
+static uint16_t SendLastBlock(uint8_t *Buffer) {
+    uint8_t HeaderSize;
+
+    switch (LastBlock) {
+        case LAST_I_BLOCK:
+            HeaderSize = BlockHeader(Buffer, PCB_I_BLOCK_VALUE | BlockNumber);
+            ResponseChunk = ApduSize - ResponseOffset;
+
+            if (ResponseChunk > Fsd - HeaderSize - ISO14443A_CRCA_SIZE) {
+                ResponseChunk = Fsd - HeaderSize - ISO14443A_CRCA_SIZE;
+                Buffer[0] |= PCB_CHAINING;
+            }
+
+            memcpy(&Buffer[HeaderSize], &ApduBuffer[ResponseOffset], ResponseChunk);
+            return HeaderSize + ResponseChunk;
+
+        case LAST_R_ACK:
+            return BlockHeader(Buffer, PCB_R_BLOCK_VALUE | BlockNumber);
+
+        case LAST_S_WTX:
+            HeaderSize = BlockHeader(Buffer, PCB_S_BLOCK_VALUE | PCB_S_WTX);
+            Buffer[HeaderSize] = Wtxm;
+            return HeaderSize + 1;
+
+        default:
+            return 0;
+    }
+}
+
+static uint16_t ProcessApdu(uint8_t *Buffer) {
+    ApduSize = Config.ApduFunc(ApduBuffer, ApduSize);
+    ResponseOffset = 0;
+    LastBlock = LAST_I_BLOCK;
+
+    return SendLastBlock(Buffer);
+}
+
+static bool BitRateSupported(uint8_t Dsi, uint8_t Dri) {
+    if ((ATS_TA_VALUE & ATS_TA_SAME_D) && (Dsi != Dri))
+        return false;
+    if ((Dsi != 0) && !(ATS_TA_VALUE & ATS_TA_DS_BIT(Dsi)))
+        return false;
+    if ((Dri != 0) && !(ATS_TA_VALUE & ATS_TA_DR_BIT(Dri)))
+        return false;
+
+    return true;
+}
+
+static uint16_t ProcessPps(uint8_t *Buffer, uint16_t ByteCount) {
+    if ((Buffer[0] & CID_MASK) != Cid)
+        return 0;
+
+    if ((ByteCount >= 3) && (Buffer[1] & PPS0_PPS1_PRESENT)) {
+        uint8_t Dsi = (Buffer[2] >> PPS1_DSI_SHIFT) & PPS1_D_MASK;
+        uint8_t Dri = Buffer[2] & PPS1_D_MASK;
+
+        /* Not answering keeps the reader at 106 kbit/s */
+        if (!BitRateSupported(Dsi, Dri))
+            return 0;
+
+        /* PPSS still goes out at 106 kbit/s */
+        ISO14443ACodecSetBitRate(Dsi, Dri);
+    }
+
+    PpsAllowed = false;
+
+    /* Acknowledged with PPSS */
+    return 1;
+}
+
+static uint16_t ProcessIBlock(uint8_t *Buffer, uint16_t ByteCount, uint8_t HeaderSize) {
+    uint8_t Pcb = Buffer[0];
+    uint16_t DataSize;
+
+    if (Pcb & PCB_NAD_FOLLOWING)
+        HeaderSize++;
+
+    if (ByteCount < HeaderSize)
+        return 0;
+
+    /* Every I-block toggles the block number to the one received */
+    BlockNumber = Pcb & PCB_BLOCK_NUMBER;
+    DataSize = ByteCount - HeaderSize;
+
+    if (!Chaining)
+        ApduSize = 0;
+
+    if (DataSize > sizeof(ApduBuffer) - ApduSize) {
+        /* Too long, let the reader time out */
+        Chaining = false;
+        LastBlock = LAST_NONE;
+        return 0;
+    }
+
+    memcpy(&ApduBuffer[ApduSize], &Buffer[HeaderSize], DataSize);
+    ApduSize += DataSize;
+
+    if (Pcb & PCB_CHAINING) {
+        Chaining = true;
+        LastBlock = LAST_R_ACK;
+        return SendLastBlock(Buffer);
+    }
+
+    Chaining = false;
+
+    if ((Config.WaitingTimeFunc != NULL) && ((Wtxm = Config.WaitingTimeFunc(ApduBuffer, ApduSize)) != 0)) {
+        /* The APDU is processed when the reader confirms the extension */
+        Wtxm = MIN(Wtxm, ISO14443_4_WTXM_MAX);
+        LastBlock = LAST_S_WTX;
+        return SendLastBlock(Buffer);
+    }
+
+    return ProcessApdu(Buffer);
+}
+
+static uint16_t ProcessRBlock(uint8_t *Buffer) {
+    uint8_t Pcb = Buffer[0];
+
+    if ((Pcb & PCB_BLOCK_NUMBER) == BlockNumber) {
+        /* Our last block got lost */
+        return SendLastBlock(Buffer);
+    } else if (Pcb & PCB_R_NAK) {
+        return BlockHeader(Buffer, PCB_R_BLOCK_VALUE | BlockNumber);
+    } else if ((LastBlock == LAST_I_BLOCK) && (ResponseOffset + ResponseChunk < ApduSize)) {
+        /* Acknowledged, continue the response chain */
+        BlockNumber ^= PCB_BLOCK_NUMBER;
+        ResponseOffset += ResponseChunk;
+        return SendLastBlock(Buffer);
+    }
+
+    return 0;
+}
+
+static uint16_t ProcessSBlock(uint8_t *Buffer) {
+    switch (Buffer[0] & PCB_S_TYPE_MASK) {
+        case PCB_S_DESELECT:
+            Deselected = true;
+            ISO14443ACodecSetBitRate(0, 0);
+            return BlockHeader(Buffer, PCB_S_BLOCK_VALUE | PCB_S_DESELECT);
+
+        case PCB_S_WTX:
+            if (LastBlock == LAST_S_WTX)
+                return ProcessApdu(Buffer);
+            return 0;
+
+        default:
+            return 0;
+    }
+}
+
+void ISO14443_4Init(const ISO14443_4ConfigType *ConfigP) {
+    memcpy_P(&Config, ConfigP, sizeof(Config));
+    Deselected = false;
+}
+
+void ISO14443_4Reset(void) {
+    Deselected = false;
+    ISO14443ACodecSetBitRate(0, 0);
+}
+
+uint16_t ISO14443_4Activate(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t Fsdi = Buffer[1] >> 4;
+
+    if (ByteCount < 2)
+        return 0;
+
+    Cid = Buffer[1] & CID_MASK;
+    Fsd = (Fsdi < sizeof(FrameSizeTable)) ? pgm_read_byte(&FrameSizeTable[Fsdi]) : ISO14443_4_MAX_TX_FRAME_SIZE;
+    BlockNumber = PCB_BLOCK_NUMBER;
+    CidFollowing = false;
+    PpsAllowed = true;
+    Deselected = false;
+    Chaining = false;
+    ApduSize = 0;
+    LastBlock = LAST_NONE;
+
+    Buffer[0] = ATS_HEADER_SIZE + Config.HistoricalSize;
+    Buffer[1] = ATS_T0_INTERFACE_BYTES | ATS_FSCI;
+    Buffer[2] = ATS_TA_VALUE;
+    Buffer[3] = (Config.Fwi << 4) | Config.Sfgi;
+    Buffer[4] = ATS_TC_CID_SUPPORTED;
+    memcpy(&Buffer[ATS_HEADER_SIZE], Config.Historical, Config.HistoricalSize);
+
+    return Buffer[0];
+}
+
+uint16_t ISO14443_4Process(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t Pcb = Buffer[0];
+    uint8_t HeaderSize = 1;
+
+    if (ByteCount == 0)
+        return 0;
+
+    /* PPS is only allowed right after the ATS */
+    if (PpsAllowed && ((Pcb & CMD_PPS_MASK) == CMD_PPS))
+        return ProcessPps(Buffer, ByteCount);
+
+    PpsAllowed = false;
+
+    if (Pcb & PCB_CID_FOLLOWING) {
+        if ((ByteCount < 2) || ((Buffer[1] & CID_MASK) != Cid))
+            return 0;
+
+        HeaderSize++;
+    } else if (Cid != 0) {
+        /* Addressed to a card without CID */
+        return 0;
+    }
+
+    CidFollowing = Pcb & PCB_CID_FOLLOWING;
+
+    switch (Pcb & PCB_BLOCK_MASK) {
+        case PCB_I_BLOCK:
+            return ProcessIBlock(Buffer, ByteCount, HeaderSize);
+        case PCB_R_BLOCK:
+            return ProcessRBlock(Buffer);
+        case PCB_S_BLOCK:
+            return ProcessSBlock(Buffer);
+        default:
+            return 0;
+    }
+}
+
+bool ISO14443_4IsDeselected(void) {
+    return Deselected;
+}
@@ -0,0 +1,57 @@
+/*
+ * ISO14443-4.h
+ *
+ *  ISO14443-4 block transmission protocol for emulated cards
+ *
+ *  The application keeps running the ISO14443-3A state machine. Once selected, it hands
+ *  RATS to ISO14443_4Activate and every following frame (CRC checked and removed) to
+ *  ISO14443_4Process. APDUs are passed to the application in one piece: the layer
+ *  collects chained blocks, splits long responses, numbers blocks, retransmits and
+ *  asks for waiting time extensions.
+ */
+
+#ifndef ISO14443_4_H_
+#define ISO14443_4_H_
+
+#include "../Common.h"
+#include "ISO14443-3A.h"
+#include "../Codec/ISO14443-2A.h"
+
+#define ISO14443_4_CMD_RATS             0xE0
+
+/* Received frames share the codec buffer with their parity bits */
+#define ISO14443_4_MAX_RX_FRAME_SIZE    ISO14443A_BUFFER_PARITY_OFFSET
+#define ISO14443_4_MAX_TX_FRAME_SIZE    CODEC_BUFFER_SIZE
+#define ISO14443_4_APDU_BUFFER_SIZE     CODEC_BUFFER_SIZE
+
+#define ISO14443_4_MAX_HISTORICAL_SIZE  15
+#define ISO14443_4_WTXM_MAX             59
+
+typedef struct {
+    /* Processes a complete APDU in place, returns the size of the response. The response
+     * must fit into ISO14443_4_APDU_BUFFER_SIZE. */
+    uint16_t (*ApduFunc)(uint8_t *Buffer, uint16_t ByteCount);
+    /* Optional. Returns the waiting time extension multiplier an APDU needs, 0 if it completes within FWT */
+    uint8_t (*WaitingTimeFunc)(const uint8_t *Buffer, uint16_t ByteCount);
+    uint8_t Fwi; /* Frame waiting time integer */
+    uint8_t Sfgi; /* Start-up frame guard time integer */
+    uint8_t HistoricalSize;
+    uint8_t Historical[ISO14443_4_MAX_HISTORICAL_SIZE];
+} ISO14443_4ConfigType;
+
+/* Config is expected in flash */
+void ISO14443_4Init(const ISO14443_4ConfigType *Config);
+
+/* Falls back to 106 kbit/s, call when the card leaves the field */
+void ISO14443_4Reset(void);
+
+/* Answers RATS with the ATS, returns its size */
+uint16_t ISO14443_4Activate(uint8_t *Buffer, uint16_t ByteCount);
+
+/* Processes PPS and blocks, returns the size of the response or 0 for no response */
+uint16_t ISO14443_4Process(uint8_t *Buffer, uint16_t ByteCount);
+
+/* True after S(DESELECT) has been answered, the card then goes to HALT */
+bool ISO14443_4IsDeselected(void);
+
+#endif /* ISO14443_4_H_ */
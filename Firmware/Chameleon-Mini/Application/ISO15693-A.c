@@ -1,6 +1,14 @@
 #include "ISO15693-A.h"
 #include "../Common.h"
+#include "../Memory.h"
+#include "../Codec/Codec.h"
 #include <util/crc16.h>
+#include <string.h>
+
+/* Response parameters after the flags byte, leaving room for the CRC */
+#define BLOCKS_BUFFER_SIZE  (CODEC_BUFFER_SIZE - ISO15693_RES_ADDR_PARAM - ISO15693_CRC16_SIZE)
+/* Lock status bytes fetched at once when spreading them over a separate table read */
+#define LOCK_CHUNK_SIZE     16
 
 CurrentFrame FrameInfo;
 uint8_t Uid[ISO15693_GENERIC_UID_SIZE];
@@ -158,3 +166,126 @@ bool ISO15693AntiColl(uint8_t *FrameBuf, uint16_t FrameBytes, CurrentFrame *Fram
 
     return true;
 }
+
+static uint16_t BlockAddress(const ISO15693BlockStoreType *Store, uint8_t Block) {
+    if (Store->LockLayout == ISO15693_LOCKS_INTERLEAVED) {
+        /* Skip the lock status byte in front of the data */
+        return Store->DataAddress + Block * (Store->BlockSize + 1) + 1;
+    } else {
+        return Store->DataAddress + Block * Store->BlockSize;
+    }
+}
+
+static uint16_t LimitBlockCount(const ISO15693BlockStoreType *Store, uint8_t FirstBlock, uint16_t BlockCount, uint8_t BytesPerBlock) {
+    /* Read up to the last block, as real tags do, and no further than the frame can take */
+    BlockCount = MIN(BlockCount, Store->BlockCount - FirstBlock);
+    return MIN(BlockCount, BLOCKS_BUFFER_SIZE / BytesPerBlock);
+}
+
+uint8_t ISO15693GetLockStatus(const ISO15693BlockStoreType *Store, uint8_t Block) {
+    uint8_t LockStatus = ISO15693_MASK_UNLOCKED;
+
+    if (Store->LockLayout == ISO15693_LOCKS_SEPARATE) {
+        MemoryReadBlock(&LockStatus, Store->LockAddress + Block, 1);
+    } else if (Store->LockLayout == ISO15693_LOCKS_INTERLEAVED) {
+        MemoryReadBlock(&LockStatus, BlockAddress(Store, Block) - 1, 1);
+    }
+
+    return LockStatus;
+}
+
+void ISO15693SetLockStatus(const ISO15693BlockStoreType *Store, uint8_t Block, uint8_t LockStatus) {
+    if (Store->LockLayout == ISO15693_LOCKS_SEPARATE) {
+        MemoryWriteBlock(&LockStatus, Store->LockAddress + Block, 1);
+    } else if (Store->LockLayout == ISO15693_LOCKS_INTERLEAVED) {
+        MemoryWriteBlock(&LockStatus, BlockAddress(Store, Block) - 1, 1);
+    }
+}
+
+void ISO15693ReadBlock(const ISO15693BlockStoreType *Store, uint8_t Block, void *Data) {
+    MemoryReadBlock(Data, BlockAddress(Store, Block), Store->BlockSize);
+}
+
+void ISO15693WriteBlock(const ISO15693BlockStoreType *Store, uint8_t Block, const void *Data) {
+    MemoryWriteBlock(Data, BlockAddress(Store, Block), Store->BlockSize);
+}
+
+/*
+ * ISO15693ReadBlocks
+ *
+ * Builds the response of READ MULTIPLE BLOCKS. With interleaved lock status the FRAM already
+ * holds the response with option flag, so it is a single read straight into the frame.
+ * Otherwise blocks and lock status are spread in place, without a temporary copy.
+ */
+uint16_t ISO15693ReadBlocks(const ISO15693BlockStoreType *Store, uint8_t *Buffer, uint8_t FirstBlock, uint16_t BlockCount, bool WithLockStatus) {
+    uint8_t BlockSize = Store->BlockSize;
+    uint8_t RecordSize = BlockSize + 1;
+    uint16_t i;
+
+    if (Store->LockLayout == ISO15693_LOCKS_INTERLEAVED) {
+        BlockCount = LimitBlockCount(Store, FirstBlock, BlockCount, RecordSize);
+        MemoryReadBlock(Buffer, BlockAddress(Store, FirstBlock) - 1, BlockCount * RecordSize);
+
+        if (WithLockStatus)
+            return BlockCount * RecordSize;
+
+        /* Drop the lock status bytes. Blocks only move towards the start of the buffer. */
+        for (i = 0; i < BlockCount; i++)
+            memmove(&Buffer[i * BlockSize], &Buffer[i * RecordSize + 1], BlockSize);
+
+        return BlockCount * BlockSize;
+    }
+
+    if (!WithLockStatus) {
+        BlockCount = LimitBlockCount(Store, FirstBlock, BlockCount, BlockSize);
+        MemoryReadBlock(Buffer, BlockAddress(Store, FirstBlock), BlockCount * BlockSize);
+        return BlockCount * BlockSize;
+    }
+
+    /* Read the data behind the room taken by the lock status bytes, then move each block to
+     * its place with its lock status in front. Block i ends up at i * (BlockSize + 1), which
+     * never reaches data of blocks not moved yet. */
+    uint8_t LockChunk[LOCK_CHUNK_SIZE];
+    uint8_t *Data;
+
+    BlockCount = LimitBlockCount(Store, FirstBlock, BlockCount, RecordSize);
+    Data = &Buffer[BlockCount];
+    MemoryReadBlock(Data, BlockAddress(Store, FirstBlock), BlockCount * BlockSize);
+
+    if (Store->LockLayout == ISO15693_LOCKS_NONE)
+        memset(LockChunk, ISO15693_MASK_UNLOCKED, sizeof(LockChunk));
+
+    for (i = 0; i < BlockCount; i++) {
+        uint8_t ChunkIndex = i % LOCK_CHUNK_SIZE;
+
+        if (ChunkIndex == 0 && Store->LockLayout == ISO15693_LOCKS_SEPARATE)
+            MemoryReadBlock(LockChunk, Store->LockAddress + FirstBlock + i, MIN(LOCK_CHUNK_SIZE, BlockCount - i));
+
+        memmove(&Buffer[i * RecordSize + 1], &Data[i * BlockSize], BlockSize);
+        Buffer[i * RecordSize] = LockChunk[ChunkIndex];
+    }
+
+    return BlockCount * RecordSize;
+}
+
+uint16_t ISO15693ReadLockStatuses(const ISO15693BlockStoreType *Store, uint8_t *Buffer, uint8_t FirstBlock, uint16_t BlockCount) {
+    uint8_t RecordSize = Store->BlockSize + 1;
+    uint16_t i;
+
+    if (Store->LockLayout == ISO15693_LOCKS_SEPARATE) {
+        BlockCount = LimitBlockCount(Store, FirstBlock, BlockCount, 1);
+        MemoryReadBlock(Buffer, Store->LockAddress + FirstBlock, BlockCount);
+    } else if (Store->LockLayout == ISO15693_LOCKS_INTERLEAVED) {
+        /* One read of the whole records, then keep every lock status byte */
+        BlockCount = LimitBlockCount(Store, FirstBlock, BlockCount, RecordSize);
+        MemoryReadBlock(Buffer, BlockAddress(Store, FirstBlock) - 1, BlockCount * RecordSize);
+
+        for (i = 0; i < BlockCount; i++)
+            Buffer[i] = Buffer[i * RecordSize];
+    } else {
+        BlockCount = LimitBlockCount(Store, FirstBlock, BlockCount, 1);
+        memset(Buffer, ISO15693_MASK_UNLOCKED, BlockCount);
+    }
+
+    return BlockCount;
+}
@@ -77,6 +77,21 @@
 #define ISO15693_MASK_USER_LOCK         ( 1 << 0 )
 #define ISO15693_MASK_FACTORY_LOCK      ( 1 << 1 )
 
+/* Where a block store keeps the lock status bytes of its blocks */
+#define ISO15693_LOCKS_NONE             0x00 /* Not stored, every block reads as unlocked */
+#define ISO15693_LOCKS_SEPARATE         0x01 /* Table of one byte per block at LockAddress */
+#define ISO15693_LOCKS_INTERLEAVED      0x02 /* In front of each block's data, as READ with option flag sends it */
+
+/* Block memory of a tag in FRAM. With ISO15693_LOCKS_INTERLEAVED every block takes
+ * BlockSize + 1 bytes from DataAddress on and LockAddress is unused. */
+typedef struct {
+    uint16_t DataAddress;
+    uint16_t LockAddress;
+    uint16_t BlockCount;
+    uint8_t BlockSize;
+    uint8_t LockLayout;
+} ISO15693BlockStoreType;
+
 typedef struct {
     uint8_t *Flags;
     uint8_t *Command;
@@ -95,6 +110,17 @@ bool ISO15693CheckCRC(void *FrameBuf, uint16_t FrameBufSize);
 bool ISO15693PrepareFrame(uint8_t *FrameBuf, uint16_t FrameBytes, CurrentFrame *FrameStruct, uint8_t IsSelected, uint8_t *MyUid, uint8_t MyAFI);
 bool ISO15693AntiColl(uint8_t *FrameBuf, uint16_t FrameBytes, CurrentFrame *FrameStruct, uint8_t *MyUid);
 
+/* Block is expected to be below Store->BlockCount */
+uint8_t ISO15693GetLockStatus(const ISO15693BlockStoreType *Store, uint8_t Block);
+void ISO15693SetLockStatus(const ISO15693BlockStoreType *Store, uint8_t Block, uint8_t LockStatus);
+void ISO15693ReadBlock(const ISO15693BlockStoreType *Store, uint8_t Block, void *Data);
+void ISO15693WriteBlock(const ISO15693BlockStoreType *Store, uint8_t Block, const void *Data);
+/* Fill the response parameters at Buffer with BlockCount blocks, each preceded by its lock
+ * status if requested, or with the lock status bytes alone. The count is cut at the last
+ * block and at what fits into the codec buffer. Return the number of bytes written. */
+uint16_t ISO15693ReadBlocks(const ISO15693BlockStoreType *Store, uint8_t *Buffer, uint8_t FirstBlock, uint16_t BlockCount, bool WithLockStatus);
+uint16_t ISO15693ReadLockStatuses(const ISO15693BlockStoreType *Store, uint8_t *Buffer, uint8_t FirstBlock, uint16_t BlockCount);
+
 INLINE
 bool ISO15693CompareUid(uint8_t *Uid1, uint8_t *Uid2) {
     if ((Uid1[0] == Uid2[7])
@@ -0,0 +1,579 @@
+/*
+ * ISO15693Tag.c
+ *
+ *  ISO15693 tag emulation, see ISO15693Tag.h
+ *
+ *  Based on the Vicinity and SL2S2002 emulation by Phillip Nash, the Tag-it Standard
+ *  emulation by rickventura and the EM4233 emulation by ceres-c & MrMoDDoM.
+ *  Chip specific commands live next to the chip, e.g. EM4233.c and Slix2.c.
+ *  Still missing support for:
+ *      - WRITE MULTIPLE BLOCKS
+ *      - Answering addressed requests in the quiet state
+ */
+
+#include "ISO15693Tag.h"
+#include "EM4233.h"
+#include "Slix2.h"
+#include "../Codec/ISO15693.h"
+#include "../Memory.h"
+
+/* Address of data a chip does not store, it uses the fixed value from its descriptor */
+#define NO_ADDRESS                  0xFFFF
+
+/* Information flags of GET SYSTEM INFO, selecting the fields that follow the UID */
+#define SYSINFO_DSFID               0x01
+#define SYSINFO_AFI                 0x02
+#define SYSINFO_MEM_SIZE            0x04
+#define SYSINFO_IC_REF              0x08
+
+/* Lock bits of AFI and DSFID in the info byte */
+#define INFO_AFI_LOCK               0x01
+#define INFO_DSFID_LOCK             0x02
+
+/* Chip features */
+#define FEATURE_SELECT              0x0001 /* SELECT and the selected state */
+#define FEATURE_RESET_TO_READY      0x0002 /* RESET TO READY, also the only way out of the quiet state */
+#define FEATURE_SYS_INFO            0x0004 /* GET SYSTEM INFO */
+#define FEATURE_READ                0x0008 /* READ SINGLE BLOCK */
+#define FEATURE_READ_MULTIPLE       0x0010 /* READ MULTIPLE BLOCKS and GET MULTIPLE BLOCK SECURITY STATUS */
+#define FEATURE_WRITE               0x0020 /* WRITE SINGLE BLOCK and LOCK BLOCK */
+#define FEATURE_WRITE_AFI_DSFID     0x0040 /* WRITE AFI, LOCK AFI, WRITE DSFID and LOCK DSFID */
+#define FEATURE_ADDRESSED_ERRORS    0x0080 /* Errors are only answered to addressed requests */
+#define FEATURE_SILENT_WRITES       0x0100 /* Of the write and lock commands only a successful WRITE SINGLE BLOCK is answered */
+#define FEATURE_UID_LSB_FIRST       0x0200 /* UID stored in the order it is sent */
+
+typedef struct {
+    ISO15693BlockStoreType Blocks;
+    uint16_t UidAddress;
+    uint16_t AfiAddress;
+    uint16_t DsfidAddress;
+    uint16_t InfoAddress;
+    uint16_t Features;
+    uint8_t Afi;
+    uint8_t Dsfid;
+    uint8_t SysInfoFlags;
+    uint8_t IcReference;
+    uint8_t RangeError;             /* Error code for blocks out of range */
+    uint8_t FactoryLockBlock;       /* Blocks locked at the factory, marked in the lock status on init */
+    uint8_t FactoryLockCount;
+    ISO15693TagCommandFunc CustomCommand; /* Custom and proprietary commands, may be NULL */
+    void (*ResetFunc)(void);        /* Resets chip specific state, may be NULL */
+    bool (*MutedFunc)(uint8_t Command); /* Whether the chip ignores a command, e.g. in privacy mode, may be NULL */
+    /* Whether a block or AFI command may access the given blocks, e.g. with password protection, may be NULL */
+    bool (*AccessFunc)(uint8_t Command, uint8_t FirstBlock, uint16_t BlockCount);
+} ChipType;
+
+enum {
+    CHIP_VICINITY,
+    CHIP_SL2S2002,
+    CHIP_TITAGIT_STD,
+    CHIP_EM4233,
+    CHIP_ICODE_SLIX2
+};
+
+static const ChipType PROGMEM ChipTable[] = {
+    [CHIP_VICINITY] = {
+        .UidAddress = VICINITY_MEM_UID_ADDRESS, .AfiAddress = NO_ADDRESS, .DsfidAddress = NO_ADDRESS, .InfoAddress = NO_ADDRESS,
+        .Features = FEATURE_RESET_TO_READY | FEATURE_SYS_INFO | FEATURE_ADDRESSED_ERRORS,
+        .SysInfoFlags = 0x00, .RangeError = ISO15693_RES_ERR_BLK_NOT_AVL
+    },
+    [CHIP_SL2S2002] = {
+        /* No lock status is stored, every page reads as unlocked */
+        .Blocks = {
+            .DataAddress = 0, .BlockCount = SL2S2002_NUMBER_OF_PAGES, .BlockSize = SL2S2002_BYTES_PER_PAGE,
+            .LockLayout = ISO15693_LOCKS_NONE
+        },
+        .UidAddress = SL2S2002_MEM_UID_ADDRESS, .AfiAddress = NO_ADDRESS, .DsfidAddress = NO_ADDRESS, .InfoAddress = NO_ADDRESS,
+        .Features = FEATURE_RESET_TO_READY | FEATURE_SYS_INFO | FEATURE_READ | FEATURE_READ_MULTIPLE | FEATURE_ADDRESSED_ERRORS,
+        .Afi = 0xC2, .Dsfid = 0x00, .SysInfoFlags = 0x0F, .IcReference = 0x01, .RangeError = ISO15693_RES_ERR_BLK_NOT_AVL
+    },
+    [CHIP_TITAGIT_STD] = {
+        /* User locks are kept with the slot, so they survive a power cycle like on the real tag */
+        .Blocks = {
+            .DataAddress = 0, .LockAddress = TITAGIT_MEM_LOCK_ADDRESS, .BlockCount = TITAGIT_NUMBER_OF_SECTORS,
+            .BlockSize = TITAGIT_BYTES_PER_PAGE, .LockLayout = ISO15693_LOCKS_SEPARATE
+        },
+        .UidAddress = TITAGIT_MEM_UID_ADDRESS, .AfiAddress = TITAGIT_MEM_AFI_ADDRESS, .DsfidAddress = NO_ADDRESS, .InfoAddress = NO_ADDRESS,
+        .Features = FEATURE_READ | FEATURE_WRITE | FEATURE_UID_LSB_FIRST,
+        .RangeError = ISO15693_RES_ERR_BLK_NOT_AVL, /* real TiTag standard reply with this error */
+        .FactoryLockBlock = 8, .FactoryLockCount = 2 /* Blocks 8 and 9 contain the UID */
+    },
+    [CHIP_EM4233] = {
+        /* Lock status stays in its own table, so dumps keep their layout */
+        .Blocks = {
+            .DataAddress = 0, .LockAddress = EM4233_MEM_LSM_ADDRESS, .BlockCount = EM4233_NUMBER_OF_BLCKS,
+            .BlockSize = EM4233_BYTES_PER_BLCK, .LockLayout = ISO15693_LOCKS_SEPARATE
+        },
+        .UidAddress = EM4233_MEM_UID_ADDRESS, .AfiAddress = EM4233_MEM_AFI_ADDRESS, .DsfidAddress = EM4233_MEM_DSFID_ADDRESS,
+        .InfoAddress = EM4233_MEM_INF_ADDRESS,
+        .Features = FEATURE_SELECT | FEATURE_RESET_TO_READY | FEATURE_SYS_INFO | FEATURE_READ | FEATURE_READ_MULTIPLE |
+        FEATURE_WRITE | FEATURE_WRITE_AFI_DSFID | FEATURE_ADDRESSED_ERRORS | FEATURE_SILENT_WRITES,
+        .SysInfoFlags = EM4233_SYSINFO_BYTE, .IcReference = EM4233_IC_REFERENCE,
+        .RangeError = ISO15693_RES_ERR_GENERIC, /* Copied this behaviour from real tag, not specified in ISO documents */
+        .CustomCommand = EM4233CustomCommand, .ResetFunc = EM4233Reset
+    },
+    [CHIP_ICODE_SLIX2] = {
+        /* New chip without legacy dumps, so the lock status sits in front of each block */
+        .Blocks = {
+            .DataAddress = SLIX2_MEM_BLOCKS_ADDRESS, .BlockCount = SLIX2_NUMBER_OF_BLCKS, .BlockSize = SLIX2_BYTES_PER_BLCK,
+            .LockLayout = ISO15693_LOCKS_INTERLEAVED
+        },
+        .UidAddress = SLIX2_MEM_UID_ADDRESS, .AfiAddress = SLIX2_MEM_AFI_ADDRESS, .DsfidAddress = SLIX2_MEM_DSFID_ADDRESS,
+        .InfoAddress = SLIX2_MEM_INF_ADDRESS,
+        .Features = FEATURE_SELECT | FEATURE_RESET_TO_READY | FEATURE_SYS_INFO | FEATURE_READ | FEATURE_READ_MULTIPLE |
+        FEATURE_WRITE | FEATURE_WRITE_AFI_DSFID,
+        .SysInfoFlags = 0x0F, .IcReference = SLIX2_IC_REFERENCE, .RangeError = ISO15693_RES_ERR_BLK_NOT_AVL,
+        .CustomCommand = Slix2CustomCommand, .ResetFunc = Slix2Reset, .MutedFunc = Slix2Muted, .AccessFunc = Slix2Access
+    }
+};
+
+static enum {
+    STATE_READY,
+    STATE_SELECTED,
+    STATE_QUIET
+} State;
+
+static ChipType Chip;
+static uint8_t Dsfid;
+
+static void LoadIdentity(void) {
+    ISO15693TagGetUid(Uid);
+
+    if (Chip.AfiAddress != NO_ADDRESS) {
+        MemoryReadBlock(&MyAFI, Chip.AfiAddress, 1);
+    } else {
+        MyAFI = Chip.Afi;
+    }
+
+    if (Chip.DsfidAddress != NO_ADDRESS) {
+        MemoryReadBlock(&Dsfid, Chip.DsfidAddress, 1);
+    } else {
+        Dsfid = Chip.Dsfid;
+    }
+}
+
+static void AppInit(uint8_t ChipIdx) {
+    memcpy_P(&Chip, &ChipTable[ChipIdx], sizeof(Chip));
+
+    for (uint8_t Block = Chip.FactoryLockBlock; Block < Chip.FactoryLockBlock + Chip.FactoryLockCount; Block++) {
+        if (!(ISO15693GetLockStatus(&Chip.Blocks, Block) & ISO15693_MASK_FACTORY_LOCK)) {
+            ISO15693SetLockStatus(&Chip.Blocks, Block, ISO15693_MASK_FACTORY_LOCK);
+        }
+    }
+
+    ISO15693TagAppReset();
+}
+
+void VicinityAppInit(void) {
+    AppInit(CHIP_VICINITY);
+}
+
+void Sl2s2002AppInit(void) {
+    AppInit(CHIP_SL2S2002);
+}
+
+void TITagitstandardAppInit(void) {
+    AppInit(CHIP_TITAGIT_STD);
+}
+
+void EM4233AppInit(void) {
+    AppInit(CHIP_EM4233);
+}
+
+void Slix2AppInit(void) {
+    AppInit(CHIP_ICODE_SLIX2);
+}
+
+void ISO15693TagAppReset(void) {
+    State = STATE_READY;
+
+    FrameInfo.Flags         = NULL;
+    FrameInfo.Command       = NULL;
+    FrameInfo.Parameters    = NULL;
+    FrameInfo.ParamLen      = 0;
+    FrameInfo.Addressed     = false;
+    FrameInfo.Selected      = false;
+
+    LoadIdentity();
+
+    if (Chip.ResetFunc != NULL) {
+        Chip.ResetFunc();
+    }
+}
+
+void ISO15693TagAppTask(void) {
+
+}
+
+void ISO15693TagAppTick(void) {
+
+}
+
+static uint16_t ErrorResponse(uint8_t *FrameBuf, uint8_t ErrorCode) {
+    if ((Chip.Features & FEATURE_ADDRESSED_ERRORS) && !FrameInfo.Addressed)
+        return ISO15693_APP_NO_RESPONSE;
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_ERROR;
+    FrameBuf[ISO15693_RES_ADDR_PARAM] = ErrorCode;
+    return 2;
+}
+
+static uint16_t WriteErrorResponse(uint8_t *FrameBuf, uint8_t ErrorCode) {
+    if (Chip.Features & FEATURE_SILENT_WRITES)
+        return ISO15693_APP_NO_RESPONSE; /* real tag does not respond anyway */
+
+    return ErrorResponse(FrameBuf, ErrorCode);
+}
+
+static bool AccessGranted(uint8_t FirstBlock, uint16_t BlockCount) {
+    return (Chip.AccessFunc == NULL) || Chip.AccessFunc(*FrameInfo.Command, FirstBlock, BlockCount);
+}
+
+static uint16_t WriteDoneResponse(uint8_t *FrameBuf) {
+    if (Chip.Features & FEATURE_SILENT_WRITES)
+        return ISO15693_APP_NO_RESPONSE; /* real tag does not respond anyway */
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1;
+}
+
+static uint16_t Select(uint8_t *FrameBuf) {
+    if (!(FrameBuf[ISO15693_ADDR_FLAGS] & ISO15693_REQ_FLAG_ADDRESS) || (FrameBuf[ISO15693_ADDR_FLAGS] & ISO15693_REQ_FLAG_SELECT)) {
+        /* tag should remain silent if Select is performed without address flag or with select flag */
+        return ISO15693_APP_NO_RESPONSE;
+    } else if (!ISO15693CompareUid(&FrameBuf[ISO15693_REQ_ADDR_PARAM], Uid)) {
+        /* tag should remain silent if Select is performed against another UID, and
+         * return to ready if it was selected
+         */
+        if (State == STATE_SELECTED) {
+            State = STATE_READY;
+        }
+        return ISO15693_APP_NO_RESPONSE;
+    }
+
+    State = STATE_SELECTED;
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1;
+}
+
+static uint16_t Inventory(uint8_t *FrameBuf, uint16_t FrameBytes) {
+    if (FrameInfo.ParamLen == 0)
+        return ISO15693_APP_NO_RESPONSE; /* malformed: mask length is missing */
+
+    if (!ISO15693AntiColl(FrameBuf, FrameBytes, &FrameInfo, Uid))
+        return ISO15693_APP_NO_RESPONSE;
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    FrameBuf[ISO15693_RES_ADDR_PARAM] = Dsfid;
+    ISO15693CopyUid(&FrameBuf[ISO15693_RES_ADDR_PARAM + 0x01], Uid);
+    return 10;
+}
+
+static uint16_t GetSysInfo(uint8_t *FrameBuf) {
+    uint8_t FramePtr = ISO15693_RES_ADDR_PARAM;
+
+    if (FrameInfo.ParamLen != 0)
+        return ISO15693_APP_NO_RESPONSE; /* malformed: not enough or too much data */
+
+    FrameBuf[FramePtr++] = Chip.SysInfoFlags;
+    ISO15693CopyUid(&FrameBuf[FramePtr], Uid);
+    FramePtr += ISO15693_GENERIC_UID_SIZE;
+
+    if (Chip.SysInfoFlags & SYSINFO_DSFID) {
+        FrameBuf[FramePtr++] = Dsfid;
+    }
+
+    if (Chip.SysInfoFlags & SYSINFO_AFI) {
+        FrameBuf[FramePtr++] = MyAFI;
+    }
+
+    if (Chip.SysInfoFlags & SYSINFO_MEM_SIZE) {
+        FrameBuf[FramePtr++] = Chip.Blocks.BlockCount - 1;
+        FrameBuf[FramePtr++] = Chip.Blocks.BlockSize - 1;
+    }
+
+    if (Chip.SysInfoFlags & SYSINFO_IC_REF) {
+        FrameBuf[FramePtr++] = Chip.IcReference;
+    }
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return FramePtr;
+}
+
+static uint16_t ReadSingle(uint8_t *FrameBuf) {
+    uint8_t BlockAddress = FrameInfo.Parameters[0];
+    bool WithLockStatus = FrameBuf[ISO15693_ADDR_FLAGS] & ISO15693_REQ_FLAG_OPTION;
+
+    if (FrameInfo.ParamLen != 1)
+        return ISO15693_APP_NO_RESPONSE; /* malformed: not enough or too much data */
+
+    if (BlockAddress >= Chip.Blocks.BlockCount)
+        return ErrorResponse(FrameBuf, Chip.RangeError);
+
+    if (!AccessGranted(BlockAddress, 1))
+        return ErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1 + ISO15693ReadBlocks(&Chip.Blocks, &FrameBuf[ISO15693_RES_ADDR_PARAM], BlockAddress, 1, WithLockStatus);
+}
+
+static uint16_t ReadMultiple(uint8_t *FrameBuf) {
+    uint8_t BlockAddress = FrameInfo.Parameters[0];
+    uint16_t BlocksNumber = FrameInfo.Parameters[1] + 0x01; /* according to ISO standard, we have to read 0x08 blocks if we get 0x07 in request */
+    bool WithLockStatus = FrameBuf[ISO15693_ADDR_FLAGS] & ISO15693_REQ_FLAG_OPTION;
+
+    if (FrameInfo.ParamLen != 2)
+        return ISO15693_APP_NO_RESPONSE; /* malformed: not enough or too much data */
+
+    if (BlockAddress >= Chip.Blocks.BlockCount)
+        return ErrorResponse(FrameBuf, Chip.RangeError);
+
+    /* we read up to latest block, as real tag does */
+    BlocksNumber = MIN(BlocksNumber, Chip.Blocks.BlockCount - BlockAddress);
+
+    if (!AccessGranted(BlockAddress, BlocksNumber))
+        return ErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1 + ISO15693ReadBlocks(&Chip.Blocks, &FrameBuf[ISO15693_RES_ADDR_PARAM], BlockAddress, BlocksNumber, WithLockStatus);
+}
+
+static uint16_t GetBlockSecurity(uint8_t *FrameBuf) {
+    uint8_t BlockAddress = FrameInfo.Parameters[0];
+    uint16_t BlocksNumber = FrameInfo.Parameters[1] + 0x01;
+
+    if (FrameInfo.ParamLen != 2)
+        return ISO15693_APP_NO_RESPONSE; /* malformed: not enough or too much data */
+
+    if (BlockAddress >= Chip.Blocks.BlockCount)
+        return ErrorResponse(FrameBuf, Chip.RangeError);
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1 + ISO15693ReadLockStatuses(&Chip.Blocks, &FrameBuf[ISO15693_RES_ADDR_PARAM], BlockAddress, BlocksNumber);
+}
+
+static uint16_t WriteSingle(uint8_t *FrameBuf) {
+    uint8_t BlockAddress = FrameInfo.Parameters[0];
+
+    if (FrameInfo.ParamLen != 1 + Chip.Blocks.BlockSize)
+        return ISO15693_APP_NO_RESPONSE; /* malformed: not enough or too much data */
+
+    if (BlockAddress >= Chip.Blocks.BlockCount)
+        return WriteErrorResponse(FrameBuf, Chip.RangeError);
+
+    if (!AccessGranted(BlockAddress, 1))
+        return WriteErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    if (ISO15693GetLockStatus(&Chip.Blocks, BlockAddress) & (ISO15693_MASK_USER_LOCK | ISO15693_MASK_FACTORY_LOCK))
+        return WriteErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_CHG_LKD);
+
+    /* Data to write begins on 2nd byte of the parameters */
+    ISO15693WriteBlock(&Chip.Blocks, BlockAddress, &FrameInfo.Parameters[1]);
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1;
+}
+
+static uint16_t LockBlock(uint8_t *FrameBuf) {
+    uint8_t BlockAddress = FrameInfo.Parameters[0];
+    uint8_t LockStatus;
+
+    if (FrameInfo.ParamLen != 1)
+        return ISO15693_APP_NO_RESPONSE; /* malformed: not enough or too much data */
+
+    if (BlockAddress >= Chip.Blocks.BlockCount)
+        return WriteErrorResponse(FrameBuf, Chip.RangeError);
+
+    if (!AccessGranted(BlockAddress, 1))
+        return WriteErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    LockStatus = ISO15693GetLockStatus(&Chip.Blocks, BlockAddress);
+
+    if (LockStatus & (ISO15693_MASK_USER_LOCK | ISO15693_MASK_FACTORY_LOCK))
+        return WriteErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_ALRD_LKD);
+
+    ISO15693SetLockStatus(&Chip.Blocks, BlockAddress, LockStatus | ISO15693_MASK_USER_LOCK);
+    return WriteDoneResponse(FrameBuf);
+}
+
+static bool InfoLocked(uint8_t LockMask) {
+    uint8_t Info;
+
+    MemoryReadBlock(&Info, Chip.InfoAddress, 1);
+    return Info & LockMask;
+}
+
+/* WRITE AFI and WRITE DSFID */
+static uint16_t WriteIdentifier(uint8_t *FrameBuf, uint16_t Address, uint8_t LockMask, uint8_t *Identifier) {
+    if (FrameInfo.ParamLen != 1)
+        return ISO15693_APP_NO_RESPONSE; /* malformed: not enough or too much data */
+
+    if (!AccessGranted(0, 0))
+        return WriteErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    if (InfoLocked(LockMask))
+        return WriteErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_CHG_LKD);
+
+    *Identifier = FrameInfo.Parameters[0];
+    MemoryWriteBlock(Identifier, Address, 1);
+    return WriteDoneResponse(FrameBuf);
+}
+
+/* LOCK AFI and LOCK DSFID */
+static uint16_t LockIdentifier(uint8_t *FrameBuf, uint8_t LockMask) {
+    uint8_t Info;
+
+    if (FrameInfo.ParamLen != 0)
+        return ISO15693_APP_NO_RESPONSE; /* malformed: not enough or too much data */
+
+    if (!AccessGranted(0, 0))
+        return WriteErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    MemoryReadBlock(&Info, Chip.InfoAddress, 1);
+
+    if (Info & LockMask)
+        return WriteErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_ALRD_LKD);
+
+    Info |= LockMask;
+    MemoryWriteBlock(&Info, Chip.InfoAddress, 1);
+    return WriteDoneResponse(FrameBuf);
+}
+
+static uint16_t ResetToReady(uint8_t *FrameBuf) {
+    State = STATE_READY;
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1;
+}
+
+uint16_t ISO15693TagAppProcess(uint8_t *FrameBuf, uint16_t FrameBytes) {
+    uint8_t Command;
+    uint16_t Features = Chip.Features;
+
+    if ((FrameBytes < ISO15693_MIN_FRAME_SIZE) || !ISO15693CheckCRC(FrameBuf, FrameBytes - ISO15693_CRC16_SIZE))
+        /* malformed frame */
+        return ISO15693_APP_NO_RESPONSE;
+
+    if ((Chip.MutedFunc != NULL) && Chip.MutedFunc(FrameBuf[ISO15693_REQ_ADDR_CMD]))
+        return ISO15693_APP_NO_RESPONSE;
+
+    if ((FrameBuf[ISO15693_REQ_ADDR_CMD] == ISO15693_CMD_SELECT) && (Features & FEATURE_SELECT)) {
+        /* Select has its own path before PrepareFrame because the state changes from
+         * selected to ready if Select is addressed to another tag.
+         */
+        return Select(FrameBuf);
+    }
+
+    if (!ISO15693PrepareFrame(FrameBuf, FrameBytes, &FrameInfo, State == STATE_SELECTED, Uid, MyAFI))
+        return ISO15693_APP_NO_RESPONSE;
+
+    Command = *FrameInfo.Command;
+
+    if (State == STATE_QUIET) {
+        if ((Command == ISO15693_CMD_RESET_TO_READY) && (Features & FEATURE_RESET_TO_READY))
+            return ResetToReady(FrameBuf);
+
+        return ISO15693_APP_NO_RESPONSE;
+    }
+
+    switch (Command) {
+        case ISO15693_CMD_INVENTORY:
+            return Inventory(FrameBuf, FrameBytes);
+
+        case ISO15693_CMD_STAY_QUIET:
+            if (FrameInfo.Addressed) {
+                State = STATE_QUIET;
+            }
+            return ISO15693_APP_NO_RESPONSE;
+
+        case ISO15693_CMD_READ_SINGLE:
+            if (Features & FEATURE_READ)
+                return ReadSingle(FrameBuf);
+            break;
+
+        case ISO15693_CMD_READ_MULTIPLE:
+            if (Features & FEATURE_READ_MULTIPLE)
+                return ReadMultiple(FrameBuf);
+            break;
+
+        case ISO15693_CMD_GET_BLOCK_SEC:
+            if (Features & FEATURE_READ_MULTIPLE)
+                return GetBlockSecurity(FrameBuf);
+            break;
+
+        case ISO15693_CMD_WRITE_SINGLE:
+            if (Features & FEATURE_WRITE)
+                return WriteSingle(FrameBuf);
+            break;
+
+        case ISO15693_CMD_LOCK_BLOCK:
+            if (Features & FEATURE_WRITE)
+                return LockBlock(FrameBuf);
+            break;
+
+        case ISO15693_CMD_WRITE_AFI:
+            if (Features & FEATURE_WRITE_AFI_DSFID)
+                return WriteIdentifier(FrameBuf, Chip.AfiAddress, INFO_AFI_LOCK, &MyAFI);
+            break;
+
+        case ISO15693_CMD_LOCK_AFI:
+            if (Features & FEATURE_WRITE_AFI_DSFID)
+                return LockIdentifier(FrameBuf, INFO_AFI_LOCK);
+            break;
+
+        case ISO15693_CMD_WRITE_DSFID:
+            if (Features & FEATURE_WRITE_AFI_DSFID)
+                return WriteIdentifier(FrameBuf, Chip.DsfidAddress, INFO_DSFID_LOCK, &Dsfid);
+            break;
+
+        case ISO15693_CMD_LOCK_DSFID:
+            if (Features & FEATURE_WRITE_AFI_DSFID)
+                return LockIdentifier(FrameBuf, INFO_DSFID_LOCK);
+            break;
+
+        case ISO15693_CMD_GET_SYS_INFO:
+            if (Features & FEATURE_SYS_INFO)
+                return GetSysInfo(FrameBuf);
+            break;
+
+        case ISO15693_CMD_RESET_TO_READY:
+            if (Features & FEATURE_RESET_TO_READY)
+                return ResetToReady(FrameBuf);
+            break;
+
+        default:
+            if (Chip.CustomCommand != NULL) {
+                uint16_t ResponseBytes = Chip.CustomCommand(FrameBuf, FrameBytes);
+
+                if (ResponseBytes != ISO15693_TAG_CMD_UNKNOWN)
+                    return ResponseBytes;
+            }
+            break;
+    }
+
+    return ErrorResponse(FrameBuf, ISO15693_RES_ERR_NOT_SUPP);
+}
+
+void ISO15693TagGetUid(ConfigurationUidType Uid) {
+    if (Chip.Features & FEATURE_UID_LSB_FIRST) {
+        uint8_t StoredUid[ISO15693_GENERIC_UID_SIZE];
+
+        MemoryReadBlock(StoredUid, Chip.UidAddress, ISO15693_GENERIC_UID_SIZE);
+        ISO15693CopyUid(Uid, StoredUid);
+    } else {
+        MemoryReadBlock(Uid, Chip.UidAddress, ISO15693_GENERIC_UID_SIZE);
+    }
+}
+
+void ISO15693TagSetUid(ConfigurationUidType NewUid) {
+    memcpy(Uid, NewUid, ISO15693_GENERIC_UID_SIZE); // Update the local variable
+
+    if (Chip.Features & FEATURE_UID_LSB_FIRST) {
+        uint8_t StoredUid[ISO15693_GENERIC_UID_SIZE];
+
+        ISO15693CopyUid(StoredUid, NewUid);
+        MemoryWriteBlock(StoredUid, Chip.UidAddress, ISO15693_GENERIC_UID_SIZE);
+    } else {
+        MemoryWriteBlock(NewUid, Chip.UidAddress, ISO15693_GENERIC_UID_SIZE);
+    }
+}
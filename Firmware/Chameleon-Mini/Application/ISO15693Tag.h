@@ -0,0 +1,51 @@
+/*
+ * ISO15693Tag.h
+ *
+ *  ISO15693 tag emulation: Vicinity, SL2S2002, Tag-it Standard, EM4233 and ICODE SLIX2
+ *
+ *  All chips share one command engine built on ISO15693PrepareFrame and ISO15693AntiColl.
+ *  They only differ in their descriptor: block memory, where UID, AFI and DSFID are kept,
+ *  the system information they report, the optional commands they answer and an optional
+ *  handler for their custom and proprietary commands.
+ */
+
+#ifndef ISO15693TAG_H_
+#define ISO15693TAG_H_
+
+#include "Application.h"
+#include "ISO15693-A.h"
+
+/* Vicinity and SL2S2002 keep the UID at the start of the generic memory */
+#define VICINITY_MEM_UID_ADDRESS    0x00
+#define SL2S2002_MEM_UID_ADDRESS    0x00
+#define SL2S2002_BYTES_PER_PAGE     4
+#define SL2S2002_NUMBER_OF_PAGES    28
+
+#define TITAGIT_STD_UID_SIZE        ISO15693_GENERIC_UID_SIZE  //ISO15693_UID_SIZE
+#define TITAGIT_BYTES_PER_PAGE      4
+#define TITAGIT_NUMBER_OF_SECTORS   11          //TAG-IT STANDARD MAX MEM SIZE is 44 bytes
+#define TITAGIT_MEM_UID_ADDRESS     0x20
+#define TITAGIT_MEM_AFI_ADDRESS     0x28        // AFI byte address
+#define TITAGIT_MEM_LOCK_ADDRESS    0x2C        // One user lock status byte per block follows the tag memory
+#define TITAGIT_STD_MEM_SIZE        56          // Tag memory and lock status, rounded to even size
+
+/* Returned by a custom command handler for commands the chip does not know */
+#define ISO15693_TAG_CMD_UNKNOWN    0xFFFF
+
+typedef uint16_t (*ISO15693TagCommandFunc)(uint8_t *FrameBuf, uint16_t FrameBytes);
+
+void VicinityAppInit(void);
+void Sl2s2002AppInit(void);
+void TITagitstandardAppInit(void);
+void EM4233AppInit(void);
+void Slix2AppInit(void);
+
+void ISO15693TagAppReset(void);
+void ISO15693TagAppTask(void);
+void ISO15693TagAppTick(void);
+uint16_t ISO15693TagAppProcess(uint8_t *FrameBuf, uint16_t FrameBytes);
+
+void ISO15693TagGetUid(ConfigurationUidType Uid);
+void ISO15693TagSetUid(ConfigurationUidType Uid);
+
+#endif /* ISO15693TAG_H_ */
@@ -394,10 +394,6 @@ void MifareClassicAppInitMini4B(void) {
 
 extern uint8_t bUidMode;                // Magic card mode switch
 
-#define FRAM_DETECTION_START_ADDR    0x7000
-#define FRAM_DETECTION_DATA_ADDR    0x7002
-#define FRAM_DETECTION_DATA_SIZE    0x0FF8
-
 static uint16_t DetectionLogPtr = FRAM_DETECTION_DATA_ADDR;
 static uint8_t EEMEM LogDetectionValid = false;
 
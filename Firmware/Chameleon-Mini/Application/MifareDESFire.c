@@ -0,0 +1,1643 @@
+/*
+ * MifareDESFire.c
+ *
+ *  MIFARE DESFire EV1 emulation
+ *
+ *  Layers: ISO14443-3A anticollision, ISO14443-4 (ISO14443-4.c), native commands
+ *  (optionally wrapped in ISO7816 APDUs) on the file system in MifareDESFireFS.c.
+ *
+ *  Authentication uses the legacy DES/2K3DES scheme (0x0A) or AES (0xAA). After
+ *  AES authentication, every command and response is CMACed as on the real card.
+ *  File data is transferred plain, MACed or enciphered as set by the file.
+ *
+ *  Not supported: record files, LimitedCredit, ChangeFileSettings, GetCardUID,
+ *  ISO authentication (0x1A) with 3K3DES keys and the ISO7816 file commands.
+ */
+
+#include "MifareDESFire.h"
+#include "MifareDESFireFS.h"
+#include "CryptoTDEA.h"
+#include "CryptoAES128.h"
+#include "ISO14443-4.h"
+#include "../Codec/ISO14443-2A.h"
+#include "../Random.h"
+#include <util/crc16.h>
+
+#define ATQA_VALUE                  0x0344
+/* As sent by genuine cards */
+#define SAK_CL1_VALUE               (ISO14443A_SAK_INCOMPLETE | ISO14443A_SAK_COMPLETE_COMPLIANT)
+#define SAK_CL2_VALUE               ISO14443A_SAK_COMPLETE_COMPLIANT
+
+/* ISO14443-4: FWI 77 ms, SFGI 1, historical byte as genuine cards */
+#define PROTOCOL_FWI                8
+#define PROTOCOL_SFGI               1
+#define PROTOCOL_WTXM               4 /* For commands clearing or copying card memory */
+
+/* Native commands */
+#define CMD_AUTHENTICATE            0x0A
+#define CMD_AUTHENTICATE_AES        0xAA
+#define CMD_CHANGE_KEY_SETTINGS     0x54
+#define CMD_GET_KEY_SETTINGS        0x45
+#define CMD_CHANGE_KEY              0xC4
+#define CMD_GET_KEY_VERSION         0x64
+#define CMD_CREATE_APPLICATION      0xCA
+#define CMD_DELETE_APPLICATION      0xDA
+#define CMD_GET_APPLICATION_IDS     0x6A
+#define CMD_SELECT_APPLICATION      0x5A
+#define CMD_FORMAT_PICC             0xFC
+#define CMD_GET_VERSION             0x60
+#define CMD_GET_FREE_MEMORY         0x6E
+#define CMD_GET_FILE_IDS            0x6F
+#define CMD_GET_FILE_SETTINGS       0xF5
+#define CMD_CREATE_STD_DATA_FILE    0xCD
+#define CMD_CREATE_BACKUP_DATA_FILE 0xCB
+#define CMD_CREATE_VALUE_FILE       0xCC
+#define CMD_DELETE_FILE             0xDF
+#define CMD_READ_DATA               0xBD
+#define CMD_WRITE_DATA              0x3D
+#define CMD_GET_VALUE               0x6C
+#define CMD_CREDIT                  0x0C
+#define CMD_DEBIT                   0xDC
+#define CMD_COMMIT_TRANSACTION      0xC7
+#define CMD_ABORT_TRANSACTION       0xA7
+#define CMD_ADDITIONAL_FRAME        0xAF
+#define CMD_NONE                    0x00
+
+/* ISO7816 wrapping: CLA INS P1 P2 [Lc Data] [Le], answered by Data SW1 SW2 */
+#define WRAPPED_CLA                 0x90
+#define WRAPPED_SW1                 0x91
+#define ISO7816_SW_WRONG_LENGTH     0x6700
+
+/* Key settings */
+#define KEY_SETTING_CHANGE_MASTER   0x01
+#define KEY_SETTING_FREE_LISTING    0x02
+#define KEY_SETTING_FREE_CREATE     0x04
+#define KEY_SETTING_CHANGE_SETTINGS 0x08
+#define KEY_SETTING_CHANGE_KEY_SHIFT 4
+#define CHANGE_KEY_SAME_KEY         0x0E
+#define CHANGE_KEY_FROZEN           0x0F
+
+/* Access rights, one nibble each: read, write, read & write, change */
+#define RIGHT_CHANGE                0x01
+#define RIGHT_READ_WRITE            0x02
+#define RIGHT_WRITE                 0x04
+#define RIGHT_READ                  0x08
+#define ACCESS_FREE                 0x0E
+
+/* Communication modes */
+#define COMM_PLAIN                  0x00
+#define COMM_MACED                  0x01
+#define COMM_ENCIPHERED             0x03
+#define COMM_DENIED                 0xFF
+
+#define FRAME_DATA_SIZE             59 /* Data bytes following the status */
+#define ENCIPHERED_FRAME_DATA_SIZE  48 /* Whole cipher blocks of either size */
+#define APP_IDS_PER_FRAME           ((FRAME_DATA_SIZE - CMAC_SIZE) / DESFIRE_AID_SIZE)
+#define VERSION_FRAME_COUNT         3
+
+#define CMAC_SIZE                   8
+#define LEGACY_MAC_SIZE             4
+#define CRC32_SIZE                  4
+#define CRC32_INIT                  0xFFFFFFFF
+#define CRC32_POLYNOMIAL            0xEDB88320
+#define CRC16_SIZE                  ISO14443A_CRCA_SIZE
+#define CRC16_INIT                  0x6363
+#define CMAC_POLYNOMIAL             0x87
+#define VALUE_SIZE                  4
+#define NOT_AUTHENTICATED           0xFF
+#define FILE_HEADER_SIZE            8 /* Command, file number, offset, length */
+#define VALUE_HEADER_SIZE           2 /* Command, file number */
+
+static const uint8_t PROGMEM Version[VERSION_FRAME_COUNT][ISO14443A_UID_SIZE_DOUBLE] = {
+    { 0x04, 0x01, 0x01, 0x01, 0x00, 0x18, 0x05 }, /* Hardware: NXP, DESFire, EV1, 4K, ISO14443-4 */
+    { 0x04, 0x01, 0x01, 0x01, 0x04, 0x18, 0x05 }, /* Software */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x20 }, /* Batch number, week and year of production, follow the UID */
+};
+
+static enum {
+    STATE_HALT,
+    STATE_IDLE,
+    STATE_READY1,
+    STATE_READY2,
+    STATE_ACTIVE,
+    STATE_PROTOCOL
+} State;
+
+static enum {
+    AUTH_NONE,
+    AUTH_LEGACY,
+    AUTH_AES
+} AuthScheme;
+
+typedef struct {
+    uint8_t Chain[CRYPTO_AES_BLOCK_SIZE];
+    uint8_t Block[CRYPTO_AES_BLOCK_SIZE];
+    uint8_t Fill;
+} MacStateType;
+
+static bool FromHalt = false;
+
+/* Selected application, the directory entry holds the file index */
+static uint8_t AppSlot;
+static DesfireAppType App;
+static uint32_t TransactionFiles; /* Backup and value files changed within the transaction */
+
+static uint8_t AuthKeyNo;
+static uint8_t SessionKey[DESFIRE_KEY_SIZE];
+static CryptoAESContextType SessionContext;
+static uint8_t SessionIV[CRYPTO_AES_BLOCK_SIZE];
+static uint8_t CMACSubkey1[CRYPTO_AES_BLOCK_SIZE];
+static uint8_t CMACSubkey2[CRYPTO_AES_BLOCK_SIZE];
+
+static MacStateType CommandMac;
+static MacStateType ResponseMac;
+static bool ResponseMacActive;
+static bool ResponseMacStarted;
+
+/* State of commands spanning several frames */
+static struct {
+    uint8_t Command; /* Continued by CMD_ADDITIONAL_FRAME */
+    uint8_t Mode;
+    uint8_t FileNo;
+    uint8_t Index; /* Frame or directory slot */
+    uint16_t Address; /* Data address in the card memory, 0 for Value */
+    uint16_t DataLeft;
+    uint16_t BytesLeft; /* Bytes to receive, including MAC or CRC and padding */
+    uint8_t Value[VALUE_SIZE];
+    uint8_t Trailer[CMAC_SIZE]; /* Received MAC or CRC */
+    uint8_t TrailerFill;
+    uint8_t Block[CRYPTO_AES_BLOCK_SIZE];
+    uint8_t BlockFill;
+    uint8_t IV[CRYPTO_AES_BLOCK_SIZE]; /* Legacy scheme, starts from zero with every message */
+    uint32_t Crc32;
+    uint16_t Crc16;
+    /* Pending authentication */
+    uint8_t AuthScheme;
+    uint8_t AuthKey[DESFIRE_KEY_SIZE];
+    uint8_t RndB[CRYPTO_AES_BLOCK_SIZE];
+} Transfer;
+
+/* Crypto and integrity helpers */
+
+INLINE uint8_t BlockSize(void) {
+    return (AuthScheme == AUTH_AES) ? CRYPTO_AES_BLOCK_SIZE : CRYPTO_DES_BLOCK_SIZE;
+}
+
+INLINE uint16_t PaddedSize(uint16_t ByteCount) {
+    uint8_t Size = BlockSize();
+
+    return (ByteCount + Size - 1) & ~(Size - 1);
+}
+
+INLINE uint8_t *CipherIV(void) {
+    return (AuthScheme == AUTH_AES) ? SessionIV : Transfer.IV;
+}
+
+/* The PICC always enciphers. Legacy CBC uses it for both directions, see CryptoTDEA.h */
+static void EncryptSend(const void *Input, void *Output, uint8_t *IV) {
+    if (AuthScheme == AUTH_AES)
+        CryptoAESEncrypt_CBCSend(1, Input, Output, IV, &SessionContext);
+    else
+        CryptoEncrypt2KTDEA_CBCSend(1, Input, Output, IV, SessionKey);
+}
+
+static void DecryptReceive(const void *Input, void *Output, uint8_t *IV) {
+    if (AuthScheme == AUTH_AES)
+        CryptoAESDecrypt_CBCReceive(1, Input, Output, IV, &SessionContext);
+    else
+        CryptoEncrypt2KTDEA_CBCReceive(1, Input, Output, IV, SessionKey);
+}
+
+static uint32_t Crc32Update(uint32_t Crc, const uint8_t *Data, uint16_t ByteCount) {
+    while (ByteCount--) {
+        Crc ^= *Data++;
+
+        for (uint8_t i = 0; i < 8; i++)
+            Crc = (Crc >> 1) ^ ((Crc & 1) ? CRC32_POLYNOMIAL : 0);
+    }
+
+    return Crc;
+}
+
+static uint16_t Crc16Update(uint16_t Crc, const uint8_t *Data, uint16_t ByteCount) {
+    while (ByteCount--)
+        Crc = _crc_ccitt_update(Crc, *Data++);
+
+    return Crc;
+}
+
+/* MACs are computed incrementally: the last block is held back until MacFinal knows it is the last one.
+ * AES uses CMAC, the legacy scheme a CBC-MAC with zero padding. */
+static void MacInit(MacStateType *Mac, const uint8_t *IV) {
+    if (IV != NULL)
+        memcpy(Mac->Chain, IV, sizeof(Mac->Chain));
+    else
+        memset(Mac->Chain, 0, sizeof(Mac->Chain));
+
+    Mac->Fill = 0;
+}
+
+static void MacProcessBlock(MacStateType *Mac) {
+    uint8_t Output[CRYPTO_AES_BLOCK_SIZE];
+
+    EncryptSend(Mac->Block, Output, Mac->Chain);
+}
+
+static void MacUpdate(MacStateType *Mac, const uint8_t *Data, uint16_t ByteCount) {
+    uint8_t Size = BlockSize();
+
+    while (ByteCount--) {
+        if (Mac->Fill == Size) {
+            MacProcessBlock(Mac);
+            Mac->Fill = 0;
+        }
+
+        Mac->Block[Mac->Fill++] = *Data++;
+    }
+}
+
+static void MacFinal(MacStateType *Mac) {
+    uint8_t Size = BlockSize();
+
+    if (AuthScheme == AUTH_AES) {
+        const uint8_t *Subkey = CMACSubkey1;
+
+        if (Mac->Fill < Size) {
+            Mac->Block[Mac->Fill++] = 0x80;
+            Subkey = CMACSubkey2;
+        }
+
+        while (Mac->Fill < Size)
+            Mac->Block[Mac->Fill++] = 0x00;
+
+        for (uint8_t i = 0; i < Size; i++)
+            Mac->Block[i] ^= Subkey[i];
+    } else {
+        while (Mac->Fill < Size)
+            Mac->Block[Mac->Fill++] = 0x00;
+    }
+
+    MacProcessBlock(Mac);
+}
+
+static void CMACSubkeyShift(uint8_t *Subkey, const uint8_t *Input) {
+    uint8_t Carry = 0;
+
+    for (uint8_t i = CRYPTO_AES_BLOCK_SIZE; i-- > 0;) {
+        uint8_t Byte = Input[i];
+
+        Subkey[i] = (Byte << 1) | Carry;
+        Carry = Byte >> 7;
+    }
+
+    if (Carry)
+        Subkey[CRYPTO_AES_BLOCK_SIZE - 1] ^= CMAC_POLYNOMIAL;
+}
+
+static void ResetAuthentication(void) {
+    AuthScheme = AUTH_NONE;
+    AuthKeyNo = NOT_AUTHENTICATED;
+}
+
+static void SelectApp(uint8_t Slot) {
+    AppSlot = Slot;
+    DesfireFSReadApp(Slot, &App);
+    ResetAuthentication();
+    TransactionFiles = 0;
+}
+
+INLINE bool IsMasterAuthenticated(void) {
+    return (AuthScheme != AUTH_NONE) && (AuthKeyNo == 0);
+}
+
+INLINE uint16_t Status(uint8_t *Buffer, uint8_t Status) {
+    Buffer[0] = Status;
+    return 1;
+}
+
+INLINE uint32_t GetLE24(const uint8_t *Data) {
+    return (uint32_t) Data[0] | ((uint32_t) Data[1] << 8) | ((uint32_t) Data[2] << 16);
+}
+
+INLINE uint16_t GetLE16(const uint8_t *Data) {
+    return (uint16_t) Data[0] | ((uint16_t) Data[1] << 8);
+}
+
+INLINE void PutLE24(uint8_t *Data, uint32_t Value) {
+    Data[0] = (Value >> 0) & 0xFF;
+    Data[1] = (Value >> 8) & 0xFF;
+    Data[2] = (Value >> 16) & 0xFF;
+}
+
+/* File access */
+
+static uint8_t GetFile(uint8_t FileNo, DesfireFileType *File) {
+    if ((AppSlot == DESFIRE_PICC_APP_SLOT) || (FileNo >= DESFIRE_MAX_FILES) || (App.FileIndex[FileNo] == DESFIRE_NO_SLOT))
+        return DESFIRE_STATUS_FILE_NOT_FOUND;
+
+    DesfireFSReadFile(App.FileIndex[FileNo], File);
+
+    return DESFIRE_STATUS_OPERATION_OK;
+}
+
+/* Communication mode for an operation granted by any of the given rights, COMM_DENIED if none grants it.
+ * Being authenticated with one of the keys gives the mode of the file, free access is always plain. */
+static uint8_t AccessMode(const DesfireFileType *File, uint8_t Rights) {
+    bool Free = false;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        if (Rights & (1 << i)) {
+            uint8_t Access = (File->AccessRights >> (i * 4)) & 0x0F;
+
+            if ((AuthScheme != AUTH_NONE) && (Access == AuthKeyNo)) {
+                if ((File->CommSettings & COMM_ENCIPHERED) == COMM_ENCIPHERED)
+                    return COMM_ENCIPHERED;
+                else if (File->CommSettings & COMM_MACED)
+                    return COMM_MACED;
+                else
+                    return COMM_PLAIN;
+            }
+
+            Free |= (Access == ACCESS_FREE);
+        }
+    }
+
+    return Free ? COMM_PLAIN : COMM_DENIED;
+}
+
+static void TransactionBegin(uint8_t FileNo, const DesfireFileType *File) {
+    uint32_t FileBit = (uint32_t) 1 << FileNo;
+
+    if (TransactionFiles & FileBit)
+        return;
+
+    /* First change within the transaction, the working copy starts from the committed data */
+    if (File->Type == DESFIRE_FILE_BACKUP)
+        DesfireFSCopy(File->DataAddress + File->Size, File->DataAddress, File->Size);
+    else
+        DesfireFSCopy(File->DataAddress + DESFIRE_VALUE_WORKING, File->DataAddress + DESFIRE_VALUE_COMMITTED, VALUE_SIZE);
+
+    TransactionFiles |= FileBit;
+}
+
+static void TransactionCommit(void) {
+    DesfireFileType File;
+
+    for (uint8_t FileNo = 0; FileNo < DESFIRE_MAX_FILES; FileNo++) {
+        if ((TransactionFiles & ((uint32_t) 1 << FileNo)) && (GetFile(FileNo, &File) == DESFIRE_STATUS_OPERATION_OK)) {
+            if (File.Type == DESFIRE_FILE_BACKUP)
+                DesfireFSCopy(File.DataAddress, File.DataAddress + File.Size, File.Size);
+            else
+                DesfireFSCopy(File.DataAddress + DESFIRE_VALUE_COMMITTED, File.DataAddress + DESFIRE_VALUE_WORKING, VALUE_SIZE);
+        }
+    }
+
+    TransactionFiles = 0;
+}
+
+/* Outgoing data: ReadData and GetValue. Non-final frames of enciphered data hold whole blocks. */
+
+static void SendStart(uint8_t Mode, uint16_t Address, uint16_t ByteCount) {
+    Transfer.Mode = Mode;
+    Transfer.Address = Address;
+    Transfer.DataLeft = ByteCount;
+    Transfer.Crc32 = CRC32_INIT;
+    Transfer.Crc16 = CRC16_INIT;
+    memset(Transfer.IV, 0, sizeof(Transfer.IV));
+
+    if (Mode == COMM_ENCIPHERED) {
+        /* The data carries its own protection */
+        ResponseMacActive = false;
+    } else if ((Mode == COMM_MACED) && (AuthScheme == AUTH_LEGACY)) {
+        MacInit(&CommandMac, NULL);
+    }
+}
+
+static uint16_t SendFinalSize(void) {
+    if (Transfer.Mode == COMM_ENCIPHERED)
+        return PaddedSize(Transfer.DataLeft + ((AuthScheme == AUTH_AES) ? CRC32_SIZE : CRC16_SIZE));
+    else if (AuthScheme == AUTH_AES)
+        return Transfer.DataLeft + CMAC_SIZE;
+    else if (Transfer.Mode == COMM_MACED)
+        return Transfer.DataLeft + LEGACY_MAC_SIZE;
+    else
+        return Transfer.DataLeft;
+}
+
+static uint16_t SendFrame(uint8_t *Buffer, uint8_t Command) {
+    uint8_t *Data = &Buffer[1];
+    bool Final = (SendFinalSize() <= FRAME_DATA_SIZE);
+    uint16_t ByteCount;
+
+    if (Final)
+        ByteCount = Transfer.DataLeft;
+    else if (Transfer.Mode == COMM_ENCIPHERED)
+        ByteCount = MIN(ENCIPHERED_FRAME_DATA_SIZE, (Transfer.DataLeft - 1) & ~(BlockSize() - 1));
+    else
+        ByteCount = MIN(FRAME_DATA_SIZE, Transfer.DataLeft - 1);
+
+    if (Transfer.Address != 0) {
+        MemoryReadBlock(Data, Transfer.Address, ByteCount);
+        Transfer.Address += ByteCount;
+    } else {
+        memcpy(Data, Transfer.Value, ByteCount);
+    }
+
+    Transfer.DataLeft -= ByteCount;
+
+    if (Transfer.Mode == COMM_ENCIPHERED) {
+        Transfer.Crc32 = Crc32Update(Transfer.Crc32, Data, ByteCount);
+        Transfer.Crc16 = Crc16Update(Transfer.Crc16, Data, ByteCount);
+
+        if (Final) {
+            if (AuthScheme == AUTH_AES) {
+                /* The CRC covers the status as well */
+                static const uint8_t StatusOK = DESFIRE_STATUS_OPERATION_OK;
+                uint32_t Crc = Crc32Update(Transfer.Crc32, &StatusOK, 1);
+
+                memcpy(&Data[ByteCount], &Crc, CRC32_SIZE);
+                ByteCount += CRC32_SIZE;
+            } else {
+                memcpy(&Data[ByteCount], &Transfer.Crc16, CRC16_SIZE);
+                ByteCount += CRC16_SIZE;
+            }
+
+            while (ByteCount < PaddedSize(ByteCount))
+                Data[ByteCount++] = 0x00;
+        }
+
+        for (uint16_t i = 0; i < ByteCount; i += BlockSize())
+            EncryptSend(&Data[i], &Data[i], CipherIV());
+    } else if ((Transfer.Mode == COMM_MACED) && (AuthScheme == AUTH_LEGACY)) {
+        MacUpdate(&CommandMac, Data, ByteCount);
+
+        if (Final) {
+            MacFinal(&CommandMac);
+            memcpy(&Data[ByteCount], CommandMac.Chain, LEGACY_MAC_SIZE);
+            ByteCount += LEGACY_MAC_SIZE;
+        }
+    }
+
+    if (Final) {
+        Buffer[0] = DESFIRE_STATUS_OPERATION_OK;
+    } else {
+        Buffer[0] = DESFIRE_STATUS_ADDITIONAL_FRAME;
+        Transfer.Command = Command;
+    }
+
+    return ByteCount + 1;
+}
+
+/* Incoming data: WriteData, Credit and Debit. Data is stored as it arrives, the MAC or CRC is checked
+ * when the last frame is in. Like on the real card, standard files keep data that fails the check. */
+
+static void ReceiveStart(uint8_t Mode, const uint8_t *Header, uint8_t HeaderSize, uint16_t Address, uint16_t ByteCount) {
+    Transfer.Mode = Mode;
+    Transfer.Address = Address;
+    Transfer.DataLeft = ByteCount;
+    Transfer.TrailerFill = 0;
+    Transfer.BlockFill = 0;
+    memset(Transfer.IV, 0, sizeof(Transfer.IV));
+
+    if (Mode == COMM_ENCIPHERED) {
+        if (AuthScheme == AUTH_AES) {
+            Transfer.Crc32 = Crc32Update(CRC32_INIT, Header, HeaderSize);
+            Transfer.BytesLeft = PaddedSize(ByteCount + CRC32_SIZE);
+        } else {
+            Transfer.Crc16 = CRC16_INIT;
+            Transfer.BytesLeft = PaddedSize(ByteCount + CRC16_SIZE);
+        }
+    } else if (AuthScheme == AUTH_AES) {
+        /* Plain and MACed commands are CMACed including their header */
+        MacInit(&CommandMac, SessionIV);
+        MacUpdate(&CommandMac, Header, HeaderSize);
+        Transfer.BytesLeft = ByteCount + ((Mode == COMM_MACED) ? CMAC_SIZE : 0);
+    } else {
+        MacInit(&CommandMac, NULL);
+        Transfer.BytesLeft = ByteCount + ((Mode == COMM_MACED) ? LEGACY_MAC_SIZE : 0);
+    }
+}
+
+static void ReceivePlain(const uint8_t *Data, uint8_t ByteCount) {
+    uint8_t DataCount = MIN(ByteCount, Transfer.DataLeft);
+
+    if (Transfer.Address != 0) {
+        MemoryWriteBlock(Data, Transfer.Address, DataCount);
+        Transfer.Address += DataCount;
+    } else {
+        memcpy(&Transfer.Value[VALUE_SIZE - Transfer.DataLeft], Data, DataCount);
+    }
+
+    if (Transfer.Mode == COMM_ENCIPHERED) {
+        Transfer.Crc32 = Crc32Update(Transfer.Crc32, Data, DataCount);
+        Transfer.Crc16 = Crc16Update(Transfer.Crc16, Data, DataCount);
+    } else if ((AuthScheme == AUTH_AES) || (Transfer.Mode == COMM_MACED)) {
+        MacUpdate(&CommandMac, Data, DataCount);
+    }
+
+    Transfer.DataLeft -= DataCount;
+
+    /* What follows the data is the MAC or CRC, then padding */
+    for (uint8_t i = DataCount; i < ByteCount; i++) {
+        if (Transfer.TrailerFill < sizeof(Transfer.Trailer))
+            Transfer.Trailer[Transfer.TrailerFill++] = Data[i];
+    }
+}
+
+static void ReceiveBytes(const uint8_t *Data, uint16_t ByteCount) {
+    Transfer.BytesLeft -= ByteCount;
+
+    if (Transfer.Mode != COMM_ENCIPHERED) {
+        while (ByteCount > 0) {
+            uint8_t Chunk = MIN(ByteCount, FRAME_DATA_SIZE);
+
+            ReceivePlain(Data, Chunk);
+            Data += Chunk;
+            ByteCount -= Chunk;
+        }
+
+        return;
+    }
+
+    while (ByteCount--) {
+        Transfer.Block[Transfer.BlockFill++] = *Data++;
+
+        if (Transfer.BlockFill == BlockSize()) {
+            uint8_t Plaintext[CRYPTO_AES_BLOCK_SIZE];
+
+            DecryptReceive(Transfer.Block, Plaintext, CipherIV());
+            ReceivePlain(Plaintext, Transfer.BlockFill);
+            Transfer.BlockFill = 0;
+        }
+    }
+}
+
+static bool ReceiveVerify(void) {
+    if (Transfer.Mode == COMM_ENCIPHERED) {
+        if (AuthScheme == AUTH_AES)
+            return memcmp(Transfer.Trailer, &Transfer.Crc32, CRC32_SIZE) == 0;
+        else
+            return memcmp(Transfer.Trailer, &Transfer.Crc16, CRC16_SIZE) == 0;
+    }
+
+    if (AuthScheme == AUTH_AES) {
+        MacFinal(&CommandMac);
+        memcpy(SessionIV, CommandMac.Chain, sizeof(SessionIV));
+
+        return (Transfer.Mode != COMM_MACED) || (memcmp(Transfer.Trailer, CommandMac.Chain, CMAC_SIZE) == 0);
+    }
+
+    if (Transfer.Mode == COMM_MACED) {
+        MacFinal(&CommandMac);
+
+        return memcmp(Transfer.Trailer, CommandMac.Chain, LEGACY_MAC_SIZE) == 0;
+    }
+
+    return true;
+}
+
+static uint16_t ApplyValue(uint8_t *Buffer, uint8_t Command);
+
+static uint16_t ReceiveFrame(uint8_t *Buffer, const uint8_t *Data, uint16_t ByteCount, uint8_t Command) {
+    if (ByteCount > Transfer.BytesLeft)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+    ReceiveBytes(Data, ByteCount);
+
+    if (Transfer.BytesLeft > 0) {
+        Transfer.Command = Command;
+        return Status(Buffer, DESFIRE_STATUS_ADDITIONAL_FRAME);
+    }
+
+    if (!ReceiveVerify()) {
+        TransactionFiles = 0;
+        return Status(Buffer, DESFIRE_STATUS_INTEGRITY_ERROR);
+    }
+
+    if (Command != CMD_WRITE_DATA)
+        return ApplyValue(Buffer, Command);
+
+    return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+}
+
+/* Key management */
+
+static uint16_t CmdAuthenticate(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t KeyNo = Buffer[1];
+    uint8_t Scheme = (Buffer[0] == CMD_AUTHENTICATE_AES) ? AUTH_AES : AUTH_LEGACY;
+    uint8_t KeyType = (Scheme == AUTH_AES) ? DESFIRE_KEY_TYPE_AES : DESFIRE_KEY_TYPE_DES;
+    uint8_t Version;
+    uint8_t RndSize;
+
+    ResetAuthentication();
+    TransactionFiles = 0;
+    ResponseMacActive = false;
+
+    if (ByteCount != 2)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (KeyNo >= (App.KeyCount & DESFIRE_KEY_COUNT_MASK))
+        return Status(Buffer, DESFIRE_STATUS_NO_SUCH_KEY);
+    if ((App.KeyCount & DESFIRE_KEY_TYPE_MASK) != KeyType)
+        return Status(Buffer, DESFIRE_STATUS_AUTHENTICATION_ERROR);
+
+    DesfireFSReadKey(&App, KeyNo, Transfer.AuthKey, &Version);
+    Transfer.AuthScheme = Scheme;
+    Transfer.Index = KeyNo;
+    memset(Transfer.IV, 0, sizeof(Transfer.IV));
+
+    /* Send ek(RndB). With AES, the IV carries over to the following messages. */
+    if (Scheme == AUTH_AES) {
+        RndSize = CRYPTO_AES_BLOCK_SIZE;
+        RandomGetBuffer(Transfer.RndB, RndSize);
+        CryptoAESInitContext(&SessionContext, Transfer.AuthKey);
+        CryptoAESEncrypt_CBCSend(1, Transfer.RndB, &Buffer[1], Transfer.IV, &SessionContext);
+    } else {
+        RndSize = CRYPTO_DES_BLOCK_SIZE;
+        RandomGetBuffer(Transfer.RndB, RndSize);
+        CryptoEncrypt2KTDEA_CBCSend(1, Transfer.RndB, &Buffer[1], Transfer.IV, Transfer.AuthKey);
+    }
+
+    Transfer.Command = Buffer[0];
+    Buffer[0] = DESFIRE_STATUS_ADDITIONAL_FRAME;
+
+    return 1 + RndSize;
+}
+
+static uint16_t CmdAuthenticateContinue(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t RndSize = (Transfer.AuthScheme == AUTH_AES) ? CRYPTO_AES_BLOCK_SIZE : CRYPTO_DES_BLOCK_SIZE;
+    uint8_t RndA[CRYPTO_AES_BLOCK_SIZE];
+    uint8_t RndBRotated[CRYPTO_AES_BLOCK_SIZE];
+
+    if (ByteCount != 1 + 2 * RndSize)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+    /* Receive dk(RndA || RndB') */
+    if (Transfer.AuthScheme == AUTH_AES) {
+        CryptoAESDecrypt_CBCReceive(1, &Buffer[1], RndA, Transfer.IV, &SessionContext);
+        CryptoAESDecrypt_CBCReceive(1, &Buffer[1 + RndSize], RndBRotated, Transfer.IV, &SessionContext);
+    } else {
+        memset(Transfer.IV, 0, sizeof(Transfer.IV));
+        CryptoEncrypt2KTDEA_CBCReceive(1, &Buffer[1], RndA, Transfer.IV, Transfer.AuthKey);
+        CryptoEncrypt2KTDEA_CBCReceive(1, &Buffer[1 + RndSize], RndBRotated, Transfer.IV, Transfer.AuthKey);
+    }
+
+    for (uint8_t i = 0; i < RndSize; i++) {
+        if (RndBRotated[i] != Transfer.RndB[(i + 1) % RndSize])
+            return Status(Buffer, DESFIRE_STATUS_AUTHENTICATION_ERROR);
+    }
+
+    /* Send ek(RndA'), reusing RndBRotated */
+    for (uint8_t i = 0; i < RndSize; i++)
+        RndBRotated[i] = RndA[(i + 1) % RndSize];
+
+    if (Transfer.AuthScheme == AUTH_AES) {
+        CryptoAESEncrypt_CBCSend(1, RndBRotated, &Buffer[1], Transfer.IV, &SessionContext);
+
+        memcpy(&SessionKey[0], &RndA[0], 4);
+        memcpy(&SessionKey[4], &Transfer.RndB[0], 4);
+        memcpy(&SessionKey[8], &RndA[12], 4);
+        memcpy(&SessionKey[12], &Transfer.RndB[12], 4);
+        CryptoAESInitContext(&SessionContext, SessionKey);
+
+        memset(SessionIV, 0, sizeof(SessionIV));
+        CryptoAESEncryptBlock(&SessionContext, SessionIV, CMACSubkey2);
+        CMACSubkeyShift(CMACSubkey1, CMACSubkey2);
+        CMACSubkeyShift(CMACSubkey2, CMACSubkey1);
+    } else {
+        memset(Transfer.IV, 0, sizeof(Transfer.IV));
+        CryptoEncrypt2KTDEA_CBCSend(1, RndBRotated, &Buffer[1], Transfer.IV, Transfer.AuthKey);
+
+        memcpy(&SessionKey[0], &RndA[0], 4);
+        memcpy(&SessionKey[4], &Transfer.RndB[0], 4);
+
+        if (memcmp(&Transfer.AuthKey[0], &Transfer.AuthKey[CRYPTO_DES_KEY_SIZE], CRYPTO_DES_KEY_SIZE) == 0) {
+            /* Single DES */
+            memcpy(&SessionKey[8], &SessionKey[0], CRYPTO_DES_KEY_SIZE);
+        } else {
+            memcpy(&SessionKey[8], &RndA[4], 4);
+            memcpy(&SessionKey[12], &Transfer.RndB[4], 4);
+        }
+    }
+
+    AuthScheme = Transfer.AuthScheme;
+    AuthKeyNo = Transfer.Index;
+    Buffer[0] = DESFIRE_STATUS_OPERATION_OK;
+
+    return 1 + RndSize;
+}
+
+static uint16_t CmdGetKeySettings(uint8_t *Buffer, uint16_t ByteCount) {
+    if (ByteCount != 1)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (!(App.KeySettings & KEY_SETTING_FREE_LISTING) && !IsMasterAuthenticated())
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+
+    Buffer[0] = DESFIRE_STATUS_OPERATION_OK;
+    Buffer[1] = App.KeySettings;
+    Buffer[2] = App.KeyCount;
+
+    return 3;
+}
+
+static uint16_t CmdChangeKeySettings(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t *Plaintext = &Buffer[1];
+    uint8_t IntegrityOffset = 1;
+
+    ResponseMacActive = (AuthScheme == AUTH_AES);
+
+    if (!IsMasterAuthenticated())
+        return Status(Buffer, DESFIRE_STATUS_AUTHENTICATION_ERROR);
+    if (!(App.KeySettings & KEY_SETTING_CHANGE_SETTINGS))
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+    if (ByteCount != 1 + BlockSize())
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+    memset(Transfer.IV, 0, sizeof(Transfer.IV));
+    DecryptReceive(Plaintext, Plaintext, CipherIV());
+
+    if (AuthScheme == AUTH_AES) {
+        uint32_t Crc = Crc32Update(CRC32_INIT, Buffer, 1 + IntegrityOffset);
+
+        if (memcmp(&Plaintext[IntegrityOffset], &Crc, CRC32_SIZE) != 0)
+            return Status(Buffer, DESFIRE_STATUS_INTEGRITY_ERROR);
+    } else {
+        uint16_t Crc = Crc16Update(CRC16_INIT, Plaintext, IntegrityOffset);
+
+        if (memcmp(&Plaintext[IntegrityOffset], &Crc, CRC16_SIZE) != 0)
+            return Status(Buffer, DESFIRE_STATUS_INTEGRITY_ERROR);
+    }
+
+    App.KeySettings = Plaintext[0];
+    DesfireFSWriteApp(AppSlot, &App);
+
+    return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+}
+
+static uint16_t CmdChangeKey(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t KeyNo = Buffer[1] & DESFIRE_KEY_COUNT_MASK;
+    uint8_t KeyType = App.KeyCount & DESFIRE_KEY_TYPE_MASK;
+    uint8_t ChangeKeyAccess = App.KeySettings >> KEY_SETTING_CHANGE_KEY_SHIFT;
+    uint8_t *Plaintext = &Buffer[2];
+    uint8_t CryptogramSize = (AuthScheme == AUTH_AES) ? 2 * CRYPTO_AES_BLOCK_SIZE : 3 * CRYPTO_DES_BLOCK_SIZE;
+    uint8_t KeyDataSize;
+    uint8_t NewKey[DESFIRE_KEY_SIZE];
+    uint8_t Version = 0;
+
+    ResponseMacActive = (AuthScheme == AUTH_AES);
+
+    if (AuthScheme == AUTH_NONE)
+        return Status(Buffer, DESFIRE_STATUS_AUTHENTICATION_ERROR);
+    if (ByteCount != 2 + CryptogramSize)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (KeyNo >= (App.KeyCount & DESFIRE_KEY_COUNT_MASK))
+        return Status(Buffer, DESFIRE_STATUS_NO_SUCH_KEY);
+
+    if ((AppSlot == DESFIRE_PICC_APP_SLOT) || (KeyNo == 0)) {
+        if ((AuthKeyNo != 0) || !(App.KeySettings & KEY_SETTING_CHANGE_MASTER))
+            return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+    } else if ((ChangeKeyAccess == CHANGE_KEY_FROZEN) ||
+               ((ChangeKeyAccess == CHANGE_KEY_SAME_KEY) && (AuthKeyNo != KeyNo)) ||
+               ((ChangeKeyAccess < CHANGE_KEY_SAME_KEY) && (AuthKeyNo != ChangeKeyAccess))) {
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+    }
+
+    /* The PICC master key may change its type */
+    if (AppSlot == DESFIRE_PICC_APP_SLOT)
+        KeyType = Buffer[1] & DESFIRE_KEY_TYPE_MASK;
+
+    if ((KeyType != DESFIRE_KEY_TYPE_DES) && (KeyType != DESFIRE_KEY_TYPE_AES))
+        return Status(Buffer, DESFIRE_STATUS_PARAMETER_ERROR);
+
+    memset(Transfer.IV, 0, sizeof(Transfer.IV));
+    for (uint8_t i = 0; i < CryptogramSize; i += BlockSize())
+        DecryptReceive(&Plaintext[i], &Plaintext[i], CipherIV());
+
+    /* New key, AES keys followed by their version, then the CRC over the cryptogram as sent.
+     * When changing another key, it is sent XORed with the old one and a CRC of the new key follows. */
+    KeyDataSize = DESFIRE_KEY_SIZE + ((KeyType == DESFIRE_KEY_TYPE_AES) ? 1 : 0);
+
+    if (AuthScheme == AUTH_AES) {
+        uint32_t Crc = Crc32Update(CRC32_INIT, Buffer, 2 + KeyDataSize);
+
+        if (memcmp(&Plaintext[KeyDataSize], &Crc, CRC32_SIZE) != 0)
+            return Status(Buffer, DESFIRE_STATUS_INTEGRITY_ERROR);
+    } else {
+        uint16_t Crc = Crc16Update(CRC16_INIT, Plaintext, KeyDataSize);
+
+        if (memcmp(&Plaintext[KeyDataSize], &Crc, CRC16_SIZE) != 0)
+            return Status(Buffer, DESFIRE_STATUS_INTEGRITY_ERROR);
+    }
+
+    memcpy(NewKey, Plaintext, DESFIRE_KEY_SIZE);
+
+    if (KeyNo != AuthKeyNo) {
+        uint8_t OldKey[DESFIRE_KEY_SIZE];
+        uint8_t NewKeyCrcOffset = KeyDataSize + ((AuthScheme == AUTH_AES) ? CRC32_SIZE : CRC16_SIZE);
+
+        DesfireFSReadKey(&App, KeyNo, OldKey, &Version);
+
+        for (uint8_t i = 0; i < DESFIRE_KEY_SIZE; i++)
+            NewKey[i] ^= OldKey[i];
+
+        if (AuthScheme == AUTH_AES) {
+            uint32_t Crc = Crc32Update(CRC32_INIT, NewKey, DESFIRE_KEY_SIZE);
+
+            if (memcmp(&Plaintext[NewKeyCrcOffset], &Crc, CRC32_SIZE) != 0)
+                return Status(Buffer, DESFIRE_STATUS_INTEGRITY_ERROR);
+        } else {
+            uint16_t Crc = Crc16Update(CRC16_INIT, NewKey, DESFIRE_KEY_SIZE);
+
+            if (memcmp(&Plaintext[NewKeyCrcOffset], &Crc, CRC16_SIZE) != 0)
+                return Status(Buffer, DESFIRE_STATUS_INTEGRITY_ERROR);
+        }
+    }
+
+    if (KeyType == DESFIRE_KEY_TYPE_AES) {
+        Version = Plaintext[DESFIRE_KEY_SIZE];
+    } else {
+        /* DES keys carry their version in the parity bits */
+        Version = 0;
+        for (uint8_t i = 0; i < CRYPTO_DES_KEY_SIZE; i++)
+            Version |= (NewKey[i] & 0x01) << (7 - i);
+    }
+
+    DesfireFSWriteKey(&App, KeyNo, NewKey, Version);
+
+    if ((App.KeyCount & DESFIRE_KEY_TYPE_MASK) != KeyType) {
+        App.KeyCount = (App.KeyCount & DESFIRE_KEY_COUNT_MASK) | KeyType;
+        DesfireFSWriteApp(AppSlot, &App);
+    }
+
+    /* Changing the key in use ends the session, the response is not MACed */
+    if (KeyNo == AuthKeyNo)
+        ResetAuthentication();
+
+    return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+}
+
+static uint16_t CmdGetKeyVersion(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t KeyNo = Buffer[1] & DESFIRE_KEY_COUNT_MASK;
+    uint8_t Key[DESFIRE_KEY_SIZE];
+
+    if (ByteCount != 2)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (KeyNo >= (App.KeyCount & DESFIRE_KEY_COUNT_MASK))
+        return Status(Buffer, DESFIRE_STATUS_NO_SUCH_KEY);
+
+    DesfireFSReadKey(&App, KeyNo, Key, &Buffer[1]);
+    Buffer[0] = DESFIRE_STATUS_OPERATION_OK;
+
+    return 2;
+}
+
+/* PICC level */
+
+static uint16_t CmdGetVersionFrame(uint8_t *Buffer) {
+    uint8_t ByteCount = ISO14443A_UID_SIZE_DOUBLE;
+
+    if (Transfer.Index == VERSION_FRAME_COUNT - 1) {
+        DesfireFSGetUid(&Buffer[1]);
+        memcpy_P(&Buffer[1 + ISO14443A_UID_SIZE_DOUBLE], Version[Transfer.Index], ISO14443A_UID_SIZE_DOUBLE);
+        ByteCount += ISO14443A_UID_SIZE_DOUBLE;
+        Buffer[0] = DESFIRE_STATUS_OPERATION_OK;
+    } else {
+        memcpy_P(&Buffer[1], Version[Transfer.Index], ISO14443A_UID_SIZE_DOUBLE);
+        Buffer[0] = DESFIRE_STATUS_ADDITIONAL_FRAME;
+        Transfer.Command = CMD_GET_VERSION;
+    }
+
+    Transfer.Index++;
+
+    return 1 + ByteCount;
+}
+
+static uint16_t CmdGetApplicationIdsFrame(uint8_t *Buffer) {
+    uint8_t Count = 0;
+
+    for (; Transfer.Index < DESFIRE_APP_SLOTS; Transfer.Index++) {
+        uint8_t *Aid = &Buffer[1 + Count * DESFIRE_AID_SIZE];
+        DesfireAppType Entry;
+
+        DesfireFSReadApp(Transfer.Index, &Entry);
+
+        if ((Entry.Aid[0] | Entry.Aid[1] | Entry.Aid[2]) != 0) {
+            if (Count == APP_IDS_PER_FRAME) {
+                Transfer.Command = CMD_GET_APPLICATION_IDS;
+                Buffer[0] = DESFIRE_STATUS_ADDITIONAL_FRAME;
+                return 1 + Count * DESFIRE_AID_SIZE;
+            }
+
+            memcpy(Aid, Entry.Aid, DESFIRE_AID_SIZE);
+            Count++;
+        }
+    }
+
+    Buffer[0] = DESFIRE_STATUS_OPERATION_OK;
+
+    return 1 + Count * DESFIRE_AID_SIZE;
+}
+
+static uint16_t CmdGetApplicationIds(uint8_t *Buffer, uint16_t ByteCount) {
+    if (ByteCount != 1)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (AppSlot != DESFIRE_PICC_APP_SLOT)
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+    if (!(App.KeySettings & KEY_SETTING_FREE_LISTING) && !IsMasterAuthenticated())
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+
+    Transfer.Index = DESFIRE_PICC_APP_SLOT + 1;
+
+    return CmdGetApplicationIdsFrame(Buffer);
+}
+
+static uint16_t CmdCreateApplication(uint8_t *Buffer, uint16_t ByteCount) {
+    const uint8_t *Aid = &Buffer[1];
+    uint8_t KeySettings = Buffer[4];
+    uint8_t KeyCount = Buffer[5] & DESFIRE_KEY_COUNT_MASK;
+    uint8_t KeyType = Buffer[5] & DESFIRE_KEY_TYPE_MASK;
+
+    /* ISO file identifier and DF name may follow, they are not used */
+    if (ByteCount < 6)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (AppSlot != DESFIRE_PICC_APP_SLOT)
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+    if (!(App.KeySettings & KEY_SETTING_FREE_CREATE) && !IsMasterAuthenticated())
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+    if ((KeyCount == 0) || (KeyCount > DESFIRE_MAX_KEYS) || ((Aid[0] | Aid[1] | Aid[2]) == 0))
+        return Status(Buffer, DESFIRE_STATUS_PARAMETER_ERROR);
+    if ((KeyType != DESFIRE_KEY_TYPE_DES) && (KeyType != DESFIRE_KEY_TYPE_AES))
+        return Status(Buffer, DESFIRE_STATUS_PARAMETER_ERROR);
+    if (DesfireFSFindApp(Aid) != DESFIRE_NO_SLOT)
+        return Status(Buffer, DESFIRE_STATUS_DUPLICATE_ERROR);
+
+    return Status(Buffer, DesfireFSCreateApp(Aid, KeySettings, KeyCount | KeyType));
+}
+
+static uint16_t CmdDeleteApplication(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t Slot;
+
+    if (ByteCount != 1 + DESFIRE_AID_SIZE)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+    Slot = DesfireFSFindApp(&Buffer[1]);
+
+    if (Slot == DESFIRE_PICC_APP_SLOT)
+        return Status(Buffer, DESFIRE_STATUS_PARAMETER_ERROR);
+    if (Slot == DESFIRE_NO_SLOT)
+        return Status(Buffer, DESFIRE_STATUS_APP_NOT_FOUND);
+    /* Either the PICC master key or the master key of the application itself */
+    if (((AppSlot != DESFIRE_PICC_APP_SLOT) && (AppSlot != Slot)) || !IsMasterAuthenticated())
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+
+    DesfireFSDeleteApp(Slot);
+
+    if (AppSlot == Slot)
+        SelectApp(DESFIRE_PICC_APP_SLOT);
+
+    return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+}
+
+static uint16_t CmdSelectApplication(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t Slot;
+
+    if (ByteCount != 1 + DESFIRE_AID_SIZE)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+    Slot = DesfireFSFindApp(&Buffer[1]);
+
+    if (Slot == DESFIRE_NO_SLOT)
+        return Status(Buffer, DESFIRE_STATUS_APP_NOT_FOUND);
+
+    SelectApp(Slot);
+
+    return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+}
+
+static uint16_t CmdFormatPicc(uint8_t *Buffer, uint16_t ByteCount) {
+    if (ByteCount != 1)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if ((AppSlot != DESFIRE_PICC_APP_SLOT) || !IsMasterAuthenticated())
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+
+    DesfireFSFormat();
+    DesfireFSReadApp(DESFIRE_PICC_APP_SLOT, &App);
+
+    return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+}
+
+static uint16_t CmdGetFreeMemory(uint8_t *Buffer, uint16_t ByteCount) {
+    if (ByteCount != 1)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+    Buffer[0] = DESFIRE_STATUS_OPERATION_OK;
+    PutLE24(&Buffer[1], DesfireFSFreeMemory());
+
+    return 4;
+}
+
+/* Application level */
+
+static uint8_t CheckFileManagement(uint8_t KeySetting) {
+    if (AppSlot == DESFIRE_PICC_APP_SLOT)
+        return DESFIRE_STATUS_PERMISSION_DENIED;
+    if (!(App.KeySettings & KeySetting) && !IsMasterAuthenticated())
+        return DESFIRE_STATUS_PERMISSION_DENIED;
+
+    return DESFIRE_STATUS_OPERATION_OK;
+}
+
+static uint16_t CmdGetFileIds(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t Count = 0;
+    uint8_t Result = CheckFileManagement(KEY_SETTING_FREE_LISTING);
+
+    if (ByteCount != 1)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (Result != DESFIRE_STATUS_OPERATION_OK)
+        return Status(Buffer, Result);
+
+    for (uint8_t FileNo = 0; FileNo < DESFIRE_MAX_FILES; FileNo++) {
+        if (App.FileIndex[FileNo] != DESFIRE_NO_SLOT)
+            Buffer[1 + Count++] = FileNo;
+    }
+
+    Buffer[0] = DESFIRE_STATUS_OPERATION_OK;
+
+    return 1 + Count;
+}
+
+static uint16_t CmdGetFileSettings(uint8_t *Buffer, uint16_t ByteCount) {
+    DesfireFileType File;
+    uint8_t Result = CheckFileManagement(KEY_SETTING_FREE_LISTING);
+
+    if (ByteCount != 2)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (Result == DESFIRE_STATUS_OPERATION_OK)
+        Result = GetFile(Buffer[1], &File);
+    if (Result != DESFIRE_STATUS_OPERATION_OK)
+        return Status(Buffer, Result);
+
+    Buffer[0] = DESFIRE_STATUS_OPERATION_OK;
+    Buffer[1] = File.Type;
+    Buffer[2] = File.CommSettings;
+    memcpy(&Buffer[3], &File.AccessRights, sizeof(File.AccessRights));
+
+    if (File.Type == DESFIRE_FILE_VALUE) {
+        memcpy(&Buffer[5], &File.LowerLimit, VALUE_SIZE);
+        memcpy(&Buffer[9], &File.UpperLimit, VALUE_SIZE);
+        MemoryReadBlock(&Buffer[13], File.DataAddress + DESFIRE_VALUE_LIMITED_CREDIT, VALUE_SIZE + 1);
+        return 18;
+    }
+
+    PutLE24(&Buffer[5], File.Size);
+
+    return 8;
+}
+
+static uint16_t CmdCreateFile(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t FileNo = Buffer[1];
+    uint8_t Result = CheckFileManagement(KEY_SETTING_FREE_CREATE);
+    DesfireFileType File;
+    uint16_t DataSize;
+
+    if (Result != DESFIRE_STATUS_OPERATION_OK)
+        return Status(Buffer, Result);
+    if (FileNo >= DESFIRE_MAX_FILES)
+        return Status(Buffer, DESFIRE_STATUS_PARAMETER_ERROR);
+    if (App.FileIndex[FileNo] != DESFIRE_NO_SLOT)
+        return Status(Buffer, DESFIRE_STATUS_DUPLICATE_ERROR);
+
+    memset(&File, 0, sizeof(File));
+    File.CommSettings = Buffer[2];
+    File.AccessRights = GetLE16(&Buffer[3]);
+
+    if (Buffer[0] == CMD_CREATE_VALUE_FILE) {
+        int32_t Value;
+
+        if (ByteCount != 18)
+            return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+        File.Type = DESFIRE_FILE_VALUE;
+        memcpy(&File.LowerLimit, &Buffer[5], VALUE_SIZE);
+        memcpy(&File.UpperLimit, &Buffer[9], VALUE_SIZE);
+        memcpy(&Value, &Buffer[13], VALUE_SIZE);
+
+        if ((File.LowerLimit > File.UpperLimit) || (Value < File.LowerLimit) || (Value > File.UpperLimit))
+            return Status(Buffer, DESFIRE_STATUS_BOUNDARY_ERROR);
+
+        Result = DesfireFSCreateFile(AppSlot, &App, FileNo, &File, DESFIRE_VALUE_DATA_SIZE);
+
+        if (Result == DESFIRE_STATUS_OPERATION_OK) {
+            MemoryWriteBlock(&Value, File.DataAddress + DESFIRE_VALUE_COMMITTED, VALUE_SIZE);
+            MemoryWriteBlock(&Value, File.DataAddress + DESFIRE_VALUE_WORKING, VALUE_SIZE);
+            MemoryWriteBlock(&Buffer[17], File.DataAddress + DESFIRE_VALUE_LIMITED_ENABLED, 1);
+        }
+
+        return Status(Buffer, Result);
+    }
+
+    if (ByteCount != FILE_HEADER_SIZE)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (GetLE24(&Buffer[5]) > MIFARE_DESFIRE_MEM_SIZE)
+        return Status(Buffer, DESFIRE_STATUS_OUT_OF_EEPROM);
+
+    File.Size = GetLE24(&Buffer[5]);
+
+    if (Buffer[0] == CMD_CREATE_BACKUP_DATA_FILE) {
+        File.Type = DESFIRE_FILE_BACKUP;
+        DataSize = 2 * File.Size;
+    } else {
+        File.Type = DESFIRE_FILE_STANDARD;
+        DataSize = File.Size;
+    }
+
+    return Status(Buffer, DesfireFSCreateFile(AppSlot, &App, FileNo, &File, DataSize));
+}
+
+static uint16_t CmdDeleteFile(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t FileNo = Buffer[1];
+    uint8_t Result = CheckFileManagement(KEY_SETTING_FREE_CREATE);
+    DesfireFileType File;
+
+    if (ByteCount != 2)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+    if (Result == DESFIRE_STATUS_OPERATION_OK)
+        Result = GetFile(FileNo, &File);
+    if (Result != DESFIRE_STATUS_OPERATION_OK)
+        return Status(Buffer, Result);
+
+    DesfireFSDeleteFile(AppSlot, &App, FileNo);
+    TransactionFiles &= ~((uint32_t) 1 << FileNo);
+
+    return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+}
+
+/* Data and value files */
+
+static uint16_t CmdReadWriteData(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t FileNo = Buffer[1];
+    uint32_t Offset = GetLE24(&Buffer[2]);
+    uint32_t Length = GetLE24(&Buffer[5]);
+    bool Write = (Buffer[0] == CMD_WRITE_DATA);
+    DesfireFileType File;
+    uint8_t Result;
+    uint8_t Mode;
+
+    if ((Write && (ByteCount < FILE_HEADER_SIZE)) || (!Write && (ByteCount != FILE_HEADER_SIZE)))
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+    Result = GetFile(FileNo, &File);
+
+    if (Result != DESFIRE_STATUS_OPERATION_OK)
+        return Status(Buffer, Result);
+    if ((File.Type != DESFIRE_FILE_STANDARD) && (File.Type != DESFIRE_FILE_BACKUP))
+        return Status(Buffer, DESFIRE_STATUS_PARAMETER_ERROR);
+
+    Mode = AccessMode(&File, (Write ? RIGHT_WRITE : RIGHT_READ) | RIGHT_READ_WRITE);
+
+    if (Mode == COMM_DENIED)
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+
+    /* Reading length 0 means up to the end of the file */
+    if (!Write && (Length == 0) && (Offset <= File.Size))
+        Length = File.Size - Offset;
+
+    if ((Offset > File.Size) || (Length > File.Size - Offset))
+        return Status(Buffer, DESFIRE_STATUS_BOUNDARY_ERROR);
+    if (Write && (Length == 0))
+        return Status(Buffer, DESFIRE_STATUS_PARAMETER_ERROR);
+
+    if (!Write) {
+        /* Backup files read the committed data */
+        SendStart(Mode, File.DataAddress + Offset, Length);
+        return SendFrame(Buffer, CMD_READ_DATA);
+    }
+
+    if (File.Type == DESFIRE_FILE_BACKUP) {
+        TransactionBegin(FileNo, &File);
+        Offset += File.Size;
+    }
+
+    ReceiveStart(Mode, Buffer, FILE_HEADER_SIZE, File.DataAddress + Offset, Length);
+
+    return ReceiveFrame(Buffer, &Buffer[FILE_HEADER_SIZE], ByteCount - FILE_HEADER_SIZE, CMD_WRITE_DATA);
+}
+
+static uint16_t CmdValue(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t Command = Buffer[0];
+    uint8_t FileNo = Buffer[1];
+    DesfireFileType File;
+    uint8_t Result;
+    uint8_t Rights;
+    uint8_t Mode;
+
+    if (ByteCount < VALUE_HEADER_SIZE)
+        return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+    Result = GetFile(FileNo, &File);
+
+    if (Result != DESFIRE_STATUS_OPERATION_OK)
+        return Status(Buffer, Result);
+    if (File.Type != DESFIRE_FILE_VALUE)
+        return Status(Buffer, DESFIRE_STATUS_PARAMETER_ERROR);
+
+    if (Command == CMD_GET_VALUE)
+        Rights = RIGHT_READ | RIGHT_WRITE | RIGHT_READ_WRITE;
+    else if (Command == CMD_DEBIT)
+        Rights = RIGHT_READ | RIGHT_READ_WRITE;
+    else
+        Rights = RIGHT_READ_WRITE;
+
+    Mode = AccessMode(&File, Rights);
+
+    if (Mode == COMM_DENIED)
+        return Status(Buffer, DESFIRE_STATUS_PERMISSION_DENIED);
+
+    Transfer.FileNo = FileNo;
+
+    if (Command == CMD_GET_VALUE) {
+        if (ByteCount != VALUE_HEADER_SIZE)
+            return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+
+        MemoryReadBlock(Transfer.Value, File.DataAddress + DESFIRE_VALUE_COMMITTED, VALUE_SIZE);
+        SendStart(Mode, 0, VALUE_SIZE);
+
+        return SendFrame(Buffer, CMD_GET_VALUE);
+    }
+
+    ReceiveStart(Mode, Buffer, VALUE_HEADER_SIZE, 0, VALUE_SIZE);
+
+    return ReceiveFrame(Buffer, &Buffer[VALUE_HEADER_SIZE], ByteCount - VALUE_HEADER_SIZE, Command);
+}
+
+/* Credit or debit the received amount to the working value */
+static uint16_t ApplyValue(uint8_t *Buffer, uint8_t Command) {
+    DesfireFileType File;
+    int32_t Amount;
+    int32_t Value;
+    int64_t Result;
+
+    memcpy(&Amount, Transfer.Value, VALUE_SIZE);
+
+    if ((Amount < 0) || (GetFile(Transfer.FileNo, &File) != DESFIRE_STATUS_OPERATION_OK))
+        return Status(Buffer, DESFIRE_STATUS_PARAMETER_ERROR);
+
+    TransactionBegin(Transfer.FileNo, &File);
+    MemoryReadBlock(&Value, File.DataAddress + DESFIRE_VALUE_WORKING, VALUE_SIZE);
+
+    Result = (Command == CMD_CREDIT) ? (int64_t) Value + Amount : (int64_t) Value - Amount;
+
+    if ((Result < File.LowerLimit) || (Result > File.UpperLimit))
+        return Status(Buffer, DESFIRE_STATUS_BOUNDARY_ERROR);
+
+    Value = Result;
+    MemoryWriteBlock(&Value, File.DataAddress + DESFIRE_VALUE_WORKING, VALUE_SIZE);
+
+    return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+}
+
+/* Command dispatch */
+
+static uint16_t ExecuteCommand(uint8_t *Buffer, uint16_t ByteCount) {
+    switch (Buffer[0]) {
+        case CMD_AUTHENTICATE:
+        case CMD_AUTHENTICATE_AES:
+            return CmdAuthenticate(Buffer, ByteCount);
+        case CMD_CHANGE_KEY_SETTINGS:
+            return CmdChangeKeySettings(Buffer, ByteCount);
+        case CMD_GET_KEY_SETTINGS:
+            return CmdGetKeySettings(Buffer, ByteCount);
+        case CMD_CHANGE_KEY:
+            return CmdChangeKey(Buffer, ByteCount);
+        case CMD_GET_KEY_VERSION:
+            return CmdGetKeyVersion(Buffer, ByteCount);
+        case CMD_CREATE_APPLICATION:
+            return CmdCreateApplication(Buffer, ByteCount);
+        case CMD_DELETE_APPLICATION:
+            return CmdDeleteApplication(Buffer, ByteCount);
+        case CMD_GET_APPLICATION_IDS:
+            return CmdGetApplicationIds(Buffer, ByteCount);
+        case CMD_SELECT_APPLICATION:
+            return CmdSelectApplication(Buffer, ByteCount);
+        case CMD_FORMAT_PICC:
+            return CmdFormatPicc(Buffer, ByteCount);
+        case CMD_GET_VERSION:
+            if (ByteCount != 1)
+                return Status(Buffer, DESFIRE_STATUS_LENGTH_ERROR);
+            Transfer.Index = 0;
+            return CmdGetVersionFrame(Buffer);
+        case CMD_GET_FREE_MEMORY:
+            return CmdGetFreeMemory(Buffer, ByteCount);
+        case CMD_GET_FILE_IDS:
+            return CmdGetFileIds(Buffer, ByteCount);
+        case CMD_GET_FILE_SETTINGS:
+            return CmdGetFileSettings(Buffer, ByteCount);
+        case CMD_CREATE_STD_DATA_FILE:
+        case CMD_CREATE_BACKUP_DATA_FILE:
+        case CMD_CREATE_VALUE_FILE:
+            return CmdCreateFile(Buffer, ByteCount);
+        case CMD_DELETE_FILE:
+            return CmdDeleteFile(Buffer, ByteCount);
+        case CMD_READ_DATA:
+        case CMD_WRITE_DATA:
+            return CmdReadWriteData(Buffer, ByteCount);
+        case CMD_GET_VALUE:
+        case CMD_CREDIT:
+        case CMD_DEBIT:
+            return CmdValue(Buffer, ByteCount);
+        case CMD_COMMIT_TRANSACTION:
+            TransactionCommit();
+            return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+        case CMD_ABORT_TRANSACTION:
+            /* Working copies are refreshed by the next change */
+            TransactionFiles = 0;
+            return Status(Buffer, DESFIRE_STATUS_OPERATION_OK);
+        default:
+            return Status(Buffer, DESFIRE_STATUS_ILLEGAL_COMMAND);
+    }
+}
+
+static uint16_t ContinueCommand(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t Command = Transfer.Command;
+
+    Transfer.Command = CMD_NONE;
+
+    switch (Command) {
+        case CMD_AUTHENTICATE:
+        case CMD_AUTHENTICATE_AES:
+            return CmdAuthenticateContinue(Buffer, ByteCount);
+        case CMD_GET_VERSION:
+            return CmdGetVersionFrame(Buffer);
+        case CMD_GET_APPLICATION_IDS:
+            return CmdGetApplicationIdsFrame(Buffer);
+        case CMD_READ_DATA:
+        case CMD_GET_VALUE:
+            return SendFrame(Buffer, Command);
+        case CMD_WRITE_DATA:
+        case CMD_CREDIT:
+        case CMD_DEBIT:
+            Transfer.Command = Command;
+            return ReceiveFrame(Buffer, &Buffer[1], ByteCount - 1, Command);
+        default:
+            return Status(Buffer, DESFIRE_STATUS_ILLEGAL_COMMAND);
+    }
+}
+
+/* Commands that are CMACed as a whole before execution. The others carry their own
+ * protection or are CMACed by the receiving functions, including their data. */
+static bool IsCMACedCommand(uint8_t Command) {
+    switch (Command) {
+        case CMD_AUTHENTICATE:
+        case CMD_AUTHENTICATE_AES:
+        case CMD_CHANGE_KEY_SETTINGS:
+        case CMD_CHANGE_KEY:
+        case CMD_WRITE_DATA:
+        case CMD_CREDIT:
+        case CMD_DEBIT:
+            return false;
+        default:
+            return true;
+    }
+}
+
+/* Processes a native command in place, the response starts with the status */
+static uint16_t ProcessNative(uint8_t *Buffer, uint16_t ByteCount) {
+    uint16_t ResponseCount;
+    uint8_t Status;
+
+    if (Buffer[0] == CMD_ADDITIONAL_FRAME) {
+        ResponseCount = ContinueCommand(Buffer, ByteCount);
+    } else {
+        Transfer.Command = CMD_NONE;
+        ResponseMacActive = (AuthScheme == AUTH_AES);
+        ResponseMacStarted = false;
+
+        if (ResponseMacActive && IsCMACedCommand(Buffer[0])) {
+            MacInit(&CommandMac, SessionIV);
+            MacUpdate(&CommandMac, Buffer, ByteCount);
+            MacFinal(&CommandMac);
+            memcpy(SessionIV, CommandMac.Chain, sizeof(SessionIV));
+        }
+
+        ResponseCount = ExecuteCommand(Buffer, ByteCount);
+    }
+
+    Status = Buffer[0];
+
+    if ((Status != DESFIRE_STATUS_OPERATION_OK) && (Status != DESFIRE_STATUS_ADDITIONAL_FRAME)) {
+        /* Errors end the session */
+        ResetAuthentication();
+        Transfer.Command = CMD_NONE;
+        return 1;
+    }
+
+    /* The response CMAC covers the data of all frames and the final status */
+    if ((AuthScheme == AUTH_AES) && ResponseMacActive && ((ResponseCount > 1) || (Status == DESFIRE_STATUS_OPERATION_OK))) {
+        if (!ResponseMacStarted) {
+            MacInit(&ResponseMac, SessionIV);
+            ResponseMacStarted = true;
+        }
+
+        MacUpdate(&ResponseMac, &Buffer[1], ResponseCount - 1);
+
+        if (Status == DESFIRE_STATUS_OPERATION_OK) {
+            MacUpdate(&ResponseMac, &Status, 1);
+            MacFinal(&ResponseMac);
+            memcpy(SessionIV, ResponseMac.Chain, sizeof(SessionIV));
+            memcpy(&Buffer[ResponseCount], ResponseMac.Chain, CMAC_SIZE);
+            ResponseCount += CMAC_SIZE;
+        }
+    }
+
+    return ResponseCount;
+}
+
+/* Processes an APDU received by ISO14443-4: a native command or one wrapped in an ISO7816 APDU */
+static uint16_t ProcessApdu(uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t *Native;
+    uint16_t NativeCount;
+    uint16_t ResponseCount;
+    uint8_t Status;
+
+    if ((ByteCount < 4) || (Buffer[0] != WRAPPED_CLA)) {
+        /* Not wrapped */
+        if (Buffer[0] != WRAPPED_CLA)
+            return ProcessNative(Buffer, ByteCount);
+
+        Buffer[0] = (ISO7816_SW_WRONG_LENGTH >> 8) & 0xFF;
+        Buffer[1] = (ISO7816_SW_WRONG_LENGTH >> 0) & 0xFF;
+        return 2;
+    }
+
+    if (ByteCount <= 5) {
+        /* No data, Le may follow */
+        Native = &Buffer[3];
+        NativeCount = 1;
+    } else if (ByteCount >= 5 + Buffer[4]) {
+        Native = &Buffer[4];
+        NativeCount = 1 + Buffer[4];
+    } else {
+        Buffer[0] = (ISO7816_SW_WRONG_LENGTH >> 8) & 0xFF;
+        Buffer[1] = (ISO7816_SW_WRONG_LENGTH >> 0) & 0xFF;
+        return 2;
+    }
+
+    Native[0] = Buffer[1];
+    ResponseCount = ProcessNative(Native, NativeCount);
+
+    /* Status first becomes SW1 SW2 last */
+    Status = Native[0];
+    memmove(Buffer, &Native[1], ResponseCount - 1);
+    Buffer[ResponseCount - 1] = WRAPPED_SW1;
+    Buffer[ResponseCount] = Status;
+
+    return ResponseCount + 1;
+}
+
+/* Commands clearing or copying larger parts of the card memory ask for more time */
+static uint8_t WaitingTime(const uint8_t *Buffer, uint16_t ByteCount) {
+    uint8_t Command = (Buffer[0] == WRAPPED_CLA) ? Buffer[1] : Buffer[0];
+
+    switch (Command) {
+        case CMD_FORMAT_PICC:
+        case CMD_CREATE_STD_DATA_FILE:
+        case CMD_CREATE_BACKUP_DATA_FILE:
+        case CMD_COMMIT_TRANSACTION:
+            return PROTOCOL_WTXM;
+        default:
+            return 0;
+    }
+}
+
+static const ISO14443_4ConfigType PROGMEM ProtocolConfig = {
+    .ApduFunc = ProcessApdu,
+    .WaitingTimeFunc = WaitingTime,
+    .Fwi = PROTOCOL_FWI,
+    .Sfgi = PROTOCOL_SFGI,
+    .HistoricalSize = 1,
+    .Historical = { 0x80 }
+};
+
+void MifareDesfireAppInit(void) {
+    DesfireFSInit();
+    ISO14443_4Init(&ProtocolConfig);
+    MifareDesfireAppReset();
+}
+
+void MifareDesfireAppReset(void) {
+    State = STATE_IDLE;
+    Transfer.Command = CMD_NONE;
+    SelectApp(DESFIRE_PICC_APP_SLOT);
+    ISO14443_4Reset();
+}
+
+void MifareDesfireAppTask(void) {
+
+}
+
+uint16_t MifareDesfireAppProcess(uint8_t *Buffer, uint16_t BitCount) {
+    uint8_t Cmd = Buffer[0];
+    uint16_t ByteCount;
+
+    switch (State) {
+        case STATE_IDLE:
+        case STATE_HALT:
+            FromHalt = State == STATE_HALT;
+            if (ISO14443AWakeUp(Buffer, &BitCount, ATQA_VALUE, FromHalt)) {
+                State = STATE_READY1;
+                return BitCount;
+            }
+            break;
+
+        case STATE_READY1:
+            if (ISO14443AWakeUp(Buffer, &BitCount, ATQA_VALUE, FromHalt)) {
+                State = FromHalt ? STATE_HALT : STATE_IDLE;
+                return ISO14443A_APP_NO_RESPONSE;
+            } else if (Cmd == ISO14443A_CMD_SELECT_CL1) {
+                /* Double size UID, CL1 starts with the cascade tag */
+                uint8_t Uid[MIFARE_DESFIRE_UID_SIZE];
+                uint8_t UidCL1[ISO14443A_CL_UID_SIZE] = { [0] = ISO14443A_UID0_CT };
+
+                DesfireFSGetUid(Uid);
+                memcpy(&UidCL1[1], Uid, ISO14443A_CL_UID_SIZE - 1);
+
+                if (ISO14443ASelect(Buffer, &BitCount, UidCL1, SAK_CL1_VALUE))
+                    State = STATE_READY2;
+
+                return BitCount;
+            } else {
+                State = STATE_IDLE;
+            }
+            break;
+
+        case STATE_READY2:
+            if (ISO14443AWakeUp(Buffer, &BitCount, ATQA_VALUE, FromHalt)) {
+                State = FromHalt ? STATE_HALT : STATE_IDLE;
+                return ISO14443A_APP_NO_RESPONSE;
+            } else if (Cmd == ISO14443A_CMD_SELECT_CL2) {
+                uint8_t Uid[MIFARE_DESFIRE_UID_SIZE];
+
+                DesfireFSGetUid(Uid);
+
+                if (ISO14443ASelect(Buffer, &BitCount, &Uid[ISO14443A_CL_UID_SIZE - 1], SAK_CL2_VALUE))
+                    State = STATE_ACTIVE;
+
+                return BitCount;
+            } else {
+                State = STATE_IDLE;
+            }
+            break;
+
+        case STATE_ACTIVE:
+        case STATE_PROTOCOL:
+            ByteCount = (BitCount + 7) >> 3;
+
+            if (ISO14443AWakeUp(Buffer, &BitCount, ATQA_VALUE, FromHalt)) {
+                MifareDesfireAppReset();
+                State = STATE_READY1;
+                return BitCount;
+            }
+
+            /* Corrupted frames are not answered, the reader retries */
+            if ((ByteCount < 1 + ISO14443A_CRCA_SIZE) || !ISO14443ACheckCRCA(Buffer, ByteCount - ISO14443A_CRCA_SIZE))
+                return ISO14443A_APP_NO_RESPONSE;
+
+            ByteCount -= ISO14443A_CRCA_SIZE;
+
+            if (State == STATE_ACTIVE) {
+                if ((Cmd == ISO14443A_CMD_HLTA) && (Buffer[1] == 0x00)) {
+                    State = STATE_HALT;
+                    return ISO14443A_APP_NO_RESPONSE;
+                } else if (Cmd == ISO14443_4_CMD_RATS) {
+                    ByteCount = ISO14443_4Activate(Buffer, ByteCount);
+                    State = STATE_PROTOCOL;
+                } else {
+                    State = STATE_IDLE;
+                    return ISO14443A_APP_NO_RESPONSE;
+                }
+            } else {
+                ByteCount = ISO14443_4Process(Buffer, ByteCount);
+
+                if (ISO14443_4IsDeselected())
+                    State = STATE_HALT;
+            }
+
+            if (ByteCount == 0)
+                return ISO14443A_APP_NO_RESPONSE;
+
+            ISO14443AAppendCRCA(Buffer, ByteCount);
+            return (ByteCount + ISO14443A_CRCA_SIZE) * BITS_PER_BYTE;
+
+        default:
+            break;
+    }
+
+    return ISO14443A_APP_NO_RESPONSE;
+}
+
+void MifareDesfireGetUid(ConfigurationUidType Uid) {
+    DesfireFSGetUid(Uid);
+}
+
+void MifareDesfireSetUid(ConfigurationUidType Uid) {
+    DesfireFSSetUid(Uid);
+}
@@ -0,0 +1,44 @@
+/*
+ * MifareDESFire.h
+ *
+ *  MIFARE DESFire EV1 emulation
+ */
+
+#ifndef MIFAREDESFIRE_H_
+#define MIFAREDESFIRE_H_
+
+#include "Application.h"
+#include "ISO14443-3A.h"
+
+#define MIFARE_DESFIRE_UID_SIZE     ISO14443A_UID_SIZE_DOUBLE
+#define MIFARE_DESFIRE_MEM_SIZE     8192 /* Card image, see MifareDESFireFS.h */
+
+/* Status codes, sent as the first byte of every native response */
+#define DESFIRE_STATUS_OPERATION_OK         0x00
+#define DESFIRE_STATUS_NO_CHANGES           0x0C
+#define DESFIRE_STATUS_OUT_OF_EEPROM        0x0E
+#define DESFIRE_STATUS_ILLEGAL_COMMAND      0x1C
+#define DESFIRE_STATUS_INTEGRITY_ERROR      0x1E
+#define DESFIRE_STATUS_NO_SUCH_KEY          0x40
+#define DESFIRE_STATUS_LENGTH_ERROR         0x7E
+#define DESFIRE_STATUS_PERMISSION_DENIED    0x9D
+#define DESFIRE_STATUS_PARAMETER_ERROR      0x9E
+#define DESFIRE_STATUS_APP_NOT_FOUND        0xA0
+#define DESFIRE_STATUS_AUTHENTICATION_ERROR 0xAE
+#define DESFIRE_STATUS_ADDITIONAL_FRAME     0xAF
+#define DESFIRE_STATUS_BOUNDARY_ERROR       0xBE
+#define DESFIRE_STATUS_COMMAND_ABORTED      0xCA
+#define DESFIRE_STATUS_COUNT_ERROR          0xCE
+#define DESFIRE_STATUS_DUPLICATE_ERROR      0xDE
+#define DESFIRE_STATUS_FILE_NOT_FOUND       0xF0
+
+void MifareDesfireAppInit(void);
+void MifareDesfireAppReset(void);
+void MifareDesfireAppTask(void);
+
+uint16_t MifareDesfireAppProcess(uint8_t *Buffer, uint16_t BitCount);
+
+void MifareDesfireGetUid(ConfigurationUidType Uid);
+void MifareDesfireSetUid(ConfigurationUidType Uid);
+
+#endif /* MIFAREDESFIRE_H_ */
@@ -0,0 +1,265 @@
+/*
+ * MifareDESFireFS.c
+ *
+ *  Application and file directory of the DESFire emulation, see MifareDESFireFS.h
+ */
+
+#include "MifareDESFireFS.h"
+#include "MifareDESFire.h"
+#include "../Memory.h"
+#include <string.h>
+
+#define PICC_UID_ADDRESS        0x0000
+#define PICC_MARKER_ADDRESS     0x0008
+#define PICC_FREE_ADDRESS       0x000C
+#define APP_DIR_ADDRESS         0x0020
+#define FILE_TABLE_ADDRESS      (APP_DIR_ADDRESS + DESFIRE_APP_SLOTS * sizeof(DesfireAppType))
+#define DATA_ADDRESS            (FILE_TABLE_ADDRESS + DESFIRE_FILE_SLOTS * sizeof(DesfireFileType))
+
+/* The PICC master key is the first record of the data area */
+#define PICC_KEY_ADDRESS        DATA_ADDRESS
+
+#define APP_ADDRESS(Slot)       (APP_DIR_ADDRESS + (uint16_t) (Slot) * sizeof(DesfireAppType))
+#define FILE_ADDRESS(Slot)      (FILE_TABLE_ADDRESS + (uint16_t) (Slot) * sizeof(DesfireFileType))
+
+#define CHUNK_SIZE              32
+
+static const uint8_t PROGMEM FormatMarker[] = { 'D', 'F', 'S', 0x01 };
+
+static void ClearBlock(uint16_t Address, uint16_t ByteCount) {
+    uint8_t Zeros[CHUNK_SIZE] = { 0 };
+
+    while (ByteCount > 0) {
+        uint16_t Chunk = MIN(ByteCount, CHUNK_SIZE);
+
+        MemoryWriteBlock(Zeros, Address, Chunk);
+        Address += Chunk;
+        ByteCount -= Chunk;
+    }
+}
+
+/* Returns the address of ByteCount cleared bytes, 0 if the card is full */
+static uint16_t Allocate(uint16_t ByteCount) {
+    uint16_t Address;
+    uint16_t NextAddress;
+
+    MemoryReadBlock(&Address, PICC_FREE_ADDRESS, sizeof(Address));
+
+    if (ByteCount > MIFARE_DESFIRE_MEM_SIZE - Address)
+        return 0;
+
+    NextAddress = Address + ByteCount;
+    MemoryWriteBlock(&NextAddress, PICC_FREE_ADDRESS, sizeof(NextAddress));
+    ClearBlock(Address, ByteCount);
+
+    return Address;
+}
+
+static void InitApp(DesfireAppType *App) {
+    memset(App, 0, sizeof(DesfireAppType));
+    memset(App->FileIndex, DESFIRE_NO_SLOT, sizeof(App->FileIndex));
+}
+
+void DesfireFSInit(void) {
+    uint8_t Marker[sizeof(FormatMarker)];
+
+    MemoryReadBlock(Marker, PICC_MARKER_ADDRESS, sizeof(Marker));
+
+    if (memcmp_P(Marker, FormatMarker, sizeof(Marker)) != 0) {
+        /* Blank or foreign memory, start with a factory fresh card */
+        DesfireFSFactoryReset();
+    }
+}
+
+void DesfireFSFactoryReset(void) {
+    uint8_t Marker[sizeof(FormatMarker)];
+    DesfireAppType App;
+
+    InitApp(&App);
+    App.KeySettings = DESFIRE_PICC_KEY_SETTINGS;
+    App.KeyCount = 1 | DESFIRE_KEY_TYPE_DES;
+    App.KeyAddress = PICC_KEY_ADDRESS;
+    DesfireFSWriteApp(DESFIRE_PICC_APP_SLOT, &App);
+
+    /* Default PICC master key is an all zero DES key, version 0 */
+    ClearBlock(PICC_KEY_ADDRESS, DESFIRE_KEY_RECORD_SIZE);
+
+    DesfireFSFormat();
+
+    memcpy_P(Marker, FormatMarker, sizeof(Marker));
+    MemoryWriteBlock(Marker, PICC_MARKER_ADDRESS, sizeof(Marker));
+}
+
+void DesfireFSFormat(void) {
+    DesfireAppType App;
+    DesfireFileType File;
+    uint16_t FreeAddress = PICC_KEY_ADDRESS + DESFIRE_KEY_RECORD_SIZE;
+
+    /* The PICC level keeps its key and key settings */
+    DesfireFSReadApp(DESFIRE_PICC_APP_SLOT, &App);
+    memset(App.FileIndex, DESFIRE_NO_SLOT, sizeof(App.FileIndex));
+    DesfireFSWriteApp(DESFIRE_PICC_APP_SLOT, &App);
+
+    InitApp(&App);
+    for (uint8_t Slot = DESFIRE_PICC_APP_SLOT + 1; Slot < DESFIRE_APP_SLOTS; Slot++)
+        DesfireFSWriteApp(Slot, &App);
+
+    memset(&File, 0, sizeof(File));
+    File.Type = DESFIRE_FILE_UNUSED;
+    for (uint8_t Slot = 0; Slot < DESFIRE_FILE_SLOTS; Slot++)
+        MemoryWriteBlock(&File, FILE_ADDRESS(Slot), sizeof(File));
+
+    MemoryWriteBlock(&FreeAddress, PICC_FREE_ADDRESS, sizeof(FreeAddress));
+}
+
+void DesfireFSGetUid(uint8_t *Uid) {
+    MemoryReadBlock(Uid, PICC_UID_ADDRESS, ISO14443A_UID_SIZE_DOUBLE);
+}
+
+void DesfireFSSetUid(const uint8_t *Uid) {
+    MemoryWriteBlock(Uid, PICC_UID_ADDRESS, ISO14443A_UID_SIZE_DOUBLE);
+}
+
+uint16_t DesfireFSFreeMemory(void) {
+    uint16_t Address;
+
+    MemoryReadBlock(&Address, PICC_FREE_ADDRESS, sizeof(Address));
+
+    return MIFARE_DESFIRE_MEM_SIZE - Address;
+}
+
+uint8_t DesfireFSFindApp(const uint8_t *Aid) {
+    uint8_t SlotAid[DESFIRE_AID_SIZE];
+
+    if ((Aid[0] | Aid[1] | Aid[2]) == 0)
+        return DESFIRE_PICC_APP_SLOT;
+
+    for (uint8_t Slot = DESFIRE_PICC_APP_SLOT + 1; Slot < DESFIRE_APP_SLOTS; Slot++) {
+        MemoryReadBlock(SlotAid, APP_ADDRESS(Slot), DESFIRE_AID_SIZE);
+
+        if (memcmp(SlotAid, Aid, DESFIRE_AID_SIZE) == 0)
+            return Slot;
+    }
+
+    return DESFIRE_NO_SLOT;
+}
+
+void DesfireFSReadApp(uint8_t Slot, DesfireAppType *App) {
+    MemoryReadBlock(App, APP_ADDRESS(Slot), sizeof(DesfireAppType));
+}
+
+void DesfireFSWriteApp(uint8_t Slot, const DesfireAppType *App) {
+    MemoryWriteBlock(App, APP_ADDRESS(Slot), sizeof(DesfireAppType));
+}
+
+uint8_t DesfireFSCreateApp(const uint8_t *Aid, uint8_t KeySettings, uint8_t KeyCount) {
+    static const uint8_t FreeAid[DESFIRE_AID_SIZE] = { 0 };
+    DesfireAppType App;
+    uint8_t Slot;
+
+    /* Free slots have AID 000000, which DesfireFSFindApp maps to the PICC level */
+    for (Slot = DESFIRE_PICC_APP_SLOT + 1; Slot < DESFIRE_APP_SLOTS; Slot++) {
+        MemoryReadBlock(App.Aid, APP_ADDRESS(Slot), DESFIRE_AID_SIZE);
+
+        if (memcmp(App.Aid, FreeAid, DESFIRE_AID_SIZE) == 0)
+            break;
+    }
+
+    if (Slot == DESFIRE_APP_SLOTS)
+        return DESFIRE_STATUS_COUNT_ERROR;
+
+    InitApp(&App);
+    memcpy(App.Aid, Aid, DESFIRE_AID_SIZE);
+    App.KeySettings = KeySettings;
+    App.KeyCount = KeyCount;
+    App.KeyAddress = Allocate((KeyCount & DESFIRE_KEY_COUNT_MASK) * DESFIRE_KEY_RECORD_SIZE);
+
+    if (App.KeyAddress == 0)
+        return DESFIRE_STATUS_OUT_OF_EEPROM;
+
+    DesfireFSWriteApp(Slot, &App);
+
+    return DESFIRE_STATUS_OPERATION_OK;
+}
+
+void DesfireFSDeleteApp(uint8_t Slot) {
+    DesfireAppType App;
+
+    DesfireFSReadApp(Slot, &App);
+
+    for (uint8_t FileNo = 0; FileNo < DESFIRE_MAX_FILES; FileNo++) {
+        if (App.FileIndex[FileNo] != DESFIRE_NO_SLOT)
+            DesfireFSDeleteFile(Slot, &App, FileNo);
+    }
+
+    InitApp(&App);
+    DesfireFSWriteApp(Slot, &App);
+}
+
+void DesfireFSReadKey(const DesfireAppType *App, uint8_t KeyNo, uint8_t *Key, uint8_t *Version) {
+    uint16_t Address = App->KeyAddress + (uint16_t) KeyNo * DESFIRE_KEY_RECORD_SIZE;
+
+    MemoryReadBlock(Key, Address, DESFIRE_KEY_SIZE);
+    MemoryReadBlock(Version, Address + DESFIRE_KEY_SIZE, 1);
+}
+
+void DesfireFSWriteKey(const DesfireAppType *App, uint8_t KeyNo, const uint8_t *Key, uint8_t Version) {
+    uint16_t Address = App->KeyAddress + (uint16_t) KeyNo * DESFIRE_KEY_RECORD_SIZE;
+
+    MemoryWriteBlock(Key, Address, DESFIRE_KEY_SIZE);
+    MemoryWriteBlock(&Version, Address + DESFIRE_KEY_SIZE, 1);
+}
+
+void DesfireFSReadFile(uint8_t Slot, DesfireFileType *File) {
+    MemoryReadBlock(File, FILE_ADDRESS(Slot), sizeof(DesfireFileType));
+}
+
+uint8_t DesfireFSCreateFile(uint8_t AppSlot, DesfireAppType *App, uint8_t FileNo, DesfireFileType *File, uint16_t DataSize) {
+    uint8_t Slot;
+    uint8_t Type;
+
+    for (Slot = 0; Slot < DESFIRE_FILE_SLOTS; Slot++) {
+        MemoryReadBlock(&Type, FILE_ADDRESS(Slot), sizeof(Type));
+
+        if (Type == DESFIRE_FILE_UNUSED)
+            break;
+    }
+
+    if (Slot == DESFIRE_FILE_SLOTS)
+        return DESFIRE_STATUS_OUT_OF_EEPROM;
+
+    File->DataAddress = Allocate(DataSize);
+
+    if (File->DataAddress == 0)
+        return DESFIRE_STATUS_OUT_OF_EEPROM;
+
+    MemoryWriteBlock(File, FILE_ADDRESS(Slot), sizeof(DesfireFileType));
+
+    App->FileIndex[FileNo] = Slot;
+    DesfireFSWriteApp(AppSlot, App);
+
+    return DESFIRE_STATUS_OPERATION_OK;
+}
+
+void DesfireFSDeleteFile(uint8_t AppSlot, DesfireAppType *App, uint8_t FileNo) {
+    uint8_t Type = DESFIRE_FILE_UNUSED;
+
+    MemoryWriteBlock(&Type, FILE_ADDRESS(App->FileIndex[FileNo]), sizeof(Type));
+
+    App->FileIndex[FileNo] = DESFIRE_NO_SLOT;
+    DesfireFSWriteApp(AppSlot, App);
+}
+
+void DesfireFSCopy(uint16_t DestAddress, uint16_t SrcAddress, uint16_t ByteCount) {
+    uint8_t Chunk[CHUNK_SIZE];
+
+    while (ByteCount > 0) {
+        uint16_t ChunkSize = MIN(ByteCount, CHUNK_SIZE);
+
+        MemoryReadBlock(Chunk, SrcAddress, ChunkSize);
+        MemoryWriteBlock(Chunk, DestAddress, ChunkSize);
+        SrcAddress += ChunkSize;
+        DestAddress += ChunkSize;
+        ByteCount -= ChunkSize;
+    }
+}
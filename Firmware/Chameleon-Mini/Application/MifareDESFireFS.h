@@ -0,0 +1,107 @@
+/*
+ * MifareDESFireFS.h
+ *
+ *  Application and file directory of the DESFire emulation, kept in the card memory (FRAM)
+ */
+
+#ifndef MIFAREDESFIREFS_H_
+#define MIFAREDESFIREFS_H_
+
+#include "../Common.h"
+
+/* Layout of the card image
+
+  0x0000  PICC info: UID, format marker, allocation pointer
+  0x0020  Application directory, DESFIRE_APP_SLOTS entries of DesfireAppType.
+          Slot 0 is the PICC level (AID 000000) holding the PICC master key.
+          Then the file table, DESFIRE_FILE_SLOTS entries of DesfireFileType
+          shared by all applications.
+          Then the data area holding keys and file contents, allocated upwards.
+
+Every application entry carries a file index, mapping the file number to its
+slot in the file table. Finding a file takes no search: the entry of the
+selected application is kept in RAM, the file record is read from its slot.
+
+As on the real card, memory of deleted applications and files is only
+reclaimed by FormatPICC. Their directory entries and file slots are reused.
+
+*/
+
+#define DESFIRE_AID_SIZE                3
+#define DESFIRE_MAX_APPS                28 /* Not counting the PICC level */
+#define DESFIRE_APP_SLOTS               (DESFIRE_MAX_APPS + 1)
+#define DESFIRE_MAX_FILES               32 /* Per application */
+#define DESFIRE_FILE_SLOTS              64
+#define DESFIRE_MAX_KEYS                14
+#define DESFIRE_KEY_SIZE                16 /* 2K3DES and AES */
+#define DESFIRE_KEY_RECORD_SIZE         (DESFIRE_KEY_SIZE + 1) /* Key and version */
+
+#define DESFIRE_PICC_APP_SLOT           0
+#define DESFIRE_NO_SLOT                 0xFF
+
+/* Key type, kept in the upper bits of the key count as in CreateApplication */
+#define DESFIRE_KEY_TYPE_MASK           0xC0
+#define DESFIRE_KEY_TYPE_DES            0x00 /* DES and 2K3DES */
+#define DESFIRE_KEY_TYPE_3K3DES         0x40
+#define DESFIRE_KEY_TYPE_AES            0x80
+#define DESFIRE_KEY_COUNT_MASK          0x0F
+
+/* File types */
+#define DESFIRE_FILE_STANDARD           0x00
+#define DESFIRE_FILE_BACKUP             0x01
+#define DESFIRE_FILE_VALUE              0x02
+#define DESFIRE_FILE_UNUSED             0xFF
+
+/* Data of value files, relative to the data address */
+#define DESFIRE_VALUE_COMMITTED         0
+#define DESFIRE_VALUE_WORKING           4
+#define DESFIRE_VALUE_LIMITED_CREDIT    8
+#define DESFIRE_VALUE_LIMITED_ENABLED   12
+#define DESFIRE_VALUE_DATA_SIZE         16
+
+/* Factory settings of the PICC master key */
+#define DESFIRE_PICC_KEY_SETTINGS       0x0F
+
+typedef struct {
+    uint8_t Aid[DESFIRE_AID_SIZE];
+    uint8_t KeySettings;
+    uint8_t KeyCount; /* Number of keys | key type */
+    uint8_t Reserved;
+    uint16_t KeyAddress;
+    uint8_t FileIndex[DESFIRE_MAX_FILES]; /* File number -> file slot or DESFIRE_NO_SLOT */
+} DesfireAppType;
+
+typedef struct {
+    uint8_t Type;
+    uint8_t CommSettings;
+    uint16_t AccessRights;
+    uint16_t DataAddress;
+    uint16_t Size; /* Data files only. Backup files take twice the size: committed data, then working copy. */
+    int32_t LowerLimit; /* Value files only */
+    int32_t UpperLimit;
+} DesfireFileType;
+
+void DesfireFSInit(void);
+void DesfireFSFactoryReset(void);
+void DesfireFSFormat(void);
+
+void DesfireFSGetUid(uint8_t *Uid);
+void DesfireFSSetUid(const uint8_t *Uid);
+uint16_t DesfireFSFreeMemory(void);
+
+uint8_t DesfireFSFindApp(const uint8_t *Aid);
+void DesfireFSReadApp(uint8_t Slot, DesfireAppType *App);
+void DesfireFSWriteApp(uint8_t Slot, const DesfireAppType *App);
+uint8_t DesfireFSCreateApp(const uint8_t *Aid, uint8_t KeySettings, uint8_t KeyCount);
+void DesfireFSDeleteApp(uint8_t Slot);
+
+void DesfireFSReadKey(const DesfireAppType *App, uint8_t KeyNo, uint8_t *Key, uint8_t *Version);
+void DesfireFSWriteKey(const DesfireAppType *App, uint8_t KeyNo, const uint8_t *Key, uint8_t Version);
+
+void DesfireFSReadFile(uint8_t Slot, DesfireFileType *File);
+uint8_t DesfireFSCreateFile(uint8_t AppSlot, DesfireAppType *App, uint8_t FileNo, DesfireFileType *File, uint16_t DataSize);
+void DesfireFSDeleteFile(uint8_t AppSlot, DesfireAppType *App, uint8_t FileNo);
+
+void DesfireFSCopy(uint16_t DestAddress, uint16_t SrcAddress, uint16_t ByteCount);
+
+#endif /* MIFAREDESFIREFS_H_ */
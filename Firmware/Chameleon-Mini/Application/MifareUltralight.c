@@ -42,15 +42,6 @@
 #define CMD_WRITE_FRAME_SIZE    6 /* without CRC bytes */
 #define CMD_COMPAT_WRITE        0xA0
 #define CMD_COMPAT_WRITE_FRAME_SIZE 2
-/* EV1 commands */
-#define CMD_GET_VERSION         0x60
-#define CMD_FAST_READ           0x3A
-#define CMD_READ_CNT            0x39
-#define CMD_INCREMENT_CNT       0xA5
-#define CMD_PWD_AUTH            0x1B
-#define CMD_READ_SIG            0x3C
-#define CMD_CHECK_TEARING_EVENT 0x3E
-#define CMD_VCSL                0x4B
 
 /* Tag memory layout; addresses and sizes in bytes */
 #define MF_ULC_COUNTER_ADDRESS    0x29
@@ -64,19 +55,6 @@
 #define UID_BCC2_ADDRESS        0x08
 #define LOCK_BYTES_1_ADDRESS    0x0A
 #define LOCK_BYTES_2_ADDRESS    0x90
-#define CONFIG_AREA_SIZE        0x10
-#define CONF_AUTH0_OFFSET       0x03
-#define CONF_ACCESS_OFFSET      0x04
-#define CONF_VCTID_OFFSET       0x05
-#define CONF_PASSWORD_OFFSET    0x08
-#define CONF_PACK_OFFSET        0x0C
-
-#define CONF_ACCESS_PROT        0x80
-#define CONF_ACCESS_CNFLCK      0x40
-
-#define CNT_MAX                 2
-#define CNT_SIZE                4
-#define CNT_MAX_VALUE           0x00FFFFFF
 
 #define BYTES_PER_READ          16
 #define PAGE_READ_MIN           0x00
@@ -86,13 +64,10 @@
 
 #define BYTES_PER_COMPAT_WRITE  16
 
-#define VERSION_INFO_LENGTH     8
-#define SIGNATURE_LENGTH        32
 
 static enum {
     UL_EV0,
-    UL_C,
-    UL_EV1,
+    UL_C
 } Flavor;
 
 static enum {
@@ -193,29 +168,6 @@ void MifareUltralightAppInit(void) {
     AppInitCommon();
 }
 
-static void AppInitEV1Common(void) {
-    uint8_t ConfigAreaAddress = PageCount * MIFARE_ULTRALIGHT_PAGE_SIZE - CONFIG_AREA_SIZE;
-    uint8_t Access;
-
-    /* Set up the emulation flavor */
-    Flavor = UL_EV1;
-    /* Fetch some of the configuration into RAM */
-    MemoryReadBlock(&FirstAuthenticatedPage, ConfigAreaAddress + CONF_AUTH0_OFFSET, 1);
-    MemoryReadBlock(&Access, ConfigAreaAddress + CONF_ACCESS_OFFSET, 1);
-    ReadAccessProtected = !!(Access & CONF_ACCESS_PROT);
-    AppInitCommon();
-}
-
-void MifareUltralightEV11AppInit(void) {
-    PageCount = MIFARE_ULTRALIGHT_EV11_PAGES;
-    AppInitEV1Common();
-}
-
-void MifareUltralightEV12AppInit(void) {
-    PageCount = MIFARE_ULTRALIGHT_EV12_PAGES;
-    AppInitEV1Common();
-}
-
 void MifareUltralightAppReset(void) {
     State = STATE_IDLE;
 }
@@ -245,33 +197,23 @@ static bool IncrementCounter(uint8_t *IncrementValue) {
     MemoryReadBlock(&CounterValue, MF_ULC_COUNTER_ADDRESS, 2);
     if (CounterValue == 0) {
         CounterValue = IncrementValue[0] + (IncrementValue[1] << 8);
-        MemoryWriteBlock(&CounterValue, MF_ULC_COUNTER_ADDRESS, 2);
+        MemoryWriteBlockAtomic(&CounterValue, MF_ULC_COUNTER_ADDRESS, 2);
         return true;
     } else {
         IncrementValue[0] &= 0x0f;
         if (IncrementValue[0] <= (0xffff - CounterValue)) {
             CounterValue += IncrementValue[0];
-            MemoryWriteBlock(&CounterValue, MF_ULC_COUNTER_ADDRESS, 2);
+            MemoryWriteBlockAtomic(&CounterValue, MF_ULC_COUNTER_ADDRESS, 2);
             return true;
         }
         return false;
     }
 }
 
-
-static bool AuthCounterIncrement(void) {
-    /* Currently not implemented */
-    return true;
-}
-
-static void AuthCounterReset(void) {
-    /* Currently not implemented */
-}
-
 /* Perform access verification and commit data if passed */
 static uint8_t AppWritePage(uint8_t PageAddress, uint8_t *const Buffer) {
     if (!ActiveConfiguration.ReadOnly) {
-        MemoryWriteBlock(Buffer, PageAddress * MIFARE_ULTRALIGHT_PAGE_SIZE, MIFARE_ULTRALIGHT_PAGE_SIZE);
+        MemoryWriteBlockAtomic(Buffer, PageAddress * MIFARE_ULTRALIGHT_PAGE_SIZE, MIFARE_ULTRALIGHT_PAGE_SIZE);
     } else {
         /* If the chameleon is in read only mode, it silently
         * ignores any attempt to write data. */
@@ -310,7 +252,7 @@ static uint16_t AppProcess(uint8_t *const Buffer, uint16_t ByteCount) {
             uint8_t PageAddress = Buffer[1];
             uint8_t PageLimit;
             uint8_t Offset;
-            /* For EV1+ cards, ensure the wraparound is at the first protected page */
+            /* For ULC cards, ensure the wraparound is at the first protected page */
             if (Flavor >= UL_C && ReadAccessProtected && !Authenticated) {
                 PageLimit = FirstAuthenticatedPage;
             } else {
@@ -412,132 +354,6 @@ static uint16_t AppProcess(uint8_t *const Buffer, uint16_t ByteCount) {
             return (9 + ISO14443A_CRCA_SIZE) * 8;
         }
     }
-    /* Handle EV1 commands */
-    if (Flavor >= UL_EV1) {
-        switch (Cmd) {
-
-            case CMD_GET_VERSION: {
-                /* Provide hardcoded version response */
-                Buffer[0] = 0x00;
-                Buffer[1] = 0x04;
-                Buffer[2] = 0x03;
-                Buffer[3] = 0x01; /**/
-                Buffer[4] = 0x01;
-                Buffer[5] = 0x00;
-                Buffer[6] = PageCount == MIFARE_ULTRALIGHT_EV11_PAGES ? 0x0B : 0x0E;
-                Buffer[7] = 0x03;
-                ISO14443AAppendCRCA(Buffer, VERSION_INFO_LENGTH);
-                return (VERSION_INFO_LENGTH + ISO14443A_CRCA_SIZE) * 8;
-            }
-
-            case CMD_FAST_READ: {
-                uint8_t StartPageAddress = Buffer[1];
-                uint8_t EndPageAddress = Buffer[2];
-                /* Validation */
-                if ((StartPageAddress > EndPageAddress) || (StartPageAddress >= PageCount) || (EndPageAddress >= PageCount)) {
-                    Buffer[0] = NAK_INVALID_ARG;
-                    return NAK_FRAME_SIZE;
-                }
-                /* Check authentication only if protection is read&write */
-                if (ReadAccessProtected) {
-                    if (!VerifyAuthentication(StartPageAddress) || !VerifyAuthentication(EndPageAddress)) {
-                        Buffer[0] = NAK_AUTH_REQUIRED;
-                        return NAK_FRAME_SIZE;
-                    }
-                }
-                /* NOTE: With the current implementation, reading the password out is possible. */
-                ByteCount = (EndPageAddress - StartPageAddress + 1) * MIFARE_ULTRALIGHT_PAGE_SIZE;
-                MemoryReadBlock(Buffer, StartPageAddress * MIFARE_ULTRALIGHT_PAGE_SIZE, ByteCount);
-                ISO14443AAppendCRCA(Buffer, ByteCount);
-                return (ByteCount + ISO14443A_CRCA_SIZE) * 8;
-            }
-
-            case CMD_PWD_AUTH: {
-                uint8_t ConfigAreaAddress = PageCount * MIFARE_ULTRALIGHT_PAGE_SIZE - CONFIG_AREA_SIZE;
-                uint8_t Password[4];
-
-                /* Verify value and increment authentication attempt counter */
-                if (!AuthCounterIncrement()) {
-                    /* Too many failed attempts */
-                    Buffer[0] = NAK_AUTH_FAILED;
-                    return NAK_FRAME_SIZE;
-                }
-                /* Read and compare the password */
-                MemoryReadBlock(Password, ConfigAreaAddress + CONF_PASSWORD_OFFSET, 4);
-                if (Password[0] != Buffer[1] || Password[1] != Buffer[2] || Password[2] != Buffer[3] || Password[3] != Buffer[4]) {
-                    Buffer[0] = NAK_AUTH_FAILED;
-                    return NAK_FRAME_SIZE;
-                }
-                /* Authenticate the user */
-                AuthCounterReset();
-                Authenticated = 1;
-                /* Send the PACK value back */
-                MemoryReadBlock(Buffer, ConfigAreaAddress + CONF_PACK_OFFSET, 2);
-                ISO14443AAppendCRCA(Buffer, 2);
-                return (2 + ISO14443A_CRCA_SIZE) * 8;
-            }
-
-            case CMD_READ_CNT: {
-                uint8_t CounterId = Buffer[1];
-                /* Validation */
-                if (CounterId > CNT_MAX) {
-                    Buffer[0] = NAK_INVALID_ARG;
-                    return NAK_FRAME_SIZE;
-                }
-                /* Returned counter length is 3 bytes */
-                MemoryReadBlock(Buffer, (PageCount + CounterId) * MIFARE_ULTRALIGHT_PAGE_SIZE, 3);
-                ISO14443AAppendCRCA(Buffer, 3);
-                return (3 + ISO14443A_CRCA_SIZE) * 8;
-            }
-
-            case CMD_INCREMENT_CNT: {
-                uint8_t CounterId = Buffer[1];
-                uint32_t Addend = (Buffer[0]) | (Buffer[1] << 8) | ((uint32_t)Buffer[2] << 16);
-                uint32_t Counter;
-                /* Validation */
-                if (CounterId > CNT_MAX) {
-                    Buffer[0] = NAK_INVALID_ARG;
-                    return NAK_FRAME_SIZE;
-                }
-                /* Read the value out */
-                MemoryReadBlock(&Counter, (PageCount + CounterId) * MIFARE_ULTRALIGHT_PAGE_SIZE, MIFARE_ULTRALIGHT_PAGE_SIZE);
-                /* Add and check for overflow */
-                Counter += Addend;
-                if (Counter > CNT_MAX_VALUE) {
-                    Buffer[0] = NAK_CTR_ERROR;
-                    return NAK_FRAME_SIZE;
-                }
-                /* Update memory */
-                MemoryWriteBlock(&Counter, (PageCount + CounterId) * MIFARE_ULTRALIGHT_PAGE_SIZE, MIFARE_ULTRALIGHT_PAGE_SIZE);
-                Buffer[0] = ACK_VALUE;
-                return ACK_FRAME_SIZE;
-            }
-
-            case CMD_READ_SIG:
-                /* Hardcoded response */
-                memset(Buffer, 0xCA, SIGNATURE_LENGTH);
-                ISO14443AAppendCRCA(Buffer, SIGNATURE_LENGTH);
-                return (SIGNATURE_LENGTH + ISO14443A_CRCA_SIZE) * 8;
-
-            case CMD_CHECK_TEARING_EVENT:
-                /* Hardcoded response */
-                Buffer[0] = 0xBD;
-                ISO14443AAppendCRCA(Buffer, 1);
-                return (1 + ISO14443A_CRCA_SIZE) * 8;
-
-            case CMD_VCSL: {
-                uint8_t ConfigAreaAddress = PageCount * MIFARE_ULTRALIGHT_PAGE_SIZE - CONFIG_AREA_SIZE;
-                /* Input is ignored completely */
-                /* Read out the value */
-                MemoryReadBlock(Buffer, ConfigAreaAddress + CONF_VCTID_OFFSET, 1);
-                ISO14443AAppendCRCA(Buffer, 1);
-                return (1 + ISO14443A_CRCA_SIZE) * 8;
-            }
-
-            default:
-                break;
-        }
-    }
     /* Command not handled. Switch to idle. */
     State = STATE_IDLE;
     return ISO14443A_APP_NO_RESPONSE;
@@ -22,12 +22,8 @@
 #define MIFARE_ULTRALIGHT_EV11_PAGES  20
 #define MIFARE_ULTRALIGHT_EV12_PAGES  41
 #define MIFARE_ULTRALIGHT_MEM_SIZE          (MIFARE_ULTRALIGHT_PAGES * MIFARE_ULTRALIGHT_PAGE_SIZE)
-#define MIFARE_ULTRALIGHT_EV11_MEM_SIZE     (MIFARE_ULTRALIGHT_EV11_PAGES * MIFARE_ULTRALIGHT_PAGE_SIZE)
-#define MIFARE_ULTRALIGHT_EV12_MEM_SIZE     (MIFARE_ULTRALIGHT_EV12_PAGES * MIFARE_ULTRALIGHT_PAGE_SIZE)
 
 void MifareUltralightAppInit(void);
-void MifareUltralightEV11AppInit(void);
-void MifareUltralightEV12AppInit(void);
 void MifareUltralightAppReset(void);
 void MifareUltralightAppTask(void);
 
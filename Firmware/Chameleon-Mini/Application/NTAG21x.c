@@ -0,0 +1,700 @@
+/*
+ * NTAG21x.c
+ *
+ *  NTAG21x and MIFARE Ultralight EV1 emulation, see NTAG21x.h
+ *
+ *  Based on the NTAG215 emulation by Giovanni Cammisa (gcammisa) and the
+ *  MifareUltralight code by skuser.
+ *  Still missing support for:
+ *      - The management of both static and dynamic lock bytes
+ *      - Bruteforce protection (AUTHLIM counter)
+ *      - UID and counter mirroring
+ */
+
+#include "NTAG21x.h"
+#include "../Codec/ISO14443-2A.h"
+#include "../Memory.h"
+
+#define ATQA_VALUE                  0x0044
+#define SAK_CL1_VALUE               ISO14443A_SAK_INCOMPLETE
+#define SAK_CL2_VALUE               ISO14443A_SAK_COMPLETE_NOT_COMPLIANT
+
+#define ACK_VALUE                   0x0A
+#define ACK_FRAME_SIZE              4 /* Bits */
+#define NAK_INVALID_ARG             0x00
+#define NAK_CRC_ERROR               0x01
+#define NAK_NOT_AUTHED              0x04
+#define NAK_CTR_ERROR               0x04
+#define NAK_EEPROM_ERROR            0x05
+#define NAK_FRAME_SIZE              4
+
+/* ISO commands */
+#define CMD_HALT                    0x50
+/* NTAG and Ultralight EV1 commands */
+#define CMD_GET_VERSION             0x60
+#define CMD_READ                    0x30
+#define CMD_FAST_READ               0x3A
+#define CMD_WRITE                   0xA2
+#define CMD_COMPAT_WRITE            0xA0
+#define CMD_READ_CNT                0x39
+#define CMD_PWD_AUTH                0x1B
+#define CMD_READ_SIG                0x3C
+/* Ultralight EV1 only */
+#define CMD_INCREMENT_CNT           0xA5
+#define CMD_CHECK_TEARING_EVENT     0x3E
+#define CMD_VCSL                    0x4B
+
+/* Tag memory layout; addresses and sizes in bytes */
+#define UID_CL1_ADDRESS             0x00
+#define UID_CL1_SIZE                3
+#define UID_BCC1_ADDRESS            0x03
+#define UID_CL2_ADDRESS             0x04
+#define UID_CL2_SIZE                4
+#define UID_BCC2_ADDRESS            0x08
+/* Type 2 tag data area holding the NDEF TLVs, up to the dynamic lock or configuration pages */
+#define DATA_AREA_PAGE              4
+
+/* The configuration takes the last four pages of every variant */
+#define CONFIG_PAGES                4
+#define CONF_AUTH0_OFFSET           0x03
+#define CONF_ACCESS_OFFSET          0x04
+#define CONF_VCTID_OFFSET           0x05
+#define CONF_PASSWORD_OFFSET        0x08
+#define CONF_PACK_OFFSET            0x0C
+/* PWD, PACK and RFUI always read back as zeros */
+#define CONF_SECRET_OFFSET          CONF_PASSWORD_OFFSET
+#define CONF_SECRET_SIZE            8
+
+#define CONF_ACCESS_PROT            0x80
+#define CONF_ACCESS_NFC_CNT_EN      0x10
+#define CONF_ACCESS_NFC_CNT_PWD_PROT 0x08
+
+/* Counters are kept in the pages following the tag memory */
+#define CNT_MAX                     2
+#define CNT_SIZE                    3
+#define CNT_TORN_OFFSET             3 /* Nonzero while the last increment of the counter has been torn */
+#define CNT_RECORD_SIZE             4 /* Counter and its tearing flag */
+#define CNT_MAX_VALUE               0x00FFFFFF
+#define NFC_CNT_ID                  2
+
+#define PWD_SIZE                    4
+#define PACK_SIZE                   2
+#define READ_PAGES                  4
+#define PAGE_WRITE_MIN              0x02
+#define SIGNATURE_LENGTH            32
+#define TEARING_FLAG_VALUE          0xBD
+#define TEARING_FLAG_TORN           0x00
+
+/* A FAST_READ response has to fit into the codec buffer along with its CRC */
+#define FAST_READ_PAGES_MAX         ((CODEC_BUFFER_SIZE - ISO14443A_CRCA_SIZE) / NTAG21X_PAGE_SIZE)
+
+/* Variant features */
+#define FEATURE_EV1_COUNTERS        0x01 /* Three counters, INCR_CNT, CHECK_TEARING_EVENT and VCSL */
+#define FEATURE_NFC_COUNTER         0x02 /* Read-only counter 2, counting the first read of a session */
+#define FEATURE_DYNAMIC_LOCK        0x04 /* Dynamic lock bytes in the page before the configuration */
+
+typedef struct {
+    uint8_t PageCount;
+    uint8_t ConfigPage;
+    uint8_t Features;
+    uint8_t Version[NTAG21X_VERSION_SIZE];
+} VariantType;
+
+enum {
+    VARIANT_NTAG210,
+    VARIANT_NTAG212,
+    VARIANT_NTAG213,
+    VARIANT_NTAG215,
+    VARIANT_NTAG216,
+    VARIANT_UL_EV11,
+    VARIANT_UL_EV12
+};
+
+static const VariantType PROGMEM VariantTable[] = {
+    [VARIANT_NTAG210] = {
+        .PageCount = NTAG210_PAGES, .ConfigPage = NTAG210_PAGES - CONFIG_PAGES, .Features = 0,
+        .Version = { 0x00, 0x04, 0x04, 0x01, 0x01, 0x00, 0x0B, 0x03 }
+    },
+    [VARIANT_NTAG212] = {
+        .PageCount = NTAG212_PAGES, .ConfigPage = NTAG212_PAGES - CONFIG_PAGES, .Features = FEATURE_DYNAMIC_LOCK,
+        .Version = { 0x00, 0x04, 0x04, 0x01, 0x01, 0x00, 0x0E, 0x03 }
+    },
+    [VARIANT_NTAG213] = {
+        .PageCount = NTAG213_PAGES, .ConfigPage = NTAG213_PAGES - CONFIG_PAGES, .Features = FEATURE_NFC_COUNTER | FEATURE_DYNAMIC_LOCK,
+        .Version = { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x0F, 0x03 }
+    },
+    [VARIANT_NTAG215] = {
+        .PageCount = NTAG215_PAGES, .ConfigPage = NTAG215_PAGES - CONFIG_PAGES, .Features = FEATURE_NFC_COUNTER | FEATURE_DYNAMIC_LOCK,
+        .Version = { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x11, 0x03 }
+    },
+    [VARIANT_NTAG216] = {
+        .PageCount = NTAG216_PAGES, .ConfigPage = NTAG216_PAGES - CONFIG_PAGES, .Features = FEATURE_NFC_COUNTER | FEATURE_DYNAMIC_LOCK,
+        .Version = { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x13, 0x03 }
+    },
+    [VARIANT_UL_EV11] = {
+        .PageCount = MIFARE_ULTRALIGHT_EV11_PAGES, .ConfigPage = MIFARE_ULTRALIGHT_EV11_PAGES - CONFIG_PAGES, .Features = FEATURE_EV1_COUNTERS,
+        .Version = { 0x00, 0x04, 0x03, 0x01, 0x01, 0x00, 0x0B, 0x03 }
+    },
+    [VARIANT_UL_EV12] = {
+        .PageCount = MIFARE_ULTRALIGHT_EV12_PAGES, .ConfigPage = MIFARE_ULTRALIGHT_EV12_PAGES - CONFIG_PAGES, .Features = FEATURE_EV1_COUNTERS | FEATURE_DYNAMIC_LOCK,
+        .Version = { 0x00, 0x04, 0x03, 0x01, 0x01, 0x00, 0x0E, 0x03 }
+    }
+};
+
+static enum {
+    STATE_HALT,
+    STATE_IDLE,
+    STATE_READY1,
+    STATE_READY2,
+    STATE_ACTIVE
+} State;
+
+static VariantType Variant;
+static bool FromHalt = false;
+static bool ArmedForCompatWrite;
+static uint8_t CompatWritePageAddress;
+static bool Authenticated;
+static bool NfcCounted;
+static uint8_t FirstAuthenticatedPage;
+static uint8_t Access;
+static uint16_t CardATQAValue;
+static uint8_t CardSAKValue;
+
+static uint16_t ConfigAddress(void) {
+    return Variant.ConfigPage * NTAG21X_PAGE_SIZE;
+}
+
+static uint16_t CounterAddress(uint8_t CounterId) {
+    return (Variant.PageCount + CounterId) * NTAG21X_PAGE_SIZE;
+}
+
+static uint16_t DataAreaEnd(void) {
+    uint8_t EndPage = Variant.ConfigPage;
+
+    if (Variant.Features & FEATURE_DYNAMIC_LOCK) {
+        EndPage--;
+    }
+
+    return EndPage * NTAG21X_PAGE_SIZE;
+}
+
+static void LoadConfig(void) {
+    /* Fetch the access configuration into RAM */
+    MemoryReadBlock(&FirstAuthenticatedPage, ConfigAddress() + CONF_AUTH0_OFFSET, 1);
+    MemoryReadBlock(&Access, ConfigAddress() + CONF_ACCESS_OFFSET, 1);
+}
+
+/* An increment dropped at power up left the old value, raise the tearing flag of that counter */
+static void CheckTornCounters(void) {
+    static const uint8_t Torn = 0x01;
+
+    for (uint8_t CounterId = 0; CounterId <= CNT_MAX; CounterId++) {
+        if (MemoryCheckTornWrite(CounterAddress(CounterId), CNT_SIZE)) {
+            MemoryWriteBlockAtomic(&Torn, CounterAddress(CounterId) + CNT_TORN_OFFSET, 1);
+        }
+    }
+}
+
+static void AppInit(uint8_t VariantIdx) {
+    memcpy_P(&Variant, &VariantTable[VariantIdx], sizeof(Variant));
+    LoadConfig();
+
+    if (Variant.Features & FEATURE_EV1_COUNTERS) {
+        CheckTornCounters();
+    }
+
+    State = STATE_IDLE;
+    FromHalt = false;
+    ArmedForCompatWrite = false;
+    Authenticated = false;
+    NfcCounted = false;
+    CardATQAValue = ATQA_VALUE;
+    CardSAKValue = SAK_CL2_VALUE;
+}
+
+void NTAG210AppInit(void) {
+    AppInit(VARIANT_NTAG210);
+}
+
+void NTAG212AppInit(void) {
+    AppInit(VARIANT_NTAG212);
+}
+
+void NTAG213AppInit(void) {
+    AppInit(VARIANT_NTAG213);
+}
+
+void NTAG215AppInit(void) {
+    AppInit(VARIANT_NTAG215);
+}
+
+void NTAG216AppInit(void) {
+    AppInit(VARIANT_NTAG216);
+}
+
+void MifareUltralightEV11AppInit(void) {
+    AppInit(VARIANT_UL_EV11);
+}
+
+void MifareUltralightEV12AppInit(void) {
+    AppInit(VARIANT_UL_EV12);
+}
+
+void NTAG21xAppReset(void) {
+    /* Leaving the field ends the session */
+    State = STATE_IDLE;
+    ArmedForCompatWrite = false;
+    Authenticated = false;
+    NfcCounted = false;
+}
+
+void NTAG21xAppTask(void) {
+
+}
+
+static bool VerifyAuthentication(uint8_t PageAddress) {
+    /* If authenticated, no verification needed */
+    if (Authenticated) {
+        return true;
+    }
+    /* Otherwise, verify the accessed page is below the limit */
+    return PageAddress < FirstAuthenticatedPage;
+}
+
+static bool ReadProtected(void) {
+    return (Access & CONF_ACCESS_PROT) && !Authenticated;
+}
+
+/* Reads consecutive pages with a single memory access, hiding the password */
+static void ReadPages(uint8_t *Buffer, uint8_t PageAddress, uint8_t Pages) {
+    uint16_t Address = PageAddress * NTAG21X_PAGE_SIZE;
+    uint16_t End = Address + Pages * NTAG21X_PAGE_SIZE;
+    uint16_t SecretAddress = ConfigAddress() + CONF_SECRET_OFFSET;
+    uint16_t SecretEnd = SecretAddress + CONF_SECRET_SIZE;
+
+    MemoryReadBlock(Buffer, Address, End - Address);
+
+    if ((Address < SecretEnd) && (End > SecretAddress)) {
+        uint16_t ClearStart = MAX(Address, SecretAddress);
+
+        memset(&Buffer[ClearStart - Address], 0, MIN(End, SecretEnd) - ClearStart);
+    }
+}
+
+static void CountNfcRead(void) {
+    uint32_t Counter = 0;
+
+    if (!(Variant.Features & FEATURE_NFC_COUNTER) || !(Access & CONF_ACCESS_NFC_CNT_EN) || NfcCounted) {
+        return;
+    }
+
+    NfcCounted = true;
+    MemoryReadBlock(&Counter, CounterAddress(NFC_CNT_ID), CNT_SIZE);
+
+    if ((Counter < CNT_MAX_VALUE) && !ActiveConfiguration.ReadOnly) {
+        Counter++;
+        MemoryWriteBlockAtomic(&Counter, CounterAddress(NFC_CNT_ID), CNT_RECORD_SIZE);
+    }
+}
+
+static void AppWritePage(uint8_t PageAddress, uint8_t *const Buffer) {
+    if (!ActiveConfiguration.ReadOnly) {
+        MemoryWriteBlockAtomic(Buffer, PageAddress * NTAG21X_PAGE_SIZE, NTAG21X_PAGE_SIZE);
+
+        if (PageAddress >= Variant.ConfigPage) {
+            LoadConfig();
+        }
+    } else {
+        /* If the chameleon is in read only mode, it silently
+        * ignores any attempt to write data. */
+    }
+}
+
+/* Handles the commands of a selected tag */
+static uint16_t AppProcess(uint8_t *const Buffer, uint16_t ByteCount) {
+    uint8_t Cmd = Buffer[0];
+
+    /* Handle the compatibility write command */
+    if (ArmedForCompatWrite) {
+        ArmedForCompatWrite = false;
+
+        /* Only the first 4 of the 16 bytes are written */
+        AppWritePage(CompatWritePageAddress, &Buffer[0]);
+        Buffer[0] = ACK_VALUE;
+        return ACK_FRAME_SIZE;
+    }
+
+    switch (Cmd) {
+        case CMD_GET_VERSION:
+            memcpy(Buffer, Variant.Version, NTAG21X_VERSION_SIZE);
+            ISO14443AAppendCRCA(Buffer, NTAG21X_VERSION_SIZE);
+            return (NTAG21X_VERSION_SIZE + ISO14443A_CRCA_SIZE) * 8;
+
+        case CMD_READ: {
+            uint8_t PageAddress = Buffer[1];
+            uint8_t PageLimit = Variant.PageCount;
+            uint8_t PagesLeft = READ_PAGES;
+            uint8_t *Data = Buffer;
+
+            /* If protected and not authenticated, the wraparound is at the first protected page */
+            if (ReadProtected()) {
+                PageLimit = MIN(PageLimit, FirstAuthenticatedPage);
+            }
+
+            /* Validation */
+            if (PageAddress >= PageLimit) {
+                Buffer[0] = NAK_INVALID_ARG;
+                return NAK_FRAME_SIZE;
+            }
+
+            CountNfcRead();
+
+            /* Read out, emulating the wraparound */
+            while (PagesLeft > 0) {
+                uint8_t Pages = MIN(PagesLeft, PageLimit - PageAddress);
+
+                ReadPages(Data, PageAddress, Pages);
+                Data += Pages * NTAG21X_PAGE_SIZE;
+                PagesLeft -= Pages;
+                PageAddress = 0;
+            }
+
+            ISO14443AAppendCRCA(Buffer, READ_PAGES * NTAG21X_PAGE_SIZE);
+            return (READ_PAGES * NTAG21X_PAGE_SIZE + ISO14443A_CRCA_SIZE) * 8;
+        }
+
+        case CMD_FAST_READ: {
+            uint8_t StartPageAddress = Buffer[1];
+            uint8_t EndPageAddress = Buffer[2];
+            uint8_t Pages = EndPageAddress - StartPageAddress + 1;
+
+            /* Validation. Unlike the real tag, the range is limited by the codec buffer. */
+            if ((StartPageAddress > EndPageAddress) || (EndPageAddress >= Variant.PageCount) || (Pages > FAST_READ_PAGES_MAX)) {
+                Buffer[0] = NAK_INVALID_ARG;
+                return NAK_FRAME_SIZE;
+            }
+
+            /* Check authentication only if protection is read&write (instead of only write protection) */
+            if (ReadProtected() && !VerifyAuthentication(EndPageAddress)) {
+                Buffer[0] = NAK_NOT_AUTHED;
+                return NAK_FRAME_SIZE;
+            }
+
+            CountNfcRead();
+
+            /* Straight into the codec buffer with a single memory access */
+            ByteCount = Pages * NTAG21X_PAGE_SIZE;
+            ReadPages(Buffer, StartPageAddress, Pages);
+            ISO14443AAppendCRCA(Buffer, ByteCount);
+            return (ByteCount + ISO14443A_CRCA_SIZE) * 8;
+        }
+
+        case CMD_PWD_AUTH: {
+            uint8_t Password[PWD_SIZE];
+
+            /* Read and compare the password */
+            MemoryReadBlock(Password, ConfigAddress() + CONF_PASSWORD_OFFSET, PWD_SIZE);
+            if (memcmp(Password, &Buffer[1], PWD_SIZE) != 0) {
+                Buffer[0] = NAK_NOT_AUTHED;
+                return NAK_FRAME_SIZE;
+            }
+
+            /* Authenticate the user and send the PACK value back */
+            Authenticated = true;
+            MemoryReadBlock(Buffer, ConfigAddress() + CONF_PACK_OFFSET, PACK_SIZE);
+            ISO14443AAppendCRCA(Buffer, PACK_SIZE);
+            return (PACK_SIZE + ISO14443A_CRCA_SIZE) * 8;
+        }
+
+        case CMD_WRITE: {
+            /* This is a write command containing 4 bytes of data that
+            * should be written to the given page address. */
+            uint8_t PageAddress = Buffer[1];
+
+            /* Validation */
+            if ((PageAddress < PAGE_WRITE_MIN) || (PageAddress >= Variant.PageCount)) {
+                Buffer[0] = NAK_INVALID_ARG;
+                return NAK_FRAME_SIZE;
+            }
+            if (!VerifyAuthentication(PageAddress)) {
+                Buffer[0] = NAK_NOT_AUTHED;
+                return NAK_FRAME_SIZE;
+            }
+            AppWritePage(PageAddress, &Buffer[2]);
+            Buffer[0] = ACK_VALUE;
+            return ACK_FRAME_SIZE;
+        }
+
+        case CMD_COMPAT_WRITE: {
+            uint8_t PageAddress = Buffer[1];
+
+            /* Validation */
+            if ((PageAddress < PAGE_WRITE_MIN) || (PageAddress >= Variant.PageCount)) {
+                Buffer[0] = NAK_INVALID_ARG;
+                return NAK_FRAME_SIZE;
+            }
+            if (!VerifyAuthentication(PageAddress)) {
+                Buffer[0] = NAK_NOT_AUTHED;
+                return NAK_FRAME_SIZE;
+            }
+            /* CRC check passed and page-address is within bounds.
+            * Store address and proceed to receiving the data. */
+            CompatWritePageAddress = PageAddress;
+            ArmedForCompatWrite = true;
+            Buffer[0] = ACK_VALUE;
+            return ACK_FRAME_SIZE;
+        }
+
+        case CMD_READ_CNT: {
+            uint8_t CounterId = Buffer[1];
+
+            if (Variant.Features & FEATURE_EV1_COUNTERS) {
+                if (CounterId > CNT_MAX) {
+                    Buffer[0] = NAK_INVALID_ARG;
+                    return NAK_FRAME_SIZE;
+                }
+            } else if (Variant.Features & FEATURE_NFC_COUNTER) {
+                if ((CounterId != NFC_CNT_ID) || !(Access & CONF_ACCESS_NFC_CNT_EN)) {
+                    Buffer[0] = NAK_INVALID_ARG;
+                    return NAK_FRAME_SIZE;
+                }
+                if ((Access & CONF_ACCESS_NFC_CNT_PWD_PROT) && !Authenticated) {
+                    Buffer[0] = NAK_NOT_AUTHED;
+                    return NAK_FRAME_SIZE;
+                }
+            } else {
+                break;
+            }
+
+            MemoryReadBlock(Buffer, CounterAddress(CounterId), CNT_SIZE);
+            ISO14443AAppendCRCA(Buffer, CNT_SIZE);
+            return (CNT_SIZE + ISO14443A_CRCA_SIZE) * 8;
+        }
+
+        case CMD_INCREMENT_CNT: {
+            uint8_t CounterId = Buffer[1];
+            uint32_t Addend = Buffer[2] | ((uint16_t) Buffer[3] << 8) | ((uint32_t) Buffer[4] << 16);
+            uint32_t Counter = 0;
+
+            if (!(Variant.Features & FEATURE_EV1_COUNTERS)) {
+                break;
+            }
+            /* Validation */
+            if (CounterId > CNT_MAX) {
+                Buffer[0] = NAK_INVALID_ARG;
+                return NAK_FRAME_SIZE;
+            }
+            /* Read the value out, add and check for overflow */
+            MemoryReadBlock(&Counter, CounterAddress(CounterId), CNT_SIZE);
+            Counter += Addend;
+            if (Counter > CNT_MAX_VALUE) {
+                Buffer[0] = NAK_CTR_ERROR;
+                return NAK_FRAME_SIZE;
+            }
+            if (!ActiveConfiguration.ReadOnly) {
+                /* The upper byte is zero and clears the tearing flag */
+                MemoryWriteBlockAtomic(&Counter, CounterAddress(CounterId), CNT_RECORD_SIZE);
+            }
+            Buffer[0] = ACK_VALUE;
+            return ACK_FRAME_SIZE;
+        }
+
+        case CMD_CHECK_TEARING_EVENT: {
+            uint8_t CounterId = Buffer[1];
+            uint8_t Torn;
+
+            if (!(Variant.Features & FEATURE_EV1_COUNTERS)) {
+                break;
+            }
+            if (CounterId > CNT_MAX) {
+                Buffer[0] = NAK_INVALID_ARG;
+                return NAK_FRAME_SIZE;
+            }
+            MemoryReadBlock(&Torn, CounterAddress(CounterId) + CNT_TORN_OFFSET, 1);
+            Buffer[0] = Torn ? TEARING_FLAG_TORN : TEARING_FLAG_VALUE;
+            ISO14443AAppendCRCA(Buffer, 1);
+            return (1 + ISO14443A_CRCA_SIZE) * 8;
+        }
+
+        case CMD_VCSL:
+            if (!(Variant.Features & FEATURE_EV1_COUNTERS)) {
+                break;
+            }
+            /* Input is ignored completely */
+            MemoryReadBlock(Buffer, ConfigAddress() + CONF_VCTID_OFFSET, 1);
+            ISO14443AAppendCRCA(Buffer, 1);
+            return (1 + ISO14443A_CRCA_SIZE) * 8;
+
+        case CMD_READ_SIG:
+            /* Hardcoded response */
+            memset(Buffer, 0xCA, SIGNATURE_LENGTH);
+            ISO14443AAppendCRCA(Buffer, SIGNATURE_LENGTH);
+            return (SIGNATURE_LENGTH + ISO14443A_CRCA_SIZE) * 8;
+
+        case CMD_HALT:
+            /* Halts the tag. According to the ISO14443, the second
+            * byte is supposed to be 0. */
+            if (Buffer[1] == 0) {
+                /* According to ISO14443, we must not send anything
+                * in order to acknowledge the HALT command. */
+                State = STATE_HALT;
+                return ISO14443A_APP_NO_RESPONSE;
+            } else {
+                Buffer[0] = NAK_INVALID_ARG;
+                return NAK_FRAME_SIZE;
+            }
+
+        default:
+            break;
+    }
+
+    /* Command not handled. Switch to idle. */
+    State = STATE_IDLE;
+    return ISO14443A_APP_NO_RESPONSE;
+}
+
+uint16_t NTAG21xAppProcess(uint8_t *Buffer, uint16_t BitCount) {
+    uint8_t Cmd = Buffer[0];
+    uint16_t ByteCount;
+
+    switch (State) {
+        case STATE_IDLE:
+        case STATE_HALT:
+            FromHalt = State == STATE_HALT;
+            if (ISO14443AWakeUp(Buffer, &BitCount, CardATQAValue, FromHalt)) {
+                /* We received a REQA or WUPA command, so wake up. A new selection drops the authentication. */
+                State = STATE_READY1;
+                Authenticated = false;
+                return BitCount;
+            }
+            break;
+
+        case STATE_READY1:
+            if (ISO14443AWakeUp(Buffer, &BitCount, CardATQAValue, FromHalt)) {
+                State = FromHalt ? STATE_HALT : STATE_IDLE;
+                return ISO14443A_APP_NO_RESPONSE;
+            } else if (Cmd == ISO14443A_CMD_SELECT_CL1) {
+                /* Load UID CL1 and perform anticollision. Since
+                * the double-sized UID is used, the first byte
+                * of CL1 has to be the cascade-tag byte. */
+                uint8_t UidCL1[ISO14443A_CL_UID_SIZE] = { [0] = ISO14443A_UID0_CT };
+
+                MemoryReadBlock(&UidCL1[1], UID_CL1_ADDRESS, UID_CL1_SIZE);
+
+                if (ISO14443ASelect(Buffer, &BitCount, UidCL1, SAK_CL1_VALUE)) {
+                    /* CL1 stage has ended successfully */
+                    State = STATE_READY2;
+                }
+
+                return BitCount;
+            } else {
+                /* Unknown command. Enter halt state */
+                State = STATE_IDLE;
+            }
+            break;
+
+        case STATE_READY2:
+            if (ISO14443AWakeUp(Buffer, &BitCount, CardATQAValue, FromHalt)) {
+                State = FromHalt ? STATE_HALT : STATE_IDLE;
+                return ISO14443A_APP_NO_RESPONSE;
+            } else if (Cmd == ISO14443A_CMD_SELECT_CL2) {
+                /* Load UID CL2 and perform anticollision */
+                uint8_t UidCL2[ISO14443A_CL_UID_SIZE];
+
+                MemoryReadBlock(UidCL2, UID_CL2_ADDRESS, UID_CL2_SIZE);
+
+                if (ISO14443ASelect(Buffer, &BitCount, UidCL2, CardSAKValue)) {
+                    /* CL2 stage has ended successfully. This means
+                    * our complete UID has been sent to the reader. */
+                    State = STATE_ACTIVE;
+                }
+
+                return BitCount;
+            } else {
+                /* Unknown command. Enter halt state */
+                State = STATE_IDLE;
+            }
+            break;
+
+        /* Only ACTIVE state, no AUTHENTICATED state, PWD_AUTH is handled in commands. */
+        case STATE_ACTIVE:
+            /* Preserve incoming data length */
+            ByteCount = (BitCount + 7) >> 3;
+            if (ISO14443AWakeUp(Buffer, &BitCount, CardATQAValue, FromHalt)) {
+                State = FromHalt ? STATE_HALT : STATE_IDLE;
+                return ISO14443A_APP_NO_RESPONSE;
+            }
+            /* At the very least, there should be 3 bytes in the buffer. */
+            if (ByteCount < (1 + ISO14443A_CRCA_SIZE)) {
+                State = STATE_IDLE;
+                return ISO14443A_APP_NO_RESPONSE;
+            }
+            /* All commands here have CRCA appended; verify it right away */
+            ByteCount -= 2;
+            if (!ISO14443ACheckCRCA(Buffer, ByteCount)) {
+                Buffer[0] = NAK_CRC_ERROR;
+                return NAK_FRAME_SIZE;
+            }
+            return AppProcess(Buffer, ByteCount);
+
+        default:
+            /* Unknown state? Should never happen. */
+            break;
+    }
+
+    /* No response has been sent, when we reach here */
+    return ISO14443A_APP_NO_RESPONSE;
+}
+
+void NTAG21xGetUid(ConfigurationUidType Uid) {
+    /* Read UID from memory */
+    MemoryReadBlock(&Uid[0], UID_CL1_ADDRESS, UID_CL1_SIZE);
+    MemoryReadBlock(&Uid[UID_CL1_SIZE], UID_CL2_ADDRESS, UID_CL2_SIZE);
+}
+
+void NTAG21xSetUid(ConfigurationUidType Uid) {
+    /* Calculate check bytes and write everything into memory */
+    uint8_t BCC1 = ISO14443A_UID0_CT ^ Uid[0] ^ Uid[1] ^ Uid[2];
+    uint8_t BCC2 = Uid[3] ^ Uid[4] ^ Uid[5] ^ Uid[6];
+
+    MemoryWriteBlock(&Uid[0], UID_CL1_ADDRESS, UID_CL1_SIZE);
+    MemoryWriteBlock(&BCC1, UID_BCC1_ADDRESS, ISO14443A_CL_BCC_SIZE);
+    MemoryWriteBlock(&Uid[UID_CL1_SIZE], UID_CL2_ADDRESS, UID_CL2_SIZE);
+    MemoryWriteBlock(&BCC2, UID_BCC2_ADDRESS, ISO14443A_CL_BCC_SIZE);
+}
+
+bool NTAG21xNdefUpdateAvailable(void) {
+    /* Variant is only valid while one of our configurations is active */
+    return ActiveConfiguration.Application == APPLICATION_NTAG21X;
+}
+
+bool NTAG21xNdefUpdateBlock(void *ByteBuffer, uint32_t BlockAddress, uint16_t ByteCount) {
+    uint16_t Start = DATA_AREA_PAGE * NTAG21X_PAGE_SIZE;
+    uint16_t AreaSize = DataAreaEnd() - Start;
+
+    if (BlockAddress >= AreaSize) {
+        /* Like UPLOAD, silently drop whatever does not fit */
+        return true;
+    }
+
+    ByteCount = MIN(ByteCount, AreaSize - BlockAddress);
+    MemoryWriteBlock(ByteBuffer, Start + BlockAddress, ByteCount);
+
+    return true;
+}
+
+void NTAG21xGetAtqa(uint16_t *Atqa) {
+    *Atqa = CardATQAValue;
+}
+
+void NTAG21xSetAtqa(uint16_t Atqa) {
+    CardATQAValue = Atqa;
+}
+
+void NTAG21xGetSak(uint8_t *Sak) {
+    *Sak = CardSAKValue;
+}
+
+void NTAG21xSetSak(uint8_t Sak) {
+    CardSAKValue = Sak;
+}
@@ -0,0 +1,58 @@
+/*
+ * NTAG21x.h
+ *
+ *  NTAG210/212/213/215/216 and MIFARE Ultralight EV1 emulation
+ *
+ *  All variants share one command engine. They only differ in their descriptor: page count,
+ *  position of the configuration pages, GET_VERSION response and the counters they have.
+ */
+
+#ifndef NTAG21X_H_
+#define NTAG21X_H_
+
+#include "Application.h"
+#include "ISO14443-3A.h"
+
+#define NTAG21X_UID_SIZE        ISO14443A_UID_SIZE_DOUBLE // 7 bytes UID
+#define NTAG21X_PAGE_SIZE       4 // bytes per page
+#define NTAG21X_VERSION_SIZE    8
+
+/* Total pages including UID, lock and configuration pages */
+#define NTAG210_PAGES           20
+#define NTAG212_PAGES           41
+#define NTAG213_PAGES           45
+#define NTAG215_PAGES           135
+#define NTAG216_PAGES           231
+
+/* The counters follow the tag memory, one page each, and are stored with the slot */
+#define NTAG21X_COUNTER_PAGES   3
+#define NTAG21X_MEM_SIZE(Pages) (((Pages) + NTAG21X_COUNTER_PAGES) * NTAG21X_PAGE_SIZE)
+
+void NTAG210AppInit(void);
+void NTAG212AppInit(void);
+void NTAG213AppInit(void);
+void NTAG215AppInit(void);
+void NTAG216AppInit(void);
+/* Ultralight EV1 is the same engine with the EV1 counters */
+void MifareUltralightEV11AppInit(void);
+void MifareUltralightEV12AppInit(void);
+
+void NTAG21xAppReset(void);
+void NTAG21xAppTask(void);
+
+uint16_t NTAG21xAppProcess(uint8_t *Buffer, uint16_t BitCount);
+
+void NTAG21xGetUid(ConfigurationUidType Uid);
+void NTAG21xSetUid(ConfigurationUidType Uid);
+
+/* NDEFUPDATE: XModem callback writing the Type 2 data area from page 4 on. UID, lock and
+ * configuration pages stay untouched, so only the NDEF TLVs change. */
+bool NTAG21xNdefUpdateAvailable(void);
+bool NTAG21xNdefUpdateBlock(void *ByteBuffer, uint32_t BlockAddress, uint16_t ByteCount);
+
+void NTAG21xGetAtqa(uint16_t *Atqa);
+void NTAG21xSetAtqa(uint16_t Atqa);
+void NTAG21xGetSak(uint8_t *Sak);
+void NTAG21xSetSak(uint8_t Sak);
+
+#endif /* NTAG21X_H_ */
@@ -4,6 +4,8 @@
 #include "../Codec/Reader14443-2A.h"
 #include "Crypto1.h"
 #include "../System.h"
+#include "../Random.h"
+#include "../Memory.h"
 #include "../uartcmd.h"
 
 #include "../Terminal/Terminal.h"
@@ -12,12 +14,18 @@
 #define IS_CASCADE_BIT_SET(buf) (buf[0] & 0x04)
 #define IS_ISO14443A_4_COMPLIANT(buf) (buf[0] & 0x20)
 
-#define TRYCOUNT_MAX    16
 
 #define FLAGS_MASK		0x03
 #define FLAGS_PARITY_OK	0x01
 #define FLAGS_NO_DATA	0x02
 
+#define READER_FIELD_OFF_TIME	10 // ms, for short power cycles of the card(s)
+
+#define NESTED_WUPA_RETRY_MAX	2 // WUPA attempts before the field is restarted
+#define NESTED_AUTH_RETRY_MAX	3
+
+#define INVENTORY_CARDS_MAX	8
+
 // TODO replace remaining magic numbers
 
 uint8_t ReaderSendBuffer[CODEC_BUFFER_SIZE];
@@ -44,7 +52,7 @@ static enum {
     STATE_END
 } ReaderState = STATE_IDLE;
 
-static struct {
+typedef struct {
     uint16_t ATQA;
     uint8_t SAK;
     uint8_t UID[10];
@@ -54,7 +62,9 @@ static struct {
         UIDSize_Double = 7,
         UIDSize_Triple = 10
     } UIDSize;
-} CardCharacteristics = {0};
+} CardCharacteristicsType;
+
+static CardCharacteristicsType CardCharacteristics = {0};
 
 typedef enum {
     CardType_NXP_MIFARE_Mini = 0, // do NOT assign another CardType item with a specific value since there are loops over this type
@@ -115,6 +125,46 @@ static const CardIdentificationType PROGMEM CardIdentificationList[] = {
 static CardType CardCandidates[ARRAY_COUNT(CardIdentificationList)];
 static uint8_t CardCandidatesIdx = 0;
 
+static struct {
+    enum {
+        INVENTORY_STATE_IDLE,
+        INVENTORY_STATE_POWERUP,
+        INVENTORY_STATE_REQA,
+        INVENTORY_STATE_ANTICOLLISION,
+        INVENTORY_STATE_SAK,
+        INVENTORY_STATE_HALT
+    } State;
+    uint8_t CascadeLevel;
+    uint8_t KnownBits;
+    uint8_t UidCL[5]; // UID part and BCC of the current cascade level
+    CardCharacteristicsType Current;
+    CardCharacteristicsType Cards[INVENTORY_CARDS_MAX];
+    uint8_t CardCount;
+} Inventory;
+
+static struct {
+    enum {
+        NESTED_STATE_SELECT,
+        NESTED_STATE_AUTH,
+        NESTED_STATE_READER_RESPONSE,
+        NESTED_STATE_NESTED_AUTH
+    } State;
+    uint8_t KeyCmd;
+    uint8_t KeyBlock;
+    uint8_t Key[6];
+    uint8_t Targets[NESTED_TARGETS_MAX][2];
+    uint8_t TargetCount;
+    uint8_t TargetIdx;
+    uint8_t NoncesPerTarget;
+    uint8_t NonceIdx;
+    uint8_t CardNonce[4];
+    uint8_t CardResponse[4];
+    uint8_t MissCount;
+    uint8_t FailCount;
+    bool SessionStored;
+    uint16_t AuthTimestamp;
+} Nested;
+
 uint16_t addParityBits(uint8_t *Buffer, uint16_t BitCount) {
     if (BitCount == 7)
         return 7;
@@ -175,6 +225,62 @@ bool checkParityBits(uint8_t *Buffer, uint16_t BitCount) {
     return true;
 }
 
+static uint16_t NonceMemGetUsed(void) {
+    uint16_t Used;
+    MemoryReadBlock(&Used, FRAM_NONCE_ADDR_ADDR, 2);
+    if (Used > FRAM_NONCE_SIZE || Used % NONCE_RECORD_SIZE) // uninitialized FRAM
+        Used = 0;
+    return Used;
+}
+
+static bool NonceMemAppend(const uint8_t Record[NONCE_RECORD_SIZE]) {
+    uint16_t Used = NonceMemGetUsed();
+    if (Used + NONCE_RECORD_SIZE > FRAM_NONCE_SIZE)
+        return false;
+    MemoryWriteBlock(Record, FRAM_NONCE_START_ADDR + Used, NONCE_RECORD_SIZE);
+    Used += NONCE_RECORD_SIZE;
+    MemoryWriteBlock(&Used, FRAM_NONCE_ADDR_ADDR, 2);
+    return true;
+}
+
+void NonceMemClear(void) {
+    uint16_t Used = 0;
+    MemoryWriteBlock(&Used, FRAM_NONCE_ADDR_ADDR, 2);
+}
+
+uint16_t NonceMemCount(void) {
+    return NonceMemGetUsed() / NONCE_RECORD_SIZE;
+}
+
+bool NonceMemLoadBlock(void *Buffer, uint32_t BlockAddress, uint16_t ByteCount) {
+    uint16_t Used = NonceMemGetUsed();
+    if (BlockAddress >= Used)
+        return false;
+    if (BlockAddress + ByteCount > Used) {
+        memset(Buffer, 0x00, ByteCount); // pad the last block
+        ByteCount = Used - BlockAddress;
+    }
+    MemoryReadBlock(Buffer, FRAM_NONCE_START_ADDR + BlockAddress, ByteCount);
+    return true;
+}
+
+void Reader14443ANestedSetup(const uint8_t Auth[8], const uint8_t *Targets, uint8_t TargetCount, uint8_t NoncesPerTarget) {
+    Nested.KeyCmd = Auth[0];
+    Nested.KeyBlock = Auth[1];
+    memcpy(Nested.Key, Auth + 2, 6);
+    if (TargetCount > NESTED_TARGETS_MAX)
+        TargetCount = NESTED_TARGETS_MAX;
+    memcpy(Nested.Targets, Targets, TargetCount * 2);
+    Nested.TargetCount = TargetCount;
+    Nested.TargetIdx = 0;
+    Nested.NoncesPerTarget = NoncesPerTarget;
+    Nested.NonceIdx = 0;
+    Nested.MissCount = 0;
+    Nested.FailCount = 0;
+    Nested.SessionStored = false;
+    Nested.State = NESTED_STATE_SELECT;
+}
+
 void Reader14443AAppTimeout(void) {
     Reader14443AAppReset();
     Reader14443ACodecReset();
@@ -323,6 +429,179 @@ INLINE uint16_t Reader14443A_RATS(uint8_t *Buffer) {
     return addParityBits(Buffer, 4 * BITS_PER_BYTE);
 }
 
+void Reader14443AInventorySetup(void) {
+    Inventory.State = INVENTORY_STATE_IDLE;
+    Inventory.CardCount = 0;
+}
+
+INLINE uint16_t Reader14443A_REQA(uint8_t *Buffer) {
+    Reader_FWT = ISO14443A_RX_PENDING_TIMEOUT;
+    Buffer[0] = ISO14443A_CMD_REQA; // halted cards must not answer
+    Inventory.State = INVENTORY_STATE_REQA;
+    return 7;
+}
+
+/* Sends the first KnownBits bits of the current cascade level. Only complete bytes are followed by a parity bit. */
+static uint16_t Reader14443A_Anticollision(uint8_t *Buffer) {
+    uint8_t KnownBytes = Inventory.KnownBits / 8;
+    uint8_t RemBits = Inventory.KnownBits % 8;
+    uint8_t Partial = 0;
+
+    if (RemBits)
+        Partial = Inventory.UidCL[KnownBytes] & ((1 << RemBits) - 1);
+    Buffer[0] = ISO14443A_CMD_SELECT_CL1 + 2 * Inventory.CascadeLevel;
+    Buffer[1] = ((2 + KnownBytes) << 4) | RemBits; // NVB
+    memcpy(Buffer + 2, Inventory.UidCL, KnownBytes);
+    uint16_t BitCount = addParityBits(Buffer, (2 + KnownBytes) * BITS_PER_BYTE);
+    if (RemBits) {
+        Buffer[BitCount / 8] = (Buffer[BitCount / 8] & ((1 << (BitCount % 8)) - 1)) | (Partial << (BitCount % 8));
+        if ((BitCount % 8) + RemBits > 8)
+            Buffer[BitCount / 8 + 1] = Partial >> (8 - (BitCount % 8));
+        BitCount += RemBits;
+    }
+    Inventory.State = INVENTORY_STATE_ANTICOLLISION;
+    return BitCount;
+}
+
+/*
+ * Merges the answer to an anticollision frame into the current cascade level. The answer starts with the bits completing a split byte.
+ * Returns false on a collision, in this case the colliding bit is set to 1 and KnownBits points directly behind it.
+ */
+static bool Reader14443A_AnticollisionMerge(uint8_t *Buffer, uint16_t BitCount) {
+    uint8_t Pos = Inventory.KnownBits;
+    bool ParityBit = false;
+    uint16_t i;
+
+    for (i = 0; i < BitCount && Pos < ISO14443A_CL_FRAME_SIZE; i++) {
+        if (ParityBit) {
+            ParityBit = false;
+            continue;
+        }
+        bool Collision = (i == Reader14443ACollisionPosition);
+        if (Collision || ((Buffer[i / 8] >> (i % 8)) & 1))
+            Inventory.UidCL[Pos / 8] |= (1 << (Pos % 8));
+        else
+            Inventory.UidCL[Pos / 8] &= ~(1 << (Pos % 8));
+        Pos++;
+        if (Pos % 8 == 0)
+            ParityBit = true;
+        if (Collision) {
+            Inventory.KnownBits = Pos;
+            return false;
+        }
+    }
+    Inventory.KnownBits = Pos;
+    return true;
+}
+
+static void Reader14443A_InventoryFinish(void) {
+    char tmpBuf[40];
+    uint8_t i;
+
+    Reader14443CurrentCommand = Reader14443_Do_Nothing;
+    Inventory.State = INVENTORY_STATE_IDLE;
+    CodecReaderFieldStop();
+    snprintf_P(tmpBuf, sizeof(tmpBuf), PSTR("%u CARD(S)"), Inventory.CardCount);
+    CommandLinePendingTaskFinished(COMMAND_INFO_OK_WITH_TEXT_ID, tmpBuf);
+    for (i = 0; i < Inventory.CardCount; i++) { // UID ATQA SAK
+        uint16_t charCnt = BufferToHexString(tmpBuf, sizeof(tmpBuf), Inventory.Cards[i].UID, Inventory.Cards[i].UIDSize);
+        snprintf_P(tmpBuf + charCnt, sizeof(tmpBuf) - charCnt, PSTR(" %04X %02X\r\n"), Inventory.Cards[i].ATQA, Inventory.Cards[i].SAK);
+        TerminalSendString(tmpBuf);
+    }
+}
+
+/*
+ * Bit oriented anticollision loop: REQA, resolve one UID by always following the 1-branch of a collision,
+ * select and halt this card and start over until no card answers the REQA anymore.
+ */
+static uint16_t Reader14443A_Inventory(uint8_t *Buffer, uint16_t BitCount) {
+    switch (Inventory.State) {
+        case INVENTORY_STATE_IDLE:
+            /* Power cycle the field, so that cards halted by a former command take part */
+            Inventory.State = INVENTORY_STATE_POWERUP;
+            Reader14443ACodecStart();
+            CodecReaderFieldRestart(READER_FIELD_OFF_TIME);
+            return 0;
+
+        case INVENTORY_STATE_POWERUP:
+            return Reader14443A_REQA(Buffer);
+
+        case INVENTORY_STATE_REQA:
+            if (BitCount == 0) { // no (more) cards in the field
+                Reader14443A_InventoryFinish();
+                return 0;
+            }
+            if (BitCount < ISO14443A_ATQA_FRAME_SIZE + 2)
+                return Reader14443A_REQA(Buffer);
+            /* With multiple cards, colliding ATQA bits are reported as set */
+            removeParityBits(Buffer, ISO14443A_ATQA_FRAME_SIZE + 2);
+            memset(&Inventory.Current, 0, sizeof(Inventory.Current));
+            Inventory.Current.ATQA = Buffer[1] << 8 | Buffer[0];
+            Inventory.CascadeLevel = 0;
+            Inventory.KnownBits = 0;
+            return Reader14443A_Anticollision(Buffer);
+
+        case INVENTORY_STATE_ANTICOLLISION:
+            if (BitCount == 0)
+                return Reader14443A_REQA(Buffer);
+            if (!Reader14443A_AnticollisionMerge(Buffer, BitCount)) {
+                if (Inventory.KnownBits >= ISO14443A_CL_FRAME_SIZE)
+                    return Reader14443A_REQA(Buffer);
+                return Reader14443A_Anticollision(Buffer);
+            }
+            if (Inventory.KnownBits < ISO14443A_CL_FRAME_SIZE || !CHECK_BCC(Inventory.UidCL))
+                return Reader14443A_REQA(Buffer);
+            Buffer[0] = ISO14443A_CMD_SELECT_CL1 + 2 * Inventory.CascadeLevel;
+            Buffer[1] = ISO14443A_NVB_AC_END;
+            memcpy(Buffer + 2, Inventory.UidCL, 5);
+            ISO14443AAppendCRCA(Buffer, 7);
+            Inventory.State = INVENTORY_STATE_SAK;
+            return addParityBits(Buffer, (7 + 2) * BITS_PER_BYTE);
+
+        case INVENTORY_STATE_SAK: {
+            if (BitCount != ISO14443A_SAK_FRAME_SIZE + 3 || !checkParityBits(Buffer, BitCount))
+                return Reader14443A_REQA(Buffer);
+            removeParityBits(Buffer, BitCount);
+            if (ISO14443_CRCA(Buffer, 3) != 0)
+                return Reader14443A_REQA(Buffer);
+
+            uint8_t *UidPart = Inventory.Current.UID + Inventory.CascadeLevel * 3;
+            if (Inventory.UidCL[0] == ISO14443A_UID0_CT)
+                memcpy(UidPart, Inventory.UidCL + 1, 3);
+            else
+                memcpy(UidPart, Inventory.UidCL, 4);
+
+            if (IS_CASCADE_BIT_SET(Buffer) && Inventory.CascadeLevel < 2) {
+                Inventory.CascadeLevel++;
+                Inventory.KnownBits = 0;
+                return Reader14443A_Anticollision(Buffer);
+            }
+            Inventory.Current.SAK = Buffer[0];
+            Inventory.Current.UIDSize = Inventory.CascadeLevel * 3 + 4;
+
+            uint8_t i;
+            for (i = 0; i < Inventory.CardCount; i++) { // a card may not have understood the HLTA
+                if (Inventory.Cards[i].UIDSize == Inventory.Current.UIDSize && memcmp(Inventory.Cards[i].UID, Inventory.Current.UID, Inventory.Current.UIDSize) == 0)
+                    break;
+            }
+            if (i == Inventory.CardCount)
+                Inventory.Cards[Inventory.CardCount++] = Inventory.Current;
+            Inventory.State = INVENTORY_STATE_HALT;
+            return Reader14443A_Halt(Buffer);
+        }
+
+        case INVENTORY_STATE_HALT:
+            if (Inventory.CardCount >= INVENTORY_CARDS_MAX) {
+                Reader14443A_InventoryFinish();
+                return 0;
+            }
+            return Reader14443A_REQA(Buffer);
+
+        default:
+            return 0;
+    }
+}
+
 static bool Identify(uint8_t *Buffer, uint16_t *BitCount) {
     uint16_t rVal = Reader14443A_Select(Buffer, *BitCount);
     if (Selected) {
@@ -481,6 +760,22 @@ static bool Identify(uint8_t *Buffer, uint16_t *BitCount) {
     return false;
 }
 
+static void Reader14443A_NestedFinish(const char *Text) {
+    Reader14443CurrentCommand = Reader14443_Do_Nothing;
+    Selected = false;
+    CodecReaderFieldStop();
+    CommandLinePendingTaskFinished(COMMAND_INFO_OK_WITH_TEXT_ID, Text);
+}
+
+/* Abort the current (encrypted) session and start over with a WUPA. If the card does not answer the WUPA, the field is restarted. */
+static uint16_t Reader14443A_NestedRestart(void) {
+    Nested.State = NESTED_STATE_SELECT;
+    Selected = false;
+    ReaderState = STATE_IDLE;
+    Reader14443ACodecStart();
+    return 0;
+}
+
 uint16_t Reader14443AAppProcess(uint8_t *Buffer, uint16_t BitCount) {
     switch (Reader14443CurrentCommand) {
         case Reader14443_Send: {
@@ -560,126 +855,29 @@ uint16_t Reader14443AAppProcess(uint8_t *Buffer, uint16_t BitCount) {
         }
 
         case Reader14443_Autocalibrate: {
-            static enum {
-                RT_STATE_IDLE,
-                RT_STATE_SEARCHING
-            } RTState = RT_STATE_IDLE;
-            static uint8_t TryCount = 0;
-            static uint8_t Thresholds[(CODEC_THRESHOLD_CALIBRATE_MAX - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS] = {0};
-
-            if (RTState == RT_STATE_IDLE) {
-                CodecThresholdSet(CODEC_THRESHOLD_CALIBRATE_MIN);
-                RTState = RT_STATE_SEARCHING;
-                TryCount = 0;
-            } else if (RTState == RT_STATE_SEARCHING && ReaderState <= STATE_HALT) {
-                if (++TryCount == TRYCOUNT_MAX) {
-                    uint16_t tmp_th = CodecThresholdIncrement();
-                    if ((tmp_th >= CODEC_THRESHOLD_CALIBRATE_MID && (tmp_th - CODEC_THRESHOLD_CALIBRATE_STEPS) < CODEC_THRESHOLD_CALIBRATE_MID)
-                            ||
-                            tmp_th >= CODEC_THRESHOLD_CALIBRATE_MAX) {
-                        bool block = false, finished = false;
-                        uint16_t min = 0;
-                        uint16_t max = 0;
-                        uint16_t maxdiff = 0;
-                        uint16_t maxdiffoffset = 0;
-                        uint16_t numworked;
-                        uint16_t i;
-
-                        // first, search inside the usual search space
-                        if (tmp_th >= CODEC_THRESHOLD_CALIBRATE_MID && (tmp_th - CODEC_THRESHOLD_CALIBRATE_STEPS) < CODEC_THRESHOLD_CALIBRATE_MID) {
-                            for (i = 0; i < (CODEC_THRESHOLD_CALIBRATE_MID - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS; i++) {
-                                if (Thresholds[i] == TRYCOUNT_MAX && i < ((CODEC_THRESHOLD_CALIBRATE_MID - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS - 1)) {
-                                    if (!block) {
-                                        block = true;
-                                        min = i;
-                                    }
-                                } else {
-                                    if (block) {
-                                        block = false;
-                                        max = i;
-                                        if ((max - min) >= maxdiff) {
-                                            maxdiff = max - min;
-                                            maxdiffoffset = min;
-                                        }
-                                    }
-                                }
-                            }
-                            if (maxdiff >= 4) { // if we have found something with at least 5 consecutive working thresholds (only if these thresholds have worked for evers attempt), we are done
-                                finished = true;
-                            }
-                        } else { // we have searched the whole space
-                            for (numworked = TRYCOUNT_MAX; numworked > 0; numworked--) {
-                                for (i = 0; i < (CODEC_THRESHOLD_CALIBRATE_MAX - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS; i++) {
-                                    if (Thresholds[i] >= numworked) {
-                                        if (!block) {
-                                            block = true;
-                                            min = i;
-                                        }
-                                    } else {
-                                        if (block) {
-                                            block = false;
-                                            max = i;
-                                            if ((max - min) >= maxdiff) {
-                                                maxdiff = max - min;
-                                                maxdiffoffset = min;
-                                            }
-                                        }
-                                    }
-                                }
-                                if (maxdiff > 0) {
-                                    break;
-                                }
-                            }
-
-                            finished = true;
-                        }
+            bool Finished;
 
-                        if (finished) {
-
-                            RTState = RT_STATE_IDLE;
-
-                            if (maxdiff != 0)
-                                CodecThresholdSet((maxdiffoffset + maxdiff / 2) * CODEC_THRESHOLD_CALIBRATE_STEPS + CODEC_THRESHOLD_CALIBRATE_MIN);
-                            else
-                                CodecThresholdReset();
-                            SETTING_UPDATE(GlobalSettings.ActiveSettingPtr->ReaderThreshold);
-
-                            CommandLinePendingTaskFinished(COMMAND_INFO_OK_WITH_TEXT_ID, NULL);
-                            uint16_t i_max = (CODEC_THRESHOLD_CALIBRATE_MID - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS;
-                            if (tmp_th >= CODEC_THRESHOLD_CALIBRATE_MAX)
-                                i_max = (CODEC_THRESHOLD_CALIBRATE_MAX - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS;
-                            for (i = 0; i < i_max; i++) {
-                                char tmpBuf[10];
-                                snprintf(tmpBuf, 10, "%4" PRIu16 ": ", i * CODEC_THRESHOLD_CALIBRATE_STEPS + CODEC_THRESHOLD_CALIBRATE_MIN);
-                                TerminalSendString(tmpBuf);
-                                if (Thresholds[i]) {
-                                    snprintf(tmpBuf, 10, "%3" PRIu16, Thresholds[i]);
-                                    TerminalSendString(tmpBuf);
-                                } else {
-                                    TerminalSendChar('-');
-                                }
-                                TerminalSendStringP(PSTR("\r\n"));
-                                Thresholds[i] = 0; // reset the threshold so the next run won't show old results
-                            }
+            uint16_t rVal = Reader14443A_Select(Buffer, BitCount);
+            if (Selected) {
+                Finished = CodecCalibrateSample(true);
+            } else if (ReaderState == STATE_IDLE) { // the select attempt has failed
+                Finished = CodecCalibrateSample(false);
+            } else {
+                return rVal;
+            }
 
+            if (Finished) {
+                SETTING_UPDATE(GlobalSettings.ActiveSettingPtr->ReaderThreshold);
+                CodecCalibrateHistogram((char *) TerminalBuffer, TERMINAL_BUFFER_SIZE);
+                CommandLinePendingTaskFinished(CodecCalibrateFound() ? COMMAND_INFO_OK_WITH_TEXT_ID : COMMAND_INFO_FALSE_ID,
+                                               (char *) TerminalBuffer);
 
-                            Selected = false;
-                            Reader14443CurrentCommand = Reader14443_Do_Nothing;
-                            Reader14443ACodecReset();
-                            return 0;
-                        }
-                    }
-                    TryCount = 0;
-                }
+                Selected = false;
+                Reader14443CurrentCommand = Reader14443_Do_Nothing;
+                Reader14443ACodecReset();
+                return 0;
             }
-
-            uint16_t rVal = Reader14443A_Select(Buffer, BitCount);
-            if (Selected) { // we are done finding the threshold
-                Thresholds[(GlobalSettings.ActiveSettingPtr->ReaderThreshold - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS] += 1;
-                if (TryCount == TRYCOUNT_MAX) {
-                    CodecThresholdIncrement();
-                    TryCount = 0;
-                }
+            if (Selected) {
                 ReaderState = STATE_IDLE;
                 Reader14443ACodecStart();
                 return Reader14443A_Halt(Buffer);
@@ -738,9 +936,14 @@ uint16_t Reader14443AAppProcess(uint8_t *Buffer, uint16_t BitCount) {
                     } else { // clone
                         Reader14443CurrentCommand = Reader14443_Do_Nothing;
                         CodecReaderFieldStop();
-                        MemoryUploadBlock(&MFUContents, 0, 64);
+                        if (!MemorySlotFits(ConfigurationGetMemorySize(CONFIG_MF_ULTRALIGHT))) {
+                            CommandLinePendingTaskFinished(COMMAND_INFO_OK_WITH_TEXT_ID, "No room for the slot");
+                            return 0;
+                        }
                         CommandLinePendingTaskFinished(COMMAND_INFO_OK_WITH_TEXT_ID, "Card Cloned to Slot");
-                        ConfigurationSetById(CONFIG_MF_ULTRALIGHT);
+                        //    The slot is sized for the card before its memory is written
+                        ConfigurationChangeById(CONFIG_MF_ULTRALIGHT);
+                        MemoryUploadBlock(&MFUContents, 0, 64);
                         MemoryStore();
                         SettingsSave();
                     }
@@ -853,9 +1056,11 @@ uint16_t Reader14443AAppProcess(uint8_t *Buffer, uint16_t BitCount) {
                             cfgid = -1;
                     }
 
-                    if (cfgid > -1) {
+                    if (cfgid > -1 && !MemorySlotFits(ConfigurationGetMemorySize(cfgid))) {
+                        CommandLinePendingTaskFinished(COMMAND_INFO_OK_WITH_TEXT_ID, "No room for the slot");
+                    } else if (cfgid > -1) {
                         CommandLinePendingTaskFinished(COMMAND_INFO_OK_WITH_TEXT_ID, "Cloned OK!");
-                        ConfigurationSetById(cfgid);
+                        ConfigurationChangeById(cfgid);
                         ApplicationReset();
                         ApplicationSetUid(CardCharacteristics.UID);
                         MemoryStore();
@@ -877,6 +1082,132 @@ uint16_t Reader14443AAppProcess(uint8_t *Buffer, uint16_t BitCount) {
             return 0;
         }
 
+        case Reader14443_Inventory:
+            return Reader14443A_Inventory(Buffer, BitCount);
+
+        case Reader14443_Nested_Collect: {
+            if (!Selected && ReaderState == STATE_READY && BitCount == 0 && ++Nested.MissCount >= NESTED_WUPA_RETRY_MAX) {
+                /* The card did not recover from the aborted authentication, so it needs a short power cycle */
+                Nested.MissCount = 0;
+                ReaderState = STATE_IDLE;
+                Reader14443ACodecStart();
+                CodecReaderFieldRestart(READER_FIELD_OFF_TIME);
+                return 0;
+            }
+
+            uint16_t rVal = Reader14443A_Select(Buffer, BitCount);
+            if (!Selected)
+                return rVal;
+
+            uint8_t *Uid = CardCharacteristics.UID + CardCharacteristics.UIDSize - 4;
+            switch (Nested.State) {
+                case NESTED_STATE_SELECT:
+                    Nested.MissCount = 0;
+                    if (!Nested.SessionStored) {
+                        uint8_t Record[NONCE_RECORD_SIZE] = {0};
+                        Record[0] = NONCE_RECORD_SESSION;
+                        Record[1] = Nested.KeyCmd;
+                        Record[2] = Nested.KeyBlock;
+                        Record[3] = CardCharacteristics.UIDSize;
+                        memcpy(Record + 4, Uid, 4);
+                        if (!NonceMemAppend(Record)) {
+                            Reader14443A_NestedFinish("NONCE MEMORY FULL");
+                            return 0;
+                        }
+                        Nested.SessionStored = true;
+                    }
+                    Buffer[0] = Nested.KeyCmd;
+                    Buffer[1] = Nested.KeyBlock;
+                    ISO14443AAppendCRCA(Buffer, 2);
+                    Nested.AuthTimestamp = SystemGetSysTick();
+                    Nested.State = NESTED_STATE_AUTH;
+                    return addParityBits(Buffer, 4 * BITS_PER_BYTE);
+
+                case NESTED_STATE_AUTH:
+                    if (BitCount != 4 * 9 || !checkParityBits(Buffer, BitCount))
+                        return Reader14443A_NestedRestart();
+                    removeParityBits(Buffer, BitCount);
+                    memcpy(Nested.CardNonce, Buffer, 4);
+
+                    /* Setup crypto1 cipher. Discard in-place encrypted CardNonce. */
+                    Crypto1Setup(Nested.Key, Uid, Buffer);
+
+                    /* Reader nonce, followed by the reader answer suc^64(nt) */
+                    RandomGetBuffer(Buffer, 4);
+                    memcpy(Buffer + 4, Nested.CardNonce, 4);
+                    Crypto1PRNG(Buffer + 4, 64);
+                    memcpy(Nested.CardResponse, Buffer + 4, 4);
+                    Crypto1PRNG(Nested.CardResponse, 32);
+
+                    addParityBits(Buffer, 8 * BITS_PER_BYTE);
+                    Crypto1ReaderAuthWithParity(Buffer);
+                    Nested.State = NESTED_STATE_READER_RESPONSE;
+                    return 8 * 9;
+
+                case NESTED_STATE_READER_RESPONSE:
+                    if (BitCount == 4 * 9) {
+                        removeParityBits(Buffer, BitCount);
+                        Crypto1ByteArray(Buffer, 4);
+                    }
+                    if (BitCount != 4 * 9 || memcmp(Buffer, Nested.CardResponse, 4) != 0) {
+                        if (++Nested.FailCount >= NESTED_AUTH_RETRY_MAX) {
+                            Reader14443A_NestedFinish("AUTH FAILED");
+                            return 0;
+                        }
+                        return Reader14443A_NestedRestart();
+                    }
+                    Nested.FailCount = 0;
+
+                    Buffer[0] = Nested.Targets[Nested.TargetIdx][0];
+                    Buffer[1] = Nested.Targets[Nested.TargetIdx][1];
+                    ISO14443AAppendCRCA(Buffer, 2);
+                    addParityBits(Buffer, 4 * BITS_PER_BYTE);
+                    Crypto1EncryptWithParity(Buffer, 4 * 9);
+                    Nested.State = NESTED_STATE_NESTED_AUTH;
+                    return 4 * 9;
+
+                case NESTED_STATE_NESTED_AUTH: {
+                    if (BitCount != 4 * 9)
+                        return Reader14443A_NestedRestart();
+
+                    uint16_t Now = SystemGetSysTick();
+                    uint8_t Record[NONCE_RECORD_SIZE];
+                    uint8_t i;
+                    Record[0] = NONCE_RECORD_NONCE;
+                    Record[1] = Nested.Targets[Nested.TargetIdx][0];
+                    Record[2] = Nested.Targets[Nested.TargetIdx][1];
+                    Record[3] = 0;
+                    for (i = 0; i < 4; i++) // the encrypted parity bits leak keystream bits, so keep them
+                        Record[3] |= ((Buffer[(9 * i + 8) / 8] >> ((9 * i + 8) % 8)) & 1) << i;
+                    memcpy(Record + 4, Nested.CardNonce, 4);
+                    removeParityBits(Buffer, BitCount);
+                    memcpy(Record + 8, Buffer, 4);
+                    Record[12] = Now >> 8;
+                    Record[13] = Now & 0xFF;
+                    Record[14] = (uint16_t)(Now - Nested.AuthTimestamp) >> 8;
+                    Record[15] = (uint16_t)(Now - Nested.AuthTimestamp) & 0xFF;
+                    if (!NonceMemAppend(Record)) {
+                        Reader14443A_NestedFinish("NONCE MEMORY FULL");
+                        return 0;
+                    }
+
+                    if (++Nested.NonceIdx >= Nested.NoncesPerTarget) {
+                        Nested.NonceIdx = 0;
+                        if (++Nested.TargetIdx >= Nested.TargetCount) {
+                            char tmpBuf[24];
+                            snprintf_P(tmpBuf, sizeof(tmpBuf), PSTR("%u NONCES COLLECTED"), Nested.TargetCount * Nested.NoncesPerTarget);
+                            Reader14443A_NestedFinish(tmpBuf);
+                            return 0;
+                        }
+                    }
+                    return Reader14443A_NestedRestart();
+                }
+
+                default:
+                    return 0;
+            }
+        }
+
         default: // e.g. Do_Nothing
             return 0;
     }
@@ -6,6 +6,12 @@
 
 #define CRC_INIT 0x6363
 
+/* Nested nonce collection, stored in FRAM behind the detection log (see Log.h) */
+#define NONCE_RECORD_SIZE	16
+#define NONCE_RECORD_SESSION	0x01
+#define NONCE_RECORD_NONCE	0x02
+#define NESTED_TARGETS_MAX	8
+
 extern uint8_t ReaderSendBuffer[];
 extern uint16_t ReaderSendBitCount;
 
@@ -22,6 +28,14 @@ uint16_t removeParityBits(uint8_t *Buffer, uint16_t BitCount);
 bool checkParityBits(uint8_t *Buffer, uint16_t BitCount);
 uint16_t ISO14443_CRCA(uint8_t *Buffer, uint8_t ByteCount);
 
+void Reader14443AInventorySetup(void);
+void Reader14443ANestedSetup(const uint8_t Auth[8], const uint8_t *Targets, uint8_t TargetCount, uint8_t NoncesPerTarget);
+
+/* Nonce memory, for use with XModem */
+void NonceMemClear(void);
+uint16_t NonceMemCount(void);
+bool NonceMemLoadBlock(void *Buffer, uint32_t BlockAddress, uint16_t ByteCount);
+
 typedef enum {
     Reader14443_Do_Nothing,
     Reader14443_Send,
@@ -31,7 +45,9 @@ typedef enum {
     Reader14443_Read_MF_Ultralight,
     Reader14443_Identify,
     Reader14443_Identify_Clone,
-    Reader14443_Clone_MF_Ultralight
+    Reader14443_Clone_MF_Ultralight,
+    Reader14443_Nested_Collect,
+    Reader14443_Inventory
 } Reader14443Command;
 
 
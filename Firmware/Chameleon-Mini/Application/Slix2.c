@@ -0,0 +1,459 @@
+/*
+ * Slix2.c
+ *
+ *  NXP ICODE SLIX2 custom commands, see Slix2.h
+ *
+ *  Passwords are sent XORed with the last random number from GET RANDOM NUMBER. The
+ *  comparison always runs over the whole password, so its timing does not tell how many
+ *  bytes matched. A wrong password mutes the tag until the field is reset, like the
+ *  real chip does.
+ *
+ *  Not supported:
+ *      - The 16 bit counter in block 79, it is a plain block here
+ *      - 64 bit password protection and READ/WRITE CONFIG
+ */
+
+#include "../Random.h"
+#include "../Memory.h"
+#include "ISO15693-A.h"
+#include "ISO15693Tag.h"
+#include "Slix2.h"
+#include <string.h>
+
+/* Mask of the block status in GET MULTIPLE BLOCK PROTECTION STATUS */
+#define BLOCK_STATUS_LOCKED             ( 1 << 0 )
+#define BLOCK_STATUS_READ_PROT          ( 1 << 1 )
+#define BLOCK_STATUS_WRITE_PROT         ( 1 << 2 )
+#define BLOCK_STATUS_PROT_LOCKED        ( 1 << 3 )
+
+/* Same block memory as the engine's SLIX2 descriptor, for the user lock bits */
+static const ISO15693BlockStoreType Blocks = {
+    .DataAddress = SLIX2_MEM_BLOCKS_ADDRESS, .BlockCount = SLIX2_NUMBER_OF_BLCKS,
+    .BlockSize = SLIX2_BYTES_PER_BLCK, .LockLayout = ISO15693_LOCKS_INTERLEAVED
+};
+
+static uint8_t RandomNumber[2];
+static bool RandomValid;
+static uint8_t GrantedPasswords; /* Password IDs received with SET PASSWORD since the last reset */
+static bool WrongPassword;
+/* Cached from the slot, written through on change */
+static uint8_t Config;
+static uint8_t ProtPointer;
+static uint8_t ProtStatus;
+
+void Slix2Reset(void) {
+    RandomValid = false;
+    GrantedPasswords = 0;
+    WrongPassword = false;
+
+    MemoryReadBlock(&Config, SLIX2_MEM_CFG_ADDRESS, 1);
+    MemoryReadBlock(&ProtPointer, SLIX2_MEM_PROT_PTR_ADDRESS, 1);
+    MemoryReadBlock(&ProtStatus, SLIX2_MEM_PROT_STS_ADDRESS, 1);
+}
+
+bool Slix2Muted(uint8_t Command) {
+    if (WrongPassword || (Config & SLIX2_CFG_DESTROYED))
+        return true;
+
+    if ((Config & SLIX2_CFG_PRIVACY) && !(GrantedPasswords & SLIX2_PWD_PRIVACY))
+        /* In privacy mode only the commands to leave it are answered */
+        return (Command != SLIX2_CMD_GET_RANDOM) && (Command != SLIX2_CMD_SET_PSW);
+
+    return false;
+}
+
+/* Protection bits of the page(s) the blocks fall into */
+static uint8_t PageProtection(uint8_t FirstBlock, uint16_t BlockCount) {
+    uint8_t Protection = 0;
+
+    if (FirstBlock < ProtPointer)
+        Protection |= ProtStatus & (SLIX2_PROT_READ_LOW | SLIX2_PROT_WRITE_LOW);
+
+    if (FirstBlock + BlockCount > ProtPointer)
+        Protection |= (ProtStatus & (SLIX2_PROT_READ_HIGH | SLIX2_PROT_WRITE_HIGH)) >> 4;
+
+    return Protection;
+}
+
+bool Slix2Access(uint8_t Command, uint8_t FirstBlock, uint16_t BlockCount) {
+    uint8_t Protection = PageProtection(FirstBlock, BlockCount);
+
+    switch (Command) {
+        case ISO15693_CMD_READ_SINGLE:
+        case ISO15693_CMD_READ_MULTIPLE:
+            return !(Protection & SLIX2_PROT_READ_LOW) || (GrantedPasswords & SLIX2_PWD_READ);
+
+        case ISO15693_CMD_WRITE_SINGLE:
+        case ISO15693_CMD_LOCK_BLOCK:
+            /* A read protected page can't be written without the read password either */
+            if ((Protection & SLIX2_PROT_READ_LOW) && !(GrantedPasswords & SLIX2_PWD_READ))
+                return false;
+            return !(Protection & SLIX2_PROT_WRITE_LOW) || (GrantedPasswords & SLIX2_PWD_WRITE);
+
+        case ISO15693_CMD_WRITE_AFI:
+        case ISO15693_CMD_LOCK_AFI:
+            return !(Config & SLIX2_CFG_AFI_PROT) || (GrantedPasswords & SLIX2_PWD_EAS_AFI);
+
+        default:
+            return true;
+    }
+}
+
+static uint16_t Slix2_ErrorResponse(uint8_t *FrameBuf, uint8_t ErrorCode) {
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_ERROR;
+    FrameBuf[ISO15693_RES_ADDR_PARAM] = ErrorCode;
+    return 2;
+}
+
+static uint16_t Slix2_DoneResponse(uint8_t *FrameBuf) {
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1;
+}
+
+static void WriteConfig(uint8_t NewConfig) {
+    Config = NewConfig;
+    MemoryWriteBlock(&Config, SLIX2_MEM_CFG_ADDRESS, 1);
+}
+
+/* Slot address of a password, or 0 if PasswordId isn't exactly one known password */
+static uint16_t PasswordAddress(uint8_t PasswordId) {
+    for (uint8_t i = 0; i < SLIX2_NUMBER_OF_PASSWORDS; i++) {
+        if (PasswordId == (1 << i))
+            return SLIX2_MEM_PWD_ADDRESS + i * SLIX2_PASSWORD_SIZE;
+    }
+
+    return 0;
+}
+
+static bool CheckXorPassword(uint8_t PasswordId, const uint8_t *XorPassword) {
+    uint8_t Password[SLIX2_PASSWORD_SIZE];
+    uint8_t Difference = 0;
+
+    MemoryReadBlock(Password, PasswordAddress(PasswordId), SLIX2_PASSWORD_SIZE);
+
+    for (uint8_t i = 0; i < SLIX2_PASSWORD_SIZE; i++) {
+        Difference |= Password[i] ^ RandomNumber[i & 1] ^ XorPassword[i];
+    }
+
+    /* A random number is used for one password only */
+    if (!RandomValid || (Difference != 0)) {
+        RandomValid = false;
+        WrongPassword = true;
+        return false;
+    }
+
+    RandomValid = false;
+    return true;
+}
+
+static uint16_t Slix2_GetRandom(uint8_t *FrameBuf) {
+    if (FrameInfo.ParamLen != 0)
+        return ISO15693_APP_NO_RESPONSE;
+
+    RandomGetBuffer(RandomNumber, sizeof(RandomNumber));
+    RandomValid = true;
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    FrameBuf[ISO15693_RES_ADDR_PARAM + 0] = RandomNumber[0];
+    FrameBuf[ISO15693_RES_ADDR_PARAM + 1] = RandomNumber[1];
+    return 3;
+}
+
+static uint16_t Slix2_SetPassword(uint8_t *FrameBuf) {
+    uint8_t PasswordId = FrameInfo.Parameters[0];
+
+    if (FrameInfo.ParamLen != 1 + SLIX2_PASSWORD_SIZE)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (PasswordAddress(PasswordId) == 0)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_OPT_NOT_SUPP);
+
+    if (!CheckXorPassword(PasswordId, &FrameInfo.Parameters[1]))
+        return ISO15693_APP_NO_RESPONSE;
+
+    GrantedPasswords |= PasswordId;
+    return Slix2_DoneResponse(FrameBuf);
+}
+
+static uint16_t Slix2_WritePassword(uint8_t *FrameBuf) {
+    uint8_t PasswordId = FrameInfo.Parameters[0];
+    uint8_t PasswordLock;
+
+    if (FrameInfo.ParamLen != 1 + SLIX2_PASSWORD_SIZE)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (PasswordAddress(PasswordId) == 0)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_OPT_NOT_SUPP);
+
+    if (!(GrantedPasswords & PasswordId))
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    MemoryReadBlock(&PasswordLock, SLIX2_MEM_PWD_LOCK_ADDRESS, 1);
+
+    if (PasswordLock & PasswordId)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_CHG_LKD);
+
+    /* A torn password write would lock the owner out for good */
+    MemoryWriteBlockAtomic(&FrameInfo.Parameters[1], PasswordAddress(PasswordId), SLIX2_PASSWORD_SIZE);
+    return Slix2_DoneResponse(FrameBuf);
+}
+
+static uint16_t Slix2_LockPassword(uint8_t *FrameBuf) {
+    uint8_t PasswordId = FrameInfo.Parameters[0];
+    uint8_t PasswordLock;
+
+    if (FrameInfo.ParamLen != 1)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (PasswordAddress(PasswordId) == 0)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_OPT_NOT_SUPP);
+
+    if (!(GrantedPasswords & PasswordId))
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    MemoryReadBlock(&PasswordLock, SLIX2_MEM_PWD_LOCK_ADDRESS, 1);
+    PasswordLock |= PasswordId;
+    MemoryWriteBlock(&PasswordLock, SLIX2_MEM_PWD_LOCK_ADDRESS, 1);
+    return Slix2_DoneResponse(FrameBuf);
+}
+
+static bool PageProtectionGranted(void) {
+    uint8_t Needed = SLIX2_PWD_READ | SLIX2_PWD_WRITE;
+
+    return (GrantedPasswords & Needed) == Needed;
+}
+
+static uint16_t Slix2_ProtectPage(uint8_t *FrameBuf) {
+    uint8_t Protection[2];
+
+    if (FrameInfo.ParamLen != 2)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (Config & SLIX2_CFG_PROT_LOCK)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_ALRD_LKD);
+
+    if (!PageProtectionGranted())
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    if (FrameInfo.Parameters[0] > SLIX2_NUMBER_OF_BLCKS)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_NOT_AVL);
+
+    ProtPointer = Protection[0] = FrameInfo.Parameters[0];
+    ProtStatus = Protection[1] = FrameInfo.Parameters[1] &
+                                 (SLIX2_PROT_READ_LOW | SLIX2_PROT_WRITE_LOW | SLIX2_PROT_READ_HIGH | SLIX2_PROT_WRITE_HIGH);
+
+    /* Pointer and status have to change together */
+    MemoryWriteBlockAtomic(Protection, SLIX2_MEM_PROT_PTR_ADDRESS, sizeof(Protection));
+    return Slix2_DoneResponse(FrameBuf);
+}
+
+static uint16_t Slix2_LockPageProtection(uint8_t *FrameBuf) {
+    if (FrameInfo.ParamLen != 1)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (Config & SLIX2_CFG_PROT_LOCK)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_ALRD_LKD);
+
+    if (!PageProtectionGranted() || (FrameInfo.Parameters[0] != ProtPointer))
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    WriteConfig(Config | SLIX2_CFG_PROT_LOCK);
+    return Slix2_DoneResponse(FrameBuf);
+}
+
+static uint16_t Slix2_GetBlockProtection(uint8_t *FrameBuf) {
+    uint8_t BlockAddress = FrameInfo.Parameters[0];
+    uint16_t BlocksNumber = FrameInfo.Parameters[1] + 0x01;
+    uint8_t *Status = &FrameBuf[ISO15693_RES_ADDR_PARAM];
+
+    if (FrameInfo.ParamLen != 2)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (BlockAddress >= SLIX2_NUMBER_OF_BLCKS)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_NOT_AVL);
+
+    BlocksNumber = MIN(BlocksNumber, SLIX2_NUMBER_OF_BLCKS - BlockAddress);
+
+    /* Start from the user lock bits, which sit where the block status wants them */
+    ISO15693ReadLockStatuses(&Blocks, Status, BlockAddress, BlocksNumber);
+
+    for (uint8_t i = 0; i < BlocksNumber; i++) {
+        uint8_t Protection = PageProtection(BlockAddress + i, 1);
+
+        Status[i] &= BLOCK_STATUS_LOCKED;
+
+        if (Protection & SLIX2_PROT_READ_LOW) {
+            Status[i] |= BLOCK_STATUS_READ_PROT;
+        }
+
+        if (Protection & SLIX2_PROT_WRITE_LOW) {
+            Status[i] |= BLOCK_STATUS_WRITE_PROT;
+        }
+
+        if (Config & SLIX2_CFG_PROT_LOCK) {
+            Status[i] |= BLOCK_STATUS_PROT_LOCKED;
+        }
+    }
+
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1 + BlocksNumber;
+}
+
+/* DESTROY and ENABLE PRIVACY */
+static uint16_t Slix2_SetStateWithPassword(uint8_t *FrameBuf, uint8_t PasswordId, uint8_t ConfigMask) {
+    if (FrameInfo.ParamLen != SLIX2_PASSWORD_SIZE)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (!CheckXorPassword(PasswordId, FrameInfo.Parameters))
+        return ISO15693_APP_NO_RESPONSE;
+
+    /* The response still goes out, the new state applies from the next command on */
+    GrantedPasswords &= ~SLIX2_PWD_PRIVACY;
+    WriteConfig(Config | ConfigMask);
+    return Slix2_DoneResponse(FrameBuf);
+}
+
+static bool EasGranted(void) {
+    return !(Config & SLIX2_CFG_EAS_PROT) || (GrantedPasswords & SLIX2_PWD_EAS_AFI);
+}
+
+/* SET EAS, RESET EAS and LOCK EAS */
+static uint16_t Slix2_ChangeEas(uint8_t *FrameBuf, uint8_t NewConfig) {
+    if (FrameInfo.ParamLen != 0)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (Config & SLIX2_CFG_EAS_LOCK)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_CHG_LKD);
+
+    if (!EasGranted())
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    WriteConfig(NewConfig);
+    return Slix2_DoneResponse(FrameBuf);
+}
+
+static uint16_t Slix2_EasAlarm(uint8_t *FrameBuf) {
+    uint8_t FramePtr = ISO15693_RES_ADDR_PARAM;
+
+    if (!(Config & SLIX2_CFG_EAS))
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (FrameBuf[ISO15693_ADDR_FLAGS] & ISO15693_REQ_FLAG_OPTION) {
+        /* Only tags matching the EAS ID mask answer, with their EAS ID first */
+        uint8_t MaskLength = FrameInfo.Parameters[0];
+        uint8_t EasId[2];
+
+        if ((FrameInfo.ParamLen == 0) || (MaskLength % 8 != 0) || (MaskLength > 16) ||
+                (FrameInfo.ParamLen != 1 + MaskLength / 8))
+            return ISO15693_APP_NO_RESPONSE;
+
+        MemoryReadBlock(EasId, SLIX2_MEM_EAS_ID_ADDRESS, sizeof(EasId));
+
+        if (memcmp(EasId, &FrameInfo.Parameters[1], MaskLength / 8) != 0)
+            return ISO15693_APP_NO_RESPONSE;
+
+        FrameBuf[FramePtr++] = EasId[0];
+        FrameBuf[FramePtr++] = EasId[1];
+    } else if (FrameInfo.ParamLen != 0) {
+        return ISO15693_APP_NO_RESPONSE;
+    }
+
+    MemoryReadBlock(&FrameBuf[FramePtr], SLIX2_MEM_EAS_SEQ_ADDRESS, SLIX2_EAS_SEQUENCE_SIZE);
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return FramePtr + SLIX2_EAS_SEQUENCE_SIZE;
+}
+
+static uint16_t Slix2_ProtectEasAfi(uint8_t *FrameBuf) {
+    if (FrameInfo.ParamLen != 0)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (!(GrantedPasswords & SLIX2_PWD_EAS_AFI))
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    /* The option flag selects AFI instead of EAS */
+    if (FrameBuf[ISO15693_ADDR_FLAGS] & ISO15693_REQ_FLAG_OPTION) {
+        WriteConfig(Config | SLIX2_CFG_AFI_PROT);
+    } else {
+        WriteConfig(Config | SLIX2_CFG_EAS_PROT);
+    }
+
+    return Slix2_DoneResponse(FrameBuf);
+}
+
+static uint16_t Slix2_WriteEasId(uint8_t *FrameBuf) {
+    if (FrameInfo.ParamLen != 2)
+        return ISO15693_APP_NO_RESPONSE;
+
+    if (Config & SLIX2_CFG_EAS_LOCK)
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_BLK_CHG_LKD);
+
+    if (!EasGranted())
+        return Slix2_ErrorResponse(FrameBuf, ISO15693_RES_ERR_GENERIC);
+
+    MemoryWriteBlock(FrameInfo.Parameters, SLIX2_MEM_EAS_ID_ADDRESS, 2);
+    return Slix2_DoneResponse(FrameBuf);
+}
+
+static uint16_t Slix2_ReadSignature(uint8_t *FrameBuf) {
+    if (FrameInfo.ParamLen != 0)
+        return ISO15693_APP_NO_RESPONSE;
+
+    MemoryReadBlock(&FrameBuf[ISO15693_RES_ADDR_PARAM], SLIX2_MEM_SIG_ADDRESS, SLIX2_SIGNATURE_SIZE);
+    FrameBuf[ISO15693_ADDR_FLAGS] = ISO15693_RES_FLAG_NO_ERROR;
+    return 1 + SLIX2_SIGNATURE_SIZE;
+}
+
+uint16_t Slix2CustomCommand(uint8_t *FrameBuf, uint16_t FrameBytes) {
+    switch (*FrameInfo.Command) {
+        case SLIX2_CMD_GET_RANDOM:
+            return Slix2_GetRandom(FrameBuf);
+
+        case SLIX2_CMD_SET_PSW:
+            return Slix2_SetPassword(FrameBuf);
+
+        case SLIX2_CMD_WRT_PSW:
+            return Slix2_WritePassword(FrameBuf);
+
+        case SLIX2_CMD_LCK_PSW:
+            return Slix2_LockPassword(FrameBuf);
+
+        case SLIX2_CMD_PRT_PAGE:
+            return Slix2_ProtectPage(FrameBuf);
+
+        case SLIX2_CMD_LCK_PAGE_PRT:
+            return Slix2_LockPageProtection(FrameBuf);
+
+        case SLIX2_CMD_GET_BLKS_PRT_STS:
+            return Slix2_GetBlockProtection(FrameBuf);
+
+        case SLIX2_CMD_DESTROY:
+            return Slix2_SetStateWithPassword(FrameBuf, SLIX2_PWD_DESTROY, SLIX2_CFG_DESTROYED);
+
+        case SLIX2_CMD_ENABLE_PRCY:
+            return Slix2_SetStateWithPassword(FrameBuf, SLIX2_PWD_PRIVACY, SLIX2_CFG_PRIVACY);
+
+        case SLIX2_CMD_SET_EAS:
+            return Slix2_ChangeEas(FrameBuf, Config | SLIX2_CFG_EAS);
+
+        case SLIX2_CMD_RST_EAS:
+            return Slix2_ChangeEas(FrameBuf, Config & ~SLIX2_CFG_EAS);
+
+        case SLIX2_CMD_LCK_EAS:
+            return Slix2_ChangeEas(FrameBuf, Config | SLIX2_CFG_EAS_LOCK);
+
+        case SLIX2_CMD_EAS_ALARM:
+            return Slix2_EasAlarm(FrameBuf);
+
+        case SLIX2_CMD_PRT_EAS_AFI:
+            return Slix2_ProtectEasAfi(FrameBuf);
+
+        case SLIX2_CMD_WRT_EAS_ID:
+            return Slix2_WriteEasId(FrameBuf);
+
+        case SLIX2_CMD_READ_SIG:
+            return Slix2_ReadSignature(FrameBuf);
+
+        default:
+            return ISO15693_TAG_CMD_UNKNOWN;
+    }
+}
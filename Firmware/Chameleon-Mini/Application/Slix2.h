@@ -0,0 +1,89 @@
+/*
+ * Slix2.h
+ *
+ *  NXP ICODE SLIX2 emulation
+ *
+ *  The standard commands are answered by the ISO15693 tag engine, see ISO15693Tag.c.
+ *  Passwords, page protection, privacy mode, EAS and the originality signature are
+ *  handled in Slix2.c. All of their state is kept with the slot, so a dump of the
+ *  slot is a complete image of the tag.
+ */
+
+#ifndef SLIX2_H_
+#define SLIX2_H_
+
+#include "Application.h"
+
+#define SLIX2_UID_SIZE                  ISO15693_GENERIC_UID_SIZE
+#define SLIX2_BYTES_PER_BLCK            4
+#define SLIX2_NUMBER_OF_BLCKS           80
+#define SLIX2_PASSWORD_SIZE             4
+#define SLIX2_NUMBER_OF_PASSWORDS       5
+#define SLIX2_EAS_SEQUENCE_SIZE         32
+#define SLIX2_SIGNATURE_SIZE            32
+
+#define SLIX2_IC_REFERENCE              0x01
+
+/* Memory map of a slot */
+#define SLIX2_MEM_BLOCKS_ADDRESS        0x000       // 80 blocks of lock status and 4 data bytes
+#define SLIX2_MEM_UID_ADDRESS           0x190
+#define SLIX2_MEM_AFI_ADDRESS           0x198
+#define SLIX2_MEM_DSFID_ADDRESS         0x199
+#define SLIX2_MEM_INF_ADDRESS           0x19A       // AFI and DSFID lock bits
+#define SLIX2_MEM_CFG_ADDRESS           0x19B       // SLIX2_CFG_* bits
+#define SLIX2_MEM_EAS_ID_ADDRESS        0x19C       // 16 bit EAS ID, LSB first
+#define SLIX2_MEM_PROT_PTR_ADDRESS      0x19E       // First block of the high page
+#define SLIX2_MEM_PROT_STS_ADDRESS      0x19F       // SLIX2_PROT_* bits
+#define SLIX2_MEM_PWD_LOCK_ADDRESS      0x1A0       // One bit per password ID, set when the password is locked
+#define SLIX2_MEM_PWD_ADDRESS           0x1A4       // Read, write, privacy, destroy and EAS/AFI password, LSB first
+#define SLIX2_MEM_EAS_SEQ_ADDRESS       0x1B8       // Answer to EAS ALARM
+#define SLIX2_MEM_SIG_ADDRESS           0x1D8       // Originality signature
+#define SLIX2_MEM_SIZE                  0x1F8
+
+/* Configuration byte */
+#define SLIX2_CFG_EAS                   ( 1 << 0 )  // EAS mode is on
+#define SLIX2_CFG_EAS_LOCK              ( 1 << 1 )
+#define SLIX2_CFG_EAS_PROT              ( 1 << 2 )  // EAS commands need the EAS/AFI password
+#define SLIX2_CFG_AFI_PROT              ( 1 << 3 )  // WRITE AFI and LOCK AFI need the EAS/AFI password
+#define SLIX2_CFG_PRIVACY               ( 1 << 4 )
+#define SLIX2_CFG_DESTROYED             ( 1 << 5 )
+#define SLIX2_CFG_PROT_LOCK             ( 1 << 6 )  // Page protection condition is locked
+
+/* Protection status of the low page (below the pointer) and the high page */
+#define SLIX2_PROT_READ_LOW             ( 1 << 0 )
+#define SLIX2_PROT_WRITE_LOW            ( 1 << 1 )
+#define SLIX2_PROT_READ_HIGH            ( 1 << 4 )
+#define SLIX2_PROT_WRITE_HIGH           ( 1 << 5 )
+
+/* Password identifiers */
+#define SLIX2_PWD_READ                  0x01
+#define SLIX2_PWD_WRITE                 0x02
+#define SLIX2_PWD_PRIVACY               0x04
+#define SLIX2_PWD_DESTROY               0x08
+#define SLIX2_PWD_EAS_AFI               0x10
+
+/* Custom command code */
+#define SLIX2_CMD_SET_EAS               0xA2
+#define SLIX2_CMD_RST_EAS               0xA3
+#define SLIX2_CMD_LCK_EAS               0xA4
+#define SLIX2_CMD_EAS_ALARM             0xA5
+#define SLIX2_CMD_PRT_EAS_AFI           0xA6
+#define SLIX2_CMD_WRT_EAS_ID            0xA7
+#define SLIX2_CMD_GET_RANDOM            0xB2
+#define SLIX2_CMD_SET_PSW               0xB3
+#define SLIX2_CMD_WRT_PSW               0xB4
+#define SLIX2_CMD_LCK_PSW               0xB5
+#define SLIX2_CMD_PRT_PAGE              0xB6
+#define SLIX2_CMD_LCK_PAGE_PRT          0xB7
+#define SLIX2_CMD_GET_BLKS_PRT_STS      0xB8
+#define SLIX2_CMD_DESTROY               0xB9
+#define SLIX2_CMD_ENABLE_PRCY           0xBA
+#define SLIX2_CMD_READ_SIG              0xBD
+
+/* Hooks for the ISO15693 tag engine */
+void Slix2Reset(void);
+bool Slix2Muted(uint8_t Command);
+bool Slix2Access(uint8_t Command, uint8_t FirstBlock, uint16_t BlockCount);
+uint16_t Slix2CustomCommand(uint8_t *FrameBuf, uint16_t FrameBytes);
+
+#endif /* SLIX2_H_ */
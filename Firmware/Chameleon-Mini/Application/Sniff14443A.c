@@ -22,13 +22,8 @@ static enum {
     STATE_SAK,
 } SniffState = STATE_IDLE;
 
-static uint16_t tmp_th = CODEC_THRESHOLD_CALIBRATE_MIN;
-static uint8_t Thresholds[(CODEC_THRESHOLD_CALIBRATE_MAX - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS] = {0};
-
 void Sniff14443AAppInit(void) {
     SniffState = STATE_REQA;
-    // Get current threshold and continue searching from here
-    tmp_th = GlobalSettings.ActiveSettingPtr->ReaderThreshold;
 }
 
 void Sniff14443AAppReset(void) {
@@ -44,18 +39,24 @@ void Sniff14443AAppTimeout(void) {
     Sniff14443AAppReset();
 }
 
+static void CalibrateSample(bool Success) {
+    if (!CodecCalibrateSample(Success))
+        return;
+
+    // Calibration finished, send the histogram to terminal and save value to EEPROM
+    SETTING_UPDATE(GlobalSettings.ActiveSettingPtr->ReaderThreshold);
+    CodecCalibrateHistogram((char *) TerminalBuffer, TERMINAL_BUFFER_SIZE);
+    CommandLinePendingTaskFinished(CodecCalibrateFound() ? COMMAND_INFO_OK_WITH_TEXT_ID : COMMAND_INFO_FALSE_ID,
+                                   (char *) TerminalBuffer);
+    Sniff14443AAppReset();
+}
+
 INLINE void reset2REQA(void) {
     SniffState = STATE_REQA;
     LED_PORT.OUTCLR = LED_RED;
 
-    // Mark the current threshold as fail and continue
-    if (tmp_th < CODEC_THRESHOLD_CALIBRATE_MAX) {
-        Thresholds[(tmp_th - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS] = 0;
-        tmp_th = CodecThresholdIncrement();
-    } else {
-        // mark finish
-        CommandLinePendingTaskFinished(COMMAND_INFO_FALSE_ID, NULL);
-    }
+    // Mark the current frame as fail and continue
+    CalibrateSample(false);
 }
 uint16_t Sniff14443AAppProcess(uint8_t *Buffer, uint16_t BitCount) {
     switch (Sniff14443CurrentCommand) {
@@ -138,21 +139,10 @@ uint16_t Sniff14443AAppProcess(uint8_t *Buffer, uint16_t BitCount) {
                             checkParityBits(Buffer, BitCount)) {
                         if ((Buffer[0] & 0x04) == 0x00) {
                             // UID complete, success SELECTED,
-                            // Mark the current threshold as ok and finish
-                            // reset
+                            // Mark the current frame as ok and wait for the next one
                             SniffState = STATE_REQA;
                             LED_PORT.OUTSET = LED_RED;
-                            Thresholds[(tmp_th - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS] += 1;
-                            CommandLinePendingTaskFinished(COMMAND_INFO_OK_WITH_TEXT_ID, NULL);
-                            // Send this threshold to terminal
-                            char tmpBuf[10];
-                            snprintf(tmpBuf, 10, "%4" PRIu16 ": ", tmp_th);
-                            TerminalSendString(tmpBuf);
-
-                            // Save value to EEPROM
-                            SETTING_UPDATE(GlobalSettings.ActiveSettingPtr->ReaderThreshold);
-
-                            Sniff14443AAppReset();
+                            CalibrateSample(true);
                         } else {
                             // UID not complete, goto ANTICOLLI
                             SniffState = STATE_ANTICOLLI;
@@ -0,0 +1,74 @@
+/*
+ * Sniff15693.c
+ *
+ *  Application layer for sniffing ISO15693
+ *  Logging is done by the codec, this only checks whether frames arrive intact.
+ *  Currently only supports Autocalibrate: a reader request followed by a card
+ *  response with a valid CRC counts as success, a request which is answered with
+ *  a broken frame or not answered at all as failure.
+ */
+
+#include "Sniff15693.h"
+#include "ISO15693-A.h"
+#include "../Codec/SniffISO15693.h"
+#include "../Terminal/Terminal.h"
+#include "../Terminal/CommandLine.h"
+
+Sniff15693Command Sniff15693CurrentCommand = Sniff15693_Do_Nothing;
+
+static bool RequestPending = false;
+
+INLINE bool FrameValid(uint8_t *FrameBuf, uint16_t FrameBytes) {
+    return (FrameBytes > ISO15693_CRC16_SIZE) && ISO15693CheckCRC(FrameBuf, FrameBytes - ISO15693_CRC16_SIZE);
+}
+
+void Sniff15693AppInit(void) {
+    RequestPending = false;
+}
+
+void Sniff15693AppReset(void) {
+    RequestPending = false;
+    Sniff15693CurrentCommand = Sniff15693_Do_Nothing;
+}
+
+void Sniff15693AppTask(void) {/* Empty */}
+void Sniff15693AppTick(void) {/* Empty */}
+
+void Sniff15693AppTimeout(void) {
+    Sniff15693AppReset();
+}
+
+static void CalibrateSample(bool Success) {
+    if (!CodecCalibrateSample(Success))
+        return;
+
+    // Calibration finished, send the histogram to terminal and save value to EEPROM
+    SETTING_UPDATE(GlobalSettings.ActiveSettingPtr->ReaderThreshold);
+    CodecCalibrateHistogram((char *) TerminalBuffer, TERMINAL_BUFFER_SIZE);
+    CommandLinePendingTaskFinished(CodecCalibrateFound() ? COMMAND_INFO_OK_WITH_TEXT_ID : COMMAND_INFO_FALSE_ID,
+                                   (char *) TerminalBuffer);
+    Sniff15693AppReset();
+}
+
+uint16_t Sniff15693AppProcess(uint8_t *FrameBuf, uint16_t FrameBytes) {
+    switch (Sniff15693CurrentCommand) {
+        case Sniff15693_Autocalibrate:
+            if (TrafficSource == TRAFFIC_READER) {
+                /* The threshold only affects the card direction, so broken requests are ignored */
+                if (RequestPending)
+                    CalibrateSample(false);
+                RequestPending = FrameValid(FrameBuf, FrameBytes);
+            } else if (RequestPending) {
+                RequestPending = false;
+                CalibrateSample(FrameValid(FrameBuf, FrameBytes));
+            }
+            break;
+
+        case Sniff15693_Do_Nothing:
+        default:
+            break;
+    }
+
+    /* A sniffer never answers */
+    return ISO15693_APP_NO_RESPONSE;
+}
@@ -0,0 +1,27 @@
+/*
+ * Sniff15693.h
+ *
+ *  Application layer for sniffing ISO15693
+ */
+
+#ifndef SNIFF15693_H_
+#define SNIFF15693_H_
+
+#include <stdint.h>
+
+void Sniff15693AppInit(void);
+void Sniff15693AppReset(void);
+void Sniff15693AppTask(void);
+void Sniff15693AppTick(void);
+void Sniff15693AppTimeout(void);
+
+uint16_t Sniff15693AppProcess(uint8_t *FrameBuf, uint16_t FrameBytes);
+
+typedef enum {
+    Sniff15693_Do_Nothing,
+    Sniff15693_Autocalibrate,
+} Sniff15693Command;
+
+extern Sniff15693Command Sniff15693CurrentCommand;
+
+#endif /* SNIFF15693_H_ */
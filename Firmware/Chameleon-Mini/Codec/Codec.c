@@ -94,3 +94,204 @@ void CodecThresholdReset(void) { // threshold has to be saved back to eeprom by
     DACB.CH0DATA = GlobalSettings.ActiveSettingPtr->ReaderThreshold;
 }
 
+
+/*
+ * Adaptive threshold calibration
+ *
+ * Every tested threshold is sampled over several frames and passes if almost all of them
+ * succeed. A coarse dyadic search (spacing 64, 32, 16, 8 steps) locates the passing region
+ * with few probes, then the edges of the widest passing run are walked step by step.
+ * The result is the center of that window, which gives the largest margin on both sides.
+ */
+enum {
+    CALIBRATE_IDLE,
+    CALIBRATE_COARSE,
+    CALIBRATE_FINE_DOWN,
+    CALIBRATE_FINE_UP,
+    CALIBRATE_DONE
+};
+
+static struct {
+    uint8_t Tries[CODEC_THRESHOLD_CALIBRATE_COUNT];
+    uint8_t Hits[CODEC_THRESHOLD_CALIBRATE_COUNT];
+    uint8_t Phase;
+    uint8_t Spacing;
+    uint8_t Index;
+    uint8_t Lo;
+    uint8_t Hi;
+    bool Found;
+} Calibration = { .Phase = CALIBRATE_IDLE };
+
+INLINE bool CalibrateTested(uint8_t Index) {
+    return Calibration.Tries[Index] != 0;
+}
+
+INLINE bool CalibratePassed(uint8_t Index) {
+    return Calibration.Hits[Index] >= CODEC_THRESHOLD_CALIBRATE_PASS;
+}
+
+static void CalibrateProbe(uint8_t Index) {
+    Calibration.Index = Index;
+    CodecThresholdSet(CODEC_THRESHOLD_CALIBRATE_MIN + (uint16_t) Index * CODEC_THRESHOLD_CALIBRATE_STEPS);
+}
+
+static bool CalibrateFinish(void) {
+    Calibration.Phase = CALIBRATE_DONE;
+    if (Calibration.Found) {
+        uint8_t Center = (Calibration.Lo + Calibration.Hi) / 2;
+        CodecThresholdSet(CODEC_THRESHOLD_CALIBRATE_MIN + (uint16_t) Center * CODEC_THRESHOLD_CALIBRATE_STEPS);
+    } else {
+        CodecThresholdReset();
+    }
+    return true;
+}
+
+// Select the widest run of passing coarse probes and start walking its lower edge
+static bool CalibrateStartFine(void) {
+    uint8_t i, RunStart = 0, BestLength = 0;
+    bool InRun = false;
+
+    for (i = 0; i < CODEC_THRESHOLD_CALIBRATE_COUNT; i++) {
+        if (!CalibrateTested(i))
+            continue;
+        if (!CalibratePassed(i)) {
+            InRun = false;
+            continue;
+        }
+        if (!InRun) {
+            InRun = true;
+            RunStart = i;
+        }
+        if (i - RunStart + 1 > BestLength) {
+            BestLength = i - RunStart + 1;
+            Calibration.Lo = RunStart;
+            Calibration.Hi = i;
+        }
+    }
+
+    if (BestLength == 0) {
+        Calibration.Found = false;
+        return CalibrateFinish();
+    }
+    Calibration.Found = true;
+
+    // The runs are maximal, so the next tested point outside of them has failed already
+    if (Calibration.Lo > 0 && !CalibrateTested(Calibration.Lo - 1)) {
+        Calibration.Phase = CALIBRATE_FINE_DOWN;
+        CalibrateProbe(Calibration.Lo - 1);
+        return false;
+    }
+    if (Calibration.Hi < CODEC_THRESHOLD_CALIBRATE_COUNT - 1 && !CalibrateTested(Calibration.Hi + 1)) {
+        Calibration.Phase = CALIBRATE_FINE_UP;
+        CalibrateProbe(Calibration.Hi + 1);
+        return false;
+    }
+    return CalibrateFinish();
+}
+
+static bool CalibrateNext(bool Passed) {
+    uint8_t Index = Calibration.Index;
+
+    switch (Calibration.Phase) {
+        case CALIBRATE_COARSE:
+            // Next odd multiple of the current spacing, the even ones were tested on a previous level
+            Index += 2 * Calibration.Spacing;
+            if (Index < CODEC_THRESHOLD_CALIBRATE_COUNT) {
+                CalibrateProbe(Index);
+                return false;
+            }
+            if (Calibration.Spacing > CODEC_THRESHOLD_CALIBRATE_FINE) {
+                bool AnyPassed = false;
+                for (Index = 0; Index < CODEC_THRESHOLD_CALIBRATE_COUNT; Index++)
+                    AnyPassed |= CalibratePassed(Index);
+                // A window narrower than twice the spacing could still be hiding between the probes
+                if (!AnyPassed || Calibration.Spacing > 2 * CODEC_THRESHOLD_CALIBRATE_FINE) {
+                    Calibration.Spacing /= 2;
+                    CalibrateProbe(Calibration.Spacing);
+                    return false;
+                }
+            }
+            return CalibrateStartFine();
+
+        case CALIBRATE_FINE_DOWN:
+            if (Passed) {
+                Calibration.Lo = Index;
+                if (Index > 0 && !CalibrateTested(Index - 1)) {
+                    CalibrateProbe(Index - 1);
+                    return false;
+                }
+            }
+            if (Calibration.Hi < CODEC_THRESHOLD_CALIBRATE_COUNT - 1 && !CalibrateTested(Calibration.Hi + 1)) {
+                Calibration.Phase = CALIBRATE_FINE_UP;
+                CalibrateProbe(Calibration.Hi + 1);
+                return false;
+            }
+            return CalibrateFinish();
+
+        case CALIBRATE_FINE_UP:
+            if (Passed) {
+                Calibration.Hi = Index;
+                if (Index < CODEC_THRESHOLD_CALIBRATE_COUNT - 1 && !CalibrateTested(Index + 1)) {
+                    CalibrateProbe(Index + 1);
+                    return false;
+                }
+            }
+            return CalibrateFinish();
+
+        default:
+            return true;
+    }
+}
+
+void CodecCalibrateStart(void) { // threshold has to be saved back to eeprom by the caller, if wanted
+    memset(&Calibration, 0, sizeof(Calibration));
+    Calibration.Phase = CALIBRATE_COARSE;
+    Calibration.Spacing = CODEC_THRESHOLD_CALIBRATE_COARSE;
+    CalibrateProbe(CODEC_THRESHOLD_CALIBRATE_COARSE);
+}
+
+// Record the outcome of one frame at the current threshold. Returns true once the calibration is finished.
+bool CodecCalibrateSample(bool Success) {
+    uint8_t Index = Calibration.Index;
+
+    if (Calibration.Phase == CALIBRATE_IDLE || Calibration.Phase == CALIBRATE_DONE)
+        return true;
+
+    Calibration.Tries[Index]++;
+    if (Success)
+        Calibration.Hits[Index]++;
+
+    // Stop sampling as soon as the verdict for this threshold cannot change anymore
+    if (CalibratePassed(Index))
+        return CalibrateNext(true);
+    if (Calibration.Tries[Index] - Calibration.Hits[Index] > CODEC_THRESHOLD_CALIBRATE_SAMPLES - CODEC_THRESHOLD_CALIBRATE_PASS)
+        return CalibrateNext(false);
+    return false;
+}
+
+bool CodecCalibrateFound(void) {
+    return Calibration.Phase == CALIBRATE_DONE && Calibration.Found;
+}
+
+// Print "threshold: hits/tries" for every tested threshold, the chosen one is marked with '*'
+uint16_t CodecCalibrateHistogram(char *Buffer, uint16_t Size) {
+    uint8_t Center = (Calibration.Lo + Calibration.Hi) / 2;
+    uint16_t Length = 0;
+    uint8_t i;
+
+    Buffer[0] = '\0';
+    for (i = 0; i < CODEC_THRESHOLD_CALIBRATE_COUNT; i++) {
+        if (!CalibrateTested(i))
+            continue;
+        int Written = snprintf_P(Buffer + Length, Size - Length, PSTR("%S%4u: %u/%u%S"), (Length > 0) ? PSTR("\r\n") : PSTR(""),
+                                 CODEC_THRESHOLD_CALIBRATE_MIN + i * CODEC_THRESHOLD_CALIBRATE_STEPS,
+                                 Calibration.Hits[i], Calibration.Tries[i],
+                                 (CodecCalibrateFound() && i == Center) ? PSTR(" *") : PSTR(""));
+        if (Written < 0 || Written >= Size - Length) {
+            Buffer[Length] = '\0';
+            break;
+        }
+        Length += Written;
+    }
+    return Length;
+}
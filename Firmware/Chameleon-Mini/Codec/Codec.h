@@ -37,6 +37,7 @@
 #define CODEC_SUBCARRIER_CC_OOK		CCB
 #define CODEC_SUBCARRIER_CCEN_PSK	TC1_CCAEN_bm
 #define CODEC_SUBCARRIER_CCEN_OOK	TC1_CCBEN_bm
+#define CODEC_SUBCARRIER_PINCTRL_PSK	PIN4CTRL
 #define CODEC_TIMER_SAMPLING		TCD0
 #define CODEC_TIMER_SAMPLING_CCA_VECT	TCD0_CCA_vect
 #define CODEC_TIMER_SAMPLING_CCB_VECT	TCD0_CCB_vect
@@ -63,9 +64,15 @@
 #define CODEC_THRESHOLD_CALIBRATE_MID   768
 #define CODEC_THRESHOLD_CALIBRATE_MAX   2048
 #define CODEC_THRESHOLD_CALIBRATE_STEPS 16
+#define CODEC_THRESHOLD_CALIBRATE_COUNT ((CODEC_THRESHOLD_CALIBRATE_MAX - CODEC_THRESHOLD_CALIBRATE_MIN) / CODEC_THRESHOLD_CALIBRATE_STEPS)
+#define CODEC_THRESHOLD_CALIBRATE_SAMPLES 8 // frames per tested threshold
+#define CODEC_THRESHOLD_CALIBRATE_PASS  (CODEC_THRESHOLD_CALIBRATE_SAMPLES - CODEC_THRESHOLD_CALIBRATE_SAMPLES / 8) // successes needed to pass
+#define CODEC_THRESHOLD_CALIBRATE_COARSE 64 // initial spacing (in steps) of the coarse search
+#define CODEC_THRESHOLD_CALIBRATE_FINE  8 // smallest spacing (in steps) of the coarse search, it stops at twice this once a probe passed
 #define CODEC_TIMER_TIMESTAMPS		TCD1
 #define CODEC_TIMER_TIMESTAMPS_CCA_VECT	TCD1_CCA_vect
 #define CODEC_TIMER_TIMESTAMPS_CCB_VECT	TCD1_CCB_vect
+#define CODEC_TIMER_TIMESTAMPS_OVF_VECT	TCD1_OVF_vect
 
 #ifndef __ASSEMBLER__
 
@@ -80,6 +87,7 @@
 #include "Reader14443-2A.h"
 #include "SniffISO14443-2A.h"
 #include "ISO15693.h"
+#include "SniffISO15693.h"
 
 /* Timing definitions for ISO14443A */
 #define ISO14443A_SUBCARRIER_DIVIDER    16
@@ -88,6 +96,7 @@
 #define ISO14443A_FRAME_DELAY_PREV1     1236
 #define ISO14443A_FRAME_DELAY_PREV0     1172
 #define ISO14443A_RX_PENDING_TIMEOUT	4 // ms
+#define ISO14443A_BPSK_SOF_CYCLES       (32 * ISO14443A_SUBCARRIER_DIVIDER) /* Phase reference before the start bit */
 
 #define CODEC_BUFFER_SIZE           256
 
@@ -110,7 +119,8 @@ extern uint16_t Reader_FWT;
 
 typedef enum {
     CODEC_SUBCARRIERMOD_OFF,
-    CODEC_SUBCARRIERMOD_OOK
+    CODEC_SUBCARRIERMOD_OOK,
+    CODEC_SUBCARRIERMOD_PSK
 } SubcarrierModType;
 
 extern uint8_t CodecBuffer[CODEC_BUFFER_SIZE];
@@ -126,17 +136,19 @@ void isr_ISO15693_CODEC_DEMOD_IN_INT0_VECT(void);
 extern void (* volatile isr_func_CODEC_TIMER_LOADMOD_CCB_VECT)(void);
 void isr_ISO15693_CODEC_TIMER_LOADMOD_CCB_VECT(void);
 void isr_SniffISO14443_2A_CODEC_TIMER_LOADMOD_CCB_VECT(void);
+void isr_SniffISO15693_CODEC_DEMOD_IN_INT0_VECT(void);
+void isr_SniffISO15693_CODEC_TIMER_SAMPLING_CCC_VECT(void);
 
 INLINE void CodecInit(void) {
-    ActiveConfiguration.CodecInitFunc();
+    CODEC_HOOK(Init)();
 }
 
 INLINE void CodecDeInit(void) {
-    ActiveConfiguration.CodecDeInitFunc();
+    CODEC_HOOK(DeInit)();
 }
 
 INLINE void CodecTask(void) {
-    ActiveConfiguration.CodecTaskFunc();
+    CODEC_HOOK(Task)();
 }
 
 /* Helper Functions for Codec implementations */
@@ -216,17 +228,32 @@ INLINE void CodecSetSubcarrier(SubcarrierModType ModType, uint16_t Divider) {
     if (ModType == CODEC_SUBCARRIERMOD_OFF) {
         CODEC_SUBCARRIER_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
         CODEC_SUBCARRIER_TIMER.CTRLB = 0;
+        CODEC_SUBCARRIER_PORT.CODEC_SUBCARRIER_PINCTRL_PSK = 0;
     } else if (ModType == CODEC_SUBCARRIERMOD_OOK) {
         /* Configure subcarrier generation with 50% DC output using OOK */
         CODEC_SUBCARRIER_TIMER.CNT = 0;
         CODEC_SUBCARRIER_TIMER.PER = Divider - 1;
         CODEC_SUBCARRIER_TIMER.CODEC_SUBCARRIER_CC_OOK = Divider / 2;
         CODEC_SUBCARRIER_TIMER.CTRLB = CODEC_SUBCARRIER_CCEN_OOK | TC_WGMODE_SINGLESLOPE_gc;
+    } else if (ModType == CODEC_SUBCARRIERMOD_PSK) {
+        /* Same subcarrier on the PSK output, starting with the reference phase */
+        CODEC_SUBCARRIER_TIMER.CNT = 0;
+        CODEC_SUBCARRIER_TIMER.PER = Divider - 1;
+        CODEC_SUBCARRIER_TIMER.CODEC_SUBCARRIER_CC_PSK = Divider / 2;
+        CODEC_SUBCARRIER_TIMER.CTRLB = CODEC_SUBCARRIER_CCEN_PSK | TC_WGMODE_SINGLESLOPE_gc;
+        CODEC_SUBCARRIER_PORT.CODEC_SUBCARRIER_PINCTRL_PSK = 0;
     }
 }
 
+INLINE void CodecSetSubcarrierPhase(bool bInverted) {
+    /* Inverting the PSK pin shifts the subcarrier phase by 180 degrees */
+    CODEC_SUBCARRIER_PORT.CODEC_SUBCARRIER_PINCTRL_PSK = bInverted ? PORT_INVEN_bm : 0;
+}
+
 INLINE void CodecChangeDivider(uint16_t Divider) {
+    /* Keep the 50% DC when switching between subcarrier frequencies */
     CODEC_SUBCARRIER_TIMER.PER = Divider - 1;
+    CODEC_SUBCARRIER_TIMER.CODEC_SUBCARRIER_CC_OOK = Divider / 2;
 }
 
 INLINE void CodecStartSubcarrier(void) {
@@ -288,6 +315,11 @@ void CodecThresholdSet(uint16_t th);
 uint16_t CodecThresholdIncrement(void);
 void CodecThresholdReset(void);
 
+void CodecCalibrateStart(void);
+bool CodecCalibrateSample(bool Success);
+bool CodecCalibrateFound(void);
+uint16_t CodecCalibrateHistogram(char *Buffer, uint16_t Size);
+
 #endif /* __ASSEMBLER__ */
 
 #endif /* CODEC_H_ */
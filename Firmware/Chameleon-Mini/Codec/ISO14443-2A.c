@@ -11,6 +11,7 @@
 #include "../LEDHook.h"
 #include "Codec.h"
 #include "Log.h"
+#include <util/atomic.h>
 
 /* Sampling is done using internal clock, synchronized to the field modulation.
  * For that we need to convert the bit rate for the internal clock. */
@@ -23,6 +24,15 @@ static volatile struct {
     volatile bool LoadmodFinished;
 } Flags = { 0 };
 
+/* Bit rate divisor integers (D = 2^x) negotiated by PPS. The pending ones take effect
+ * the next time demodulation starts, so the PPS response still goes out at the old rate. */
+static uint8_t Dsi = 0, Dri = 0;
+static uint8_t PendingDsi = 0, PendingDri = 0;
+static uint16_t SampleRateCycles = SAMPLE_RATE_SYSTEM_CYCLES;
+static uint16_t BitGridCycles = ISO14443A_BIT_GRID_CYCLES;
+static uint16_t BitRateCycles = ISO14443A_BIT_RATE_CYCLES;
+static uint8_t SofBits;
+
 typedef enum {
     /* Demod */
     DEMOD_DATA_BIT,
@@ -39,6 +49,11 @@ typedef enum {
     LOADMOD_PARITY1,
     LOADMOD_STOP_BIT0,
     LOADMOD_STOP_BIT1,
+    LOADMOD_BPSK_SOF,
+    LOADMOD_BPSK_START_BIT,
+    LOADMOD_BPSK_DATA,
+    LOADMOD_BPSK_PARITY,
+    LOADMOD_BPSK_EOF,
     LOADMOD_FINISHED
 } StateType;
 
@@ -48,12 +63,21 @@ typedef enum {
 #define ParityRegister	Codec8Reg2
 #define SampleIdxRegister Codec8Reg2
 #define SampleRegister	Codec8Reg3
+#define SofRegister		Codec8Reg3
 #define BitSent			CodecCount16Register1
 #define BitCount		CodecCount16Register2
 #define CodecBufferPtr	CodecPtrRegister1
 #define ParityBufferPtr	CodecPtrRegister2
 
 static void StartDemod(void) {
+    /* Higher bit rates only change the timing, Miller coding and framing stay the same */
+    Dsi = PendingDsi;
+    Dri = PendingDri;
+    SampleRateCycles = SAMPLE_RATE_SYSTEM_CYCLES >> Dri;
+    BitGridCycles = ISO14443A_BIT_GRID_CYCLES >> Dsi;
+    BitRateCycles = ISO14443A_BIT_RATE_CYCLES >> Dsi;
+    SofBits = ISO14443A_BPSK_SOF_CYCLES / BitRateCycles;
+
     /* Activate Power for demodulator */
     CodecSetDemodPower(true);
 
@@ -67,7 +91,7 @@ static void StartDemod(void) {
 
     /* Configure sampling-timer free running and sync to first modulation-pause. */
     CODEC_TIMER_SAMPLING.CNT = 0;                               // Reset the timer count
-    CODEC_TIMER_SAMPLING.PER = SAMPLE_RATE_SYSTEM_CYCLES - 1;   // Set Period regisiter
+    CODEC_TIMER_SAMPLING.PER = SampleRateCycles - 1;   // Set Period regisiter
     CODEC_TIMER_SAMPLING.CCA = 0xFFFF; /* CCA Interrupt is not active! */
     CODEC_TIMER_SAMPLING.CTRLA = TC_CLKSEL_DIV1_gc;
     CODEC_TIMER_SAMPLING.CTRLD = TC_EVACT_RESTART_gc | CODEC_TIMER_MODSTART_EVSEL;
@@ -94,8 +118,8 @@ ISR_SHARED isr_ISO14443_2A_TCD0_CCC_vect(void) {
      * We want to sample the demodulated data stream in the first quarter of the half-bit
      * where the pulsed miller encoded is located. */
     CODEC_TIMER_SAMPLING.CTRLD = TC_EVACT_OFF_gc;
-    CODEC_TIMER_SAMPLING.PERBUF = SAMPLE_RATE_SYSTEM_CYCLES / 2 - 1; /* Half bit width */
-    CODEC_TIMER_SAMPLING.CCABUF = SAMPLE_RATE_SYSTEM_CYCLES / 8 - 14 - 1; /* Compensate for DIGFILT and ISR prolog */
+    CODEC_TIMER_SAMPLING.PERBUF = SampleRateCycles / 2 - 1; /* Half bit width */
+    CODEC_TIMER_SAMPLING.CCABUF = SampleRateCycles / 8 - 14 - 1; /* Compensate for DIGFILT and ISR prolog */
 
     /* Setup Frame Delay Timer and wire to EVSYS. Frame delay time is
      * measured from last change in RF field, therefore we use
@@ -237,6 +261,11 @@ ISR(CODEC_TIMER_LOADMOD_OVF_VECT) {
         [LOADMOD_PARITY1] = && LOADMOD_PARITY1_LABEL,
         [LOADMOD_STOP_BIT0] = && LOADMOD_STOP_BIT0_LABEL,
         [LOADMOD_STOP_BIT1] = && LOADMOD_STOP_BIT1_LABEL,
+        [LOADMOD_BPSK_SOF] = && LOADMOD_BPSK_SOF_LABEL,
+        [LOADMOD_BPSK_START_BIT] = && LOADMOD_BPSK_START_BIT_LABEL,
+        [LOADMOD_BPSK_DATA] = && LOADMOD_BPSK_DATA_LABEL,
+        [LOADMOD_BPSK_PARITY] = && LOADMOD_BPSK_PARITY_LABEL,
+        [LOADMOD_BPSK_EOF] = && LOADMOD_BPSK_EOF_LABEL,
         [LOADMOD_FINISHED] = && LOADMOD_FINISHED_LABEL
     };
 
@@ -248,7 +277,7 @@ ISR(CODEC_TIMER_LOADMOD_OVF_VECT) {
 
 LOADMOD_FDT_LABEL:
     /* No data has been produced, but FDT has ended. Switch over to bit-grid aligning. */
-    CODEC_TIMER_LOADMOD.PER = ISO14443A_BIT_GRID_CYCLES - 1;
+    CODEC_TIMER_LOADMOD.PER = BitGridCycles - 1;
     return;
 
 LOADMOD_START_LABEL:
@@ -366,6 +395,76 @@ LOADMOD_STOP_BIT1_LABEL:
     StateRegister = LOADMOD_FINISHED;
     return;
 
+LOADMOD_BPSK_SOF_LABEL:
+    /* Above 106 kbit/s the subcarrier is phase modulated with one interrupt per bit.
+     * It starts with the reference phase for a while. */
+    CodecSetLoadmodState(true);
+    CodecStartSubcarrier();
+
+    CODEC_TIMER_LOADMOD.PER = BitRateCycles - 1;
+    SofRegister = SofBits;
+    StateRegister = LOADMOD_BPSK_START_BIT;
+    return;
+
+LOADMOD_BPSK_START_BIT_LABEL:
+    if (--SofRegister > 0) {
+        return;
+    }
+
+    /* Start bit is a logic 0, i.e. the first phase change */
+    CodecSetSubcarrierPhase(true);
+    StateRegister = LOADMOD_BPSK_DATA;
+    ParityRegister = ~0;
+    BitSent = 0;
+
+    /* Prefetch first byte */
+    DataRegister = *CodecBufferPtr;
+    return;
+
+LOADMOD_BPSK_DATA_LABEL:
+    /* NRZ-L, a logic 0 is sent with inverted phase */
+    if (DataRegister & 1) {
+        CodecSetSubcarrierPhase(false);
+        ParityRegister = ~ParityRegister;
+    } else {
+        CodecSetSubcarrierPhase(true);
+    }
+
+    DataRegister = DataRegister >> 1;
+    BitSent++;
+
+    if ((BitSent % 8) == 0) {
+        StateRegister = LOADMOD_BPSK_PARITY;
+    } else if (BitSent == BitCount) {
+        StateRegister = LOADMOD_BPSK_EOF;
+    }
+
+    return;
+
+LOADMOD_BPSK_PARITY_LABEL:
+    if (ParityBufferPtr != NULL) {
+        CodecSetSubcarrierPhase(!*ParityBufferPtr);
+        ParityBufferPtr++;
+    } else {
+        CodecSetSubcarrierPhase(!ParityRegister);
+        ParityRegister = ~0;
+    }
+
+    if (BitSent == BitCount) {
+        StateRegister = LOADMOD_BPSK_EOF;
+    } else {
+        DataRegister = *++CodecBufferPtr;
+        StateRegister = LOADMOD_BPSK_DATA;
+    }
+
+    return;
+
+LOADMOD_BPSK_EOF_LABEL:
+    /* End of communication is the subcarrier being switched off */
+    CodecSetLoadmodState(false);
+    StateRegister = LOADMOD_FINISHED;
+    return;
+
 LOADMOD_FINISHED_LABEL:
     /* We have written all of our bits. Deactivate the loadmod
      * timer. Also disable the bit-rate interrupt again. And
@@ -383,6 +482,8 @@ void ISO14443ACodecInit(void) {
     /* Initialize some global vars and start looking out for reader commands */
     Flags.DemodFinished = 0;
     Flags.LoadmodFinished = 0;
+    PendingDsi = 0;
+    PendingDri = 0;
 
     isr_func_TCD0_CCC_vect = &isr_Reader14443_2A_TCD0_CCC_vect;
     isr_func_CODEC_DEMOD_IN_INT0_VECT = &isr_ISO14443_2A_TCD0_CCC_vect;
@@ -415,6 +516,15 @@ void ISO14443ACodecDeInit(void) {
 }
 
 void ISO14443ACodecTask(void) {
+    if ((PendingDsi != Dsi) || (PendingDri != Dri)) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            /* Still waiting for the first modulation pause, restart at the new bit rate right away */
+            if (CODEC_DEMOD_IN_PORT.INT0MASK) {
+                StartDemod();
+            }
+        }
+    }
+
     if (Flags.DemodFinished) {
         Flags.DemodFinished = 0;
         /* Reception finished. Process the received bytes */
@@ -446,9 +556,13 @@ void ISO14443ACodecTask(void) {
 
             BitCount = AnswerBitCount;
             CodecBufferPtr = CodecBuffer;
-            CodecSetSubcarrier(CODEC_SUBCARRIERMOD_OOK, ISO14443A_SUBCARRIER_DIVIDER);
-
-            StateRegister = LOADMOD_START;
+            if (Dsi == 0) {
+                CodecSetSubcarrier(CODEC_SUBCARRIERMOD_OOK, ISO14443A_SUBCARRIER_DIVIDER);
+                StateRegister = LOADMOD_START;
+            } else {
+                CodecSetSubcarrier(CODEC_SUBCARRIERMOD_PSK, ISO14443A_SUBCARRIER_DIVIDER);
+                StateRegister = LOADMOD_BPSK_SOF;
+            }
         } else {
             /* No data to be processed. Disable loadmodding and start listening again */
             CODEC_TIMER_LOADMOD.CTRLA = TC_CLKSEL_OFF_gc;
@@ -466,3 +580,7 @@ void ISO14443ACodecTask(void) {
     }
 }
 
+void ISO14443ACodecSetBitRate(uint8_t NewDsi, uint8_t NewDri) {
+    PendingDsi = MIN(NewDsi, ISO14443A_MAX_DSI);
+    PendingDri = MIN(NewDri, ISO14443A_MAX_DRI);
+}
@@ -15,11 +15,20 @@
 
 #define ISO14443A_BUFFER_PARITY_OFFSET    (CODEC_BUFFER_SIZE/2)
 
+/* Highest bit rate divisor integers (D = 2^x) the ISRs keep up with at F_CPU.
+ * Card to reader uses BPSK with one interrupt per bit, reader to card samples twice per bit. */
+#define ISO14443A_MAX_DSI                 2 /* 424 kbit/s */
+#define ISO14443A_MAX_DRI                 1 /* 212 kbit/s */
+
 /* Codec Interface */
 void ISO14443ACodecInit(void);
 void ISO14443ACodecDeInit(void);
 void ISO14443ACodecTask(void);
 
+/* Switches to the bit rates negotiated by PPS, or back to 106 kbit/s with 0, 0.
+ * A response being prepared is still sent at the old bit rate. */
+void ISO14443ACodecSetBitRate(uint8_t Dsi, uint8_t Dri);
+
 
 
 #endif
@@ -23,6 +23,14 @@
  *      due to possible slowdowns of data generation in the currently running Application. Until the application is done,
  *      the state machine will be stuck in LOADMOD_WAIT state, not outputting any data.
  *      The ISR will now be invoked every 32 carrier pulses (see ISO15693-2:2006, section 8.2), even when waiting for data.
+ *
+ *  Response modes:
+ *      The response is sent with the data rate and subcarrier mode the reader asked for in the request flags
+ *      (see ISO15693-2:2006, section 8). Both are latched in ISO15693_EOC, before the application can overwrite the buffer:
+ *          - high data rate, single subcarrier: half bit of 8 pulses of fc/32 (256 carrier pulses, 26.48 kbit/s)
+ *          - high data rate, dual subcarrier: half bits of 8 pulses of fc/32 and 9 pulses of fc/28 (256 and 252 carrier pulses)
+ *          - low data rate: same as above, with every half bit lasting 4 times as long (6.62 kbit/s)
+ *      Requests are accepted both with 1 out of 4 and 1 out of 256 coding, the SOF tells which one is being used.
  */
 
 #include "ISO15693.h"
@@ -34,20 +42,14 @@
 #include <avr/io.h>
 
 
-#define SOC_1_OF_4_CODE         0x7B
-#define SOC_1_OF_256_CODE       0x7E
-#define EOC_CODE                0xDF
-#define REQ_SUBCARRIER_SINGLE   0x00
-#define REQ_SUBCARRIER_DUAL     0x01
-#define REQ_DATARATE_LOW        0x00
-#define REQ_DATARATE_HIGH       0x02
-#define ISO15693_SAMPLE_CLK     TC_CLKSEL_DIV2_gc // 13.56MHz
-#define ISO15693_SAMPLE_PERIOD  128 // 9.4us
 #define ISO15693_T1_TIME        4352 - 14 /* ISO t1 time - ISR prologue compensation */ // 4192 + 128 + 128 - 1
 
 #define SUBCARRIER_1            32
 #define SUBCARRIER_2            28
 #define SUBCARRIER_OFF          0
+#define HALFBIT_SUBCARRIER_1    256 /* 8 pulses of fc/32 */
+#define HALFBIT_SUBCARRIER_2    252 /* 9 pulses of fc/28 */
+#define LOW_DATARATE_FACTOR     4
 #define SOF_PATTERN             0x1D // 0001 1101
 #define EOF_PATTERN             0xB8 // 1011 1000
 
@@ -97,6 +99,7 @@ static volatile uint8_t ShiftRegister;
 static volatile uint8_t ByteCount;
 static volatile uint16_t BitRate1;
 static volatile uint16_t BitRate2;
+static volatile bool DualSubcarrier;
 static volatile uint16_t SampleDataCount;
 
 /* This function implements CODEC_DEMOD_IN_INT0_VECT interrupt vector.
@@ -120,14 +123,15 @@ ISR_SHARED isr_ISO15693_CODEC_DEMOD_IN_INT0_VECT(void) {
  * when we have 8 bits in SampleRegister and they represent an end of frame.
  */
 INLINE void ISO15693_EOC(void) {
-    /* Set bitrate required by the reader on SOF for our following response */
+    /* Latch the response mode required by the reader in the request flags for our following response */
     if (CodecBuffer[0] & REQ_DATARATE_HIGH) {
-        BitRate1 = 256;
-        BitRate2 = 252; /* If single subcarrier mode is requested, BitRate2 is useless, but setting it nevertheless was still faster than checking */
+        BitRate1 = HALFBIT_SUBCARRIER_1;
+        BitRate2 = HALFBIT_SUBCARRIER_2; /* If single subcarrier mode is requested, BitRate2 is useless, but setting it nevertheless was still faster than checking */
     } else {
-        BitRate1 = 256 * 4; // Possible value: 256 * 4 - 1
-        BitRate2 = 252 * 4; // Possible value: 252 * 4 - 3
+        BitRate1 = HALFBIT_SUBCARRIER_1 * LOW_DATARATE_FACTOR;
+        BitRate2 = HALFBIT_SUBCARRIER_2 * LOW_DATARATE_FACTOR;
     }
+    DualSubcarrier = (CodecBuffer[0] & REQ_SUBCARRIER_DUAL) ? true : false;
 
     Flags.DemodFinished = 1;
     /* Disable demodulation interrupt */
@@ -475,6 +479,8 @@ LOADMOD_FINISHED_LABEL:
     /* Disable compare/capture for all level interrupts on channel B for TCE0 - From 14.12.7 [8331F–AVR–04/2013] */
     CODEC_TIMER_LOADMOD.INTCTRLB = TC_CCBINTLVL_OFF_gc;
     CodecSetSubcarrier(CODEC_SUBCARRIERMOD_OFF, 0);
+    /* A dual subcarrier response keeps the load switched on for its whole length, release it */
+    CodecSetLoadmodState(false);
     Flags.LoadmodFinished = 1;
     return;
 }
@@ -624,15 +630,11 @@ void ISO15693CodecTask(void) {
 
         uint16_t DemodByteCount = ByteCount;
         uint16_t AppReceivedByteCount = 0;
-        bool bDualSubcarrier = false;
 
         if (DemodByteCount > 0) {
             LogEntry(LOG_INFO_CODEC_RX_DATA, CodecBuffer, DemodByteCount);
             LEDHook(LED_CODEC_RX, LED_PULSE);
 
-            if (CodecBuffer[0] & REQ_SUBCARRIER_DUAL) {
-                bDualSubcarrier = true;
-            }
             AppReceivedByteCount = ApplicationProcess(CodecBuffer, DemodByteCount);
         }
 
@@ -651,7 +653,7 @@ void ISO15693CodecTask(void) {
             CodecBufferPtr = CodecBuffer;
 
             /* Start loadmodulating */
-            if (bDualSubcarrier) {
+            if (DualSubcarrier) {
                 CodecSetSubcarrier(CODEC_SUBCARRIERMOD_OOK, SUBCARRIER_2);
                 StateRegister = LOADMOD_START_DUAL;
             } else {
@@ -10,6 +10,17 @@
 
 #define ISO15693_APP_NO_RESPONSE        0x0000
 
+/* Reader to card framing, shared by the emulating and the sniffing codec */
+#define SOC_1_OF_4_CODE         0x7B
+#define SOC_1_OF_256_CODE       0x7E
+#define EOC_CODE                0xDF
+#define REQ_SUBCARRIER_SINGLE   0x00
+#define REQ_SUBCARRIER_DUAL     0x01
+#define REQ_DATARATE_LOW        0x00
+#define REQ_DATARATE_HIGH       0x02
+#define ISO15693_SAMPLE_CLK     TC_CLKSEL_DIV2_gc // 13.56MHz
+#define ISO15693_SAMPLE_PERIOD  128 // 9.4us
+
 /* Codec Interface */
 void ISO15693CodecInit(void);
 void ISO15693CodecDeInit(void);
@@ -26,6 +26,8 @@ static volatile struct {
 
 static volatile uint16_t RxPendingSince;
 
+uint16_t Reader14443ACollisionPosition = ISO14443A_NO_COLLISION;
+
 static volatile enum {
     STATE_IDLE,
     STATE_MILLER_SEND,
@@ -282,6 +284,7 @@ void Reader14443ACodecTask(void) {
     if (!Flags.RxPending && (Flags.Start || Flags.RxDone)) {
         if (State == STATE_FDT && CODEC_TIMER_LOADMOD.CNT < ISO14443A_PICC_TO_PCD_MIN_FDT) // we are in frame delay time, so we can return later
             return;
+        Reader14443ACollisionPosition = ISO14443A_NO_COLLISION;
         if (Flags.RxDone && BitCount > 0) { // decode the raw received data
             if (BitCount < ISO14443A_RX_MINIMUM_BITCOUNT * 2) {
                 BitCount = 0;
@@ -313,8 +316,10 @@ void Reader14443ACodecTask(void) {
                             breakflag = true;
                             break;
 
-                        default:
-                            // error, should not happen, TODO handle this
+                        default: // both halves modulated: collision
+                            if (Reader14443ACollisionPosition == ISO14443A_NO_COLLISION)
+                                Reader14443ACollisionPosition = BitCount;
+                            Insert1();
                             break;
                     }
                     BitCountTmp += 2;
@@ -11,6 +11,11 @@
 #include "Codec.h"
 #include "Terminal/CommandLine.h"
 
+#define ISO14443A_NO_COLLISION	0xFFFF
+
+/* Position of the first collision within the last received frame (including parity bits) */
+extern uint16_t Reader14443ACollisionPosition;
+
 /* Codec Interface */
 void Reader14443ACodecInit(void);
 void Reader14443ACodecDeInit(void);
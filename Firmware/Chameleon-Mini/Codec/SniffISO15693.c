@@ -0,0 +1,439 @@
+/*
+ * SniffISO15693.c
+ *
+ *  Sniffing codec for ISO15693, works in both directions: VCD->VICC, VICC->VCD
+ *  The reader direction is demodulated like in ISO15693.c, the card direction replaces the load modulation.
+ *
+ *  Interrupts information
+ *      - Reader field demodulation uses the shared PORTB INT0 and TCD0 CCC handlers exactly like ISO15693.c
+ *      - Card responses are found by counting subcarrier edges: Analog Comparator 0 (DAC threshold) is routed
+ *        on Event Channel 2, which clocks CODEC_TIMER_LOADMOD (TCE0). TCE0 CCC fires after the first edges of
+ *        the SOF and starts CODEC_TIMER_TIMESTAMPS (TCD1), which overflows once every half bit.
+ *        On every overflow the half bit counts as modulated if enough edges have been seen, pairs of
+ *        half bits are then Manchester decoded.
+ *      - CODEC_SUBCARRIER_TIMER (TCC1) is not needed for load modulation and runs freely at fc/32
+ *        to timestamp the start of each frame.
+ *
+ *  Only single subcarrier card responses are demodulated. Responses to dual subcarrier requests are skipped,
+ *  the edge count of the two subcarriers is too close to tell them apart.
+ */
+
+#include "SniffISO15693.h"
+#include "../System.h"
+#include "../Application/Application.h"
+#include "LEDHook.h"
+
+#define SNIFF_TIMESTAMP_TIMER       CODEC_SUBCARRIER_TIMER
+#define SNIFF_TIMESTAMP_CLK         TC_CLKSEL_DIV64_gc // 27.12MHz / 64 = fc/32
+
+#define SNIFF_CPU_CYCLES_PER_FC     (F_CPU / CODEC_CARRIER_FREQ)
+#define SNIFF_SUBCARRIER_CYCLES     (32 * SNIFF_CPU_CYCLES_PER_FC) // one period of fc/32
+#define SNIFF_HALFBIT_CYCLES_HIGH   (256 * SNIFF_CPU_CYCLES_PER_FC) // 18.88us, 8 subcarrier periods
+#define SNIFF_HALFBIT_CYCLES_LOW    (4 * SNIFF_HALFBIT_CYCLES_HIGH)
+#define SNIFF_EDGES_HIGH            4 // half of the subcarrier periods in a modulated half bit
+#define SNIFF_EDGES_LOW             (4 * SNIFF_EDGES_HIGH)
+#define SNIFF_SOF_EDGES             4 // edges needed before a card SOF is assumed
+#define SNIFF_SOF_ISR_CYCLES        20 // time from the edge to timer start
+#define SNIFF_SOF_PATTERN           0x1D // ___ ^^^ _ ^ in half bits, the first 3 unmodulated ones are not seen
+#define SNIFF_SOF_HALFBITS          5
+
+/* Define pseudo variables to use fast register access. This is useful for global vars */
+#define DataRegister            Codec8Reg0
+#define ModulationPauseCount    Codec8Reg2
+#define SampleRegister          Codec8Reg3
+#define BitSampleCount          CodecCount16Register2
+#define ReaderBufferPtr         CodecPtrRegister1
+#define CardBufferPtr           CodecPtrRegister2
+
+static volatile struct {
+    volatile bool ReaderDataAvailable;
+    volatile bool CardDataAvailable;
+} Flags = { 0 };
+
+typedef enum {
+    DEMOD_SOC_STATE,
+    DEMOD_1_OUT_OF_4_STATE,
+    DEMOD_1_OUT_OF_256_STATE
+} DemodStateType;
+
+static volatile enum {
+    CARD_SOF,
+    CARD_DATA
+} CardState;
+
+static volatile DemodStateType DemodState;
+static volatile uint16_t SampleDataCount;
+static volatile uint8_t ReaderByteCount;
+static volatile uint8_t CardByteCount;
+static volatile uint8_t CardSampleRegister;
+static volatile uint8_t CardDataRegister;
+static volatile uint16_t CardBitCount;
+static volatile uint8_t CardHalfBitCount;
+static uint16_t CardHalfBitCycles = SNIFF_HALFBIT_CYCLES_LOW;
+static uint8_t CardEdgeThreshold = SNIFF_EDGES_LOW;
+
+INLINE void StoreTimestamp(uint8_t *Buffer) {
+    uint16_t Timestamp = SNIFF_TIMESTAMP_TIMER.CNT;
+
+    Buffer[0] = (uint8_t)(Timestamp >> 8);
+    Buffer[1] = (uint8_t)(Timestamp >> 0);
+}
+
+/////////////////////////////////////////////////
+// Card->Reader Direction Traffic
+/////////////////////////////////////////////////
+
+INLINE void CardSniffStop(void) {
+    CODEC_TIMER_TIMESTAMPS.CTRLA = TC_CLKSEL_OFF_gc;
+    CODEC_TIMER_TIMESTAMPS.INTCTRLA = TC_OVFINTLVL_OFF_gc;
+    CODEC_TIMER_TIMESTAMPS.INTFLAGS = TC1_OVFIF_bm;
+
+    CODEC_TIMER_LOADMOD.CTRLA = TC_CLKSEL_OFF_gc;
+    CODEC_TIMER_LOADMOD.INTCTRLB = TC_CCCINTLVL_OFF_gc;
+    CODEC_TIMER_LOADMOD.INTFLAGS = TC0_CCCIF_bm;
+
+    ACA.AC0CTRL = CODEC_AC_DEMOD_SETTINGS;
+}
+
+/* Wait for the first subcarrier edges of a card SOF */
+INLINE void CardSniffStart(void) {
+    CardBufferPtr = &CodecBuffer2[SNIFF_ISO15693_TIMESTAMP_SIZE];
+    CardState = CARD_SOF;
+    CardSampleRegister = 0;
+    CardDataRegister = 0;
+    CardBitCount = 0;
+    CardHalfBitCount = 0;
+
+    /* Every falling edge of the comparator is one subcarrier period */
+    ACA.AC0CTRL = CODEC_AC_DEMOD_SETTINGS | AC_ENABLE_bm;
+    EVSYS.CH2MUX = EVSYS_CHMUX_ACA_CH0_gc;
+    EVSYS.CH2CTRL = EVSYS_DIGFILT_1SAMPLE_gc;
+
+    CODEC_TIMER_LOADMOD.CTRLA = TC_CLKSEL_OFF_gc;
+    CODEC_TIMER_LOADMOD.CTRLD = TC_EVACT_OFF_gc;
+    CODEC_TIMER_LOADMOD.CNT = 0;
+    CODEC_TIMER_LOADMOD.PER = 0xFFFF;
+    CODEC_TIMER_LOADMOD.CCC = SNIFF_SOF_EDGES;
+    CODEC_TIMER_LOADMOD.INTFLAGS = TC0_CCCIF_bm;
+    CODEC_TIMER_LOADMOD.INTCTRLB = TC_CCCINTLVL_HI_gc;
+    CODEC_TIMER_LOADMOD.CTRLA = TC_CLKSEL_EVCH2_gc;
+}
+
+/////////////////////////////////////////////////
+// Reader->Card Direction Traffic
+/////////////////////////////////////////////////
+
+INLINE void ReaderSniffStop(void) {
+    CODEC_DEMOD_IN_PORT.INT0MASK = 0;
+
+    CODEC_TIMER_SAMPLING.CTRLA = TC_CLKSEL_OFF_gc;
+    CODEC_TIMER_SAMPLING.CTRLD = TC_EVACT_OFF_gc;
+    CODEC_TIMER_SAMPLING.INTCTRLB = TC_CCCINTLVL_OFF_gc;
+    CODEC_TIMER_SAMPLING.INTFLAGS = TC0_CCCIF_bm;
+}
+
+/* Reset global variables/interrupts to demodulate incoming reader data via ISRs */
+INLINE void ReaderSniffStart(void) {
+    ReaderBufferPtr = &CodecBuffer[SNIFF_ISO15693_TIMESTAMP_SIZE];
+    DemodState = DEMOD_SOC_STATE;
+    DataRegister = 0;
+    SampleRegister = 0;
+    BitSampleCount = 0;
+    SampleDataCount = 0;
+    ModulationPauseCount = 0;
+    ReaderByteCount = 0;
+
+    CODEC_TIMER_SAMPLING.CTRLA = ISO15693_SAMPLE_CLK;
+    CODEC_TIMER_SAMPLING.CTRLD = TC_EVACT_RESTART_gc | CODEC_TIMER_MODSTART_EVSEL;
+    CODEC_TIMER_SAMPLING.CNT = 0;
+
+    /* Start looking out for modulation pause via interrupt. */
+    CODEC_DEMOD_IN_PORT.INTFLAGS = PORT_INT0IF_bm;
+    CODEC_DEMOD_IN_PORT.INT0MASK = CODEC_DEMOD_IN_MASK0;
+}
+
+/* The card frame has ended, hand it over to the codec task and listen to the reader again */
+INLINE void CardSniffFinish(void) {
+    CardSniffStop();
+
+    CardByteCount = CardBufferPtr - &CodecBuffer2[SNIFF_ISO15693_TIMESTAMP_SIZE];
+    if (CardByteCount > 0)
+        Flags.CardDataAvailable = true;
+
+    if (!Flags.ReaderDataAvailable)
+        ReaderSniffStart();
+}
+
+/* This is the first edge of the first modulation pause of a reader frame */
+ISR_SHARED isr_SniffISO15693_CODEC_DEMOD_IN_INT0_VECT(void) {
+    StoreTimestamp(CodecBuffer);
+
+    /* Clear Compare Channel C (CCC) interrupt Flags and sample the field from now on */
+    CODEC_TIMER_SAMPLING.INTFLAGS = TC0_CCCIF_bm;
+    CODEC_TIMER_SAMPLING.INTCTRLB = TC_CCCINTLVL_HI_gc;
+
+    /* The reader is talking, so there is no card response to wait for anymore */
+    CardSniffStop();
+
+    CODEC_DEMOD_IN_PORT.INT0MASK = 0;
+}
+
+/* Reader frame ended with an EOF */
+INLINE void ReaderSniffEOC(void) {
+    ReaderSniffStop();
+
+    ReaderByteCount = ReaderBufferPtr - &CodecBuffer[SNIFF_ISO15693_TIMESTAMP_SIZE];
+    if (ReaderByteCount == 0) {
+        ReaderSniffStart();
+        return;
+    }
+    Flags.ReaderDataAvailable = true;
+
+    /* The request flags tell us how the card is going to answer */
+    uint8_t RequestFlags = CodecBuffer[SNIFF_ISO15693_TIMESTAMP_SIZE];
+    if (RequestFlags & REQ_DATARATE_HIGH) {
+        CardHalfBitCycles = SNIFF_HALFBIT_CYCLES_HIGH;
+        CardEdgeThreshold = SNIFF_EDGES_HIGH;
+    } else {
+        CardHalfBitCycles = SNIFF_HALFBIT_CYCLES_LOW;
+        CardEdgeThreshold = SNIFF_EDGES_LOW;
+    }
+    if (!(RequestFlags & REQ_SUBCARRIER_DUAL))
+        CardSniffStart();
+}
+
+/* Demodulates 1 out of 4 and 1 out of 256 coded reader frames into CodecBuffer, see ISO15693.c */
+ISR_SHARED isr_SniffISO15693_CODEC_TIMER_SAMPLING_CCC_VECT(void) {
+    /* Shift demod data */
+    SampleRegister = (SampleRegister << 1) | (!(CODEC_DEMOD_IN_PORT.IN & CODEC_DEMOD_IN_MASK) ? 0x01 : 0x00);
+
+    if (++BitSampleCount == 8) {
+        BitSampleCount = 0;
+        switch (DemodState) {
+            case DEMOD_SOC_STATE:
+                if (SampleRegister == SOC_1_OF_4_CODE) {
+                    DemodState = DEMOD_1_OUT_OF_4_STATE;
+                    SampleDataCount = 0;
+                    ModulationPauseCount = 0;
+                } else if (SampleRegister == SOC_1_OF_256_CODE) {
+                    DemodState = DEMOD_1_OUT_OF_256_STATE;
+                    SampleDataCount = 0;
+                } else { // No SOC. Restart and try again, we probably received garbage or a lone EOF.
+                    ReaderSniffStop();
+                    ReaderSniffStart();
+                }
+                break;
+
+            case DEMOD_1_OUT_OF_4_STATE:
+                if (SampleRegister == EOC_CODE) {
+                    ReaderSniffEOC();
+                } else {
+                    uint8_t SampleData = ~SampleRegister;
+                    if (SampleData == (0x01 << 6)) {
+                        /* ^_^^^^^^ -> 00 */
+                        ModulationPauseCount++;
+                        DataRegister >>= 2;
+                    } else if (SampleData == (0x01 << 4)) {
+                        /* ^^^_^^^^ -> 01 */
+                        ModulationPauseCount++;
+                        DataRegister >>= 2;
+                        DataRegister |= 0b01 << 6;
+                    } else if (SampleData == (0x01 << 2)) {
+                        /* ^^^^^_^^ -> 10 */
+                        ModulationPauseCount++;
+                        DataRegister >>= 2;
+                        DataRegister |= 0b10 << 6;
+                    } else if (SampleData == (0x01 << 0)) {
+                        /* ^^^^^^^_ -> 11 */
+                        ModulationPauseCount++;
+                        DataRegister >>= 2;
+                        DataRegister |= 0b11 << 6;
+                    }
+
+                    if (ModulationPauseCount == 4) {
+                        ModulationPauseCount = 0;
+                        if (ReaderBufferPtr < &CodecBuffer[SNIFF_ISO15693_TIMESTAMP_SIZE + SNIFF_ISO15693_FRAME_SIZE_MAX])
+                            *ReaderBufferPtr++ = DataRegister;
+                    }
+                }
+                break;
+
+            case DEMOD_1_OUT_OF_256_STATE:
+                if (SampleRegister == EOC_CODE) {
+                    ReaderSniffEOC();
+                } else {
+                    uint8_t Position = ((SampleDataCount / 2) % 256) - 1;
+                    uint8_t SampleData = ~SampleRegister;
+
+                    if (SampleData == (0x01 << 6)) {
+                        /* ^_^^^^^^ -> N-3 */
+                        DataRegister = Position - 3;
+                        ModulationPauseCount++;
+                    } else if (SampleData == (0x01 << 4)) {
+                        /* ^^^_^^^^ -> N-2 */
+                        DataRegister = Position - 2;
+                        ModulationPauseCount++;
+                    } else if (SampleData == (0x01 << 2)) {
+                        /* ^^^^^_^^ -> N-1 */
+                        DataRegister = Position - 1;
+                        ModulationPauseCount++;
+                    } else if (SampleData == (0x01 << 0)) {
+                        /* ^^^^^^^_ -> N-0 */
+                        DataRegister = Position - 0;
+                        ModulationPauseCount++;
+                    }
+
+                    if (ModulationPauseCount == 1) {
+                        ModulationPauseCount = 0;
+                        if (ReaderBufferPtr < &CodecBuffer[SNIFF_ISO15693_TIMESTAMP_SIZE + SNIFF_ISO15693_FRAME_SIZE_MAX])
+                            *ReaderBufferPtr++ = DataRegister;
+                    }
+                }
+                break;
+        }
+    }
+    SampleDataCount++;
+}
+
+/* The first subcarrier edges of a card SOF have been counted: start sampling on the half bit grid */
+ISR(CODEC_TIMER_LOADMOD_CCC_VECT) {
+    StoreTimestamp(CodecBuffer2);
+
+    CODEC_TIMER_LOADMOD.INTCTRLB = TC_CCCINTLVL_OFF_gc;
+    /* Do not mistake the load modulation for reader pauses until the card is done */
+    CODEC_DEMOD_IN_PORT.INT0MASK = 0;
+
+    /* The edges counted so far belong to the first half bit, so the grid starts SNIFF_SOF_EDGES periods ago */
+    CODEC_TIMER_TIMESTAMPS.CTRLA = TC_CLKSEL_OFF_gc;
+    CODEC_TIMER_TIMESTAMPS.CTRLB = 0;
+    CODEC_TIMER_TIMESTAMPS.CTRLD = TC_EVACT_OFF_gc;
+    CODEC_TIMER_TIMESTAMPS.PER = CardHalfBitCycles - 1;
+    CODEC_TIMER_TIMESTAMPS.CNT = SNIFF_SOF_EDGES * SNIFF_SUBCARRIER_CYCLES + SNIFF_SOF_ISR_CYCLES;
+    CODEC_TIMER_TIMESTAMPS.INTFLAGS = TC1_OVFIF_bm;
+    CODEC_TIMER_TIMESTAMPS.INTCTRLA = TC_OVFINTLVL_HI_gc;
+    CODEC_TIMER_TIMESTAMPS.CTRLA = TC_CLKSEL_DIV1_gc;
+}
+
+/* Called once every half bit of a card frame */
+ISR(CODEC_TIMER_TIMESTAMPS_OVF_VECT) {
+    uint16_t Edges = CODEC_TIMER_LOADMOD.CNT;
+    CODEC_TIMER_LOADMOD.CNT = 0;
+
+    uint8_t NewSampleRegister = (CardSampleRegister << 1) | ((Edges >= CardEdgeThreshold) ? 0x01 : 0x00);
+    CardSampleRegister = NewSampleRegister;
+    CardHalfBitCount++;
+
+    if (CardState == CARD_SOF) {
+        if (CardHalfBitCount < SNIFF_SOF_HALFBITS)
+            return;
+
+        if ((NewSampleRegister & 0x1F) == SNIFF_SOF_PATTERN) {
+            CardState = CARD_DATA;
+            CardHalfBitCount = 0;
+        } else {
+            /* The edges were noise, wait for the real SOF */
+            CardSniffStop();
+            CardSniffStart();
+            if (!Flags.ReaderDataAvailable)
+                ReaderSniffStart();
+        }
+        return;
+    }
+
+    /* Manchester decoding needs both half bits */
+    if (CardHalfBitCount & 0x01)
+        return;
+
+    switch (NewSampleRegister & 0x03) {
+        case 0b10: // modulated, unmodulated -> 0
+            CardDataRegister >>= 1;
+            break;
+
+        case 0b01: // unmodulated, modulated -> 1
+            CardDataRegister = (CardDataRegister >> 1) | 0x80;
+            break;
+
+        default:
+            /* Both halves modulated is the EOF following its leading logic 0, which leaves a single
+             * bit behind that is dropped here. Both halves unmodulated means the card stopped without EOF. */
+            CardSniffFinish();
+            return;
+    }
+
+    if ((++CardBitCount & 0x07) == 0) {
+        if (CardBufferPtr < &CodecBuffer2[SNIFF_ISO15693_TIMESTAMP_SIZE + SNIFF_ISO15693_FRAME_SIZE_MAX])
+            *CardBufferPtr++ = CardDataRegister;
+    }
+}
+
+/////////////////////////////////////////////////
+// Init and deInit, task, functions for this codec
+/////////////////////////////////////////////////
+
+void SniffISO15693CodecInit(void) {
+    CodecInitCommon();
+
+    /* Register shared ISR handlers for the reader direction */
+    isr_func_TCD0_CCC_vect = &isr_SniffISO15693_CODEC_TIMER_SAMPLING_CCC_VECT;
+    isr_func_CODEC_DEMOD_IN_INT0_VECT = &isr_SniffISO15693_CODEC_DEMOD_IN_INT0_VECT;
+
+    /* Configure sampling-timer free running and sync to first modulation-pause */
+    CODEC_TIMER_SAMPLING.PER = ISO15693_SAMPLE_PERIOD - 1;
+    CODEC_TIMER_SAMPLING.CCC = ISO15693_SAMPLE_PERIOD / 2 - 14 - 1;
+    CODEC_TIMER_SAMPLING.INTCTRLB = TC_CCCINTLVL_OFF_gc;
+    CODEC_TIMER_SAMPLING.INTFLAGS = TC0_CCCIF_bm;
+
+    CODEC_TIMER_LOADMOD.INTCTRLA = 0;
+    CODEC_TIMER_TIMESTAMPS.INTCTRLB = 0;
+
+    /* Free running frame timestamps */
+    SNIFF_TIMESTAMP_TIMER.CTRLB = 0;
+    SNIFF_TIMESTAMP_TIMER.PER = 0xFFFF;
+    SNIFF_TIMESTAMP_TIMER.CNT = 0;
+    SNIFF_TIMESTAMP_TIMER.CTRLA = SNIFF_TIMESTAMP_CLK;
+
+    CodecSetDemodPower(true);
+
+    Flags.ReaderDataAvailable = false;
+    Flags.CardDataAvailable = false;
+
+    ReaderSniffStart();
+}
+
+void SniffISO15693CodecDeInit(void) {
+    ReaderSniffStop();
+    CardSniffStop();
+
+    EVSYS.CH2MUX = 0;
+    EVSYS.CH2CTRL = 0;
+    SNIFF_TIMESTAMP_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
+
+    CodecSetDemodPower(false);
+}
+
+void SniffISO15693CodecTask(void) {
+    if (Flags.ReaderDataAvailable) {
+        Flags.ReaderDataAvailable = false;
+
+        LogEntry(LOG_INFO_CODEC_SNI_ISO15693_READER_DATA, CodecBuffer, SNIFF_ISO15693_TIMESTAMP_SIZE + ReaderByteCount);
+        LEDHook(LED_CODEC_RX, LED_PULSE);
+
+        // Let the Application layer know where this data comes from
+        TrafficSource = TRAFFIC_READER;
+        ApplicationProcess(&CodecBuffer[SNIFF_ISO15693_TIMESTAMP_SIZE], ReaderByteCount);
+
+        /* The card might still be answering, it restarts the reader demodulation once it is done */
+        if (!(CODEC_TIMER_TIMESTAMPS.INTCTRLA & TC1_OVFINTLVL_gm))
+            ReaderSniffStart();
+    }
+
+    if (Flags.CardDataAvailable) {
+        Flags.CardDataAvailable = false;
+
+        LogEntry(LOG_INFO_CODEC_SNI_ISO15693_CARD_DATA, CodecBuffer2, SNIFF_ISO15693_TIMESTAMP_SIZE + CardByteCount);
+        LEDHook(LED_CODEC_RX, LED_PULSE);
+
+        TrafficSource = TRAFFIC_CARD;
+        ApplicationProcess(&CodecBuffer2[SNIFF_ISO15693_TIMESTAMP_SIZE], CardByteCount);
+    }
+}
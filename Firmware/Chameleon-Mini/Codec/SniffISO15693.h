@@ -0,0 +1,22 @@
+/*
+ * SniffISO15693.h
+ *
+ *  Sniffing codec for ISO15693, works in both directions: VCD->VICC, VICC->VCD
+ */
+
+#ifndef SNIFF_ISO15693_H_
+#define SNIFF_ISO15693_H_
+
+#include "Codec.h"
+
+/* Every sniffed frame is logged with a big endian timestamp of its start in front of it.
+ * The timestamp counts in units of fc/32 (~2.36us) and wraps around every ~155ms. */
+#define SNIFF_ISO15693_TIMESTAMP_SIZE   2
+#define SNIFF_ISO15693_FRAME_SIZE_MAX   (0xFF - SNIFF_ISO15693_TIMESTAMP_SIZE) // a log entry holds at most 255 bytes
+
+/* Codec Interface */
+void SniffISO15693CodecInit(void);
+void SniffISO15693CodecDeInit(void);
+void SniffISO15693CodecTask(void);
+
+#endif /* SNIFF_ISO15693_H_ */
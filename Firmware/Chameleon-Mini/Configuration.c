@@ -51,8 +51,15 @@ static const MapEntryType PROGMEM ConfigurationMap[] = {
 #ifdef CONFIG_ISO14443A_READER_SUPPORT
     { .Id = CONFIG_ISO14443A_READER,	.Text = "ISO14443A_READER" },
 #endif
-#ifdef CONFIG_NTAG215_SUPPORT
+#ifdef CONFIG_NTAG21X_SUPPORT
+    { .Id = CONFIG_NTAG210,	.Text = "NTAG210" },
+    { .Id = CONFIG_NTAG212,	.Text = "NTAG212" },
+    { .Id = CONFIG_NTAG213,	.Text = "NTAG213" },
     { .Id = CONFIG_NTAG215,	.Text = "NTAG215" },
+    { .Id = CONFIG_NTAG216,	.Text = "NTAG216" },
+#endif
+#ifdef CONFIG_MF_DESFIRE_SUPPORT
+    { .Id = CONFIG_MF_DESFIRE,	.Text = "MF_DESFIRE_EV1" },
 #endif
 #ifdef CONFIG_VICINITY_SUPPORT
     { .Id = CONFIG_VICINITY,	.Text = "VICINITY" },
@@ -69,43 +76,22 @@ static const MapEntryType PROGMEM ConfigurationMap[] = {
 #ifdef CONFIG_EM4233_SUPPORT
     { .Id = CONFIG_EM4233,	.Text = "EM4233" },
 #endif
+#ifdef CONFIG_ICODE_SLIX2_SUPPORT
+    { .Id = CONFIG_ICODE_SLIX2,	.Text = "ICODE_SLIX2" },
+#endif
 };
 
 /* Include all Codecs and Applications */
 #include "Codec/Codec.h"
 #include "Application/Application.h"
 
-static void CodecInitDummy(void) { }
-static void CodecDeInitDummy(void) { }
-static void CodecTaskDummy(void) { }
 static void ApplicationInitDummy(void) {}
-static void ApplicationResetDummy(void) {}
-static void ApplicationTaskDummy(void) {}
-static void ApplicationTickDummy(void) {}
-static uint16_t ApplicationProcessDummy(uint8_t *ByteBuffer, uint16_t ByteCount) { return 0; }
-static void ApplicationGetUidDummy(ConfigurationUidType Uid) { }
-static void ApplicationSetUidDummy(ConfigurationUidType Uid) { }
-static void ApplicationGetAtqaDummy(uint16_t * Atqa) { *Atqa = CONFIGURATION_DUMMY_ATQA; }
-static void ApplicationSetAtqaDummy(uint16_t Atqa) { }
-static void ApplicationGetSakDummy(uint8_t * Sak) { *Sak = CONFIGURATION_DUMMY_SAK; }
-static void ApplicationSetSakDummy(uint8_t Sak) { }
 
 static const PROGMEM ConfigurationType ConfigurationTable[] = {
     [CONFIG_NONE] = {
-        .CodecInitFunc = CodecInitDummy,
-        .CodecDeInitFunc = CodecDeInitDummy,
-        .CodecTaskFunc = CodecTaskDummy,
+        .Codec = CODEC_NONE,
+        .Application = APPLICATION_NONE,
         .ApplicationInitFunc = ApplicationInitDummy,
-        .ApplicationResetFunc = ApplicationResetDummy,
-        .ApplicationTaskFunc = ApplicationTaskDummy,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = ApplicationProcessDummy,
-        .ApplicationGetUidFunc = ApplicationGetUidDummy,
-        .ApplicationSetUidFunc = ApplicationSetUidDummy,
-        .ApplicationGetSakFunc = ApplicationGetSakDummy,
-        .ApplicationSetSakFunc = ApplicationSetSakDummy,
-        .ApplicationGetAtqaFunc = ApplicationGetAtqaDummy,
-        .ApplicationSetAtqaFunc = ApplicationSetAtqaDummy,
         .UidSize = 0,
         .MemorySize = 0,
         .ReadOnly = true,
@@ -113,102 +99,47 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
     },
 #ifdef CONFIG_MF_ULTRALIGHT_SUPPORT
     [CONFIG_MF_ULTRALIGHT] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_ULTRALIGHT,
         .ApplicationInitFunc = MifareUltralightAppInit,
-        .ApplicationResetFunc = MifareUltralightAppReset,
-        .ApplicationTaskFunc = MifareUltralightAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareUltralightAppProcess,
-        .ApplicationGetUidFunc = MifareUltralightGetUid,
-        .ApplicationSetUidFunc = MifareUltralightSetUid,
-        .ApplicationGetSakFunc = MifareUltralightGetSak,
-        .ApplicationSetSakFunc = MifareUltralightSetSak,
-        .ApplicationGetAtqaFunc = MifareUltralightGetAtqa,
-        .ApplicationSetAtqaFunc = MifareUltralightSetAtqa,
         .UidSize = MIFARE_ULTRALIGHT_UID_SIZE,
         .MemorySize = MIFARE_ULTRALIGHT_MEM_SIZE,
         .ReadOnly = false,
         .TagFamily = TAG_FAMILY_ISO14443A
     },
     [CONFIG_MF_ULTRALIGHT_C] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_ULTRALIGHT_C,
         .ApplicationInitFunc = MifareUltralightCAppInit,
-        .ApplicationResetFunc = MifareUltralightCAppReset,
-        .ApplicationTaskFunc = MifareUltralightAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareUltralightAppProcess,
-        .ApplicationGetUidFunc = MifareUltralightGetUid,
-        .ApplicationSetUidFunc = MifareUltralightSetUid,
-        .ApplicationGetSakFunc = MifareUltralightGetSak,
-        .ApplicationSetSakFunc = MifareUltralightSetSak,
-        .ApplicationGetAtqaFunc = MifareUltralightGetAtqa,
-        .ApplicationSetAtqaFunc = MifareUltralightSetAtqa,
         .UidSize = MIFARE_ULTRALIGHT_UID_SIZE,
         .MemorySize = MIFARE_ULTRALIGHTC_MEM_SIZE,
         .ReadOnly = false,
         .TagFamily = TAG_FAMILY_ISO14443A
     },
     [CONFIG_MF_ULTRALIGHT_EV1_80B] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_NTAG21X,
         .ApplicationInitFunc = MifareUltralightEV11AppInit,
-        .ApplicationResetFunc = MifareUltralightAppReset,
-        .ApplicationTaskFunc = MifareUltralightAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareUltralightAppProcess,
-        .ApplicationGetUidFunc = MifareUltralightGetUid,
-        .ApplicationSetUidFunc = MifareUltralightSetUid,
-        .ApplicationGetSakFunc = MifareUltralightGetSak,
-        .ApplicationSetSakFunc = MifareUltralightSetSak,
-        .ApplicationGetAtqaFunc = MifareUltralightGetAtqa,
-        .ApplicationSetAtqaFunc = MifareUltralightSetAtqa,
-        .UidSize = MIFARE_ULTRALIGHT_UID_SIZE,
-        .MemorySize = MIFARE_ULTRALIGHT_EV11_MEM_SIZE,
+        .UidSize = NTAG21X_UID_SIZE,
+        .MemorySize = NTAG21X_MEM_SIZE(MIFARE_ULTRALIGHT_EV11_PAGES),
         .ReadOnly = false,
         .TagFamily = TAG_FAMILY_ISO14443A
     },
     [CONFIG_MF_ULTRALIGHT_EV1_164B] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_NTAG21X,
         .ApplicationInitFunc = MifareUltralightEV12AppInit,
-        .ApplicationResetFunc = MifareUltralightAppReset,
-        .ApplicationTaskFunc = MifareUltralightAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareUltralightAppProcess,
-        .ApplicationGetUidFunc = MifareUltralightGetUid,
-        .ApplicationSetUidFunc = MifareUltralightSetUid,
-        .ApplicationGetSakFunc = MifareUltralightGetSak,
-        .ApplicationSetSakFunc = MifareUltralightSetSak,
-        .ApplicationGetAtqaFunc = MifareUltralightGetAtqa,
-        .ApplicationSetAtqaFunc = MifareUltralightSetAtqa,
-        .UidSize = MIFARE_ULTRALIGHT_UID_SIZE,
-        .MemorySize = MIFARE_ULTRALIGHT_EV12_MEM_SIZE,
+        .UidSize = NTAG21X_UID_SIZE,
+        .MemorySize = NTAG21X_MEM_SIZE(MIFARE_ULTRALIGHT_EV12_PAGES),
         .ReadOnly = false,
         .TagFamily = TAG_FAMILY_ISO14443A
     },
 #endif
 #ifdef CONFIG_MF_CLASSIC_MINI_4B_SUPPORT
     [CONFIG_MF_CLASSIC_MINI_4B] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_CLASSIC,
         .ApplicationInitFunc = MifareClassicAppInitMini4B,
-        .ApplicationResetFunc = MifareClassicAppReset,
-        .ApplicationTaskFunc = MifareClassicAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareClassicAppProcess,
-        .ApplicationGetUidFunc = MifareClassicGetUid,
-        .ApplicationSetUidFunc = MifareClassicSetUid,
-        .ApplicationGetSakFunc = MifareClassicGetSak,
-        .ApplicationSetSakFunc = MifareClassicSetSak,
-        .ApplicationGetAtqaFunc = MifareClassicGetAtqa,
-        .ApplicationSetAtqaFunc = MifareClassicSetAtqa,
         .UidSize = MIFARE_CLASSIC_UID_SIZE,
         .MemorySize = MIFARE_CLASSIC_MINI_MEM_SIZE,
         .ReadOnly = false,
@@ -217,20 +148,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_MF_CLASSIC_1K_SUPPORT
     [CONFIG_MF_CLASSIC_1K] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_CLASSIC,
         .ApplicationInitFunc = MifareClassicAppInit1K,
-        .ApplicationResetFunc = MifareClassicAppReset,
-        .ApplicationTaskFunc = MifareClassicAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareClassicAppProcess,
-        .ApplicationGetUidFunc = MifareClassicGetUid,
-        .ApplicationSetUidFunc = MifareClassicSetUid,
-        .ApplicationGetSakFunc = MifareClassicGetSak,
-        .ApplicationSetSakFunc = MifareClassicSetSak,
-        .ApplicationGetAtqaFunc = MifareClassicGetAtqa,
-        .ApplicationSetAtqaFunc = MifareClassicSetAtqa,
         .UidSize = MIFARE_CLASSIC_UID_SIZE,
         .MemorySize = MIFARE_CLASSIC_1K_MEM_SIZE,
         .ReadOnly = false,
@@ -239,20 +159,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_MF_CLASSIC_1K_7B_SUPPORT
     [CONFIG_MF_CLASSIC_1K_7B] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_CLASSIC,
         .ApplicationInitFunc = MifareClassicAppInit1K7B,
-        .ApplicationResetFunc = MifareClassicAppReset,
-        .ApplicationTaskFunc = MifareClassicAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareClassicAppProcess,
-        .ApplicationGetUidFunc = MifareClassicGetUid,
-        .ApplicationSetUidFunc = MifareClassicSetUid,
-        .ApplicationGetSakFunc = MifareClassicGetSak,
-        .ApplicationSetSakFunc = MifareClassicSetSak,
-        .ApplicationGetAtqaFunc = MifareClassicGetAtqa,
-        .ApplicationSetAtqaFunc = MifareClassicSetAtqa,
         .UidSize = ISO14443A_UID_SIZE_DOUBLE,
         .MemorySize = MIFARE_CLASSIC_1K_MEM_SIZE,
         .ReadOnly = false,
@@ -261,20 +170,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_MF_CLASSIC_4K_SUPPORT
     [CONFIG_MF_CLASSIC_4K] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_CLASSIC,
         .ApplicationInitFunc = MifareClassicAppInit4K,
-        .ApplicationResetFunc = MifareClassicAppReset,
-        .ApplicationTaskFunc = MifareClassicAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareClassicAppProcess,
-        .ApplicationGetUidFunc = MifareClassicGetUid,
-        .ApplicationSetUidFunc = MifareClassicSetUid,
-        .ApplicationGetSakFunc = MifareClassicGetSak,
-        .ApplicationSetSakFunc = MifareClassicSetSak,
-        .ApplicationGetAtqaFunc = MifareClassicGetAtqa,
-        .ApplicationSetAtqaFunc = MifareClassicSetAtqa,
         .UidSize = MIFARE_CLASSIC_UID_SIZE,
         .MemorySize = MIFARE_CLASSIC_4K_MEM_SIZE,
         .ReadOnly = false,
@@ -283,20 +181,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_MF_CLASSIC_4K_7B_SUPPORT
     [CONFIG_MF_CLASSIC_4K_7B] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_CLASSIC,
         .ApplicationInitFunc = MifareClassicAppInit4K7B,
-        .ApplicationResetFunc = MifareClassicAppReset,
-        .ApplicationTaskFunc = MifareClassicAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareClassicAppProcess,
-        .ApplicationGetUidFunc = MifareClassicGetUid,
-        .ApplicationSetUidFunc = MifareClassicSetUid,
-        .ApplicationGetSakFunc = MifareClassicGetSak,
-        .ApplicationSetSakFunc = MifareClassicSetSak,
-        .ApplicationGetAtqaFunc = MifareClassicGetAtqa,
-        .ApplicationSetAtqaFunc = MifareClassicSetAtqa,
         .UidSize = ISO14443A_UID_SIZE_DOUBLE,
         .MemorySize = MIFARE_CLASSIC_4K_MEM_SIZE,
         .ReadOnly = false,
@@ -305,20 +192,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_MF_DETECTION_SUPPORT
     [CONFIG_MF_DETECTION] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_CLASSIC,
         .ApplicationInitFunc = MifareDetectionInit1K,
-        .ApplicationResetFunc = MifareClassicAppReset,
-        .ApplicationTaskFunc = MifareClassicAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareClassicAppProcess,
-        .ApplicationGetUidFunc = MifareClassicGetUid,
-        .ApplicationSetUidFunc = MifareClassicSetUid,
-        .ApplicationGetSakFunc = MifareClassicGetSak,
-        .ApplicationSetSakFunc = MifareClassicSetSak,
-        .ApplicationGetAtqaFunc = MifareClassicGetAtqa,
-        .ApplicationSetAtqaFunc = MifareClassicSetAtqa,
         .UidSize = MIFARE_CLASSIC_UID_SIZE,
         .MemorySize = MIFARE_CLASSIC_1K_MEM_SIZE,
         .ReadOnly = false,
@@ -327,20 +203,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_MF_DETECTION_4K_SUPPORT
     [CONFIG_MF_DETECTION_4K] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_CLASSIC,
         .ApplicationInitFunc = MifareDetectionInit4K,
-        .ApplicationResetFunc = MifareClassicAppReset,
-        .ApplicationTaskFunc = MifareClassicAppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = MifareClassicAppProcess,
-        .ApplicationGetUidFunc = MifareClassicGetUid,
-        .ApplicationSetUidFunc = MifareClassicSetUid,
-        .ApplicationGetSakFunc = MifareClassicGetSak,
-        .ApplicationSetSakFunc = MifareClassicSetSak,
-        .ApplicationGetAtqaFunc = MifareClassicGetAtqa,
-        .ApplicationSetAtqaFunc = MifareClassicSetAtqa,
         .UidSize = MIFARE_CLASSIC_UID_SIZE,
         .MemorySize = MIFARE_CLASSIC_4K_MEM_SIZE,
         .ReadOnly = false,
@@ -349,20 +214,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_ISO14443A_SNIFF_SUPPORT
     [CONFIG_ISO14443A_SNIFF] = {
-        .CodecInitFunc = Sniff14443ACodecInit,
-        .CodecDeInitFunc = Sniff14443ACodecDeInit,
-        .CodecTaskFunc = Sniff14443ACodecTask,
+        .Codec = CODEC_SNIFF14443A,
+        .Application = APPLICATION_SNIFF14443A,
         .ApplicationInitFunc = Sniff14443AAppInit,
-        .ApplicationResetFunc = Sniff14443AAppReset,
-        .ApplicationTaskFunc = Sniff14443AAppTask,
-        .ApplicationTickFunc = Sniff14443AAppTick,
-        .ApplicationProcessFunc = Sniff14443AAppProcess,
-        .ApplicationGetUidFunc = ApplicationGetUidDummy,
-        .ApplicationSetUidFunc = ApplicationSetUidDummy,
-        .ApplicationGetSakFunc = ApplicationGetSakDummy,
-        .ApplicationSetSakFunc = ApplicationSetSakDummy,
-        .ApplicationGetAtqaFunc = ApplicationGetAtqaDummy,
-        .ApplicationSetAtqaFunc = ApplicationSetAtqaDummy,
         .UidSize = 0,
         .MemorySize = 0,
         .ReadOnly = true,
@@ -371,20 +225,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_ISO14443A_READER_SUPPORT
     [CONFIG_ISO14443A_READER] = {
-        .CodecInitFunc = Reader14443ACodecInit,
-        .CodecDeInitFunc = Reader14443ACodecDeInit,
-        .CodecTaskFunc = Reader14443ACodecTask,
+        .Codec = CODEC_READER14443A,
+        .Application = APPLICATION_READER14443A,
         .ApplicationInitFunc = Reader14443AAppInit,
-        .ApplicationResetFunc = Reader14443AAppReset,
-        .ApplicationTaskFunc = Reader14443AAppTask,
-        .ApplicationTickFunc = Reader14443AAppTick,
-        .ApplicationProcessFunc = Reader14443AAppProcess,
-        .ApplicationGetUidFunc = ApplicationGetUidDummy,
-        .ApplicationSetUidFunc = ApplicationSetUidDummy,
-        .ApplicationGetSakFunc = ApplicationGetSakDummy,
-        .ApplicationSetSakFunc = ApplicationSetSakDummy,
-        .ApplicationGetAtqaFunc = ApplicationGetAtqaDummy,
-        .ApplicationSetAtqaFunc = ApplicationSetAtqaDummy,
         .UidSize = 0,
         .MemorySize = 0,
         .ReadOnly = false,
@@ -393,16 +236,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_VICINITY_SUPPORT
     [CONFIG_VICINITY] = {
-        .CodecInitFunc = ISO15693CodecInit,
-        .CodecDeInitFunc = ISO15693CodecDeInit,
-        .CodecTaskFunc = ISO15693CodecTask,
+        .Codec = CODEC_ISO15693,
+        .Application = APPLICATION_ISO15693_TAG,
         .ApplicationInitFunc = VicinityAppInit,
-        .ApplicationResetFunc = VicinityAppReset,
-        .ApplicationTaskFunc = VicinityAppTask,
-        .ApplicationTickFunc = VicinityAppTick,
-        .ApplicationProcessFunc = VicinityAppProcess,
-        .ApplicationGetUidFunc = VicinityGetUid,
-        .ApplicationSetUidFunc = VicinitySetUid,
         .UidSize = ISO15693_GENERIC_UID_SIZE,
         .MemorySize = ISO15693_GENERIC_MEM_SIZE,
         .ReadOnly = false,
@@ -411,16 +247,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_ISO15693_SNIFF_SUPPORT
     [CONFIG_ISO15693_SNIFF] = {
-        .CodecInitFunc = ISO15693CodecInit,
-        .CodecDeInitFunc = ISO15693CodecDeInit,
-        .CodecTaskFunc = ISO15693CodecTask,
-        .ApplicationInitFunc = ApplicationInitDummy,
-        .ApplicationResetFunc = ApplicationResetDummy,
-        .ApplicationTaskFunc = ApplicationTaskDummy,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = ApplicationProcessDummy,
-        .ApplicationGetUidFunc = ApplicationGetUidDummy,
-        .ApplicationSetUidFunc = ApplicationSetUidDummy,
+        .Codec = CODEC_SNIFF15693,
+        .Application = APPLICATION_SNIFF15693,
+        .ApplicationInitFunc = Sniff15693AppInit,
         .UidSize = 0,
         .MemorySize = 0,
         .ReadOnly = true,
@@ -429,16 +258,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_SL2S2002_SUPPORT
     [CONFIG_SL2S2002] = {
-        .CodecInitFunc = ISO15693CodecInit,
-        .CodecDeInitFunc = ISO15693CodecDeInit,
-        .CodecTaskFunc = ISO15693CodecTask,
+        .Codec = CODEC_ISO15693,
+        .Application = APPLICATION_ISO15693_TAG,
         .ApplicationInitFunc = Sl2s2002AppInit,
-        .ApplicationResetFunc = Sl2s2002AppReset,
-        .ApplicationTaskFunc = Sl2s2002AppTask,
-        .ApplicationTickFunc = Sl2s2002AppTick,
-        .ApplicationProcessFunc = Sl2s2002AppProcess,
-        .ApplicationGetUidFunc = Sl2s2002GetUid,
-        .ApplicationSetUidFunc = Sl2s2002SetUid,
         .UidSize = ISO15693_GENERIC_UID_SIZE,
         .MemorySize = ISO15693_GENERIC_MEM_SIZE,
         .ReadOnly = false,
@@ -447,16 +269,9 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_TITAGITSTANDARD_SUPPORT
     [CONFIG_TITAGITSTANDARD] = {
-        .CodecInitFunc = ISO15693CodecInit,
-        .CodecDeInitFunc = ISO15693CodecDeInit,
-        .CodecTaskFunc = ISO15693CodecTask,
+        .Codec = CODEC_ISO15693,
+        .Application = APPLICATION_ISO15693_TAG,
         .ApplicationInitFunc = TITagitstandardAppInit,
-        .ApplicationResetFunc = TITagitstandardAppReset,
-        .ApplicationTaskFunc = TITagitstandardAppTask,
-        .ApplicationTickFunc = TITagitstandardAppTick,
-        .ApplicationProcessFunc = TITagitstandardAppProcess,
-        .ApplicationGetUidFunc = TITagitstandardGetUid,
-        .ApplicationSetUidFunc = TITagitstandardSetUid,
         .UidSize = TITAGIT_STD_UID_SIZE,
         .MemorySize = TITAGIT_STD_MEM_SIZE,
         .ReadOnly = false,
@@ -465,47 +280,772 @@ static const PROGMEM ConfigurationType ConfigurationTable[] = {
 #endif
 #ifdef CONFIG_EM4233_SUPPORT
     [CONFIG_EM4233] = {
-        .CodecInitFunc = ISO15693CodecInit,
-        .CodecDeInitFunc = ISO15693CodecDeInit,
-        .CodecTaskFunc = ISO15693CodecTask,
+        .Codec = CODEC_ISO15693,
+        .Application = APPLICATION_ISO15693_TAG,
         .ApplicationInitFunc = EM4233AppInit,
-        .ApplicationResetFunc = EM4233AppReset,
-        .ApplicationTaskFunc = EM4233AppTask,
-        .ApplicationTickFunc = EM4233AppTick,
-        .ApplicationProcessFunc = EM4233AppProcess,
-        .ApplicationGetUidFunc = EM4233GetUid,
-        .ApplicationSetUidFunc = EM4233SetUid,
         .UidSize = EM4233_STD_UID_SIZE,
-        .MemorySize = EM4233_STD_MEM_SIZE,
+        .MemorySize = EM4233_MEM_SIZE,
         .ReadOnly = false,
         .TagFamily = TAG_FAMILY_ISO15693
     },
 #endif
-#ifdef CONFIG_NTAG215_SUPPORT
+#ifdef CONFIG_ICODE_SLIX2_SUPPORT
+    [CONFIG_ICODE_SLIX2] = {
+        .Codec = CODEC_ISO15693,
+        .Application = APPLICATION_ISO15693_TAG,
+        .ApplicationInitFunc = Slix2AppInit,
+        .UidSize = SLIX2_UID_SIZE,
+        .MemorySize = SLIX2_MEM_SIZE,
+        .ReadOnly = false,
+        .TagFamily = TAG_FAMILY_ISO15693
+    },
+#endif
+#ifdef CONFIG_NTAG21X_SUPPORT
+    [CONFIG_NTAG210] = {
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_NTAG21X,
+        .ApplicationInitFunc = NTAG210AppInit,
+        .UidSize = NTAG21X_UID_SIZE,
+        .MemorySize = NTAG21X_MEM_SIZE(NTAG210_PAGES),
+        .ReadOnly = false,
+        .TagFamily = TAG_FAMILY_ISO14443A
+    },
+    [CONFIG_NTAG212] = {
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_NTAG21X,
+        .ApplicationInitFunc = NTAG212AppInit,
+        .UidSize = NTAG21X_UID_SIZE,
+        .MemorySize = NTAG21X_MEM_SIZE(NTAG212_PAGES),
+        .ReadOnly = false,
+        .TagFamily = TAG_FAMILY_ISO14443A
+    },
+    [CONFIG_NTAG213] = {
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_NTAG21X,
+        .ApplicationInitFunc = NTAG213AppInit,
+        .UidSize = NTAG21X_UID_SIZE,
+        .MemorySize = NTAG21X_MEM_SIZE(NTAG213_PAGES),
+        .ReadOnly = false,
+        .TagFamily = TAG_FAMILY_ISO14443A
+    },
     [CONFIG_NTAG215] = {
-        .CodecInitFunc = ISO14443ACodecInit,
-        .CodecDeInitFunc = ISO14443ACodecDeInit,
-        .CodecTaskFunc = ISO14443ACodecTask,
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_NTAG21X,
         .ApplicationInitFunc = NTAG215AppInit,
-        .ApplicationResetFunc = NTAG215AppReset,
-        .ApplicationTaskFunc = NTAG215AppTask,
-        .ApplicationTickFunc = ApplicationTickDummy,
-        .ApplicationProcessFunc = NTAG215AppProcess,
-        .ApplicationGetUidFunc = NTAG215GetUid,
-        .ApplicationSetUidFunc = NTAG215SetUid,
-        .UidSize = NTAG215_UID_SIZE,
-        .MemorySize = NTAG215_MEM_SIZE,
+        .UidSize = NTAG21X_UID_SIZE,
+        .MemorySize = NTAG21X_MEM_SIZE(NTAG215_PAGES),
         .ReadOnly = false,
         .TagFamily = TAG_FAMILY_ISO14443A
     },
+    [CONFIG_NTAG216] = {
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_NTAG21X,
+        .ApplicationInitFunc = NTAG216AppInit,
+        .UidSize = NTAG21X_UID_SIZE,
+        .MemorySize = NTAG21X_MEM_SIZE(NTAG216_PAGES),
+        .ReadOnly = false,
+        .TagFamily = TAG_FAMILY_ISO14443A
+    },
+#endif
+#ifdef CONFIG_MF_DESFIRE_SUPPORT
+    [CONFIG_MF_DESFIRE] = {
+        .Codec = CODEC_ISO14443A,
+        .Application = APPLICATION_MF_DESFIRE,
+        .ApplicationInitFunc = MifareDesfireAppInit,
+        .UidSize = MIFARE_DESFIRE_UID_SIZE,
+        .MemorySize = MIFARE_DESFIRE_MEM_SIZE,
+        .ReadOnly = false,
+        .TagFamily = TAG_FAMILY_ISO14443A
+    },
+#endif
+};
+
+#ifdef CONFIG_STATIC_DISPATCH
+/* Every hook is a switch over the active codec or application engine with direct calls in
+ * its cases, so there are no function pointers to follow. A switch only holds the engines the
+ * supported configurations need. Where that is a single one it shrinks to one comparison and
+ * a direct call, which link time optimization can inline. What counts is the number of engines,
+ * not of configurations: the MF Classic configurations all share one engine, while
+ * CONFIG_MF_ULTRALIGHT_SUPPORT alone needs the Ultralight, Ultralight C and NTAG21x engines.
+ */
+void CodecInitDispatch(void) {
+    switch (ActiveConfiguration.Codec) {
+#ifdef USES_CODEC_ISO14443A
+        case CODEC_ISO14443A:
+            ISO14443ACodecInit();
+            break;
+#endif
+#ifdef USES_CODEC_READER14443A
+        case CODEC_READER14443A:
+            Reader14443ACodecInit();
+            break;
+#endif
+#ifdef USES_CODEC_SNIFF14443A
+        case CODEC_SNIFF14443A:
+            Sniff14443ACodecInit();
+            break;
+#endif
+#ifdef USES_CODEC_ISO15693
+        case CODEC_ISO15693:
+            ISO15693CodecInit();
+            break;
+#endif
+#ifdef USES_CODEC_SNIFF15693
+        case CODEC_SNIFF15693:
+            SniffISO15693CodecInit();
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void CodecDeInitDispatch(void) {
+    switch (ActiveConfiguration.Codec) {
+#ifdef USES_CODEC_ISO14443A
+        case CODEC_ISO14443A:
+            ISO14443ACodecDeInit();
+            break;
+#endif
+#ifdef USES_CODEC_READER14443A
+        case CODEC_READER14443A:
+            Reader14443ACodecDeInit();
+            break;
+#endif
+#ifdef USES_CODEC_SNIFF14443A
+        case CODEC_SNIFF14443A:
+            Sniff14443ACodecDeInit();
+            break;
+#endif
+#ifdef USES_CODEC_ISO15693
+        case CODEC_ISO15693:
+            ISO15693CodecDeInit();
+            break;
+#endif
+#ifdef USES_CODEC_SNIFF15693
+        case CODEC_SNIFF15693:
+            SniffISO15693CodecDeInit();
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void CodecTaskDispatch(void) {
+    switch (ActiveConfiguration.Codec) {
+#ifdef USES_CODEC_ISO14443A
+        case CODEC_ISO14443A:
+            ISO14443ACodecTask();
+            break;
+#endif
+#ifdef USES_CODEC_READER14443A
+        case CODEC_READER14443A:
+            Reader14443ACodecTask();
+            break;
+#endif
+#ifdef USES_CODEC_SNIFF14443A
+        case CODEC_SNIFF14443A:
+            Sniff14443ACodecTask();
+            break;
+#endif
+#ifdef USES_CODEC_ISO15693
+        case CODEC_ISO15693:
+            ISO15693CodecTask();
+            break;
+#endif
+#ifdef USES_CODEC_SNIFF15693
+        case CODEC_SNIFF15693:
+            SniffISO15693CodecTask();
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void ApplicationResetDispatch(void) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT:
+            MifareUltralightAppReset();
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT_C:
+            MifareUltralightCAppReset();
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+        case APPLICATION_MF_CLASSIC:
+            MifareClassicAppReset();
+            break;
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+        case APPLICATION_NTAG21X:
+            NTAG21xAppReset();
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_DESFIRE
+        case APPLICATION_MF_DESFIRE:
+            MifareDesfireAppReset();
+            break;
+#endif
+#ifdef USES_APPLICATION_READER14443A
+        case APPLICATION_READER14443A:
+            Reader14443AAppReset();
+            break;
+#endif
+#ifdef USES_APPLICATION_SNIFF14443A
+        case APPLICATION_SNIFF14443A:
+            Sniff14443AAppReset();
+            break;
+#endif
+#ifdef USES_APPLICATION_ISO15693_TAG
+        case APPLICATION_ISO15693_TAG:
+            ISO15693TagAppReset();
+            break;
+#endif
+#ifdef USES_APPLICATION_SNIFF15693
+        case APPLICATION_SNIFF15693:
+            Sniff15693AppReset();
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void ApplicationTaskDispatch(void) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT:
+            MifareUltralightAppTask();
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT_C:
+            MifareUltralightAppTask();
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+        case APPLICATION_MF_CLASSIC:
+            MifareClassicAppTask();
+            break;
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+        case APPLICATION_NTAG21X:
+            NTAG21xAppTask();
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_DESFIRE
+        case APPLICATION_MF_DESFIRE:
+            MifareDesfireAppTask();
+            break;
+#endif
+#ifdef USES_APPLICATION_READER14443A
+        case APPLICATION_READER14443A:
+            Reader14443AAppTask();
+            break;
+#endif
+#ifdef USES_APPLICATION_SNIFF14443A
+        case APPLICATION_SNIFF14443A:
+            Sniff14443AAppTask();
+            break;
+#endif
+#ifdef USES_APPLICATION_ISO15693_TAG
+        case APPLICATION_ISO15693_TAG:
+            ISO15693TagAppTask();
+            break;
+#endif
+#ifdef USES_APPLICATION_SNIFF15693
+        case APPLICATION_SNIFF15693:
+            Sniff15693AppTask();
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void ApplicationTickDispatch(void) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_READER14443A
+        case APPLICATION_READER14443A:
+            Reader14443AAppTick();
+            break;
+#endif
+#ifdef USES_APPLICATION_SNIFF14443A
+        case APPLICATION_SNIFF14443A:
+            Sniff14443AAppTick();
+            break;
+#endif
+#ifdef USES_APPLICATION_ISO15693_TAG
+        case APPLICATION_ISO15693_TAG:
+            ISO15693TagAppTick();
+            break;
+#endif
+#ifdef USES_APPLICATION_SNIFF15693
+        case APPLICATION_SNIFF15693:
+            Sniff15693AppTick();
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+uint16_t ApplicationProcessDispatch(uint8_t *ByteBuffer, uint16_t ByteCount) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT:
+            return MifareUltralightAppProcess(ByteBuffer, ByteCount);
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT_C:
+            return MifareUltralightAppProcess(ByteBuffer, ByteCount);
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+        case APPLICATION_MF_CLASSIC:
+            return MifareClassicAppProcess(ByteBuffer, ByteCount);
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+        case APPLICATION_NTAG21X:
+            return NTAG21xAppProcess(ByteBuffer, ByteCount);
+#endif
+#ifdef USES_APPLICATION_MF_DESFIRE
+        case APPLICATION_MF_DESFIRE:
+            return MifareDesfireAppProcess(ByteBuffer, ByteCount);
+#endif
+#ifdef USES_APPLICATION_READER14443A
+        case APPLICATION_READER14443A:
+            return Reader14443AAppProcess(ByteBuffer, ByteCount);
+#endif
+#ifdef USES_APPLICATION_SNIFF14443A
+        case APPLICATION_SNIFF14443A:
+            return Sniff14443AAppProcess(ByteBuffer, ByteCount);
+#endif
+#ifdef USES_APPLICATION_ISO15693_TAG
+        case APPLICATION_ISO15693_TAG:
+            return ISO15693TagAppProcess(ByteBuffer, ByteCount);
+#endif
+#ifdef USES_APPLICATION_SNIFF15693
+        case APPLICATION_SNIFF15693:
+            return Sniff15693AppProcess(ByteBuffer, ByteCount);
+#endif
+        default:
+            return 0;
+    }
+}
+
+void ApplicationGetUidDispatch(ConfigurationUidType Uid) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT:
+            MifareUltralightGetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT_C:
+            MifareUltralightGetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+        case APPLICATION_MF_CLASSIC:
+            MifareClassicGetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+        case APPLICATION_NTAG21X:
+            NTAG21xGetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_DESFIRE
+        case APPLICATION_MF_DESFIRE:
+            MifareDesfireGetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_ISO15693_TAG
+        case APPLICATION_ISO15693_TAG:
+            ISO15693TagGetUid(Uid);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void ApplicationSetUidDispatch(ConfigurationUidType Uid) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT:
+            MifareUltralightSetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT_C:
+            MifareUltralightSetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+        case APPLICATION_MF_CLASSIC:
+            MifareClassicSetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+        case APPLICATION_NTAG21X:
+            NTAG21xSetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_DESFIRE
+        case APPLICATION_MF_DESFIRE:
+            MifareDesfireSetUid(Uid);
+            break;
+#endif
+#ifdef USES_APPLICATION_ISO15693_TAG
+        case APPLICATION_ISO15693_TAG:
+            ISO15693TagSetUid(Uid);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void ApplicationGetSakDispatch(uint8_t *Sak) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT:
+            MifareUltralightGetSak(Sak);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT_C:
+            MifareUltralightGetSak(Sak);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+        case APPLICATION_MF_CLASSIC:
+            MifareClassicGetSak(Sak);
+            break;
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+        case APPLICATION_NTAG21X:
+            NTAG21xGetSak(Sak);
+            break;
+#endif
+        default:
+            *Sak = CONFIGURATION_DUMMY_SAK;
+            break;
+    }
+}
+
+void ApplicationSetSakDispatch(uint8_t Sak) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT:
+            MifareUltralightSetSak(Sak);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT_C:
+            MifareUltralightSetSak(Sak);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+        case APPLICATION_MF_CLASSIC:
+            MifareClassicSetSak(Sak);
+            break;
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+        case APPLICATION_NTAG21X:
+            NTAG21xSetSak(Sak);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void ApplicationGetAtqaDispatch(uint16_t *Atqa) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT:
+            MifareUltralightGetAtqa(Atqa);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT_C:
+            MifareUltralightGetAtqa(Atqa);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+        case APPLICATION_MF_CLASSIC:
+            MifareClassicGetAtqa(Atqa);
+            break;
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+        case APPLICATION_NTAG21X:
+            NTAG21xGetAtqa(Atqa);
+            break;
+#endif
+        default:
+            *Atqa = CONFIGURATION_DUMMY_ATQA;
+            break;
+    }
+}
+
+void ApplicationSetAtqaDispatch(uint16_t Atqa) {
+    switch (ActiveConfiguration.Application) {
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT:
+            MifareUltralightSetAtqa(Atqa);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+        case APPLICATION_MF_ULTRALIGHT_C:
+            MifareUltralightSetAtqa(Atqa);
+            break;
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+        case APPLICATION_MF_CLASSIC:
+            MifareClassicSetAtqa(Atqa);
+            break;
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+        case APPLICATION_NTAG21X:
+            NTAG21xSetAtqa(Atqa);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+#else /* CONFIG_STATIC_DISPATCH */
+
+static void CodecInitDummy(void) { }
+static void CodecDeInitDummy(void) { }
+static void CodecTaskDummy(void) { }
+static void ApplicationResetDummy(void) {}
+static void ApplicationTaskDummy(void) {}
+static void ApplicationTickDummy(void) {}
+static uint16_t ApplicationProcessDummy(uint8_t *ByteBuffer, uint16_t ByteCount) { return 0; }
+static void ApplicationGetUidDummy(ConfigurationUidType Uid) { }
+static void ApplicationSetUidDummy(ConfigurationUidType Uid) { }
+static void ApplicationGetAtqaDummy(uint16_t * Atqa) { *Atqa = CONFIGURATION_DUMMY_ATQA; }
+static void ApplicationSetAtqaDummy(uint16_t Atqa) { }
+static void ApplicationGetSakDummy(uint8_t * Sak) { *Sak = CONFIGURATION_DUMMY_SAK; }
+static void ApplicationSetSakDummy(uint8_t Sak) { }
+
+static const PROGMEM CodecType CodecTable[] = {
+    [CODEC_NONE] = {
+        .CodecInitFunc = CodecInitDummy,
+        .CodecDeInitFunc = CodecDeInitDummy,
+        .CodecTaskFunc = CodecTaskDummy
+    },
+#ifdef USES_CODEC_ISO14443A
+    [CODEC_ISO14443A] = {
+        .CodecInitFunc = ISO14443ACodecInit,
+        .CodecDeInitFunc = ISO14443ACodecDeInit,
+        .CodecTaskFunc = ISO14443ACodecTask
+    },
+#endif
+#ifdef USES_CODEC_READER14443A
+    [CODEC_READER14443A] = {
+        .CodecInitFunc = Reader14443ACodecInit,
+        .CodecDeInitFunc = Reader14443ACodecDeInit,
+        .CodecTaskFunc = Reader14443ACodecTask
+    },
+#endif
+#ifdef USES_CODEC_SNIFF14443A
+    [CODEC_SNIFF14443A] = {
+        .CodecInitFunc = Sniff14443ACodecInit,
+        .CodecDeInitFunc = Sniff14443ACodecDeInit,
+        .CodecTaskFunc = Sniff14443ACodecTask
+    },
+#endif
+#ifdef USES_CODEC_ISO15693
+    [CODEC_ISO15693] = {
+        .CodecInitFunc = ISO15693CodecInit,
+        .CodecDeInitFunc = ISO15693CodecDeInit,
+        .CodecTaskFunc = ISO15693CodecTask
+    },
+#endif
+#ifdef USES_CODEC_SNIFF15693
+    [CODEC_SNIFF15693] = {
+        .CodecInitFunc = SniffISO15693CodecInit,
+        .CodecDeInitFunc = SniffISO15693CodecDeInit,
+        .CodecTaskFunc = SniffISO15693CodecTask
+    },
 #endif
 };
 
+static const PROGMEM ApplicationType ApplicationTable[] = {
+    [APPLICATION_NONE] = {
+        .ApplicationResetFunc = ApplicationResetDummy,
+        .ApplicationTaskFunc = ApplicationTaskDummy,
+        .ApplicationTickFunc = ApplicationTickDummy,
+        .ApplicationProcessFunc = ApplicationProcessDummy,
+        .ApplicationGetUidFunc = ApplicationGetUidDummy,
+        .ApplicationSetUidFunc = ApplicationSetUidDummy,
+        .ApplicationGetSakFunc = ApplicationGetSakDummy,
+        .ApplicationSetSakFunc = ApplicationSetSakDummy,
+        .ApplicationGetAtqaFunc = ApplicationGetAtqaDummy,
+        .ApplicationSetAtqaFunc = ApplicationSetAtqaDummy
+    },
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+    [APPLICATION_MF_ULTRALIGHT] = {
+        .ApplicationResetFunc = MifareUltralightAppReset,
+        .ApplicationTaskFunc = MifareUltralightAppTask,
+        .ApplicationTickFunc = ApplicationTickDummy,
+        .ApplicationProcessFunc = MifareUltralightAppProcess,
+        .ApplicationGetUidFunc = MifareUltralightGetUid,
+        .ApplicationSetUidFunc = MifareUltralightSetUid,
+        .ApplicationGetSakFunc = MifareUltralightGetSak,
+        .ApplicationSetSakFunc = MifareUltralightSetSak,
+        .ApplicationGetAtqaFunc = MifareUltralightGetAtqa,
+        .ApplicationSetAtqaFunc = MifareUltralightSetAtqa
+    },
+#endif
+#ifdef USES_APPLICATION_MF_ULTRALIGHT
+    [APPLICATION_MF_ULTRALIGHT_C] = {
+        .ApplicationResetFunc = MifareUltralightCAppReset,
+        .ApplicationTaskFunc = MifareUltralightAppTask,
+        .ApplicationTickFunc = ApplicationTickDummy,
+        .ApplicationProcessFunc = MifareUltralightAppProcess,
+        .ApplicationGetUidFunc = MifareUltralightGetUid,
+        .ApplicationSetUidFunc = MifareUltralightSetUid,
+        .ApplicationGetSakFunc = MifareUltralightGetSak,
+        .ApplicationSetSakFunc = MifareUltralightSetSak,
+        .ApplicationGetAtqaFunc = MifareUltralightGetAtqa,
+        .ApplicationSetAtqaFunc = MifareUltralightSetAtqa
+    },
+#endif
+#ifdef USES_APPLICATION_MF_CLASSIC
+    [APPLICATION_MF_CLASSIC] = {
+        .ApplicationResetFunc = MifareClassicAppReset,
+        .ApplicationTaskFunc = MifareClassicAppTask,
+        .ApplicationTickFunc = ApplicationTickDummy,
+        .ApplicationProcessFunc = MifareClassicAppProcess,
+        .ApplicationGetUidFunc = MifareClassicGetUid,
+        .ApplicationSetUidFunc = MifareClassicSetUid,
+        .ApplicationGetSakFunc = MifareClassicGetSak,
+        .ApplicationSetSakFunc = MifareClassicSetSak,
+        .ApplicationGetAtqaFunc = MifareClassicGetAtqa,
+        .ApplicationSetAtqaFunc = MifareClassicSetAtqa
+    },
+#endif
+#ifdef USES_APPLICATION_NTAG21X
+    [APPLICATION_NTAG21X] = {
+        .ApplicationResetFunc = NTAG21xAppReset,
+        .ApplicationTaskFunc = NTAG21xAppTask,
+        .ApplicationTickFunc = ApplicationTickDummy,
+        .ApplicationProcessFunc = NTAG21xAppProcess,
+        .ApplicationGetUidFunc = NTAG21xGetUid,
+        .ApplicationSetUidFunc = NTAG21xSetUid,
+        .ApplicationGetSakFunc = NTAG21xGetSak,
+        .ApplicationSetSakFunc = NTAG21xSetSak,
+        .ApplicationGetAtqaFunc = NTAG21xGetAtqa,
+        .ApplicationSetAtqaFunc = NTAG21xSetAtqa
+    },
+#endif
+#ifdef USES_APPLICATION_MF_DESFIRE
+    [APPLICATION_MF_DESFIRE] = {
+        .ApplicationResetFunc = MifareDesfireAppReset,
+        .ApplicationTaskFunc = MifareDesfireAppTask,
+        .ApplicationTickFunc = ApplicationTickDummy,
+        .ApplicationProcessFunc = MifareDesfireAppProcess,
+        .ApplicationGetUidFunc = MifareDesfireGetUid,
+        .ApplicationSetUidFunc = MifareDesfireSetUid,
+        .ApplicationGetSakFunc = ApplicationGetSakDummy,
+        .ApplicationSetSakFunc = ApplicationSetSakDummy,
+        .ApplicationGetAtqaFunc = ApplicationGetAtqaDummy,
+        .ApplicationSetAtqaFunc = ApplicationSetAtqaDummy
+    },
+#endif
+#ifdef USES_APPLICATION_READER14443A
+    [APPLICATION_READER14443A] = {
+        .ApplicationResetFunc = Reader14443AAppReset,
+        .ApplicationTaskFunc = Reader14443AAppTask,
+        .ApplicationTickFunc = Reader14443AAppTick,
+        .ApplicationProcessFunc = Reader14443AAppProcess,
+        .ApplicationGetUidFunc = ApplicationGetUidDummy,
+        .ApplicationSetUidFunc = ApplicationSetUidDummy,
+        .ApplicationGetSakFunc = ApplicationGetSakDummy,
+        .ApplicationSetSakFunc = ApplicationSetSakDummy,
+        .ApplicationGetAtqaFunc = ApplicationGetAtqaDummy,
+        .ApplicationSetAtqaFunc = ApplicationSetAtqaDummy
+    },
+#endif
+#ifdef USES_APPLICATION_SNIFF14443A
+    [APPLICATION_SNIFF14443A] = {
+        .ApplicationResetFunc = Sniff14443AAppReset,
+        .ApplicationTaskFunc = Sniff14443AAppTask,
+        .ApplicationTickFunc = Sniff14443AAppTick,
+        .ApplicationProcessFunc = Sniff14443AAppProcess,
+        .ApplicationGetUidFunc = ApplicationGetUidDummy,
+        .ApplicationSetUidFunc = ApplicationSetUidDummy,
+        .ApplicationGetSakFunc = ApplicationGetSakDummy,
+        .ApplicationSetSakFunc = ApplicationSetSakDummy,
+        .ApplicationGetAtqaFunc = ApplicationGetAtqaDummy,
+        .ApplicationSetAtqaFunc = ApplicationSetAtqaDummy
+    },
+#endif
+#ifdef USES_APPLICATION_ISO15693_TAG
+    [APPLICATION_ISO15693_TAG] = {
+        .ApplicationResetFunc = ISO15693TagAppReset,
+        .ApplicationTaskFunc = ISO15693TagAppTask,
+        .ApplicationTickFunc = ISO15693TagAppTick,
+        .ApplicationProcessFunc = ISO15693TagAppProcess,
+        .ApplicationGetUidFunc = ISO15693TagGetUid,
+        .ApplicationSetUidFunc = ISO15693TagSetUid,
+        .ApplicationGetSakFunc = ApplicationGetSakDummy,
+        .ApplicationSetSakFunc = ApplicationSetSakDummy,
+        .ApplicationGetAtqaFunc = ApplicationGetAtqaDummy,
+        .ApplicationSetAtqaFunc = ApplicationSetAtqaDummy
+    },
+#endif
+#ifdef USES_APPLICATION_SNIFF15693
+    [APPLICATION_SNIFF15693] = {
+        .ApplicationResetFunc = Sniff15693AppReset,
+        .ApplicationTaskFunc = Sniff15693AppTask,
+        .ApplicationTickFunc = Sniff15693AppTick,
+        .ApplicationProcessFunc = Sniff15693AppProcess,
+        .ApplicationGetUidFunc = ApplicationGetUidDummy,
+        .ApplicationSetUidFunc = ApplicationSetUidDummy,
+        .ApplicationGetSakFunc = ApplicationGetSakDummy,
+        .ApplicationSetSakFunc = ApplicationSetSakDummy,
+        .ApplicationGetAtqaFunc = ApplicationGetAtqaDummy,
+        .ApplicationSetAtqaFunc = ApplicationSetAtqaDummy
+    },
+#endif
+};
+
+CodecType ActiveCodec;
+ApplicationType ActiveApplication;
+
+#endif /* CONFIG_STATIC_DISPATCH */
+
 ConfigurationType ActiveConfiguration;
 
-void ConfigurationInit(void) {
+static void LoadConfiguration(ConfigurationEnum Configuration) {
+    if (Configuration >= CONFIG_COUNT) {
+        Configuration = CONFIG_NONE;
+    }
+
+    /* Copy struct from PROGMEM to RAM */
     memcpy_P(&ActiveConfiguration,
-             &ConfigurationTable[CONFIG_NONE], sizeof(ConfigurationType));
+             &ConfigurationTable[Configuration], sizeof(ConfigurationType));
+
+#ifndef CONFIG_STATIC_DISPATCH
+    memcpy_P(&ActiveCodec, &CodecTable[ActiveConfiguration.Codec], sizeof(CodecType));
+    memcpy_P(&ActiveApplication, &ApplicationTable[ActiveConfiguration.Application], sizeof(ApplicationType));
+#endif
+}
+
+void ConfigurationInit(void) {
+    LoadConfiguration(CONFIG_NONE);
     //    Simulation mode antenna load, Default is close load.
     PORTC.DIRSET = PIN7_bm;
     PORTC.OUTCLR = PIN7_bm;
@@ -513,17 +1053,25 @@ void ConfigurationInit(void) {
     ConfigurationSetById(GlobalSettings.ActiveSettingPtr->Configuration);
 }
 
-void ConfigurationSetById(ConfigurationEnum Configuration) {
+static void ConfigurationApply(ConfigurationEnum Configuration, bool Resize) {
     CodecDeInit();
 
     //    Cancel currently executed command when configuration changes
     CommandLinePendingTaskBreak(); // break possibly pending task
 
+    //    Fit the slot to the card memory, the caller has checked that it fits
+    if (Resize) {
+        MemorySlotResize(ConfigurationGetMemorySize(Configuration));
+    }
+
     GlobalSettings.ActiveSettingPtr->Configuration = Configuration;
 
-    /* Copy struct from PROGMEM to RAM */
-    memcpy_P(&ActiveConfiguration,
-             &ConfigurationTable[Configuration], sizeof(ConfigurationType));
+    //    A configuration that is not built into this firmware runs as NONE, its slot and setting are kept
+    if (Configuration >= CONFIG_COUNT) {
+        Configuration = CONFIG_NONE;
+    }
+
+    LoadConfiguration(Configuration);
 
     //    Configure antenna load as appropriate
 #ifdef CONFIG_ISO14443A_READER_SUPPORT
@@ -539,8 +1087,24 @@ void ConfigurationSetById(ConfigurationEnum Configuration) {
     ApplicationInit();
 }
 
+void ConfigurationSetById(ConfigurationEnum Configuration) {
+    ConfigurationApply(Configuration, false);
+}
+
+bool ConfigurationChangeById(ConfigurationEnum Configuration) {
+    if ((Configuration >= CONFIG_COUNT) || !MemorySlotFits(ConfigurationGetMemorySize(Configuration))) {
+        return false;
+    }
+
+    ConfigurationApply(Configuration, true);
+    return true;
+}
+
 void ConfigurationGetByName(char *Configuration, uint16_t BufferSize) {
-    MapIdToText(ConfigurationMap, ARRAY_COUNT(ConfigurationMap), GlobalSettings.ActiveSettingPtr->Configuration, Configuration, BufferSize);
+    if (!MapIdToText(ConfigurationMap, ARRAY_COUNT(ConfigurationMap), GlobalSettings.ActiveSettingPtr->Configuration, Configuration, BufferSize)) {
+        //    Not built into this firmware
+        MapIdToText(ConfigurationMap, ARRAY_COUNT(ConfigurationMap), CONFIG_NONE, Configuration, BufferSize);
+    }
 }
 
 bool ConfigurationSetByName(const char *Configuration) {
@@ -555,7 +1119,9 @@ bool ConfigurationSetByName(const char *Configuration) {
 #endif
             return false;
         }
-        ConfigurationSetById(Id);
+        if (!ConfigurationChangeById(Id)) {
+            return false;
+        }
         LogEntry(LOG_INFO_CONFIG_SET, Configuration, StringLength(Configuration, CONFIGURATION_NAME_LENGTH_MAX - 1));
         return true;
     } else {
@@ -563,6 +1129,14 @@ bool ConfigurationSetByName(const char *Configuration) {
     }
 }
 
+uint16_t ConfigurationGetMemorySize(ConfigurationEnum Configuration) {
+    if (Configuration >= CONFIG_COUNT) {
+        return 0;
+    }
+
+    return pgm_read_word(&ConfigurationTable[Configuration].MemorySize);
+}
+
 void ConfigurationGetList(char *List, uint16_t BufferSize) {
     MapToString(ConfigurationMap, ARRAY_COUNT(ConfigurationMap), List, BufferSize);
 }
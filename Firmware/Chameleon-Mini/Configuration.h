@@ -57,15 +57,12 @@ typedef enum  {
 #ifdef CONFIG_ISO14443A_READER_SUPPORT
     CONFIG_ISO14443A_READER,
 #endif
-#ifdef CONFIG_NTAG215_SUPPORT
+#ifdef CONFIG_NTAG21X_SUPPORT
     CONFIG_NTAG215,
 #endif
 #ifdef CONFIG_VICINITY_SUPPORT
     CONFIG_VICINITY,
 #endif
-#ifdef CONFIG_ISO15693_SNIFF_SUPPORT
-    CONFIG_ISO15693_SNIFF,
-#endif
 #ifdef CONFIG_SL2S2002_SUPPORT
     CONFIG_SL2S2002,
 #endif
@@ -74,6 +71,22 @@ typedef enum  {
 #endif
 #ifdef CONFIG_EM4233_SUPPORT
     CONFIG_EM4233,
+#endif
+#ifdef CONFIG_ICODE_SLIX2_SUPPORT
+    CONFIG_ICODE_SLIX2,
+#endif
+    /* Settings store the raw value, so new configurations go below */
+#ifdef CONFIG_ISO15693_SNIFF_SUPPORT
+    CONFIG_ISO15693_SNIFF,
+#endif
+#ifdef CONFIG_MF_DESFIRE_SUPPORT
+    CONFIG_MF_DESFIRE,
+#endif
+#ifdef CONFIG_NTAG21X_SUPPORT
+    CONFIG_NTAG210,
+    CONFIG_NTAG212,
+    CONFIG_NTAG213,
+    CONFIG_NTAG216,
 #endif
     /* This HAS to be the last element */
     CONFIG_COUNT
@@ -86,14 +99,75 @@ typedef enum  {
 #define TAG_FAMILY_ISO15693  5
 
 
-/** With this `struct` the behavior of a configuration is defined. */
+/** Codecs. Every codec is one set of codec functions, see \ref CodecType. */
+typedef enum {
+    CODEC_NONE = 0,
+    CODEC_ISO14443A,
+    CODEC_READER14443A,
+    CODEC_SNIFF14443A,
+    CODEC_ISO15693,
+    CODEC_SNIFF15693,
+    CODEC_COUNT
+} CodecEnum;
+
+/** Application engines. Every engine is one set of application functions, see \ref ApplicationType,
+ *  and is shared by all configurations running on it. */
+typedef enum {
+    APPLICATION_NONE = 0,
+    APPLICATION_MF_ULTRALIGHT,
+    APPLICATION_MF_ULTRALIGHT_C,
+    APPLICATION_MF_CLASSIC,
+    APPLICATION_NTAG21X,
+    APPLICATION_MF_DESFIRE,
+    APPLICATION_READER14443A,
+    APPLICATION_SNIFF14443A,
+    APPLICATION_ISO15693_TAG,
+    APPLICATION_SNIFF15693,
+    APPLICATION_COUNT
+} ApplicationEnum;
+
+/* Codecs and application engines needed by the supported configurations */
+#if defined(CONFIG_MF_ULTRALIGHT_SUPPORT) || defined(CONFIG_MF_CLASSIC_MINI_4B_SUPPORT) || defined(CONFIG_MF_CLASSIC_1K_SUPPORT) \
+    || defined(CONFIG_MF_CLASSIC_1K_7B_SUPPORT) || defined(CONFIG_MF_CLASSIC_4K_SUPPORT) || defined(CONFIG_MF_CLASSIC_4K_7B_SUPPORT) \
+    || defined(CONFIG_MF_DETECTION_SUPPORT) || defined(CONFIG_MF_DETECTION_4K_SUPPORT) || defined(CONFIG_NTAG21X_SUPPORT) \
+    || defined(CONFIG_MF_DESFIRE_SUPPORT)
+#define USES_CODEC_ISO14443A
+#endif
+#ifdef CONFIG_ISO14443A_READER_SUPPORT
+#define USES_CODEC_READER14443A
+#define USES_APPLICATION_READER14443A
+#endif
+#ifdef CONFIG_ISO14443A_SNIFF_SUPPORT
+#define USES_CODEC_SNIFF14443A
+#define USES_APPLICATION_SNIFF14443A
+#endif
+#if defined(CONFIG_VICINITY_SUPPORT) || defined(CONFIG_SL2S2002_SUPPORT) || defined(CONFIG_TITAGITSTANDARD_SUPPORT) \
+    || defined(CONFIG_EM4233_SUPPORT) || defined(CONFIG_ICODE_SLIX2_SUPPORT)
+#define USES_CODEC_ISO15693
+#define USES_APPLICATION_ISO15693_TAG
+#endif
+#ifdef CONFIG_ISO15693_SNIFF_SUPPORT
+#define USES_CODEC_SNIFF15693
+#define USES_APPLICATION_SNIFF15693
+#endif
+#ifdef CONFIG_MF_ULTRALIGHT_SUPPORT
+#define USES_APPLICATION_MF_ULTRALIGHT
+#endif
+#if defined(CONFIG_MF_CLASSIC_MINI_4B_SUPPORT) || defined(CONFIG_MF_CLASSIC_1K_SUPPORT) || defined(CONFIG_MF_CLASSIC_1K_7B_SUPPORT) \
+    || defined(CONFIG_MF_CLASSIC_4K_SUPPORT) || defined(CONFIG_MF_CLASSIC_4K_7B_SUPPORT) || defined(CONFIG_MF_DETECTION_SUPPORT) \
+    || defined(CONFIG_MF_DETECTION_4K_SUPPORT)
+#define USES_APPLICATION_MF_CLASSIC
+#endif
+/* The Ultralight EV1 configurations run on the NTAG21x engine */
+#if defined(CONFIG_MF_ULTRALIGHT_SUPPORT) || defined(CONFIG_NTAG21X_SUPPORT)
+#define USES_APPLICATION_NTAG21X
+#endif
+#ifdef CONFIG_MF_DESFIRE_SUPPORT
+#define USES_APPLICATION_MF_DESFIRE
+#endif
+
+/** The functions of a codec. */
 typedef struct {
-    /**
-     * \defgroup
-     * \name Codec
-     * Codec related methods.
-     * @{
-     */
     /** Function that initializes the codec. */
     void (*CodecInitFunc)(void);
     /** Function that deinitializes the codec. */
@@ -102,18 +176,10 @@ typedef struct {
      * Within this function the essential codec work is done.
      */
     void (*CodecTaskFunc)(void);
-    /**
-     * @}
-     */
+} CodecType;
 
-    /**
-     * \defgroup
-     * \name Application
-     * Application related functions.
-     * @{
-     */
-    /** Function that initializes the application. */
-    void (*ApplicationInitFunc)(void);
+/** The functions of an application engine. */
+typedef struct {
     /** Function that resets the application. */
     void (*ApplicationResetFunc)(void);
     /** Function that is called on every iteration of the main loop. Application work that is independent from the codec layer can be done here. */
@@ -146,26 +212,32 @@ typedef struct {
      * Writes the SAK for the current configuration to the given buffer.
      * \param Sak	The target buffer.
      */
-    void (*ApplicationGetSakFunc) (uint8_t * Sak);
+    void (*ApplicationGetSakFunc)(uint8_t *Sak);
     /**
      * Writes a given SAK to the current configuration.
      * \param Sak	The source buffer.
      */
-    void (*ApplicationSetSakFunc) (uint8_t Sak);
+    void (*ApplicationSetSakFunc)(uint8_t Sak);
     /**
      * Writes the ATQA for the current configuration to the given buffer.
      * \param Atqa	The target buffer.
      */
-    void (*ApplicationGetAtqaFunc) (uint16_t * Atqa);
+    void (*ApplicationGetAtqaFunc)(uint16_t *Atqa);
     /**
      * Writes a given ATQA to the current configuration.
      * \param Atqa	The source buffer.
      */
-    void (*ApplicationSetAtqaFunc) (uint16_t Atqa);
-    /**
-     * @}
-     */
+    void (*ApplicationSetAtqaFunc)(uint16_t Atqa);
+} ApplicationType;
 
+/** With this `struct` the behavior of a configuration is defined. */
+typedef struct {
+    /** The codec, see \ref CodecEnum. */
+    uint8_t Codec;
+    /** The application engine, see \ref ApplicationEnum. */
+    uint8_t Application;
+    /** Function that initializes the application for this configuration. */
+    void (*ApplicationInitFunc)(void);
     /**
      * Defines how many space the configuration needs. For emulating configurations this is the memory space of
      * the emulated card.
@@ -192,10 +264,41 @@ typedef struct {
 
 extern ConfigurationType ActiveConfiguration;
 
+#ifdef CONFIG_STATIC_DISPATCH
+/* Dispatch over the active codec and application engine without function pointers, see Configuration.c */
+void CodecInitDispatch(void);
+void CodecDeInitDispatch(void);
+void CodecTaskDispatch(void);
+void ApplicationResetDispatch(void);
+void ApplicationTaskDispatch(void);
+void ApplicationTickDispatch(void);
+uint16_t ApplicationProcessDispatch(uint8_t *ByteBuffer, uint16_t ByteCount);
+void ApplicationGetUidDispatch(ConfigurationUidType Uid);
+void ApplicationSetUidDispatch(ConfigurationUidType Uid);
+void ApplicationGetSakDispatch(uint8_t *Sak);
+void ApplicationSetSakDispatch(uint8_t Sak);
+void ApplicationGetAtqaDispatch(uint16_t *Atqa);
+void ApplicationSetAtqaDispatch(uint16_t Atqa);
+
+#define CODEC_HOOK(Name)        Codec##Name##Dispatch
+#define APPLICATION_HOOK(Name)  Application##Name##Dispatch
+#else
+/* Functions of the active codec and application engine, copied from flash on configuration change */
+extern CodecType ActiveCodec;
+extern ApplicationType ActiveApplication;
+
+#define CODEC_HOOK(Name)        ActiveCodec.Codec##Name##Func
+#define APPLICATION_HOOK(Name)  ActiveApplication.Application##Name##Func
+#endif
+
 void ConfigurationInit(void);
 void ConfigurationSetById(ConfigurationEnum Configuration);
+/* Changes the configuration of the active setting and fits its slot to the memory size.
+ * ConfigurationSetById only applies a configuration, it leaves the slot as it is. */
+bool ConfigurationChangeById(ConfigurationEnum Configuration);
 void ConfigurationGetByName(char *Configuration, uint16_t BufferSize);
 bool ConfigurationSetByName(const char *Configuration);
 void ConfigurationGetList(char *ConfigurationList, uint16_t BufferSize);
+uint16_t ConfigurationGetMemorySize(ConfigurationEnum Configuration);
 
 #endif /* STANDARDS_H_ */
@@ -76,8 +76,10 @@ void LEDInit(void) {
 
 //    根据状态切换指示灯
 void Led8Map(uint8_t LedNo) {
-    //    超出范围
-    if (LedNo > SETTINGS_COUNT) {
+    //    The reader setting shows the last pattern, settings without a pattern keep the LEDs
+    if (LedNo >= SETTINGS_COUNT) {
+        LedNo = ARRAY_COUNT(LedConfig) / 5 - 1;
+    } else if (LedNo >= ARRAY_COUNT(LedConfig) / 5 - 1) {
         return;
     }
 
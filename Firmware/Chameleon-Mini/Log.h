@@ -8,6 +8,14 @@
 #define FRAM_LOG_START_ADDR	0x4002 // directly after the address
 #define FRAM_LOG_SIZE		0x2FFE // the whole second half (minus the 2 Bytes of Address)
 
+/* The last 4 KB of FRAM are shared by the detection log of MF_DETECTION and the nonce memory of the reader */
+#define FRAM_DETECTION_START_ADDR	0x7000 // 256 byte aligned, the download reports the address relative to it
+#define FRAM_DETECTION_DATA_ADDR	0x7002 // directly after the address
+#define FRAM_DETECTION_DATA_SIZE	0x07F8 // the first half (minus the 2 Bytes of Address and a spare)
+#define FRAM_NONCE_ADDR_ADDR		0x7800
+#define FRAM_NONCE_START_ADDR		0x7802 // directly after the address
+#define FRAM_NONCE_SIZE			0x07FE // up to the end of the FRAM
+
 /** Enum for log entry type. \note Every entry type has a specific integer value, which can be found in the source code. */
 typedef enum {
     /* Generic */
@@ -29,6 +37,9 @@ typedef enum {
     LOG_INFO_CODEC_SNI_CARD_DATA                 = 0x46, //< Sniffing codec receive data from card
     LOG_INFO_CODEC_SNI_CARD_DATA_W_PARITY        = 0x47, //< Sniffing codec receive data from card
 
+    LOG_INFO_CODEC_SNI_ISO15693_READER_DATA      = 0x48, //< ISO15693 sniffing codec receive data from reader, prefixed with a 16 bit fc/32 timestamp
+    LOG_INFO_CODEC_SNI_ISO15693_CARD_DATA        = 0x49, //< ISO15693 sniffing codec receive data from card, prefixed with a 16 bit fc/32 timestamp
+
 
 
     /* App */
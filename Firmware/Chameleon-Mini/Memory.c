@@ -10,6 +10,8 @@
  */
 
 #include "Memory.h"
+#include <stddef.h>
+#include <string.h>
 #include "Configuration.h"
 #include "Common.h"
 #include "Settings.h"
@@ -32,6 +34,70 @@
 #define FRAM_MISO	PIN2_bm
 #define FRAM_SCK	PIN1_bm
 
+/* Write journal, kept in FRAM behind the image table */
+#define JOURNAL_ADDR            (IMAGE_TABLE_ADDR + sizeof(ImageTableType))
+#define JOURNAL_STATE_ADDR      (JOURNAL_ADDR + offsetof(JournalType, State))
+#define JOURNAL_DATA_ADDR       (JOURNAL_ADDR + offsetof(JournalType, Data))
+#define JOURNAL_STATE_IDLE      0x00
+#define JOURNAL_STATE_PENDING   0x5A /* Entry header valid, data being written */
+#define JOURNAL_STATE_COMMITTED 0xA5 /* Entry complete, target being written */
+
+typedef struct {
+    uint16_t Address;
+    uint8_t ByteCount;
+    uint8_t State; /* Written together with and after the header */
+    uint8_t Data[MEMORY_JOURNAL_DATA_SIZE];
+} JournalType;
+
+/* Slot allocation table, kept in EEPROM next to the settings */
+#define SLOT_PAGE_SIZE          APP_SECTION_PAGE_SIZE
+#define SLOT_PAGE_COUNT         (MEMORY_SIZE / SLOT_PAGE_SIZE)
+#define SLOT_PAGES(ByteCount)   ((uint16_t) (((uint32_t) (ByteCount) + SLOT_PAGE_SIZE - 1) / SLOT_PAGE_SIZE))
+#define SLOT_ADDRESS(Page)      ((uint32_t) (Page) * SLOT_PAGE_SIZE)
+#define SLOT_TABLE_MAGIC        0x534C
+
+typedef struct {
+    uint16_t FirstPage;
+    uint16_t PageCount; /* Zero for a slot without memory */
+} MemorySlotType;
+
+/* Slot move or table update in progress, kept in FRAM behind the journal. MemoryInit completes an interrupted one. */
+#define SLOT_MOVE_ADDR          (JOURNAL_ADDR + sizeof(JournalType))
+#define SLOT_MOVE_DONE_ADDR     (SLOT_MOVE_ADDR + offsetof(SlotMoveType, PagesDone))
+#define SLOT_MOVE_STATE_ADDR    (SLOT_MOVE_ADDR + offsetof(SlotMoveType, State))
+#define SLOT_MOVE_IDLE          0x00
+#define SLOT_MOVE_PENDING       0x5A /* Written after the other fields */
+
+typedef struct {
+    uint16_t FromPage;
+    uint16_t ToPage;
+    uint8_t SlotIdx;
+    uint8_t PageCount;
+    uint8_t PagesDone; /* Updated after every copied page */
+    uint8_t State;
+} SlotMoveType;
+
+/* Slot images resident in FRAM. They are made of flash pages and fill the FRAM below the log,
+ * except for the image table, the journal and the slot move record at its end. */
+#define IMAGE_TABLE_ADDR        (FRAM_LOG_ADDR_ADDR - SLOT_PAGE_SIZE)
+#define IMAGE_AREA_PAGES        (IMAGE_TABLE_ADDR / SLOT_PAGE_SIZE)
+#define IMAGE_ADDRESS(Page)     ((uint16_t) (Page) * SLOT_PAGE_SIZE)
+#define IMAGE_COUNT             8
+#define IMAGE_NONE              0xFF
+#define IMAGE_TABLE_MAGIC       0x494D
+
+typedef struct {
+    uint8_t Setting; /* IMAGE_NONE for a free entry */
+    uint8_t FirstPage;
+    uint8_t PageCount;
+    uint8_t Dirty; /* Changed since it has been stored to flash */
+} MemoryImageType;
+
+typedef struct {
+    uint16_t Magic;
+    MemoryImageType Images[IMAGE_COUNT]; /* Most recently used first, the active setting owns Images[0] */
+} ImageTableType;
+
 /* Declarations from assembler file */
 uint16_t FlashReadWord(uint32_t Address);
 void FlashEraseApplicationPage(uint32_t Address);
@@ -43,11 +109,18 @@ void FlashWaitForSPM(void);
 uint8_t       bUidMode = 0;
 uint8_t EEMEM bUidMode_EEP = 0;
 
-uint8_t       bSramWriteFlag = 0;
-uint8_t EEMEM bSramWriteFlag_EEP = 0;
-
 static uint8_t ScrapBuffer[] = {0};
 
+static MemorySlotType MemorySlots[SETTINGS_COUNT];
+static MemorySlotType EEMEM StoredMemorySlots[SETTINGS_COUNT];
+static uint16_t EEMEM StoredMemorySlotsMagic;
+
+static ImageTableType ImageTable;
+
+/* Target of the write dropped at power up */
+static uint16_t TornAddress;
+static uint8_t TornByteCount = 0;
+
 INLINE uint8_t SPITransferByte(uint8_t Data) {
     FRAM_USART.DATA = Data;
 
@@ -57,7 +130,18 @@ INLINE uint8_t SPITransferByte(uint8_t Data) {
 }
 
 #ifdef USE_DMA
-INLINE void SPIReadBlock(void *Buffer, uint16_t ByteCount) {
+/* The block transfers run in the background until SPIWaitBlock */
+INLINE void SPIWaitBlock(void) {
+    /* Wait for DMA to finish */
+    while (RECV_DMA.CTRLA & DMA_CH_ENABLE_bm)
+        ;
+
+    /* Clear Interrupt flag */
+    RECV_DMA.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm;
+    SEND_DMA.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm;
+}
+
+INLINE void SPIStartReadBlock(void *Buffer, uint16_t ByteCount) {
     /* Set up read and write transfers */
     RECV_DMA.ADDRCTRL = DMA_CH_SRCRELOAD_NONE_gc | DMA_CH_SRCDIR_FIXED_gc | DMA_CH_DESTRELOAD_NONE_gc | DMA_CH_DESTDIR_INC_gc;
     RECV_DMA.DESTADDR0 = ((uintptr_t) Buffer >> 0) & 0xFF;
@@ -72,16 +156,16 @@ INLINE void SPIReadBlock(void *Buffer, uint16_t ByteCount) {
     /* Enable read and write transfers */
     RECV_DMA.CTRLA |= DMA_CH_ENABLE_bm;
     SEND_DMA.CTRLA |= DMA_CH_ENABLE_bm;
+}
 
-    /* Wait for DMA to finish */
-    while (RECV_DMA.CTRLA & DMA_CH_ENABLE_bm)
-        ;
-
-    /* Clear Interrupt flag */
-    RECV_DMA.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm;
-    SEND_DMA.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm;
+INLINE void SPIReadBlock(void *Buffer, uint16_t ByteCount) {
+    SPIStartReadBlock(Buffer, ByteCount);
+    SPIWaitBlock();
 }
 #else
+INLINE void SPIWaitBlock(void) {
+}
+
 INLINE void SPIReadBlock(void *Buffer, uint16_t ByteCount) {
     uint8_t *ByteBuffer = (uint8_t *) Buffer;
 
@@ -93,10 +177,13 @@ INLINE void SPIReadBlock(void *Buffer, uint16_t ByteCount) {
     }
 }
 
+INLINE void SPIStartReadBlock(void *Buffer, uint16_t ByteCount) {
+    SPIReadBlock(Buffer, ByteCount);
+}
 #endif
 
 #ifdef USE_DMA
-INLINE void SPIWriteBlock(const void *Buffer, uint16_t ByteCount) {
+INLINE void SPIStartWriteBlock(const void *Buffer, uint16_t ByteCount) {
     /* Set up read and write transfers */
     RECV_DMA.ADDRCTRL = DMA_CH_SRCRELOAD_NONE_gc | DMA_CH_SRCDIR_FIXED_gc | DMA_CH_DESTRELOAD_NONE_gc | DMA_CH_DESTDIR_FIXED_gc;
     RECV_DMA.DESTADDR0 = ((uintptr_t) ScrapBuffer >> 0) & 0xFF;
@@ -110,14 +197,11 @@ INLINE void SPIWriteBlock(const void *Buffer, uint16_t ByteCount) {
     /* Enable read and write transfers */
     RECV_DMA.CTRLA |= DMA_CH_ENABLE_bm;
     SEND_DMA.CTRLA |= DMA_CH_ENABLE_bm;
+}
 
-    /* Wait for DMA to finish */
-    while (RECV_DMA.CTRLA & DMA_CH_ENABLE_bm)
-        ;
-
-    /* Clear Interrupt flag */
-    RECV_DMA.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm;
-    SEND_DMA.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm;
+INLINE void SPIWriteBlock(const void *Buffer, uint16_t ByteCount) {
+    SPIStartWriteBlock(Buffer, ByteCount);
+    SPIWaitBlock();
 }
 #else
 INLINE void SPIWriteBlock(const void *Buffer, uint16_t ByteCount) {
@@ -130,6 +214,10 @@ INLINE void SPIWriteBlock(const void *Buffer, uint16_t ByteCount) {
         FRAM_USART.DATA; /* Flush Buffer */
     }
 }
+
+INLINE void SPIStartWriteBlock(const void *Buffer, uint16_t ByteCount) {
+    SPIWriteBlock(Buffer, ByteCount);
+}
 #endif
 
 INLINE void FRAMRead(void *Buffer, uint16_t Address, uint16_t ByteCount) {
@@ -147,15 +235,7 @@ INLINE void FRAMRead(void *Buffer, uint16_t Address, uint16_t ByteCount) {
     FRAM_PORT.OUTSET = FRAM_CS;
 }
 
-INLINE void FRAMWrite(const void *Buffer, uint16_t Address, uint16_t ByteCount) {
-    if (0 == ByteCount)
-        return;
-
-    if (bSramWriteFlag == 0x00 && Address < FRAM_LOG_ADDR_ADDR) {
-        bSramWriteFlag++;
-        WriteEEPBlock((uint16_t) &bSramWriteFlag_EEP, &bSramWriteFlag, 1);
-    }
-
+INLINE void FRAMWriteData(const void *Buffer, uint16_t Address, uint16_t ByteCount) {
     FRAM_PORT.OUTCLR = FRAM_CS;
     SPITransferByte(0x06); /* Write Enable */
     FRAM_PORT.OUTSET = FRAM_CS;
@@ -172,6 +252,40 @@ INLINE void FRAMWrite(const void *Buffer, uint16_t Address, uint16_t ByteCount)
     SPIWriteBlock(Buffer, ByteCount);
 
     FRAM_PORT.OUTSET = FRAM_CS;
+}
+
+/* Addresses below the log are a window onto the image of the active setting. Moves the address
+ * into the image and returns how many of the bytes lie inside of it. */
+INLINE uint16_t ImageTranslate(uint16_t *Address, uint16_t ByteCount) {
+    const MemoryImageType *Image = &ImageTable.Images[0];
+    uint16_t ImageSize = IMAGE_ADDRESS(Image->PageCount);
+
+    if (*Address >= FRAM_LOG_ADDR_ADDR)
+        return ByteCount;
+
+    if (*Address >= ImageSize)
+        return 0;
+
+    ByteCount = MIN(ByteCount, ImageSize - *Address);
+    *Address += IMAGE_ADDRESS(Image->FirstPage);
+
+    return ByteCount;
+}
+
+INLINE void FRAMWrite(const void *Buffer, uint16_t Address, uint16_t ByteCount) {
+    uint16_t FRAMAddress = Address;
+    uint16_t FRAMByteCount = ImageTranslate(&FRAMAddress, ByteCount);
+
+    if (0 == FRAMByteCount)
+        return;
+
+    if ((Address < FRAM_LOG_ADDR_ADDR) && !ImageTable.Images[0].Dirty) {
+        ImageTable.Images[0].Dirty = 1;
+        FRAMWriteData(&ImageTable.Images[0].Dirty, IMAGE_TABLE_ADDR + offsetof(ImageTableType, Images[0].Dirty), 1);
+    }
+
+    FRAMWriteData(Buffer, FRAMAddress, FRAMByteCount);
+
 #ifdef CONFIG_ISO14443A_READER_SUPPORT
     if (0 == Address && GlobalSettings.ActiveSettingPtr->Configuration != CONFIG_ISO14443A_READER) {
         ConfigurationSetById(GlobalSettings.ActiveSettingPtr->Configuration);
@@ -183,6 +297,20 @@ INLINE void FRAMWrite(const void *Buffer, uint16_t Address, uint16_t ByteCount)
 #endif
 }
 
+INLINE void FRAMFill(uint8_t Value, uint16_t Address, uint16_t ByteCount) {
+    uint8_t Buffer[16];
+
+    memset(Buffer, Value, sizeof(Buffer));
+
+    while (ByteCount > 0) {
+        uint16_t ChunkSize = MIN(ByteCount, sizeof(Buffer));
+
+        FRAMWriteData(Buffer, Address, ChunkSize);
+        Address += ChunkSize;
+        ByteCount -= ChunkSize;
+    }
+}
+
 INLINE void FlashRead(void *Buffer, uint32_t Address, uint16_t ByteCount) {
     uint8_t *BufPtr = (uint8_t *) Buffer;
 
@@ -261,7 +389,32 @@ INLINE void FlashErase(uint32_t Address, uint16_t ByteCount) {
     }
 }
 
-INLINE void FlashToFRAM(uint32_t Address, uint16_t ByteCount) {
+INLINE void FlashCopyPage(uint32_t DestAddress, uint32_t SrcAddress) {
+    uint32_t PhysicalDest = DestAddress + FLASH_DATA_ADDR;
+    uint32_t PhysicalSrc = SrcAddress + FLASH_DATA_ADDR;
+
+    if ((PhysicalDest >= FLASH_DATA_START) && (PhysicalDest <= FLASH_DATA_END)
+            && (PhysicalSrc >= FLASH_DATA_START) && (PhysicalSrc <= FLASH_DATA_END)) {
+        /* The page is streamed through the flash page buffer, no RAM copy needed */
+        FlashWaitForSPM();
+
+        FlashEraseFlashBuffer();
+        FlashWaitForSPM();
+
+        for (uint16_t i = 0; i < APP_SECTION_PAGE_SIZE; i += 2) {
+            FlashLoadFlashWord(i, FlashReadWord(PhysicalSrc + i));
+            FlashWaitForSPM();
+        }
+
+        FlashEraseWriteApplicationPage(PhysicalDest);
+        FlashWaitForSPM();
+    }
+}
+
+INLINE void FlashToFRAM(uint32_t Address, uint16_t FRAMAddress, uint16_t ByteCount) {
+    uint8_t PageBuffer[APP_SECTION_PAGE_SIZE];
+    uint8_t *HalfBuffer = PageBuffer;
+
     if (0 == ByteCount)
         return;
 
@@ -281,34 +434,35 @@ INLINE void FlashToFRAM(uint32_t Address, uint16_t ByteCount) {
         FRAM_PORT.OUTCLR = FRAM_CS;
 
         SPITransferByte(0x02); /* Write command */
-        SPITransferByte(0); /* Address hi and lo byte */
-        SPITransferByte(0);
+        SPITransferByte((FRAMAddress >> 8) & 0xFF);   /* Address hi and lo byte */
+        SPITransferByte((FRAMAddress >> 0) & 0xFF);
 
-        /* Loop through bytes, read words from flash and write
-         * double byte into FRAM. */
+        /* Read half a page from flash while DMA writes the other half into FRAM */
         while (ByteCount > 1) {
-            uint16_t Word = FlashReadWord(PhysicalAddress);
+            uint16_t ChunkSize = MIN(ByteCount & ~1, APP_SECTION_PAGE_SIZE / 2);
 
-            SPITransferByte((Word >> 0) & 0xFF);
-            SPITransferByte((Word >> 8) & 0xFF);
+            FlashRead(HalfBuffer, Address, ChunkSize);
 
-            PhysicalAddress += 2;
-            ByteCount -= 2;
+            SPIWaitBlock();
+            SPIStartWriteBlock(HalfBuffer, ChunkSize);
+
+            HalfBuffer = (HalfBuffer == PageBuffer) ? &PageBuffer[APP_SECTION_PAGE_SIZE / 2] : PageBuffer;
+            Address += ChunkSize;
+            ByteCount -= ChunkSize;
         }
 
+        SPIWaitBlock();
+
         /* End write procedure of FRAM */
         FRAM_PORT.OUTSET = FRAM_CS;
     }
 }
 
-INLINE void FRAMToFlash(uint32_t Address, uint16_t ByteCount) {
-    if (0 == ByteCount)
-        return;
+INLINE void FRAMToFlash(uint32_t Address, uint16_t FRAMAddress, uint16_t ByteCount) {
+    uint8_t PageBuffer[APP_SECTION_PAGE_SIZE];
 
-    if (0 == bSramWriteFlag)
+    if (0 == ByteCount)
         return;
-    bSramWriteFlag = 0;
-    WriteEEPBlock((uint16_t) &bSramWriteFlag_EEP, &bSramWriteFlag, 1);
 
     /* We assume that FlashWrite is always called for write actions that are
      * aligned to APP_SECTION_PAGE_SIZE and a multiple of APP_SECTION_PAGE_SIZE.
@@ -322,8 +476,10 @@ INLINE void FRAMToFlash(uint32_t Address, uint16_t ByteCount) {
         FRAM_PORT.OUTCLR = FRAM_CS;
 
         SPITransferByte(0x03); /* Read command */
-        SPITransferByte(0); /* Address hi and lo byte */
-        SPITransferByte(0);
+        SPITransferByte((FRAMAddress >> 8) & 0xFF);   /* Address hi and lo byte */
+        SPITransferByte((FRAMAddress >> 0) & 0xFF);
+
+        SPIStartReadBlock(PageBuffer, APP_SECTION_PAGE_SIZE);
 
         while (PageCount-- > 0) {
             /* For each page to program, wait for NVM to get ready,
@@ -336,17 +492,24 @@ INLINE void FRAMToFlash(uint32_t Address, uint16_t ByteCount) {
             FlashEraseFlashBuffer();
             FlashWaitForSPM();
 
+            SPIWaitBlock();
+
             /* Write one page worth of data into flash buffer */
             for (uint16_t i = 0; i < APP_SECTION_PAGE_SIZE; i += 2) {
                 uint16_t Word = 0;
 
-                Word |= ((uint16_t) SPITransferByte(0) << 0);
-                Word |= ((uint16_t) SPITransferByte(0) << 8);
+                Word |= ((uint16_t) PageBuffer[i + 0] << 0);
+                Word |= ((uint16_t) PageBuffer[i + 1] << 8);
 
                 FlashLoadFlashWord(i, Word);
                 FlashWaitForSPM();
             }
 
+            /* The SRAM copy is free again. DMA fetches the next page from FRAM while this one
+             * is programmed, the CPU stalls on the application section but DMA does not. */
+            if (PageCount > 0)
+                SPIStartReadBlock(PageBuffer, APP_SECTION_PAGE_SIZE);
+
             /* Program flash buffer into flash */
             FlashEraseWriteApplicationPage(PhysicalAddress);
             FlashWaitForSPM();
@@ -359,9 +522,478 @@ INLINE void FRAMToFlash(uint32_t Address, uint16_t ByteCount) {
     }
 }
 
+/* Finishes or drops a journaled write interrupted by a power loss. Runs before the
+ * configuration is set up, so it must not trigger the reconfiguration in FRAMWrite. */
+static void JournalRecover(void) {
+    JournalType Journal;
+
+    FRAMRead(&Journal, JOURNAL_ADDR, sizeof(Journal));
+
+    if ((Journal.State != JOURNAL_STATE_PENDING) && (Journal.State != JOURNAL_STATE_COMMITTED)) {
+        return;
+    }
+
+    /* The journal holds FRAM addresses, the write has gone to the image containing them */
+    for (uint8_t i = 0; (i < IMAGE_COUNT) && (ImageTable.Images[i].Setting != IMAGE_NONE); i++) {
+        MemoryImageType *Image = &ImageTable.Images[i];
+        uint16_t ImageAddress = IMAGE_ADDRESS(Image->FirstPage);
+        uint16_t ImageSize = IMAGE_ADDRESS(Image->PageCount);
+
+        if ((Journal.ByteCount <= MEMORY_JOURNAL_DATA_SIZE) && (Journal.Address >= ImageAddress)
+                && (Journal.Address - ImageAddress < ImageSize) && (Journal.ByteCount <= ImageSize - (Journal.Address - ImageAddress))) {
+            if (Journal.State == JOURNAL_STATE_COMMITTED) {
+                FRAMWriteData(Journal.Data, Journal.Address, Journal.ByteCount);
+                Image->Dirty = 1;
+                FRAMWriteData(&ImageTable, IMAGE_TABLE_ADDR, sizeof(ImageTable));
+            } else if (i == 0) {
+                /* The target still holds the old data */
+                TornAddress = Journal.Address - ImageAddress;
+                TornByteCount = Journal.ByteCount;
+            }
+            break;
+        }
+    }
+
+    Journal.State = JOURNAL_STATE_IDLE;
+    FRAMWriteData(&Journal.State, JOURNAL_STATE_ADDR, 1);
+}
+
+static uint16_t SlotPagesUsed(void) {
+    uint16_t PagesUsed = 0;
+
+    for (uint8_t i = 0; i < SETTINGS_COUNT; i++) {
+        PagesUsed += MemorySlots[i].PageCount;
+    }
+
+    return PagesUsed;
+}
+
+static bool SlotTableValid(void) {
+    for (uint8_t i = 0; i < SETTINGS_COUNT; i++) {
+        const MemorySlotType *Slot = &MemorySlots[i];
+
+        if (Slot->PageCount == 0)
+            continue;
+
+        if ((Slot->PageCount > SLOT_PAGES(MEMORY_SIZE_PER_SETTING)) || (Slot->FirstPage >= SLOT_PAGE_COUNT)
+                || (Slot->PageCount > SLOT_PAGE_COUNT - Slot->FirstPage))
+            return false;
+
+        for (uint8_t j = 0; j < i; j++) {
+            const MemorySlotType *Other = &MemorySlots[j];
+
+            if ((Other->PageCount != 0) && (Slot->FirstPage < Other->FirstPage + Other->PageCount)
+                    && (Other->FirstPage < Slot->FirstPage + Slot->PageCount))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/* Copies the pages that are left, in the direction that reads every page before it is overwritten.
+ * So an interrupted copy can go on from the recorded progress. The slot table refers to the new
+ * place only after the last page. */
+static void SlotMoveFinish(SlotMoveType *Move) {
+    MemorySlotType *Slot = &MemorySlots[Move->SlotIdx];
+
+    while (Move->PagesDone < Move->PageCount) {
+        uint8_t i = (Move->ToPage < Move->FromPage) ? Move->PagesDone : Move->PageCount - 1 - Move->PagesDone;
+
+        FlashCopyPage(SLOT_ADDRESS(Move->ToPage + i), SLOT_ADDRESS(Move->FromPage + i));
+
+        Move->PagesDone++;
+        FRAMWriteData(&Move->PagesDone, SLOT_MOVE_DONE_ADDR, 1);
+    }
+
+    Slot->FirstPage = Move->ToPage;
+    Slot->PageCount = Move->PageCount;
+    WriteEEPBlock((uint16_t) &StoredMemorySlots[Move->SlotIdx], Slot, sizeof(MemorySlotType));
+
+    Move->State = SLOT_MOVE_IDLE;
+    FRAMWriteData(&Move->State, SLOT_MOVE_STATE_ADDR, 1);
+}
+
+/* Moves the pages of a slot to FirstPage and stores its entry with PageCount. The move is recorded
+ * in FRAM first, so a power loss can neither leave the slot table pointing at pages that are only
+ * partly copied nor tear the entry. */
+static void SlotMove(uint8_t SlotIdx, uint16_t FirstPage, uint16_t PageCount) {
+    SlotMoveType Move;
+
+    Move.FromPage = MemorySlots[SlotIdx].FirstPage;
+    Move.ToPage = FirstPage;
+    Move.SlotIdx = SlotIdx;
+    Move.PageCount = PageCount;
+    Move.PagesDone = (FirstPage == Move.FromPage) ? PageCount : 0;
+    FRAMWriteData(&Move, SLOT_MOVE_ADDR, offsetof(SlotMoveType, State));
+
+    Move.State = SLOT_MOVE_PENDING;
+    FRAMWriteData(&Move.State, SLOT_MOVE_STATE_ADDR, 1);
+
+    SlotMoveFinish(&Move);
+}
+
+INLINE void SlotSave(uint8_t SlotIdx) {
+    SlotMove(SlotIdx, MemorySlots[SlotIdx].FirstPage, MemorySlots[SlotIdx].PageCount);
+}
+
+/* Completes a slot move interrupted by a power loss, after the slot table is loaded. The entry of
+ * the slot may be torn, so it is rewritten from the record. */
+static void SlotMoveRecover(void) {
+    SlotMoveType Move;
+
+    FRAMRead(&Move, SLOT_MOVE_ADDR, sizeof(Move));
+
+    if (Move.State != SLOT_MOVE_PENDING)
+        return;
+
+    if ((Move.SlotIdx < SETTINGS_COUNT) && (Move.PageCount <= SLOT_PAGES(MEMORY_SIZE_PER_SETTING))
+            && (Move.PagesDone <= Move.PageCount) && (Move.FromPage <= SLOT_PAGE_COUNT - Move.PageCount)
+            && (Move.ToPage <= SLOT_PAGE_COUNT - Move.PageCount)) {
+        SlotMoveFinish(&Move);
+    } else {
+        Move.State = SLOT_MOVE_IDLE;
+        FRAMWriteData(&Move.State, SLOT_MOVE_STATE_ADDR, 1);
+    }
+}
+
+/* Packs all slots to the start of the data area, keeping their order */
+static void SlotCompact(void) {
+    uint16_t NextPage = 0;
+    MemorySlotType *Slot;
+
+    do {
+        Slot = NULL;
+
+        for (uint8_t i = 0; i < SETTINGS_COUNT; i++) {
+            MemorySlotType *Candidate = &MemorySlots[i];
+
+            if ((Candidate->PageCount != 0) && (Candidate->FirstPage >= NextPage)
+                    && ((Slot == NULL) || (Candidate->FirstPage < Slot->FirstPage)))
+                Slot = Candidate;
+        }
+
+        if (Slot != NULL) {
+            if (Slot->FirstPage != NextPage)
+                SlotMove(Slot - MemorySlots, NextPage, Slot->PageCount);
+
+            NextPage += Slot->PageCount;
+        }
+    } while (Slot != NULL);
+}
+
+static bool SlotFits(uint8_t SlotIdx, uint16_t PageCount) {
+    return PageCount <= MemorySlots[SlotIdx].PageCount + SLOT_PAGE_COUNT - SlotPagesUsed();
+}
+
+/* Resizes a slot in place. It keeps its contents up to the smaller size, added pages are erased.
+ * The slots behind it are moved up to make room or down to close the gap. Every step leaves a slot
+ * table that matches the flash, a power loss during a move is completed by SlotMoveRecover. */
+static bool SlotResize(uint8_t SlotIdx, uint16_t PageCount) {
+    MemorySlotType *Slot = &MemorySlots[SlotIdx];
+
+    if (PageCount == Slot->PageCount)
+        return true;
+
+    if (!SlotFits(SlotIdx, PageCount))
+        return false;
+
+    SlotCompact();
+
+    if (PageCount > Slot->PageCount) {
+        uint16_t Delta = PageCount - Slot->PageCount;
+        uint16_t Limit = SLOT_PAGE_COUNT;
+        MemorySlotType *Other;
+
+        if (Slot->PageCount == 0)
+            Slot->FirstPage = SlotPagesUsed();
+
+        /* All free pages are at the end now. Move the slots behind up, the last one first */
+        do {
+            Other = NULL;
+
+            for (uint8_t i = 0; i < SETTINGS_COUNT; i++) {
+                MemorySlotType *Candidate = &MemorySlots[i];
+
+                if ((Candidate->PageCount != 0) && (Candidate->FirstPage > Slot->FirstPage)
+                        && (Candidate->FirstPage < Limit) && ((Other == NULL) || (Candidate->FirstPage > Other->FirstPage)))
+                    Other = Candidate;
+            }
+
+            if (Other != NULL) {
+                Limit = Other->FirstPage;
+                SlotMove(Other - MemorySlots, Other->FirstPage + Delta, Other->PageCount);
+            }
+        } while (Other != NULL);
+
+        /* The added pages still hold what the slot behind or an earlier slot left there */
+        FlashErase(SLOT_ADDRESS(Slot->FirstPage + Slot->PageCount), Delta * SLOT_PAGE_SIZE);
+
+        Slot->PageCount = PageCount;
+        SlotSave(SlotIdx);
+    } else {
+        /* Saved before the slots behind move into the released pages */
+        Slot->PageCount = PageCount;
+        SlotSave(SlotIdx);
+        SlotCompact();
+    }
+
+    return true;
+}
+
+static void SlotTableInit(void) {
+    uint16_t Magic;
+
+    ReadEEPBlock((uint16_t) &StoredMemorySlotsMagic, &Magic, sizeof(Magic));
+    ReadEEPBlock((uint16_t) StoredMemorySlots, MemorySlots, sizeof(MemorySlots));
+
+    if (Magic == SLOT_TABLE_MAGIC)
+        SlotMoveRecover();
+
+    if ((Magic != SLOT_TABLE_MAGIC) || !SlotTableValid()) {
+        /* Take over the fixed layout of older firmware with one MEMORY_SIZE_PER_SETTING region per slot */
+        for (uint8_t i = 0; i < SETTINGS_COUNT; i++) {
+            if (i < MEMORY_SIZE / MEMORY_SIZE_PER_SETTING) {
+                MemorySlots[i].FirstPage = i * SLOT_PAGES(MEMORY_SIZE_PER_SETTING);
+                MemorySlots[i].PageCount = SLOT_PAGES(MEMORY_SIZE_PER_SETTING);
+            } else {
+                MemorySlots[i].FirstPage = 0;
+                MemorySlots[i].PageCount = 0;
+            }
+        }
+
+        Magic = SLOT_TABLE_MAGIC;
+        WriteEEPBlock((uint16_t) StoredMemorySlots, MemorySlots, sizeof(MemorySlots));
+        WriteEEPBlock((uint16_t) &StoredMemorySlotsMagic, &Magic, sizeof(Magic));
+    }
+
+    /* Slots are not fitted to their configuration here, only MemorySlotResize changes them. So a slot
+     * keeps its pages when this firmware lacks its configuration or after the fixed layout is taken over. */
+}
+
+static void ImageTableSave(void) {
+    FRAMWriteData(&ImageTable, IMAGE_TABLE_ADDR, sizeof(ImageTable));
+}
+
+static bool ImageTableValid(void) {
+    if (ImageTable.Magic != IMAGE_TABLE_MAGIC)
+        return false;
+
+    for (uint8_t i = 0; i < IMAGE_COUNT; i++) {
+        const MemoryImageType *Image = &ImageTable.Images[i];
+
+        if (Image->Setting == IMAGE_NONE)
+            continue;
+
+        /* Free entries only at the end, one image per setting, no overlaps */
+        if ((i > 0) && (ImageTable.Images[i - 1].Setting == IMAGE_NONE))
+            return false;
+
+        if ((Image->Setting > SETTINGS_COUNT) || (Image->PageCount > SLOT_PAGES(MEMORY_SIZE_PER_SETTING))
+                || (Image->FirstPage + Image->PageCount > IMAGE_AREA_PAGES))
+            return false;
+
+        for (uint8_t j = 0; j < i; j++) {
+            const MemoryImageType *Other = &ImageTable.Images[j];
+
+            if (Other->Setting == Image->Setting)
+                return false;
+
+            if ((Image->PageCount != 0) && (Other->PageCount != 0) && (Image->FirstPage < Other->FirstPage + Other->PageCount)
+                    && (Other->FirstPage < Image->FirstPage + Image->PageCount))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static void ImageStore(MemoryImageType *Image) {
+    /* The reader setting has no storage */
+    if (Image->Dirty && (Image->Setting < SETTINGS_COUNT)) {
+        const MemorySlotType *Slot = &MemorySlots[Image->Setting];
+
+        FRAMToFlash(SLOT_ADDRESS(Slot->FirstPage), IMAGE_ADDRESS(Image->FirstPage),
+                    MIN(Image->PageCount, Slot->PageCount) * SLOT_PAGE_SIZE);
+    }
+
+    Image->Dirty = 0;
+}
+
+static void ImageRecall(MemoryImageType *Image) {
+    if (Image->Setting < SETTINGS_COUNT) {
+        const MemorySlotType *Slot = &MemorySlots[Image->Setting];
+        uint8_t PageCount = MIN(Image->PageCount, Slot->PageCount);
+
+        FlashToFRAM(SLOT_ADDRESS(Slot->FirstPage), IMAGE_ADDRESS(Image->FirstPage), IMAGE_ADDRESS(PageCount));
+
+        /* A slot smaller than its configuration reads as erased flash beyond its pages */
+        FRAMFill(0xFF, IMAGE_ADDRESS(Image->FirstPage + PageCount), IMAGE_ADDRESS(Image->PageCount - PageCount));
+    }
+
+    Image->Dirty = 0;
+}
+
+/* Removes an entry from the table. The image has to be stored before. */
+static void ImageDrop(uint8_t ImageIdx) {
+    for (uint8_t i = ImageIdx; i < IMAGE_COUNT - 1; i++) {
+        ImageTable.Images[i] = ImageTable.Images[i + 1];
+    }
+
+    ImageTable.Images[IMAGE_COUNT - 1].Setting = IMAGE_NONE;
+}
+
+static bool ImagePagesFree(uint8_t FirstPage, uint8_t PageCount) {
+    if (FirstPage + PageCount > IMAGE_AREA_PAGES)
+        return false;
+
+    for (uint8_t i = 0; (i < IMAGE_COUNT) && (ImageTable.Images[i].Setting != IMAGE_NONE); i++) {
+        const MemoryImageType *Image = &ImageTable.Images[i];
+
+        /* Images without pages take no space */
+        if ((Image->PageCount != 0) && (FirstPage < Image->FirstPage + Image->PageCount) && (Image->FirstPage < FirstPage + PageCount))
+            return false;
+    }
+
+    return true;
+}
+
+/* Finds free FRAM pages at the start of the area or right behind an image */
+static int16_t ImageFindPages(uint8_t PageCount) {
+    if (ImagePagesFree(0, PageCount))
+        return 0;
+
+    for (uint8_t i = 0; (i < IMAGE_COUNT) && (ImageTable.Images[i].Setting != IMAGE_NONE); i++) {
+        uint8_t FirstPage = ImageTable.Images[i].FirstPage + ImageTable.Images[i].PageCount;
+
+        if (ImagePagesFree(FirstPage, PageCount))
+            return FirstPage;
+    }
+
+    return -1;
+}
+
+/* Loads the image of a setting from flash into free FRAM and makes it the most recently used.
+ * Least recently used images are stored and evicted until it fits. */
+static void ImageLoad(uint8_t Setting, uint8_t PageCount) {
+    int16_t FirstPage;
+
+    while ((ImageTable.Images[IMAGE_COUNT - 1].Setting != IMAGE_NONE) || ((FirstPage = ImageFindPages(PageCount)) < 0)) {
+        uint8_t LastIdx = IMAGE_COUNT - 1;
+
+        while (ImageTable.Images[LastIdx].Setting == IMAGE_NONE)
+            LastIdx--;
+
+        ImageStore(&ImageTable.Images[LastIdx]);
+        ImageDrop(LastIdx);
+    }
+
+    for (uint8_t i = IMAGE_COUNT - 1; i > 0; i--) {
+        ImageTable.Images[i] = ImageTable.Images[i - 1];
+    }
+
+    ImageTable.Images[0].Setting = Setting;
+    ImageTable.Images[0].FirstPage = FirstPage;
+    ImageTable.Images[0].PageCount = PageCount;
+    ImageRecall(&ImageTable.Images[0]);
+
+    ImageTableSave();
+}
+
+/* Makes the image of the active setting Images[0]. A resident image is used as it is. */
+static void ImageActivate(void) {
+    uint8_t Setting = GlobalSettings.ActiveSettingIdx;
+    uint8_t PageCount = SLOT_PAGES(ConfigurationGetMemorySize(GlobalSettings.ActiveSettingPtr->Configuration));
+
+    for (uint8_t i = 0; (i < IMAGE_COUNT) && (ImageTable.Images[i].Setting != IMAGE_NONE); i++) {
+        MemoryImageType Image = ImageTable.Images[i];
+
+        if (Image.Setting == Setting) {
+            if (Image.PageCount == PageCount) {
+                while (i > 0) {
+                    ImageTable.Images[i] = ImageTable.Images[i - 1];
+                    i--;
+                }
+
+                ImageTable.Images[0] = Image;
+                ImageTableSave();
+                return;
+            }
+
+            ImageStore(&ImageTable.Images[i]);
+            ImageDrop(i);
+            break;
+        }
+    }
+
+    ImageLoad(Setting, PageCount);
+}
+
+/* Resizes the image of the active setting in place if possible, otherwise reloads it elsewhere */
+static void ImageResize(uint8_t PageCount) {
+    MemoryImageType *Image = &ImageTable.Images[0];
+
+    if (PageCount <= Image->PageCount) {
+        Image->PageCount = PageCount;
+        ImageTableSave();
+    } else if (ImagePagesFree(Image->FirstPage + Image->PageCount, PageCount - Image->PageCount)) {
+        /* The new pages come from flash, which SlotResize has erased */
+        if (Image->Setting < SETTINGS_COUNT)
+            FlashToFRAM(SLOT_ADDRESS(MemorySlots[Image->Setting].FirstPage + Image->PageCount),
+                        IMAGE_ADDRESS(Image->FirstPage + Image->PageCount), IMAGE_ADDRESS(PageCount - Image->PageCount));
+
+        Image->PageCount = PageCount;
+        ImageTableSave();
+    } else {
+        uint8_t Setting = Image->Setting;
+
+        ImageStore(Image);
+        ImageDrop(0);
+        ImageLoad(Setting, PageCount);
+    }
+}
+
+static void ImageTableInit(void) {
+    FRAMRead(&ImageTable, IMAGE_TABLE_ADDR, sizeof(ImageTable));
+
+    if (!ImageTableValid()) {
+        /* Older firmware kept the memory of the active setting at the start of FRAM. It may be newer
+         * than the flash, so it is taken over as a changed image. */
+        ImageTable.Magic = IMAGE_TABLE_MAGIC;
+
+        for (uint8_t i = 0; i < IMAGE_COUNT; i++) {
+            ImageTable.Images[i].Setting = IMAGE_NONE;
+        }
+
+        ImageTable.Images[0].Setting = GlobalSettings.ActiveSettingIdx;
+        ImageTable.Images[0].FirstPage = 0;
+        ImageTable.Images[0].PageCount = SLOT_PAGES(ConfigurationGetMemorySize(GlobalSettings.ActiveSettingPtr->Configuration));
+        ImageTable.Images[0].Dirty = 1;
+
+        ImageTableSave();
+
+        /* Neither is there a slot move to complete */
+        uint8_t State = SLOT_MOVE_IDLE;
+        FRAMWriteData(&State, SLOT_MOVE_STATE_ADDR, 1);
+    }
+}
+
+/* Drops images that no longer match the size of their slot, after SlotTableInit */
+static void ImageTableCheck(void) {
+    for (uint8_t i = IMAGE_COUNT; i-- > 0;) {
+        MemoryImageType *Image = &ImageTable.Images[i];
+
+        if ((Image->Setting != IMAGE_NONE)
+                && (Image->PageCount != SLOT_PAGES(ConfigurationGetMemorySize(GlobalSettings.Settings[Image->Setting].Configuration)))) {
+            ImageStore(Image);
+            ImageDrop(i);
+            ImageTableSave();
+        }
+    }
+}
+
 void MemoryInit(void) {
     ReadEEPBlock((uint16_t) &bUidMode_EEP, &bUidMode, 1);
-    ReadEEPBlock((uint16_t) &bSramWriteFlag_EEP, &bSramWriteFlag, 1);
 
     /* Configure FRAM_USART for SPI master mode 0 with maximum clock frequency */
     FRAM_PORT.OUTSET = FRAM_CS;
@@ -398,12 +1030,26 @@ void MemoryInit(void) {
     SEND_DMA.DESTADDR1 = ((uintptr_t) &FRAM_USART.DATA >> 8) & 0xFF;
     SEND_DMA.DESTADDR2 = 0;
     SEND_DMA.CTRLA = DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_1BYTE_gc;
+
+    ImageTableInit();
+    JournalRecover();
+    SlotTableInit();
+    ImageTableCheck();
+    ImageActivate();
 }
 
 void MemoryReadBlock(void *Buffer, uint16_t Address, uint16_t ByteCount) {
+    uint16_t FRAMAddress = Address;
+    uint16_t FRAMByteCount;
+
     if (ByteCount == 0)
         return;
-    FRAMRead(Buffer, Address, ByteCount);
+
+    FRAMByteCount = ImageTranslate(&FRAMAddress, ByteCount);
+    FRAMRead(Buffer, FRAMAddress, FRAMByteCount);
+
+    /* Nothing is stored beyond the image */
+    memset((uint8_t *) Buffer + FRAMByteCount, MEMORY_INIT_VALUE, ByteCount - FRAMByteCount);
 }
 
 void MemoryWriteBlock(const void *Buffer, uint16_t Address, uint16_t ByteCount) {
@@ -414,17 +1060,67 @@ void MemoryWriteBlock(const void *Buffer, uint16_t Address, uint16_t ByteCount)
     LEDHook(LED_MEMORY_CHANGED, LED_ON);
 }
 
+void MemoryWriteBlockAtomic(const void *Buffer, uint16_t Address, uint16_t ByteCount) {
+    JournalType Journal;
+    uint16_t FRAMAddress = Address;
+    uint8_t State;
+
+    if ((ByteCount == 0) || (ByteCount > MEMORY_JOURNAL_DATA_SIZE))
+        return;
+
+    /* Only writes into the image of the active setting are journaled */
+    if ((Address >= FRAM_LOG_ADDR_ADDR) || (ImageTranslate(&FRAMAddress, ByteCount) != ByteCount))
+        return;
+
+    /* Header and state go out in one transfer, state last */
+    Journal.Address = FRAMAddress;
+    Journal.ByteCount = ByteCount;
+    Journal.State = JOURNAL_STATE_PENDING;
+    FRAMWriteData(&Journal, JOURNAL_ADDR, offsetof(JournalType, Data));
+    FRAMWriteData(Buffer, JOURNAL_DATA_ADDR, ByteCount);
+
+    State = JOURNAL_STATE_COMMITTED;
+    FRAMWriteData(&State, JOURNAL_STATE_ADDR, 1);
+
+    MemoryWriteBlock(Buffer, Address, ByteCount);
+
+    State = JOURNAL_STATE_IDLE;
+    FRAMWriteData(&State, JOURNAL_STATE_ADDR, 1);
+}
+
+bool MemoryCheckTornWrite(uint16_t Address, uint16_t ByteCount) {
+    if ((TornByteCount == 0) || (Address >= TornAddress + TornByteCount) || (TornAddress >= Address + ByteCount))
+        return false;
+
+    TornByteCount = 0;
+    return true;
+}
+
 void MemoryClear(void) {
-    if (GlobalSettings.ActiveSettingIdx < SETTINGS_COUNT)
-        FlashErase((uint32_t) GlobalSettings.ActiveSettingIdx * MEMORY_SIZE_PER_SETTING, MEMORY_SIZE_PER_SETTING);
+    if (GlobalSettings.ActiveSettingIdx < SETTINGS_COUNT) {
+        const MemorySlotType *Slot = &MemorySlots[GlobalSettings.ActiveSettingIdx];
+        FlashErase(SLOT_ADDRESS(Slot->FirstPage), Slot->PageCount * SLOT_PAGE_SIZE);
+    }
 
     MemoryRecall();
 }
 
+void MemoryActivate(void) {
+    ImageActivate();
+
+    /* A torn write belongs to the memory of the previous setting */
+    TornByteCount = 0;
+
+    SystemTickClearFlag();
+}
+
 void MemoryRecall(void) {
     /* Recall memory from permanent flash */
-    if (GlobalSettings.ActiveSettingIdx < SETTINGS_COUNT)
-        FlashToFRAM((uint32_t) GlobalSettings.ActiveSettingIdx * MEMORY_SIZE_PER_SETTING, ActiveConfiguration.MemorySize);
+    ImageRecall(&ImageTable.Images[0]);
+    ImageTableSave();
+
+    /* A torn write belongs to the memory that has just been replaced */
+    TornByteCount = 0;
 
 #ifdef CONFIG_ISO14443A_READER_SUPPORT
     if (GlobalSettings.ActiveSettingPtr->Configuration != CONFIG_ISO14443A_READER)
@@ -436,8 +1132,10 @@ void MemoryRecall(void) {
 
 void MemoryStore(void) {
     /* Store current memory into permanent flash */
-    if (GlobalSettings.ActiveSettingIdx < SETTINGS_COUNT)
-        FRAMToFlash((uint32_t) GlobalSettings.ActiveSettingIdx * MEMORY_SIZE_PER_SETTING, ActiveConfiguration.MemorySize);
+    if (ImageTable.Images[0].Dirty) {
+        ImageStore(&ImageTable.Images[0]);
+        ImageTableSave();
+    }
 
     LEDHook(LED_MEMORY_CHANGED, LED_OFF);
     LEDHook(LED_MEMORY_STORED, LED_PULSE);
@@ -445,6 +1143,23 @@ void MemoryStore(void) {
     SystemTickClearFlag();
 }
 
+bool MemorySlotFits(uint16_t ByteCount) {
+    /* The reader setting has no storage */
+    if (GlobalSettings.ActiveSettingIdx >= SETTINGS_COUNT)
+        return true;
+
+    return SlotFits(GlobalSettings.ActiveSettingIdx, SLOT_PAGES(ByteCount));
+}
+
+bool MemorySlotResize(uint16_t ByteCount) {
+    if ((GlobalSettings.ActiveSettingIdx < SETTINGS_COUNT) && !SlotResize(GlobalSettings.ActiveSettingIdx, SLOT_PAGES(ByteCount)))
+        return false;
+
+    ImageResize(SLOT_PAGES(ByteCount));
+
+    return true;
+}
+
 bool MemoryUploadBlock(void *Buffer, uint32_t BlockAddress, uint16_t ByteCount) {
     if ((BlockAddress >= MEMORY_SIZE_PER_SETTING) || (BlockAddress >= ActiveConfiguration.MemorySize)) {
         /* Prevent writing out of bounds by silently ignoring it */
@@ -471,7 +1186,7 @@ bool MemoryDownloadBlock(void *Buffer, uint32_t BlockAddress, uint16_t ByteCount
         ByteCount = MIN(ByteCount, BytesLeft);
 
         /* Output local memory contents */
-        FRAMRead(Buffer, BlockAddress, ByteCount);
+        MemoryReadBlock(Buffer, BlockAddress, ByteCount);
 
         return true;
     }
@@ -10,7 +10,8 @@
 
 #define MEMORY_SIZE					(FLASH_DATA_SIZE) /* From makefile */
 #define MEMORY_INIT_VALUE			0x00
-#define MEMORY_SIZE_PER_SETTING		8192
+#define MEMORY_SIZE_PER_SETTING		8192 /* Largest slot, the working image in FRAM */
+#define MEMORY_JOURNAL_DATA_SIZE	16 /* Largest tearing-safe write */
 
 #ifndef __ASSEMBLER__
 #include "Common.h"
@@ -20,10 +21,28 @@ void MemoryReadBlock(void *Buffer, uint16_t Address, uint16_t ByteCount);
 void MemoryWriteBlock(const void *Buffer, uint16_t Address, uint16_t ByteCount);
 void MemoryClear(void);
 
+/* Tearing-safe write. The data goes to a shadow entry in FRAM first and only after its commit
+ * marker is set to the target, so a power loss leaves either the old or the new data.
+ * MemoryInit completes committed writes and drops the others. */
+void MemoryWriteBlockAtomic(const void *Buffer, uint16_t Address, uint16_t ByteCount);
+/* True if a write into the given range has been dropped by MemoryInit. Reports it only once. */
+bool MemoryCheckTornWrite(uint16_t Address, uint16_t ByteCount);
 
+
+/* FRAM keeps the images of the recently used settings. Addresses below the log refer to the image
+ * of the active setting, the others are stored to flash when their space is needed.
+ * MemoryActivate switches to the image of the active setting, loading it only if it is not resident. */
+void MemoryActivate(void);
 void MemoryRecall(void);
 void MemoryStore(void);
 
+/* Every slot owns a page aligned region of the flash data area, just large enough for the memory
+ * of its configuration. Resizing the slot of the active setting moves the slots behind it, so the
+ * free pages always stay in one piece at the end. Slots are only resized on an explicit change of
+ * the configuration, never at boot: a slot smaller than its configuration stores what fits. */
+bool MemorySlotFits(uint16_t ByteCount);
+bool MemorySlotResize(uint16_t ByteCount);
+
 /* For use with XModem */
 bool MemoryUploadBlock(void *Buffer, uint32_t BlockAddress, uint16_t ByteCount);
 bool MemoryDownloadBlock(void *Buffer, uint32_t BlockAddress, uint16_t ByteCount);
@@ -58,34 +58,60 @@ SettingsType EEMEM StoredSettings = {
             .bSakMode = 0,
         }
 #endif
-    }
+    },
+    .Version = SETTINGS_VERSION
 };
 
+static void SettingsDefault(uint8_t First, uint8_t Last) {
+    for (uint8_t i = First; i <= Last; i++) {
+        GlobalSettings.Settings[i].Configuration = CONFIG_NONE;
+        GlobalSettings.Settings[i].ButtonActions[BUTTON_L_PRESS_SHORT] = DEFAULT_LBUTTON_ACTION;
+        GlobalSettings.Settings[i].ButtonActions[BUTTON_R_PRESS_SHORT] = DEFAULT_RBUTTON_ACTION;
+        GlobalSettings.Settings[i].ButtonActions[BUTTON_L_PRESS_LONG]  = DEFAULT_LBUTTON_ACTION_LONG;
+        GlobalSettings.Settings[i].ButtonActions[BUTTON_R_PRESS_LONG]  = DEFAULT_RBUTTON_ACTION_LONG;
+        GlobalSettings.Settings[i].LogMode = DEFAULT_LOG_MODE;
+        GlobalSettings.Settings[i].LEDRedFunction = DEFAULT_RED_LED_ACTION;
+        GlobalSettings.Settings[i].LEDGreenFunction = DEFAULT_GREEN_LED_ACTION;
+        GlobalSettings.Settings[i].PendingTaskTimeout = DEFAULT_PENDING_TASK_TIMEOUT;
+        GlobalSettings.Settings[i].ReaderThreshold = DEFAULT_READER_THRESHOLD;
+        GlobalSettings.Settings[i].bSakMode = 0;
+    }
+}
+
 void SettingsLoad(void) {
+    bool Changed = false;
+
     ReadEEPBlock((uint16_t) &StoredSettings, &GlobalSettings, sizeof(SettingsType));
 
-    if (GlobalSettings.ActiveSettingIdx > SETTINGS_COUNT || GlobalSettings.ActiveSettingPtr !=  &GlobalSettings.Settings[GlobalSettings.ActiveSettingIdx]) {
+    if (GlobalSettings.Version != SETTINGS_VERSION && GlobalSettings.ActiveSettingIdx <= SETTINGS_COUNT_V1) {
+        /* Older firmware stored SETTINGS_COUNT_V1 slots followed by the reader-only setting.
+         * Move that one behind the added slots, which start out empty */
+        GlobalSettings.Settings[SETTINGS_COUNT] = GlobalSettings.Settings[SETTINGS_COUNT_V1];
+        SettingsDefault(SETTINGS_COUNT_V1, SETTINGS_COUNT - 1);
+
+        if (GlobalSettings.ActiveSettingIdx == SETTINGS_COUNT_V1)
+            GlobalSettings.ActiveSettingIdx = SETTINGS_COUNT;
+
+        GlobalSettings.ActiveSettingPtr = &GlobalSettings.Settings[GlobalSettings.ActiveSettingIdx];
+        GlobalSettings.Version = SETTINGS_VERSION;
+        Changed = true;
+    }
+
+    if (GlobalSettings.Version != SETTINGS_VERSION || GlobalSettings.ActiveSettingIdx > SETTINGS_COUNT
+            || GlobalSettings.ActiveSettingPtr !=  &GlobalSettings.Settings[GlobalSettings.ActiveSettingIdx]) {
         GlobalSettings.ActiveSettingIdx = SETTINGS_COUNT;
         GlobalSettings.ActiveSettingPtr = &GlobalSettings.Settings[SETTINGS_COUNT];
+        GlobalSettings.Version = SETTINGS_VERSION;
 
-        for (int i = 0; i <= SETTINGS_COUNT; i++) {
-            GlobalSettings.Settings[i].Configuration = CONFIG_NONE;
-            GlobalSettings.Settings[i].ButtonActions[BUTTON_L_PRESS_SHORT] = DEFAULT_LBUTTON_ACTION;
-            GlobalSettings.Settings[i].ButtonActions[BUTTON_R_PRESS_SHORT] = DEFAULT_RBUTTON_ACTION;
-            GlobalSettings.Settings[i].ButtonActions[BUTTON_L_PRESS_LONG]  = DEFAULT_LBUTTON_ACTION_LONG;
-            GlobalSettings.Settings[i].ButtonActions[BUTTON_R_PRESS_LONG]  = DEFAULT_RBUTTON_ACTION_LONG;
-            GlobalSettings.Settings[i].LogMode = DEFAULT_LOG_MODE;
-            GlobalSettings.Settings[i].LEDRedFunction = DEFAULT_RED_LED_ACTION;
-            GlobalSettings.Settings[i].LEDGreenFunction = DEFAULT_GREEN_LED_ACTION;
-            GlobalSettings.Settings[i].PendingTaskTimeout = DEFAULT_PENDING_TASK_TIMEOUT;
-            GlobalSettings.Settings[i].ReaderThreshold = DEFAULT_READER_THRESHOLD;
-        }
+        SettingsDefault(0, SETTINGS_COUNT);
 #ifdef CONFIG_ISO14443A_READER_SUPPORT
         GlobalSettings.Settings[SETTINGS_COUNT].Configuration = CONFIG_ISO14443A_READER;
 #endif
+        Changed = true;
+    }
 
+    if (Changed)
         SettingsSave();
-    }
 }
 
 void SettingsSave(void) {
@@ -114,9 +140,22 @@ void SettingsCycle(uint8_t bAdd) {
     }
 }
 
+static uint8_t SettingToName(uint8_t Setting, char *Name) {
+    uint8_t Length = 0;
+
+    if (Setting >= 10) {
+        Name[Length++] = '0' + Setting / 10;
+    }
+
+    Name[Length++] = '0' + Setting % 10;
+    Name[Length] = '\0';
+
+    return Length;
+}
+
 bool SettingsSetActiveById(uint8_t Setting) {
-    uint8_t cSetting = Setting + '0';
-    LogEntry(LOG_INFO_SETTING_SET, &cSetting, 1);
+    char SettingName[4];
+    LogEntry(LOG_INFO_SETTING_SET, SettingName, SettingToName(Setting, SettingName));
 
     if ((Setting >= SETTINGS_FIRST) && (Setting <= (SETTINGS_LAST + 1))) {
         uint8_t SettingIdx = SETTING_TO_INDEX(Setting);
@@ -125,26 +164,24 @@ bool SettingsSetActiveById(uint8_t Setting) {
         CommandLinePendingTaskBreak();
 
         if (SettingIdx != GlobalSettings.ActiveSettingIdx) {
-            /* Store current memory contents permanently */
-            MemoryStore();
-
             GlobalSettings.ActiveSettingIdx = SettingIdx;
             GlobalSettings.ActiveSettingPtr =
                 &GlobalSettings.Settings[SettingIdx];
 
+            /* Switch to the memory of the new setting. The previous memory stays in FRAM
+             * and is stored to flash once its space is needed. */
+            MemoryActivate();
+
             /* Settings have changed. Progress changes through system */
             ConfigurationSetById(GlobalSettings.ActiveSettingPtr->Configuration);
             LogSetModeById(GlobalSettings.ActiveSettingPtr->LogMode);
 
-            /* Recall new memory contents ( ApplicationInitFunc() will be called again )*/
-            MemoryRecall();
-
             SETTING_UPDATE(GlobalSettings.ActiveSettingIdx);
             SETTING_UPDATE(GlobalSettings.ActiveSettingPtr);
         }
 
         /* Notify LED. blink according to current setting */
-        LEDHook(LED_SETTING_CHANGE, LED_BLINK + SettingIdx);
+        LEDHook(LED_SETTING_CHANGE, LED_BLINK + MIN(SettingIdx, LED_BLINK_9X - LED_BLINK));
 
         return true;
     } else {
@@ -157,18 +194,20 @@ uint8_t SettingsGetActiveById(void) {
 }
 
 void SettingsGetActiveByName(char *SettingOut, uint16_t BufferSize) {
-    SettingOut[0] = SettingsGetActiveById() + '0';
-    SettingOut[1] = '\0';
+    SettingToName(SettingsGetActiveById(), SettingOut);
 }
 
 bool SettingsSetActiveByName(const char *Setting) {
-    uint8_t SettingNr = Setting[0] - '0';
+    uint8_t SettingNr = 0;
+    uint8_t i;
 
-    if (Setting[1] == '\0') {
-//        LogEntry(LOG_INFO_SETTING_SET, Setting, 1);
+    for (i = 0; (i < 2) && (Setting[i] >= '0') && (Setting[i] <= '9'); i++) {
+        SettingNr = SettingNr * 10 + Setting[i] - '0';
+    }
+
+    if ((i > 0) && (Setting[i] == '\0')) {
         return SettingsSetActiveById(SettingNr);
     } else {
         return false;
     }
 }
-
@@ -15,7 +15,9 @@
 #include "Memory.h"
 #include <avr/eeprom.h>
 
-#define SETTINGS_COUNT		(MEMORY_SIZE / MEMORY_SIZE_PER_SETTING)
+#define SETTINGS_COUNT		32 /* Slots are sized by their configuration, see MemorySlotResize */
+#define SETTINGS_COUNT_V1	8 /* Slot count of older firmware, whose settings carry no version */
+#define SETTINGS_VERSION	0x5302 /* Identifies the layout of SettingsType in the EEPROM */
 #define SETTINGS_FIRST		1
 #define SETTINGS_LAST		(SETTINGS_FIRST + SETTINGS_COUNT - 1)
 
@@ -41,6 +43,7 @@ typedef struct {
     uint8_t ActiveSettingIdx;
     SettingsEntryType *ActiveSettingPtr;
     SettingsEntryType Settings[SETTINGS_COUNT + 1];
+    uint16_t Version;
 } SettingsType;
 
 extern SettingsType GlobalSettings, StoredSettings;
@@ -97,6 +97,15 @@ const PROGMEM CommandEntryType CommandTable[] = {
         .SetFunc    = NO_FUNCTION,
         .GetFunc    = NO_FUNCTION
     },
+#ifdef CONFIG_NTAG21X_SUPPORT
+    {
+        .Command    = COMMAND_NDEFUPDATE,
+        .ExecFunc   = CommandExecNdefUpdate,
+        .ExecParamFunc = NO_FUNCTION,
+        .SetFunc    = NO_FUNCTION,
+        .GetFunc    = NO_FUNCTION
+    },
+#endif
     {
         .Command    = COMMAND_RESET,
         .ExecFunc   = CommandExecReset,
@@ -303,6 +312,41 @@ const PROGMEM CommandEntryType CommandTable[] = {
         .SetFunc 	= NO_FUNCTION,
         .GetFunc 	= NO_FUNCTION
     },
+    {
+        .Command	= COMMAND_INVENTORY,
+        .ExecFunc 	= CommandExecInventory,
+        .ExecParamFunc = NO_FUNCTION,
+        .SetFunc 	= NO_FUNCTION,
+        .GetFunc 	= NO_FUNCTION
+    },
+    {
+        .Command	= COMMAND_NESTED,
+        .ExecFunc 	= NO_FUNCTION,
+        .ExecParamFunc = CommandExecParamNested,
+        .SetFunc 	= NO_FUNCTION,
+        .GetFunc 	= NO_FUNCTION
+    },
+    {
+        .Command	= COMMAND_NONCEMEM,
+        .ExecFunc 	= NO_FUNCTION,
+        .ExecParamFunc = NO_FUNCTION,
+        .SetFunc 	= NO_FUNCTION,
+        .GetFunc 	= CommandGetNonceMem
+    },
+    {
+        .Command	= COMMAND_NONCEDOWNLOAD,
+        .ExecFunc 	= CommandExecNonceDownload,
+        .ExecParamFunc = NO_FUNCTION,
+        .SetFunc 	= NO_FUNCTION,
+        .GetFunc 	= NO_FUNCTION
+    },
+    {
+        .Command	= COMMAND_NONCECLEAR,
+        .ExecFunc 	= CommandExecNonceClear,
+        .ExecParamFunc = NO_FUNCTION,
+        .SetFunc 	= NO_FUNCTION,
+        .GetFunc 	= NO_FUNCTION
+    },
 #endif
     {
         .Command	= COMMAND_TIMEOUT,
@@ -323,7 +367,7 @@ const PROGMEM CommandEntryType CommandTable[] = {
         .ExecFunc   = CommandExecAutocalibrate,
         .ExecParamFunc = NO_FUNCTION,
         .SetFunc    = NO_FUNCTION,
-        .GetFunc    = NO_FUNCTION
+        .GetFunc    = CommandGetAutocalibrate
     },
     {
         .Command    = COMMAND_FIELD,
@@ -377,6 +421,15 @@ const PROGMEM CommandEntryType CommandTable[] = {
         .SetFunc    = NO_FUNCTION,
         .GetFunc    = CommandGetBaudrate,
     },
+#ifdef SUPPORT_CRYPTO_BENCHMARK
+    {
+        .Command    = COMMAND_CRYPTOBENCH,
+        .ExecFunc   = NO_FUNCTION,
+        .ExecParamFunc = NO_FUNCTION,
+        .SetFunc    = NO_FUNCTION,
+        .GetFunc    = CommandGetCryptoBench
+    },
+#endif
     {
         /* This has to be last element */
         .Command    = COMMAND_LIST_END,
@@ -17,6 +17,13 @@
 #include "../Codec/Codec.h"
 #include "uartcmd.h"
 #include "../Application/Reader14443A.h"
+#ifdef CONFIG_NTAG21X_SUPPORT
+#include "../Application/NTAG21x.h"
+#endif
+#ifdef SUPPORT_CRYPTO_BENCHMARK
+#include "../Application/CryptoTDEA.h"
+#include "../Application/CryptoAES128.h"
+#endif
 
 extern Reader14443Command Reader14443CurrentCommand;
 extern Sniff14443Command Sniff14443CurrentCommand;
@@ -192,6 +199,17 @@ CommandStatusIdType CommandExecDownload(char *OutMessage) {
     return COMMAND_INFO_XMODEM_WAIT_ID;
 }
 
+#ifdef CONFIG_NTAG21X_SUPPORT
+CommandStatusIdType CommandExecNdefUpdate(char *OutMessage) {
+    if (!NTAG21xNdefUpdateAvailable()) {
+        return COMMAND_ERR_INVALID_USAGE_ID;
+    }
+
+    XModemReceive(NTAG21xNdefUpdateBlock);
+    return COMMAND_INFO_XMODEM_WAIT_ID;
+}
+#endif
+
 CommandStatusIdType CommandExecReset(char *OutMessage) {
     USB_Detach();
     USB_Disable();
@@ -584,6 +602,82 @@ CommandStatusIdType CommandExecIdentifyCard(char *OutMessage) {
     CommandLinePendingTaskTimeout = &Reader14443AAppTimeout;
     return TIMEOUT_COMMAND;
 }
+
+CommandStatusIdType CommandExecInventory(char *OutMessage) {
+    if (GlobalSettings.ActiveSettingPtr->Configuration != CONFIG_ISO14443A_READER)
+        return COMMAND_ERR_INVALID_USAGE_ID;
+    ApplicationReset();
+
+    Reader14443CurrentCommand = Reader14443_Inventory;
+    Reader14443AAppInit();
+    Reader14443AInventorySetup();
+    Reader14443ACodecStart();
+    CommandLinePendingTaskTimeout = &Reader14443AAppTimeout;
+    return TIMEOUT_COMMAND;
+}
+
+CommandStatusIdType CommandExecParamNested(char *OutMessage, const char *InParams) {
+    if (GlobalSettings.ActiveSettingPtr->Configuration != CONFIG_ISO14443A_READER)
+        return COMMAND_ERR_INVALID_USAGE_ID;
+
+    /* First parameter: auth command, block and key of the known sector */
+    char const *paramTwo = strchr(InParams, ' ');
+    if (paramTwo != (InParams + 16))
+        return COMMAND_ERR_INVALID_PARAM_ID;
+    char tmpHex[NESTED_TARGETS_MAX * 4 + 1];
+    uint8_t Auth[8];
+    memcpy(tmpHex, InParams, 16);
+    tmpHex[16] = '\0';
+    if (HexStringToBuffer(Auth, sizeof(Auth), tmpHex) != sizeof(Auth) || (Auth[0] != 0x60 && Auth[0] != 0x61))
+        return COMMAND_ERR_INVALID_PARAM_ID;
+
+    /* Second parameter: up to NESTED_TARGETS_MAX pairs of auth command and block */
+    InParams = ++paramTwo;
+    char const *paramThree = strchr(InParams, ' ');
+    uint16_t length = (paramThree == NULL) ? strlen(InParams) : (paramThree - InParams);
+    if (length == 0 || (length % 4) || length > NESTED_TARGETS_MAX * 4)
+        return COMMAND_ERR_INVALID_PARAM_ID;
+    uint8_t Targets[NESTED_TARGETS_MAX * 2];
+    memcpy(tmpHex, InParams, length);
+    tmpHex[length] = '\0';
+    if (HexStringToBuffer(Targets, sizeof(Targets), tmpHex) != length / 2)
+        return COMMAND_ERR_INVALID_PARAM_ID;
+    uint8_t i;
+    for (i = 0; i < length / 2; i += 2) {
+        if (Targets[i] != 0x60 && Targets[i] != 0x61)
+            return COMMAND_ERR_INVALID_PARAM_ID;
+    }
+
+    /* Optional third parameter: number of nonces per target */
+    uint16_t count = 1;
+    if (paramThree != NULL && (!sscanf_P(paramThree + 1, PSTR("%5u"), &count) || count == 0 || count > 255))
+        return COMMAND_ERR_INVALID_PARAM_ID;
+
+    ApplicationReset();
+
+    Reader14443CurrentCommand = Reader14443_Nested_Collect;
+    Reader14443AAppInit();
+    Reader14443ANestedSetup(Auth, Targets, length / 4, count);
+    Reader14443ACodecStart();
+    CommandLinePendingTaskTimeout = &Reader14443AAppTimeout;
+    return TIMEOUT_COMMAND;
+}
+
+CommandStatusIdType CommandGetNonceMem(char *OutParam) {
+    snprintf_P(OutParam, TERMINAL_BUFFER_SIZE,
+               PSTR("%u of %u records"), NonceMemCount(), FRAM_NONCE_SIZE / NONCE_RECORD_SIZE);
+    return COMMAND_INFO_OK_WITH_TEXT_ID;
+}
+
+CommandStatusIdType CommandExecNonceDownload(char *OutMessage) {
+    XModemSend(NonceMemLoadBlock);
+    return COMMAND_INFO_XMODEM_WAIT_ID;
+}
+
+CommandStatusIdType CommandExecNonceClear(char *OutMessage) {
+    NonceMemClear();
+    return COMMAND_INFO_OK_ID;
+}
 #endif
 
 CommandStatusIdType CommandGetTimeout(char *OutParam) {
@@ -655,6 +749,7 @@ CommandStatusIdType CommandExecAutocalibrate(char *OutMessage) {
 
         Reader14443CurrentCommand = Reader14443_Autocalibrate;
         Reader14443AAppInit();
+        CodecCalibrateStart();
         Reader14443ACodecStart();
         CommandLinePendingTaskTimeout = &Reader14443AAppTimeout;
         return TIMEOUT_COMMAND;
@@ -666,13 +761,31 @@ CommandStatusIdType CommandExecAutocalibrate(char *OutMessage) {
 
         Sniff14443CurrentCommand = Sniff14443_Autocalibrate;
         Sniff14443AAppInit();
+        CodecCalibrateStart();
         CommandLinePendingTaskTimeout = &Sniff14443AAppTimeout;
         return TIMEOUT_COMMAND;
     }
+#endif
+#ifdef CONFIG_ISO15693_SNIFF_SUPPORT
+    if (GlobalSettings.ActiveSettingPtr->Configuration == CONFIG_ISO15693_SNIFF) {
+        ApplicationReset();
+
+        Sniff15693CurrentCommand = Sniff15693_Autocalibrate;
+        Sniff15693AppInit();
+        CodecCalibrateStart();
+        CommandLinePendingTaskTimeout = &Sniff15693AppTimeout;
+        return TIMEOUT_COMMAND;
+    }
 #endif
     return COMMAND_ERR_INVALID_USAGE_ID;
 }
 
+CommandStatusIdType CommandGetAutocalibrate(char *OutParam) {
+    if (CodecCalibrateHistogram(OutParam, TERMINAL_BUFFER_SIZE) == 0)
+        return COMMAND_INFO_OK_ID; // no calibration has been run yet
+    return COMMAND_INFO_OK_WITH_TEXT_ID;
+}
+
 #ifdef CONFIG_ISO14443A_READER_SUPPORT
 CommandStatusIdType CommandExecClone(char *OutMessage) {
     ConfigurationSetById(CONFIG_ISO14443A_READER);
@@ -835,3 +948,81 @@ CommandStatusIdType CommandGetSakMode(char *OutMessage) {
     OutMessage[1] = '\0';
     return COMMAND_INFO_OK_WITH_TEXT_ID;
 }
+
+#ifdef SUPPORT_CRYPTO_BENCHMARK
+#define CRYPTO_BENCH_TIMER  CODEC_READER_TIMER
+
+typedef enum {
+    CRYPTO_BENCH_2KTDEA_ENC,
+    CRYPTO_BENCH_3KTDEA_ENC,
+    CRYPTO_BENCH_AES_ENC,
+    CRYPTO_BENCH_AES_DEC
+} CryptoBenchType;
+
+/* Clock cycles for one CBC block, including the call overhead */
+static uint16_t CryptoBenchRun(CryptoBenchType Type, const uint8_t *Keys, const CryptoAESContextType *Context) {
+    uint8_t Block[CRYPTO_AES_BLOCK_SIZE] = { 0 };
+    uint8_t IV[CRYPTO_AES_BLOCK_SIZE] = { 0 };
+    uint16_t Cycles;
+
+    uint8_t SREGSave = SREG;
+    cli();
+
+    CRYPTO_BENCH_TIMER.CNT = 0;
+    CRYPTO_BENCH_TIMER.CTRLA = TC_CLKSEL_DIV1_gc;
+
+    switch (Type) {
+        case CRYPTO_BENCH_2KTDEA_ENC:
+            CryptoEncrypt2KTDEA_CBCSend(1, Block, Block, IV, Keys);
+            break;
+        case CRYPTO_BENCH_3KTDEA_ENC:
+            CryptoEncrypt3KTDEA_CBCSend(1, Block, Block, IV, Keys);
+            break;
+        case CRYPTO_BENCH_AES_ENC:
+            CryptoAESEncrypt_CBCSend(1, Block, Block, IV, Context);
+            break;
+        case CRYPTO_BENCH_AES_DEC:
+            CryptoAESDecrypt_CBCReceive(1, Block, Block, IV, Context);
+            break;
+    }
+
+    CRYPTO_BENCH_TIMER.CTRLA = TC_CLKSEL_OFF_gc;
+    Cycles = CRYPTO_BENCH_TIMER.CNT;
+
+    SREG = SREGSave;
+    return Cycles;
+}
+
+CommandStatusIdType CommandGetCryptoBench(char *OutParam) {
+    /* The timer generates the reader field otherwise */
+    if (CodecGetReaderField())
+        return COMMAND_ERR_INVALID_USAGE_ID;
+
+    uint8_t Keys[CRYPTO_3KTDEA_KEY_SIZE];
+    CryptoAESContextType Context;
+    uint8_t CtrlBSave = CRYPTO_BENCH_TIMER.CTRLB;
+    uint16_t PerSave = CRYPTO_BENCH_TIMER.PER;
+
+    RandomGetBuffer(Keys, sizeof(Keys));
+    CryptoAESInitContext(&Context, Keys);
+
+    CRYPTO_BENCH_TIMER.CTRLB = TC_WGMODE_NORMAL_gc;
+    CRYPTO_BENCH_TIMER.PER = 0xFFFF;
+
+    uint16_t Cycles2KTDEA = CryptoBenchRun(CRYPTO_BENCH_2KTDEA_ENC, Keys, &Context);
+    uint16_t Cycles3KTDEA = CryptoBenchRun(CRYPTO_BENCH_3KTDEA_ENC, Keys, &Context);
+    uint16_t CyclesAESEnc = CryptoBenchRun(CRYPTO_BENCH_AES_ENC, Keys, &Context);
+    uint16_t CyclesAESDec = CryptoBenchRun(CRYPTO_BENCH_AES_DEC, Keys, &Context);
+
+    CRYPTO_BENCH_TIMER.CTRLB = CtrlBSave;
+    CRYPTO_BENCH_TIMER.PER = PerSave;
+    CRYPTO_BENCH_TIMER.CNT = 0;
+
+    snprintf_P(OutParam, TERMINAL_BUFFER_SIZE,
+               PSTR("2KTDEA-CBC:%u/%ub 3KTDEA-CBC:%u/%ub AES128-CBC-ENC:%u/%ub AES128-CBC-DEC:%u/%ub"),
+               Cycles2KTDEA, CRYPTO_DES_BLOCK_SIZE, Cycles3KTDEA, CRYPTO_DES_BLOCK_SIZE,
+               CyclesAESEnc, CRYPTO_AES_BLOCK_SIZE, CyclesAESDec, CRYPTO_AES_BLOCK_SIZE);
+
+    return COMMAND_INFO_OK_WITH_TEXT_ID;
+}
+#endif
@@ -84,6 +84,9 @@ CommandStatusIdType CommandExecUpload(char *OutMessage);
 #define COMMAND_DOWNLOAD    "DOWNLOAD"
 CommandStatusIdType CommandExecDownload(char *OutMessage);
 
+#define COMMAND_NDEFUPDATE  "NDEFUPDATE"
+CommandStatusIdType CommandExecNdefUpdate(char *OutMessage);
+
 #define COMMAND_RESET       "RESET"
 CommandStatusIdType CommandExecReset(char *OutMessage);
 
@@ -180,6 +183,21 @@ CommandStatusIdType CommandExecCloneMFU(char *OutMessage);
 #define COMMAND_IDENTIFY_CARD	"IDENTIFY"
 CommandStatusIdType CommandExecIdentifyCard(char *OutMessage);
 
+#define COMMAND_INVENTORY	"INVENTORY"
+CommandStatusIdType CommandExecInventory(char *OutMessage);
+
+#define COMMAND_NESTED		"NESTED"
+CommandStatusIdType CommandExecParamNested(char *OutMessage, const char *InParams);
+
+#define COMMAND_NONCEMEM	"NONCEMEM"
+CommandStatusIdType CommandGetNonceMem(char *OutParam);
+
+#define COMMAND_NONCEDOWNLOAD	"NONCEDOWNLOAD"
+CommandStatusIdType CommandExecNonceDownload(char *OutMessage);
+
+#define COMMAND_NONCECLEAR	"NONCECLEAR"
+CommandStatusIdType CommandExecNonceClear(char *OutMessage);
+
 #define COMMAND_TIMEOUT		"TIMEOUT"
 CommandStatusIdType	CommandGetTimeout(char *OutMessage);
 CommandStatusIdType	CommandSetTimeout(char *OutMessage, const char *InParam);
@@ -190,6 +208,7 @@ CommandStatusIdType CommandSetThreshold(char *OutMessage, const char *InParam);
 
 #define COMMAND_AUTOCALIBRATE   "AUTOCALIBRATE"
 CommandStatusIdType CommandExecAutocalibrate(char *OutMessage);
+CommandStatusIdType CommandGetAutocalibrate(char *OutParam);
 
 #define COMMAND_FIELD	"FIELD"
 CommandStatusIdType CommandSetField(char *OutMessage, const char *InParam);
@@ -218,6 +237,11 @@ CommandStatusIdType CommandSetBaudrate(char *OutMessage, const char *InParam);
 CommandStatusIdType CommandGetLedMode(char *OutMessage);
 CommandStatusIdType CommandSetLedMode(char *OutMessage, const char *InParam);
 
+#ifdef SUPPORT_CRYPTO_BENCHMARK
+#define COMMAND_CRYPTOBENCH "CRYPTOBENCH"
+CommandStatusIdType CommandGetCryptoBench(char *OutParam);
+#endif
+
 #define COMMAND_LIST_END    ""
 /* Defines the end of command list. This is no actual command */
 
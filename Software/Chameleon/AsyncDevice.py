@@ -0,0 +1,505 @@
+#!/usr/bin/python3
+#
+# asyncio based access to the Chameleon. A reader task owns the serial port and
+# demultiplexes everything the Chameleon sends:
+#   - status lines and the response text following them go to the command that is waiting for them
+#   - after a WAITING FOR XMODEM status, the raw bytes go to the XModem transfer
+#   - in LIVE log mode, the log entries go to the live log queue, one complete entry at a time
+# Chameleon.Device wraps this class into the blocking API.
+
+import asyncio
+import collections
+import queue
+import re
+import time
+import serial
+import serial.tools.list_ports
+import Chameleon
+from Chameleon.XModem import XModem
+
+class DeviceProtocol:
+    COMMAND_VERSION = "VERSION"
+    COMMAND_UPLOAD = "UPLOAD"
+    COMMAND_DOWNLOAD = "DOWNLOAD"
+    COMMAND_NDEF_UPDATE = "NDEFUPDATE"
+    COMMAND_SETTING = "SETTING"
+    COMMAND_UID = "UID"
+    COMMAND_GETUID = "GETUID"
+    COMMAND_IDENTIFY = "IDENTIFY"
+    COMMAND_INVENTORY = "INVENTORY"
+    COMMAND_DUMPMFU = "DUMP_MFU"
+    COMMAND_CONFIG = "CONFIG"
+    COMMAND_LOG_DOWNLOAD = "LOGDOWNLOAD"
+    COMMAND_LOG_CLEAR = "LOGCLEAR"
+    COMMAND_LOGMODE = "LOGMODE"
+    COMMAND_NONCE_DOWNLOAD = "NONCEDOWNLOAD"
+    COMMAND_NONCE_CLEAR = "NONCECLEAR"
+    COMMAND_LBUTTON = "LBUTTON"
+    COMMAND_LBUTTONLONG = "LBUTTON_LONG"
+    COMMAND_RBUTTON = "RBUTTON"
+    COMMAND_RBUTTONLONG = "RBUTTON_LONG"
+    COMMAND_GREEN_LED = "LEDGREEN"
+    COMMAND_RED_LED = "LEDRED"
+    COMMAND_THRESHOLD = "THRESHOLD"
+    COMMAND_UPGRADE = "upgrade"
+    COMMAND_CLEAR = "CLEAR"
+
+    STATUS_CODE_OK = 100
+    STATUS_CODE_OK_WITH_TEXT = 101
+    STATUS_CODE_WAITING_FOR_XMODEM = 110
+    STATUS_CODE_FALSE = 120
+    STATUS_CODE_TRUE = 121
+    STATUS_CODE_UNKNOWN_COMMAND = 200
+    STATUS_CODE_UNKNOWN_COMMAND_USAGE = 201
+    STATUS_CODE_INVALID_PARAMETER = 202
+
+    STATUS_CODES_SUCCESS = [
+        STATUS_CODE_OK,
+        STATUS_CODE_OK_WITH_TEXT,
+        STATUS_CODE_WAITING_FOR_XMODEM,
+        STATUS_CODE_FALSE,
+        STATUS_CODE_TRUE
+    ]
+
+    STATUS_CODES_FAILURE = [
+        STATUS_CODE_UNKNOWN_COMMAND,
+        STATUS_CODE_UNKNOWN_COMMAND_USAGE,
+        STATUS_CODE_INVALID_PARAMETER
+    ]
+
+    LINE_ENDING = "\r"
+    SUGGEST_CHAR = "?"
+    SET_CHAR = "="
+    GET_CHAR = "?"
+
+    LOGMODE_LIVE = "LIVE"
+
+    # Timeouts in seconds
+    RESPONSE_TIMEOUT = 5.0
+    POLL_INTERVAL = 0.05
+
+    TRACE_SIZE = 1000
+
+    def listDevices():
+        devices = []
+
+        for port in serial.tools.list_ports.grep("({0:04x}:{1:04x})|({0:04X}:{1:04X})".format(Chameleon.USB_VID, Chameleon.USB_PID)):
+            devices.append(port[0])
+
+        return devices
+
+class XModemStream:
+    """Serial port look-alike for the blocking XModem class, reading the bytes the reader task sets aside"""
+
+    def __init__(self, device):
+        self.device = device
+        self.pending = bytearray()
+
+    def read(self, size=1):
+        while (len(self.pending) < size):
+            try:
+                self.pending += self.device.xmodemBytes.get(timeout=self.device.RESPONSE_TIMEOUT)
+            except queue.Empty:
+                break
+        data = bytes(self.pending[:size])
+        del self.pending[:size]
+        return data
+
+    def write(self, data):
+        return self.device.serial.write(data)
+
+class AsyncDevice(DeviceProtocol):
+    STATUS_PATTERN = re.compile(r'(\d{3}):(.*)$')
+
+    def __init__(self, verboseFunc = None):
+        self.verboseFunc = verboseFunc
+        self.serial = serial.Serial(None, 9600, timeout=self.POLL_INTERVAL)
+        self.versionString = ""
+        self.supportedConfs = []
+
+        # Per command latency, see latencyTrace()
+        self.trace = collections.deque(maxlen=self.TRACE_SIZE)
+
+        self.lines = None
+        self.liveLog = None
+        self.xmodemBytes = queue.Queue()
+        self.commandLock = None
+        self.readerTask = None
+
+        # Demultiplexer state, only touched by the reader task
+        self.buffer = bytearray()
+        self.pendingCommand = None
+        self.textLines = 0
+        self.responseLine = 0
+        self.xmodemActive = False
+        self.liveEnabled = False
+
+    def verboseLog(self, text):
+        if (self.verboseFunc):
+            self.verboseFunc(text)
+
+    async def connect(self, comport):
+        self.serial.port = comport
+        try:
+            self.serial.open()
+        except:
+            pass
+
+        if (self.serial.isOpen()):
+            # Send escape key to force clearing the Chameleon's input buffer
+            self.serial.write(b"\x1B")
+            self.verboseLog("Opening serial port {} succeeded".format(comport))
+        else:
+            self.verboseLog("Opening serial port {} failed".format(comport))
+            return False
+
+        self.lines = asyncio.Queue()
+        self.liveLog = asyncio.Queue()
+        self.commandLock = asyncio.Lock()
+        self.readerTask = asyncio.get_running_loop().create_task(self.readLoop())
+
+        # Try to retrieve chameleons version information and supported confs
+        result = await self.getSetCmd(self.COMMAND_VERSION)
+
+        if (result is not None):
+            if (result['statusCode'] == self.STATUS_CODE_OK_WITH_TEXT):
+                self.versionString = result['response']
+            else:
+                return False
+
+            result = await self.getCmdSuggestions(self.COMMAND_CONFIG)
+
+            if (result['statusCode'] == self.STATUS_CODE_OK_WITH_TEXT):
+                self.supportedConfs = result['response'].split(",")
+            else:
+                return False
+
+            # Learn whether live log entries are to be expected
+            await self.cmdLogMode()
+        else:
+            return False
+
+        return True
+
+    async def disconnect(self):
+        self.verboseLog("Closing serial port")
+        if (self.readerTask is not None):
+            self.readerTask.cancel()
+            try:
+                await self.readerTask
+            except asyncio.CancelledError:
+                pass
+            self.readerTask = None
+        self.serial.close()
+
+    def isConnected(self):
+        return self.serial.isOpen()
+
+    def readChunk(self):
+        # Blocks for at most POLL_INTERVAL, runs in the executor
+        return self.serial.read(max(1, self.serial.in_waiting))
+
+    async def readLoop(self):
+        loop = asyncio.get_running_loop()
+
+        while (self.serial.isOpen()):
+            data = await loop.run_in_executor(None, self.readChunk)
+            if (len(data) > 0):
+                self.demux(data)
+
+    def demux(self, data):
+        self.buffer += data
+
+        while (len(self.buffer) > 0):
+            if (self.xmodemActive):
+                self.xmodemBytes.put(bytes(self.buffer))
+                self.buffer.clear()
+                break
+
+            first = self.buffer[0]
+            if (self.liveEnabled and self.textLines == 0 and not (0x30 <= first <= 0x39)):
+                # Status lines start with a digit, no log event type does
+                size = 4 + self.buffer[1] if len(self.buffer) >= 2 else 4
+                if (len(self.buffer) < size):
+                    break
+                self.liveLog.put_nowait(bytes(self.buffer[:size]))
+                del self.buffer[:size]
+                continue
+
+            end = self.buffer.find(b'\n')
+            if (end < 0):
+                break
+            line = self.buffer[:end + 1].decode('ascii', 'replace').rstrip()
+            del self.buffer[:end + 1]
+
+            if (self.textLines > 0):
+                self.textLines -= 1
+                self.textReceived(line)
+            else:
+                self.statusReceived(line)
+            self.lines.put_nowait(line)
+
+    def statusReceived(self, line):
+        match = self.STATUS_PATTERN.search(line)
+        if (match is None):
+            return
+
+        statusCode = int(match.group(1))
+        if (statusCode == self.STATUS_CODE_OK_WITH_TEXT):
+            self.textLines = 1
+            self.responseLine = 0
+        elif (statusCode == self.STATUS_CODE_WAITING_FOR_XMODEM):
+            # Everything from here on belongs to the transfer
+            self.xmodemActive = True
+        elif (statusCode in self.STATUS_CODES_SUCCESS and self.pendingCommand is not None):
+            # Switch before the first live entry gets here
+            if (self.pendingCommand.startswith(self.COMMAND_LOGMODE + self.SET_CHAR)):
+                self.liveEnabled = self.pendingCommand.upper().endswith(self.SET_CHAR + self.LOGMODE_LIVE)
+
+    def textReceived(self, line):
+        if (self.responseLine == 0):
+            if (self.pendingCommand == self.COMMAND_INVENTORY):
+                # First line holds the card count, followed by one line per card
+                try:
+                    self.textLines = int(line.split(" ")[0])
+                except ValueError:
+                    pass
+            elif (self.pendingCommand == self.COMMAND_LOGMODE + self.GET_CHAR):
+                self.liveEnabled = (line.upper() == self.LOGMODE_LIVE)
+        self.responseLine += 1
+
+    async def readLine(self):
+        try:
+            return await asyncio.wait_for(self.lines.get(), self.RESPONSE_TIMEOUT)
+        except asyncio.TimeoutError:
+            return None
+
+    async def writeCmd(self, cmd):
+        async with self.commandLock:
+            return await self.writeCmdLocked(cmd)
+
+    async def writeCmdLocked(self, cmd):
+        # Forget about lines nobody waited for
+        while (not self.lines.empty()):
+            self.lines.get_nowait()
+
+        # Execute command
+        self.pendingCommand = cmd
+        startTime = time.perf_counter()
+        cmdLine = cmd + self.LINE_ENDING
+        self.serial.write(cmdLine.encode('ascii'))
+
+        # Get status response, skipping anything that is not one
+        while True:
+            status = await self.readLine()
+            if (status is None or self.STATUS_PATTERN.search(status) is not None):
+                break
+            self.verboseLog("Skipping <{}>".format(status))
+
+        statusTime = time.perf_counter()
+
+        if (status is None):
+            self.verboseLog("Executing <{}>: Timeout".format(cmd))
+            self.trace.append({'command': cmd, 'statusCode': None, 'latency': None, 'total': None})
+            return None
+
+        match = self.STATUS_PATTERN.search(status)
+        statusCode = int(match.group(1))
+        statusText = match.group(2)
+
+        result = {'statusCode': statusCode, 'statusText': statusText, 'response': None}
+
+        if (statusCode == self.STATUS_CODE_OK_WITH_TEXT):
+            result['response'] = await self.readResponse()
+        elif (statusCode == self.STATUS_CODE_TRUE):
+            result['response'] = True
+        elif (statusCode == self.STATUS_CODE_FALSE):
+            result['response'] = False
+
+        endTime = time.perf_counter()
+        self.trace.append({'command': cmd, 'statusCode': statusCode,
+                           'latency': (statusTime - startTime) * 1000, 'total': (endTime - startTime) * 1000})
+        self.verboseLog("Executing <{}>: {} ({:.1f} ms)".format(cmd, status, (endTime - startTime) * 1000))
+
+        return result
+
+    async def readResponse(self):
+        # Read response to command, if any
+        response = await self.readLine() or ""
+        self.verboseLog("Response: {}".format(response))
+        return response
+
+    def latencyTrace(self):
+        """Latency of the last commands in ms: until the status line and until the whole response"""
+        return list(self.trace)
+
+    async def read(self, size=1024, timeout=0.01):
+        """Live log entries received so far, waits up to timeout for the first one"""
+        data = b''
+        try:
+            data = await asyncio.wait_for(self.liveLog.get(), timeout)
+        except asyncio.TimeoutError:
+            return data
+
+        while (len(data) < size and not self.liveLog.empty()):
+            data += self.liveLog.get_nowait()
+        return data
+
+    async def liveLogEntries(self):
+        """Live log entries as they arrive"""
+        while True:
+            yield await self.liveLog.get()
+
+    async def xmodemTransfer(self, cmd, dataStream, send):
+        # No other command may interrupt the transfer
+        async with self.commandLock:
+            result = await self.writeCmdLocked(cmd)
+            if (result is None or result['statusCode'] != self.STATUS_CODE_WAITING_FOR_XMODEM):
+                return None
+
+            # XMODEM started, the blocking implementation runs in the executor
+            xmodem = XModem(XModemStream(self), self.verboseFunc)
+            transfer = xmodem.sendData if send else xmodem.recvData
+            startTime = time.perf_counter()
+            try:
+                byteCount = await asyncio.get_running_loop().run_in_executor(None, transfer, dataStream)
+            finally:
+                self.xmodemActive = False
+                while (not self.xmodemBytes.empty()):
+                    self.xmodemBytes.get_nowait()
+            self.trace.append({'command': cmd + " XMODEM", 'statusCode': None,
+                               'latency': None, 'total': (time.perf_counter() - startTime) * 1000})
+            return byteCount
+
+    async def execCmd(self, cmd, args=None):
+        if (args is None):
+            return await self.writeCmd("{}".format(cmd))
+        else:
+            return await self.writeCmd("{} {}".format(cmd, args))
+
+    async def getSetCmd(self, cmd, arg=None):
+        # Determine if set or get mode
+        if (arg is None):
+            return await self.writeCmd("{}{}".format(cmd, self.GET_CHAR))
+        else:
+            return await self.writeCmd("{}{}{}".format(cmd, self.SET_CHAR, arg))
+
+    async def returnCmd(self, cmd, arg=None):
+        return await self.writeCmd("{}".format(cmd))
+
+    async def getCmdSuggestions(self, cmd):
+        result = await self.getSetCmd(cmd, self.SUGGEST_CHAR)
+        if (result['response'] is not None):
+            result['suggestions'] = result['response'].split(",")
+
+        return result
+
+    async def cmdUploadDump(self, dataStream):
+        return await self.xmodemTransfer(self.COMMAND_UPLOAD, dataStream, True)
+
+    async def cmdDownloadDump(self, dataStream):
+        return await self.xmodemTransfer(self.COMMAND_DOWNLOAD, dataStream, False)
+
+    async def cmdNdefUpdate(self, dataStream):
+        return await self.xmodemTransfer(self.COMMAND_NDEF_UPDATE, dataStream, True)
+
+    async def cmdDownloadLog(self, dataStream):
+        return await self.xmodemTransfer(self.COMMAND_LOG_DOWNLOAD, dataStream, False)
+
+    async def cmdClearLog(self):
+        return await self.execCmd(self.COMMAND_LOG_CLEAR)
+
+    async def cmdDownloadNonces(self, dataStream):
+        return await self.xmodemTransfer(self.COMMAND_NONCE_DOWNLOAD, dataStream, False)
+
+    async def cmdClearNonces(self):
+        return await self.execCmd(self.COMMAND_NONCE_CLEAR)
+
+    async def cmdClear(self):
+        return await self.execCmd(self.COMMAND_CLEAR)
+
+    async def cmdLogMode(self, newLogMode = None):
+        return await self.getSetCmd(self.COMMAND_LOGMODE, newLogMode)
+
+    async def cmdVersion(self):
+        return await self.getSetCmd(self.COMMAND_VERSION)
+
+    async def cmdSetting(self, newSetting = None):
+        return await self.getSetCmd(self.COMMAND_SETTING, newSetting)
+
+    async def cmdUID(self, newUID = None):
+        return await self.getSetCmd(self.COMMAND_UID, newUID)
+
+    async def cmdGetUID(self):
+        return await self.returnCmd(self.COMMAND_GETUID)
+
+    async def cmdIdentify(self):
+        return await self.returnCmd(self.COMMAND_IDENTIFY)
+
+    async def cmdInventory(self):
+        # The card lines belong to the response, no other command may run before they are read
+        async with self.commandLock:
+            result = await self.writeCmdLocked(self.COMMAND_INVENTORY)
+            if (result is not None and result['statusCode'] == self.STATUS_CODE_OK_WITH_TEXT):
+                # First line holds the card count, followed by one line per card
+                cardCount = int(result['response'].split(" ")[0])
+                result['cards'] = [await self.readResponse() for i in range(cardCount)]
+
+        return result
+
+    async def cmdDumpMFU(self):
+        return await self.returnCmd(self.COMMAND_DUMPMFU)
+
+    async def cmdConfig(self, newConfig = None):
+        if (newConfig == self.SUGGEST_CHAR):
+            return await self.getCmdSuggestions(self.COMMAND_CONFIG)
+        else:
+            return await self.getSetCmd(self.COMMAND_CONFIG, newConfig)
+
+    async def cmdLButton(self, newAction = None):
+        if (newAction == self.SUGGEST_CHAR):
+            return await self.getCmdSuggestions(self.COMMAND_LBUTTON)
+        else:
+            return await self.getSetCmd(self.COMMAND_LBUTTON, newAction)
+
+    async def cmdLButtonLong(self, newAction = None):
+        if (newAction == self.SUGGEST_CHAR):
+            return await self.getCmdSuggestions(self.COMMAND_LBUTTONLONG)
+        else:
+            return await self.getSetCmd(self.COMMAND_LBUTTONLONG, newAction)
+
+    async def cmdRButton(self, newAction = None):
+        if (newAction == self.SUGGEST_CHAR):
+            return await self.getCmdSuggestions(self.COMMAND_RBUTTON)
+        else:
+            return await self.getSetCmd(self.COMMAND_RBUTTON, newAction)
+
+    async def cmdRButtonLong(self, newAction = None):
+        if (newAction == self.SUGGEST_CHAR):
+            return await self.getCmdSuggestions(self.COMMAND_RBUTTONLONG)
+        else:
+            return await self.getSetCmd(self.COMMAND_RBUTTONLONG, newAction)
+
+    async def cmdGreenLED(self, newFunction = None):
+        if (newFunction == self.SUGGEST_CHAR):
+            return await self.getCmdSuggestions(self.COMMAND_GREEN_LED)
+        else:
+            return await self.getSetCmd(self.COMMAND_GREEN_LED, newFunction)
+
+    async def cmdRedLED(self, newFunction = None):
+        if (newFunction == self.SUGGEST_CHAR):
+            return await self.getCmdSuggestions(self.COMMAND_RED_LED)
+        else:
+            return await self.getSetCmd(self.COMMAND_RED_LED, newFunction)
+
+    async def cmdThreshold(self, value):
+        if(value == self.SUGGEST_CHAR):
+            return await self.getCmdSuggestions(self.COMMAND_THRESHOLD)
+        else:
+            return await self.getSetCmd(self.COMMAND_THRESHOLD, value)
+
+    async def cmdUpgrade(self):
+        # Execute command, the Chameleon does not answer anymore
+        cmdLine = self.COMMAND_UPGRADE + self.LINE_ENDING
+        self.serial.write(cmdLine.encode('ascii'))
+        return 0
@@ -0,0 +1,217 @@
+#!/usr/bin/python
+#
+# Indexed capture files: the raw binary log plus a sidecar index, so large
+# logs can be filtered by time range and event type without a linear parse.
+#
+# Layout, all integers little endian, every section aligned to 8 bytes:
+#   header    magic, version, entry count, event types count, session count, section offsets
+#   log       raw log as downloaded from the Chameleon
+#   offsets   uint32 per entry, start of the entry header within the log
+#   times     uint64 per entry, absolute ms since the start of the capture
+#   events    uint8 per entry, event type
+#   types     uint8 per event type present, in the same order as the bitmaps
+#   bitmaps   one bitmap per event type present, bit n is set if entry n is of that type
+#   sessions  uint32 per session, index of its first entry. A session starts at every BOOT entry.
+
+import array
+import bisect
+import mmap
+import struct
+import sys
+import Chameleon.LogParser as LogParser
+
+CAPTURE_MAGIC = b'CHAMCAP\0'
+CAPTURE_VERSION = 1
+CAPTURE_EXTENSION = '.chc'
+
+# magic, version, entryCount, typeCount, sessionCount, log, offsets, times, events, types, bitmaps, sessions, logSize
+HEADER_FORMAT = '<8sHHIII8Q'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+
+LOG_EVENT_BOOT = 0xFF
+TIMESTAMP_MAX = 65536
+
+def align(size):
+    return (size + 7) & ~7
+
+def absoluteTimes(timestamps, events):
+    """Unwrap the 16 bit ms timestamps. The systick restarts from 0 on every BOOT entry."""
+    times = array.array('Q')
+    elapsedMs = 0
+    lastTimestamp = 0
+
+    for timestamp, event in zip(timestamps, events):
+        if (event == LOG_EVENT_BOOT):
+            lastTimestamp = 0
+        elapsedMs += (timestamp - lastTimestamp) % TIMESTAMP_MAX
+        lastTimestamp = timestamp
+        times.append(elapsedMs)
+
+    return times
+
+def buildIndex(log):
+    """Index sections for a raw log, returned as bytes in file layout"""
+    columns = LogParser.parseColumns(log)
+    count = columns['count']
+    events = columns['event']
+
+    offsets = array.array('I', (offset - LogParser.LOG_HEADER_SIZE for offset in columns['offset']))
+    times = absoluteTimes(columns['timestamp'], events)
+
+    types = sorted(set(events))
+    bitmapSize = (count + 7) // 8
+    bitmaps = bytearray(len(types) * bitmapSize)
+    typeIndex = { eventType: i * bitmapSize for i, eventType in enumerate(types) }
+    for n, event in enumerate(events):
+        bitmaps[typeIndex[event] + (n >> 3)] |= 1 << (n & 7)
+
+    sessions = array.array('I', [0] if count > 0 and events[0] != LOG_EVENT_BOOT else [])
+    sessions.extend(n for n, event in enumerate(events) if event == LOG_EVENT_BOOT)
+
+    if (sys.byteorder != 'little'):
+        for column in (offsets, times, sessions):
+            column.byteswap()
+
+    return {
+        'count': count,
+        'size': columns['size'],
+        'offsets': offsets.tobytes(),
+        'times': times.tobytes(),
+        'events': bytes(events),
+        'types': bytes(types),
+        'bitmaps': bytes(bitmaps),
+        'sessions': sessions.tobytes(),
+    }
+
+def write(fileHandle, log):
+    """Write log as indexed capture, returns the number of entries"""
+    index = buildIndex(log)
+    sections = [('log', log[:index['size']])] + \
+               [(name, index[name]) for name in ('offsets', 'times', 'events', 'types', 'bitmaps', 'sessions')]
+
+    position = align(HEADER_SIZE)
+    offsets = []
+    for name, data in sections:
+        offsets.append(position)
+        position = align(position + len(data))
+
+    fileHandle.write(struct.pack(HEADER_FORMAT, CAPTURE_MAGIC, CAPTURE_VERSION, 0, index['count'],
+                                 len(index['types']), len(index['sessions']) // 4, *offsets, index['size']))
+
+    for (name, data), offset in zip(sections, offsets):
+        fileHandle.write(b'\0' * (offset - fileHandle.tell()))
+        fileHandle.write(data)
+
+    return index['count']
+
+def isCapture(fileHandle):
+    magic = fileHandle.read(len(CAPTURE_MAGIC))
+    fileHandle.seek(0)
+    return magic == CAPTURE_MAGIC
+
+class LogReader:
+    """Minimal reader over the mapped log, without copying it as a whole"""
+
+    def __init__(self, log):
+        self.log = log
+        self.position = 0
+
+    def read(self, size=-1):
+        end = len(self.log) if size < 0 else self.position + size
+        data = bytes(self.log[self.position:end])
+        self.position += len(data)
+        return data
+
+class Capture:
+    """Random access to a capture file, which is memory mapped. A raw log is indexed in memory instead."""
+
+    def __init__(self, fileHandle):
+        if (isCapture(fileHandle)):
+            self.buffer = memoryview(mmap.mmap(fileHandle.fileno(), 0, access=mmap.ACCESS_READ))
+            self.loadIndex()
+        else:
+            self.buffer = memoryview(fileHandle.read())
+            self.indexLog()
+
+    def loadIndex(self):
+        (magic, version, _, self.count, typeCount, sessionCount,
+         logOffset, offsetsOffset, timesOffset, eventsOffset, typesOffset, bitmapsOffset, sessionsOffset,
+         logSize) = struct.unpack_from(HEADER_FORMAT, self.buffer)
+
+        if (version != CAPTURE_VERSION):
+            raise ValueError("Unsupported capture version {}".format(version))
+
+        bitmapSize = (self.count + 7) // 8
+        self.log = self.buffer[logOffset:logOffset + logSize]
+        self.offsets = self.column(offsetsOffset, self.count, 'I')
+        self.times = self.column(timesOffset, self.count, 'Q')
+        self.events = self.buffer[eventsOffset:eventsOffset + self.count]
+        self.sessions = self.column(sessionsOffset, sessionCount, 'I')
+        self.bitmaps = { eventType: self.buffer[bitmapsOffset + i * bitmapSize:bitmapsOffset + (i + 1) * bitmapSize]
+                         for i, eventType in enumerate(self.buffer[typesOffset:typesOffset + typeCount]) }
+
+    def indexLog(self):
+        index = buildIndex(self.buffer)
+        self.count = index['count']
+        bitmapSize = (self.count + 7) // 8
+        self.log = self.buffer[:index['size']]
+        self.offsets = self.column(0, self.count, 'I', index['offsets'])
+        self.times = self.column(0, self.count, 'Q', index['times'])
+        self.events = memoryview(index['events'])
+        self.sessions = self.column(0, len(index['sessions']) // 4, 'I', index['sessions'])
+        self.bitmaps = { eventType: index['bitmaps'][i * bitmapSize:(i + 1) * bitmapSize]
+                         for i, eventType in enumerate(index['types']) }
+
+    def column(self, offset, count, typecode, buffer=None):
+        data = (self.buffer if buffer is None else memoryview(buffer))[offset:offset + count * array.array(typecode).itemsize]
+        if (sys.byteorder == 'little'):
+            # Straight into the mapped file, nothing is copied
+            return data.cast(typecode)
+        column = array.array(typecode)
+        column.frombytes(data)
+        column.byteswap()
+        return column
+
+    def entryRange(self, startMs=None, endMs=None):
+        """Indices of the entries with startMs <= time < endMs"""
+        first = 0 if startMs is None else bisect.bisect_left(self.times, startMs)
+        last = self.count if endMs is None else bisect.bisect_left(self.times, endMs)
+        return range(first, max(first, last))
+
+    def select(self, startMs=None, endMs=None, eventTypes=None):
+        """Indices of the entries in the time range having one of the event types"""
+        entries = self.entryRange(startMs, endMs)
+
+        if (eventTypes is None):
+            return list(entries)
+
+        # Walk the bitmaps of the requested types, a byte at a time
+        selected = []
+        first = entries.start >> 3
+        last = (entries.stop + 7) >> 3
+        bitmaps = [self.bitmaps[eventType] for eventType in eventTypes if eventType in self.bitmaps]
+        for byteIndex in range(first, last):
+            bits = 0
+            for bitmap in bitmaps:
+                bits |= bitmap[byteIndex]
+            while (bits):
+                lowest = bits & -bits
+                n = (byteIndex << 3) + lowest.bit_length() - 1
+                if (entries.start <= n < entries.stop):
+                    selected.append(n)
+                bits ^= lowest
+
+        return selected
+
+    def logStream(self):
+        """File like access to the raw log, for the streaming consumers of plain logs"""
+        return LogReader(self.log)
+
+    def entry(self, n):
+        """Raw log entry n, header included"""
+        offset = self.offsets[n]
+        return bytes(self.log[offset:offset + LogParser.LOG_HEADER_SIZE + self.log[offset + 1]])
+
+    def session(self, n):
+        """Index of the session entry n belongs to"""
+        return bisect.bisect_right(self.sessions, n) - 1
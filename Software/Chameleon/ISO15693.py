@@ -0,0 +1,155 @@
+import binascii
+
+# Timestamps of sniffed ISO15693 frames count in fc/32
+CARRIER_FREQ = 13.56e6
+TIMESTAMP_TICK_US = 32 / CARRIER_FREQ * 1e6
+TIMESTAMP_MAX = 65536
+
+# Parameters for CRC-16/ISO15693 (reflected, preset 0xFFFF, complemented)
+CRC_PRESET = 0xFFFF
+CRC_POLY = 0x8408
+
+REQ_FLAG_SUBCARRIER = 0x01
+REQ_FLAG_DATARATE = 0x02
+REQ_FLAG_INVENTORY = 0x04
+REQ_FLAG_SELECT = 0x10
+REQ_FLAG_ADDRESS = 0x20
+REQ_FLAG_OPTION = 0x40
+RES_FLAG_ERROR = 0x01
+
+CMD_INVENTORY = 0x01
+CMD_GET_SYSTEM_INFO = 0x2B
+
+Commands = {
+    0x01: "INVENTORY",
+    0x02: "STAY QUIET",
+    0x20: "READ SINGLE BLOCK",
+    0x21: "WRITE SINGLE BLOCK",
+    0x22: "LOCK BLOCK",
+    0x23: "READ MULTIPLE BLOCKS",
+    0x24: "WRITE MULTIPLE BLOCKS",
+    0x25: "SELECT",
+    0x26: "RESET TO READY",
+    0x27: "WRITE AFI",
+    0x28: "LOCK AFI",
+    0x29: "WRITE DSFID",
+    0x2A: "LOCK DSFID",
+    0x2B: "GET SYSTEM INFORMATION",
+    0x2C: "GET MULTIPLE BLOCK SECURITY STATUS",
+}
+
+Errors = {
+    0x01: "NOT SUPPORTED",
+    0x02: "NOT RECOGNIZED",
+    0x03: "OPTION NOT SUPPORTED",
+    0x0F: "UNKNOWN ERROR",
+    0x10: "BLOCK NOT AVAILABLE",
+    0x11: "BLOCK ALREADY LOCKED",
+    0x12: "BLOCK LOCKED",
+    0x13: "BLOCK NOT PROGRAMMED",
+    0x14: "BLOCK NOT LOCKED",
+}
+
+# The card response can only be interpreted knowing the request
+lastCommand = None
+
+
+def CRC(data):
+    crc = CRC_PRESET
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            if crc & 0x0001:
+                crc = (crc >> 1) ^ CRC_POLY
+            else:
+                crc >>= 1
+    return ~crc & 0xFFFF
+
+
+def CRC_check(data):
+    if len(data) < 3:
+        return False
+    crc = CRC(data[:-2])
+    return data[-2] == (crc & 0xFF) and data[-1] == (crc >> 8)
+
+
+def formatUID(data):
+    # UIDs are transmitted LSByte first
+    return binascii.hexlify(bytes(reversed(data))).decode()
+
+
+def splitTimestamp(data):
+    """Split the fc/32 frame timestamp off a sniffed frame"""
+    if len(data) < 2:
+        return (None, data)
+    return ((data[0] << 8) | data[1], data[2:])
+
+
+def timestampDelta(lastTicks, ticks, elapsedMs):
+    """Delta in us between two frame timestamps. The systick delta resolves the 16 bit wraparound."""
+    delta = (ticks - lastTicks) % TIMESTAMP_MAX
+    expected = elapsedMs * 1000 / TIMESTAMP_TICK_US
+    wraps = round((expected - delta) / TIMESTAMP_MAX)
+    if wraps > 0:
+        delta += wraps * TIMESTAMP_MAX
+    return delta * TIMESTAMP_TICK_US
+
+
+def parseReader(data):
+    global lastCommand
+    lastCommand = None
+
+    if len(data) < 2:
+        return "SHORT FRAME"
+    if not CRC_check(data):
+        return "CRC ERROR"
+
+    flags = data[0]
+    command = data[1]
+    lastCommand = command
+
+    if command in Commands:
+        text = Commands[command]
+        offset = 2
+    elif command >= 0xA0 and len(data) > 4:
+        text = "CUSTOM {:02X} (IC MFG {:02X})".format(command, data[2])
+        offset = 3
+    else:
+        text = "RFU {:02X}".format(command)
+        offset = 2
+
+    text += " HIGH RATE" if flags & REQ_FLAG_DATARATE else " LOW RATE"
+    if flags & REQ_FLAG_SUBCARRIER:
+        text += " DUAL SUBCARRIER"
+    if flags & REQ_FLAG_INVENTORY:
+        text += " 1 SLOT" if flags & 0x20 else " 16 SLOTS"
+    else:
+        if flags & REQ_FLAG_SELECT:
+            text += " SELECTED"
+        if flags & REQ_FLAG_ADDRESS and len(data) >= offset + 8 + 2:
+            text += " UID " + formatUID(data[offset:offset + 8])
+    if flags & REQ_FLAG_OPTION:
+        text += " OPTION"
+
+    return text
+
+
+def parseCard(data):
+    if len(data) < 1:
+        return ""
+    if not CRC_check(data):
+        return "CRC ERROR"
+
+    flags = data[0]
+    if flags & RES_FLAG_ERROR:
+        if len(data) < 4:
+            return "ERROR"
+        return "ERROR " + Errors.get(data[1], "{:02X}".format(data[1]))
+
+    text = "OK"
+    if lastCommand == CMD_INVENTORY and len(data) == 1 + 1 + 8 + 2:
+        text += " DSFID {:02X} UID {}".format(data[1], formatUID(data[2:10]))
+    elif lastCommand == CMD_GET_SYSTEM_INFO and len(data) >= 1 + 1 + 8 + 2:
+        text += " UID " + formatUID(data[2:10])
+
+    return text
@@ -1,42 +1,13 @@
 #!/usr/bin/python
 
-import struct
 import binascii
-import math
+import Chameleon.LogParser as LogParser
 import Chameleon.ISO14443 as iso14443_3
+import Chameleon.ISO15693 as iso15693
 
 def checkParityBit(data):
-    byteCount = len(data)
-    # Short frame, no parityBit
-    if (byteCount == 1):
-        return (True, data)
-
-    # 9 bit is a group, validate bit count is calculated below
-    bitCount = int((byteCount*8)/9) * 9
-    parsedData = bytearray(int(bitCount/9))
-
-    oneCounter = 0            # Counter for count ones in a byte
-    for i in range(0, bitCount):
-        # Get bit i in data
-        byteIndex = math.floor(i/8)
-        bitIndex = i % 8
-        bit = (data[byteIndex] >> bitIndex) & 0x01
-
-        # Check parityBit
-        # Current bit is parityBit
-        if(i % 9 == 8):
-            # Even number of ones in current byte
-            if(oneCounter % 2 and bit == 1):
-                return (False, data)
-            # Odd number of ones in current byte
-            elif((not oneCounter % 2) and bit == 0):
-                return (False, data)
-            oneCounter = 0
-        # Current bit is normal bit
-        else:
-            oneCounter += bit
-            parsedData[int(i/9)] |= bit << (i%9)
-    return (True, parsedData)
+    # 9 bit groups are validated and stripped by table lookup, see LogParser
+    return LogParser.stripParity(data)
 
 def noDecoder(data):
     return ""
@@ -47,6 +18,10 @@ def textDecoder(data):
 def binaryDecoder(data):
     return binascii.hexlify(data).decode()
 
+def timestampedDecoder(data):
+    # Skip the fc/32 timestamp of sniffed ISO15693 frames
+    return binascii.hexlify(data[2:]).decode()
+
 def binaryParityDecoder(data):
     isValid, checkedData = checkParityBit(data)
     if(isValid):
@@ -54,6 +29,11 @@ def binaryParityDecoder(data):
     else:
         return binascii.hexlify(checkedData).decode()+"!"
 
+# Sniffed ISO14443A frames, the ones with parity bits are stripped before decoding
+SNIFF_READER_EVENTS = (0x44, 0x45)
+SNIFF_CARD_EVENTS = (0x46, 0x47)
+SNIFF_PARITY_EVENTS = (0x45, 0x47)
+
 eventTypes = {
     0x00: { 'name': 'EMPTY',          'decoder': noDecoder },
     0x10: { 'name': 'GENERIC',        'decoder': textDecoder },
@@ -71,6 +51,8 @@ eventTypes = {
     0x45: { 'name': 'CODEC RX SNI READER W/PARITY', 'decoder': binaryParityDecoder },
     0x46: { 'name': 'CODEC RX SNI CARD',            'decoder': binaryDecoder },
     0x47: { 'name': 'CODEC RX SNI CARD W/PARITY',   'decoder': binaryParityDecoder },
+    0x48: { 'name': 'CODEC RX SNI READER ISO15693', 'decoder': timestampedDecoder },
+    0x49: { 'name': 'CODEC RX SNI CARD ISO15693',   'decoder': timestampedDecoder },
    
 
     0x80: { 'name': 'APP READ',       'decoder': binaryDecoder },
@@ -97,67 +79,97 @@ eventTypes = {
 TIMESTAMP_MAX = 65536
 eventTypes = { i : ({'name': 'UNKNOWN', 'decoder': binaryDecoder} if i not in eventTypes.keys() else eventTypes[i]) for i in range(256) }
 
-def parseBinary(binaryStream, decoder=None):
-    log = []
-    
-    # Completely read file contents and process them byte by byte
-    # logFile = fileHandle.read()
-    # fileIdx = 0
-    lastTimestamp = 0
-    
-    while True:
-        # Read log entry header from file
-        header = binaryStream.read(struct.calcsize('<BBH'))
-
-        if (header is None):
-            # No more data available
-            break
-
-        if (len(header) < struct.calcsize('<BBH')):
-            # No more data available
-            break
-        
-        (event, dataLength, timestamp) = struct.unpack_from('>BBH', header)
-    
-        # Break if there are no more events
-        if (eventTypes[event]['name'] == 'EMPTY'):
-            break
+class StreamDecoder:
+    """Resumable decoder for binary logs arriving in chunks, e.g. from live logging.
+    Entries straddling a chunk boundary are kept until they are complete,
+    timestamp deltas and the ISO15693 frame timing carry on across chunks."""
+
+    def __init__(self, decoder=None):
+        self.decoder = decoder
+        self.pending = b''
+        self.finished = False
+        self.lastTimestamp = 0
+        self.elapsedMs = 0
+        self.lastFrameTicks = None
+        self.lastFrameMs = 0
+
+    def feed(self, data):
+        """Decode all entries completed by data, returns them as a list of dicts"""
+        log = []
+
+        if (self.finished or data is None or len(data) == 0):
+            return log
+
+        buffer = self.pending + bytes(data)
+        columns = LogParser.parseColumns(buffer)
+
+        for i in range(columns['count']):
+            offset = columns['offset'][i]
+            log.append(self.decodeEntry(columns['event'][i], columns['timestamp'][i],
+                                        buffer[offset:offset + columns['length'][i]]))
+
+        # Keep an incomplete entry for the next chunk, an EMPTY event ends the log
+        size = columns['size']
+        if (size + LogParser.LOG_HEADER_SIZE <= len(buffer) and buffer[size] == LogParser.LOG_EVENT_EMPTY):
+            self.finished = True
+            self.pending = b''
+        else:
+            self.pending = buffer[size:]
 
-        # Read data from file
-        logData = binaryStream.read(dataLength)
+        return log
 
-        # Decode data
-        logData = eventTypes[event]['decoder'](logData)
-        
+    def decodeEntry(self, event, timestamp, rawData):
         # Calculate delta timestamp respecting 16 bit overflow
-        deltaTimestamp = timestamp - lastTimestamp;
-        lastTimestamp = timestamp
-        
-        if (deltaTimestamp < 0):
-            deltaTimestamp += TIMESTAMP_MAX;
+        deltaTimestamp = (timestamp - self.lastTimestamp) % TIMESTAMP_MAX
+        self.lastTimestamp = timestamp
+        self.elapsedMs += deltaTimestamp
 
         note = ""
-        # If we need to decode the data and paritybit check success
-        if (decoder!=None and len(logData) >0 and logData[-1] != '!'):
-            # Decode the data from Reader
-            if(event == 0x44 or event == 0x45):
-                note = iso14443_3.parseReader(binascii.a2b_hex(logData), decoder)
-            elif (event == 0x46 or event == 0x47):
-                note = iso14443_3.parseCard(binascii.a2b_hex(logData), decoder)
-
-        # Create log entry as dict and append it to event list
-        logEntry = {
+        if (event in SNIFF_READER_EVENTS or event in SNIFF_CARD_EVENTS):
+            # Keep the stripped frame around instead of decoding it back from hex
+            if (event in SNIFF_PARITY_EVENTS):
+                (isValid, frame) = LogParser.stripParity(rawData)
+            else:
+                (isValid, frame) = (True, rawData)
+
+            logData = binascii.hexlify(frame).decode()
+            if (not isValid):
+                logData += "!"
+
+            # If we need to decode the data and paritybit check success
+            if (self.decoder != None and isValid and len(frame) > 0):
+                if (event in SNIFF_READER_EVENTS):
+                    note = iso14443_3.parseReader(frame, self.decoder)
+                else:
+                    note = iso14443_3.parseCard(frame, self.decoder)
+        else:
+            logData = eventTypes[event]['decoder'](rawData)
+
+        # Sniffed ISO15693 frames carry a high resolution timestamp and are always decoded
+        if (event == 0x48 or event == 0x49):
+            (frameTicks, frameData) = iso15693.splitTimestamp(rawData)
+            if (event == 0x48):
+                note = iso15693.parseReader(frameData)
+            else:
+                note = iso15693.parseCard(frameData)
+
+            if (frameTicks is not None):
+                if (self.lastFrameTicks is not None):
+                    frameDelta = iso15693.timestampDelta(self.lastFrameTicks, frameTicks, self.elapsedMs - self.lastFrameMs)
+                    note = "[{:+.1f} us] {}".format(frameDelta, note)
+                self.lastFrameTicks = frameTicks
+                self.lastFrameMs = self.elapsedMs
+
+        # Create log entry as dict
+        return {
             'eventName': eventTypes[event]['name'],
-            'dataLength': dataLength,
+            'dataLength': len(rawData),
             'timestamp': timestamp,
             'deltaTimestamp': deltaTimestamp,
             'data': logData,
             'note': note
         }
-        
-        log.append(logEntry)
 
-    return log
-
-
-        
+def parseBinary(binaryStream, decoder=None):
+    # Completely read the stream and decode it in one go
+    return StreamDecoder(decoder).feed(binaryStream.read())
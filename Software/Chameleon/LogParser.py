@@ -0,0 +1,101 @@
+#!/usr/bin/python
+#
+# Bulk parser for binary Chameleon logs. The compiled Chameleon._logparser
+# extension is used when it has been built (see setup.py), otherwise the
+# pure Python implementation below gives the same results.
+
+import array
+
+LOG_HEADER_SIZE = 4
+LOG_EVENT_EMPTY = 0x00
+
+# Indexed by a 9 bit group (8 data bits + odd parity bit in bit 8), True if the parity is valid
+PARITY_VALID = [bin(group).count('1') % 2 == 1 for group in range(512)]
+
+def pyParse(buffer):
+    """Pure Python version of _logparser.parse"""
+    log = bytes(buffer)
+    size = len(log)
+
+    events = bytearray()
+    lengths = bytearray()
+    timestamps = array.array('H')
+    deltas = array.array('H')
+    offsets = array.array('I')
+
+    pos = 0
+    lastTimestamp = 0
+
+    while (pos + LOG_HEADER_SIZE <= size):
+        event = log[pos]
+        length = log[pos + 1]
+
+        # No more events, or the entry is cut off
+        if (event == LOG_EVENT_EMPTY or pos + LOG_HEADER_SIZE + length > size):
+            break
+
+        timestamp = (log[pos + 2] << 8) | log[pos + 3]
+
+        events.append(event)
+        lengths.append(length)
+        timestamps.append(timestamp)
+        deltas.append((timestamp - lastTimestamp) & 0xFFFF)
+        offsets.append(pos + LOG_HEADER_SIZE)
+        lastTimestamp = timestamp
+
+        pos += LOG_HEADER_SIZE + length
+
+    return (len(events), pos, bytes(events), bytes(lengths),
+            timestamps.tobytes(), deltas.tobytes(), offsets.tobytes())
+
+def pyStripParity(data):
+    """Pure Python version of _logparser.stripParity"""
+    data = bytes(data)
+    byteCount = len(data)
+
+    # Short frame, no parity bit
+    if (byteCount == 1):
+        return (True, data)
+
+    # Frames are at most 255 bytes, so shifting one big integer is cheap
+    bits = int.from_bytes(data, 'little')
+    stripped = bytearray((byteCount * 8) // 9)
+
+    for group in range(len(stripped)):
+        groupBits = (bits >> (group * 9)) & 0x1FF
+        if (not PARITY_VALID[groupBits]):
+            return (False, data)
+        stripped[group] = groupBits & 0xFF
+
+    return (True, bytes(stripped))
+
+try:
+    from Chameleon._logparser import parse, stripParity
+    NATIVE = True
+except ImportError:
+    parse = pyParse
+    stripParity = pyStripParity
+    NATIVE = False
+
+def parseColumns(buffer, parseFunc=None):
+    """Split a binary log into columns of equal length:
+    event and length (bytes), timestamp and deltaTimestamp in ms (array 'H'),
+    offset of the entry data within buffer (array 'I').
+    'size' is the number of bytes taken up by complete entries."""
+    (count, size, events, lengths, timestamps, deltas, offsets) = (parseFunc or parse)(buffer)
+
+    columns = {
+        'count': count,
+        'size': size,
+        'event': events,
+        'length': lengths,
+        'timestamp': array.array('H'),
+        'deltaTimestamp': array.array('H'),
+        'offset': array.array('I'),
+    }
+
+    columns['timestamp'].frombytes(timestamps)
+    columns['deltaTimestamp'].frombytes(deltas)
+    columns['offset'].frombytes(offsets)
+
+    return columns
@@ -0,0 +1,208 @@
+#!/usr/bin/python
+#
+# NDEF compiler for the Type 2 tag configurations (NTAG21x, Ultralight EV1).
+#
+# Builds NDEF records (URI, text, vCard, Wi-Fi), encodes them into a message and
+# lays the message out as NDEF TLV in a complete memory image:
+#   pages 0-2   UID with BCC bytes, static lock bytes
+#   page 3      capability container
+#   page 4-     data area holding the NDEF TLV and the terminator TLV
+#   lock page   dynamic lock bytes, only for the larger variants
+#   last 4      configuration pages, unprotected (AUTH0 = 0xFF)
+# The image is uploaded with UPLOAD. NDEFUPDATE takes just the data area and leaves
+# UID, lock and configuration pages of the slot alone.
+
+import struct
+
+PAGE_SIZE = 4
+DATA_AREA_PAGE = 4
+CONFIG_PAGES = 4
+UID_SIZE = 7
+CASCADE_TAG = 0x88
+
+# Record header flags
+FLAG_MB = 0x80
+FLAG_ME = 0x40
+FLAG_SR = 0x10
+TNF_WELL_KNOWN = 0x01
+TNF_MEDIA = 0x02
+
+TLV_NDEF = 0x03
+TLV_TERMINATOR = 0xFE
+TLV_LONG_LENGTH = 0xFF
+
+CC_MAGIC = 0xE1
+CC_VERSION = 0x10
+CC_ACCESS = 0x00
+
+# Configuration name: page count, CC data area size in bytes, dynamic lock page, first configuration page
+TAG_LAYOUTS = {
+    "NTAG210":                  (20, 48, False, [0x00, 0x00, 0x00, 0xFF]),
+    "NTAG212":                  (41, 128, True, [0x00, 0x00, 0x00, 0xFF]),
+    "NTAG213":                  (45, 144, True, [0x04, 0x00, 0x00, 0xFF]),
+    "NTAG215":                  (135, 496, True, [0x04, 0x00, 0x00, 0xFF]),
+    "NTAG216":                  (231, 872, True, [0x04, 0x00, 0x00, 0xFF]),
+    "MF_ULTRALIGHT_EV1_80B":    (20, 48, False, [0x00, 0x00, 0x00, 0xFF]),
+    "MF_ULTRALIGHT_EV1_164B":   (41, 128, True, [0x00, 0x00, 0x00, 0xFF]),
+}
+
+DYNAMIC_LOCK_NTAG = [0x00, 0x00, 0x00, 0xBD]
+DYNAMIC_LOCK_EV1 = [0x00, 0x00, 0x00, 0x00]
+# ACCESS, VCTID, RFUI / PWD / PACK, RFUI
+CONFIG_TAIL = [0x00, 0x05, 0x00, 0x00] + [0xFF] * 4 + [0x00] * 4
+
+# URI identifier codes, longest prefixes first so the best match wins
+URI_PREFIXES = [
+    "http://www.", "https://www.", "http://", "https://", "tel:", "mailto:",
+    "ftp://anonymous:anonymous@", "ftp://ftp.", "ftps://", "sftp://", "smb://",
+    "nfs://", "ftp://", "dav://", "news:", "telnet://", "imap:", "rtsp://",
+    "urn:", "pop:", "sip:", "sips:", "tftp:", "btspp://", "btl2cap://",
+    "btgoep://", "tcpobex://", "irdaobex://", "file://", "urn:epc:id:",
+    "urn:epc:tag:", "urn:epc:pat:", "urn:epc:raw:", "urn:epc:", "urn:nfc:",
+]
+
+# Wi-Fi simple configuration attributes
+WSC_VERSION = 0x104A
+WSC_CREDENTIAL = 0x100E
+WSC_NETWORK_INDEX = 0x1026
+WSC_SSID = 0x1045
+WSC_AUTH_TYPE = 0x1003
+WSC_ENCRYPTION_TYPE = 0x100F
+WSC_NETWORK_KEY = 0x1027
+WSC_MAC_ADDRESS = 0x1020
+
+# Authentication name: authentication type, encryption type
+WIFI_AUTH_TYPES = {
+    "OPEN":     (0x0001, 0x0001),
+    "WPA":      (0x0002, 0x0004),
+    "WPA2":     (0x0020, 0x0008),
+}
+
+class Record:
+    def __init__(self, tnf, recordType, payload):
+        self.tnf = tnf
+        self.type = recordType
+        self.payload = payload
+
+def uriRecord(uri):
+    code = 0
+    for index, prefix in sorted(enumerate(URI_PREFIXES, 1), key=lambda item: -len(item[1])):
+        if (uri.startswith(prefix)):
+            code = index
+            uri = uri[len(prefix):]
+            break
+
+    return Record(TNF_WELL_KNOWN, b'U', bytes([code]) + uri.encode('utf-8'))
+
+def textRecord(text, language="en"):
+    language = language.encode('ascii')
+    # Status byte: UTF-8 and the length of the language code
+    return Record(TNF_WELL_KNOWN, b'T', bytes([len(language)]) + language + text.encode('utf-8'))
+
+def vcardRecord(vcard):
+    if (isinstance(vcard, str)):
+        vcard = vcard.encode('utf-8')
+
+    return Record(TNF_MEDIA, b'text/vcard', vcard)
+
+def wscAttribute(attributeId, value):
+    return struct.pack(">HH", attributeId, len(value)) + value
+
+def wifiRecord(ssid, key="", auth="WPA2"):
+    auth = auth.upper()
+    if (auth not in WIFI_AUTH_TYPES):
+        raise ValueError("Unknown Wi-Fi authentication {}, expected one of {}".format(auth, ", ".join(WIFI_AUTH_TYPES)))
+    authType, encryptionType = WIFI_AUTH_TYPES[auth]
+
+    credential = wscAttribute(WSC_NETWORK_INDEX, b'\x01')
+    credential += wscAttribute(WSC_SSID, ssid.encode('utf-8'))
+    credential += wscAttribute(WSC_AUTH_TYPE, struct.pack(">H", authType))
+    credential += wscAttribute(WSC_ENCRYPTION_TYPE, struct.pack(">H", encryptionType))
+    credential += wscAttribute(WSC_NETWORK_KEY, key.encode('utf-8'))
+    credential += wscAttribute(WSC_MAC_ADDRESS, b'\xFF' * 6)
+
+    payload = wscAttribute(WSC_VERSION, b'\x10') + wscAttribute(WSC_CREDENTIAL, credential)
+    return Record(TNF_MEDIA, b'application/vnd.wfa.wsc', payload)
+
+def parseRecord(spec):
+    """Record from a command line description:
+       uri:URI, text:TEXT, vcard:FILE, wifi:SSID[,KEY[,OPEN|WPA|WPA2]]"""
+    kind, sep, value = spec.partition(':')
+    kind = kind.lower()
+
+    if (not sep):
+        raise ValueError("Record {} is missing its type".format(spec))
+    elif (kind == "uri"):
+        return uriRecord(value)
+    elif (kind == "text"):
+        return textRecord(value)
+    elif (kind == "vcard"):
+        with open(value, 'rb') as fileHandle:
+            return vcardRecord(fileHandle.read())
+    elif (kind == "wifi"):
+        fields = value.split(',')
+        return wifiRecord(*fields[:3])
+    else:
+        raise ValueError("Unknown record type {}".format(kind))
+
+def encodeMessage(records):
+    message = b''
+
+    for index, record in enumerate(records):
+        header = record.tnf
+        if (index == 0):
+            header |= FLAG_MB
+        if (index == len(records) - 1):
+            header |= FLAG_ME
+
+        if (len(record.payload) < 256):
+            header |= FLAG_SR
+            lengths = struct.pack(">BBB", header, len(record.type), len(record.payload))
+        else:
+            lengths = struct.pack(">BBI", header, len(record.type), len(record.payload))
+
+        message += lengths + record.type + record.payload
+
+    return message
+
+def layout(configName):
+    if (configName not in TAG_LAYOUTS):
+        raise ValueError("Configuration {} has no Type 2 tag layout, expected one of {}".format(configName, ", ".join(TAG_LAYOUTS)))
+
+    return TAG_LAYOUTS[configName]
+
+def dataArea(configName, message):
+    """NDEF and terminator TLV, zero padded to the size of the data area"""
+    pageCount, ccSize, dynamicLock, configPage = layout(configName)
+
+    if (len(message) < TLV_LONG_LENGTH):
+        tlv = bytes([TLV_NDEF, len(message)])
+    else:
+        tlv = struct.pack(">BBH", TLV_NDEF, TLV_LONG_LENGTH, len(message))
+    tlv += message + bytes([TLV_TERMINATOR])
+
+    if (len(tlv) > ccSize):
+        raise ValueError("NDEF message needs {} bytes, {} only has {}".format(len(tlv), configName, ccSize))
+
+    areaSize = (pageCount - CONFIG_PAGES - (1 if dynamicLock else 0) - DATA_AREA_PAGE) * PAGE_SIZE
+    return tlv + bytes(areaSize - len(tlv))
+
+def buildImage(configName, message, uid=None):
+    """Complete memory image for UPLOAD"""
+    pageCount, ccSize, dynamicLock, configPage = layout(configName)
+    uid = bytes(UID_SIZE) if uid is None else bytes(uid)
+
+    if (len(uid) != UID_SIZE):
+        raise ValueError("UID needs {} bytes".format(UID_SIZE))
+
+    bcc0 = CASCADE_TAG ^ uid[0] ^ uid[1] ^ uid[2]
+    bcc1 = uid[3] ^ uid[4] ^ uid[5] ^ uid[6]
+    image = uid[0:3] + bytes([bcc0]) + uid[3:7] + bytes([bcc1, 0x48, 0x00, 0x00])
+    image += bytes([CC_MAGIC, CC_VERSION, ccSize // 8, CC_ACCESS])
+    image += dataArea(configName, message)
+
+    if (dynamicLock):
+        image += bytes(DYNAMIC_LOCK_NTAG if configName.startswith("NTAG") else DYNAMIC_LOCK_EV1)
+
+    image += bytes(configPage + CONFIG_TAIL)
+    return image
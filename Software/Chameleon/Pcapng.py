@@ -0,0 +1,186 @@
+#!/usr/bin/python
+#
+# Streaming export of binary Chameleon logs to pcapng, for Wireshark's ISO14443 dissector.
+#
+# ISO14443A frames are written as Enhanced Packet Blocks with LINKTYPE_ISO_14443, each one
+# carrying the pseudo header (version, event, length) in front of the frame. Frames logged
+# with parity bits are stripped; when their parity is broken, they are written as logged and
+# flagged with a symbol error in epb_flags.
+#
+# Codec frames are logged as received or sent by the Chameleon, so their direction depends on
+# the configuration: it follows the CONFIG SET entries, before the first one it is given by the caller.
+#
+# Wireshark has no ISO15693 link type, so sniffed ISO15693 frames go into Custom Blocks:
+#   interface id (uint32), timestamp high/low (uint32 each), direction (uint8, 0 = reader, 1 = card),
+#   reserved (uint8), fc/32 timestamp of the frame (uint16), frame length (uint16), frame
+#
+# Timestamps are the log's ms timestamps made absolute: wraparounds are corrected and every
+# BOOT entry continues the time line. startTime (seconds since the epoch) is added to all of them.
+
+import struct
+import Chameleon.LogParser as LogParser
+import Chameleon.ISO15693 as iso15693
+
+BLOCK_SHB = 0x0A0D0D0A
+BLOCK_IDB = 0x00000001
+BLOCK_EPB = 0x00000006
+BLOCK_CUSTOM = 0x00000BAD
+BYTE_ORDER_MAGIC = 0x1A2B3C4D
+
+# No private enterprise number is registered for the Chameleon, readers can tell the blocks apart by PEN 0
+CUSTOM_BLOCK_PEN = 0
+
+LINKTYPE_ISO_14443 = 264
+ISO14443_EVENT_PCD_TO_PICC = 0xFF
+ISO14443_EVENT_PICC_TO_PCD = 0xFE
+
+OPT_ENDOFOPT = 0
+OPT_COMMENT = 1
+OPT_SHB_USERAPPL = 4
+OPT_IF_NAME = 2
+OPT_IF_TSRESOL = 9
+OPT_EPB_FLAGS = 2
+
+EPB_FLAG_INBOUND = 0x00000001
+EPB_FLAG_OUTBOUND = 0x00000002
+EPB_FLAG_SYMBOL_ERROR = 0x80000000
+
+# Timestamps in units of 1 ms
+TSRESOL_MS = 3
+
+LOG_EVENT_BOOT = 0xFF
+LOG_EVENT_CONFIG_SET = 0x11
+READER_CONFIGURATIONS = ("ISO14443A_READER",)
+TIMESTAMP_MAX = 65536
+
+# Event type: (direction, parity bits present), reader to card is outbound.
+# The codec events are given for emulation, in reader mode RX comes from the card.
+ISO14443_EVENTS = {
+    0x40: (EPB_FLAG_OUTBOUND, False),  # CODEC RX
+    0x41: (EPB_FLAG_INBOUND, False),   # CODEC TX
+    0x42: (EPB_FLAG_OUTBOUND, True),
+    0x43: (EPB_FLAG_INBOUND, True),
+    0x44: (EPB_FLAG_OUTBOUND, False),  # SNI READER
+    0x45: (EPB_FLAG_OUTBOUND, True),
+    0x46: (EPB_FLAG_INBOUND, False),   # SNI CARD
+    0x47: (EPB_FLAG_INBOUND, True),
+}
+
+ISO14443_CODEC_EVENTS = (0x40, 0x41, 0x42, 0x43)
+
+ISO15693_EVENTS = {
+    0x48: 0,    # SNI READER ISO15693
+    0x49: 1,    # SNI CARD ISO15693
+}
+
+CHUNK_SIZE = 1 << 20
+
+def padding(length):
+    return b'\0' * (-length % 4)
+
+def option(code, value):
+    return struct.pack('<HH', code, len(value)) + value + padding(len(value))
+
+def block(blockType, body):
+    length = 12 + len(body)
+    return struct.pack('<II', blockType, length) + body + struct.pack('<I', length)
+
+def sectionHeader(application):
+    body = struct.pack('<IHHq', BYTE_ORDER_MAGIC, 1, 0, -1)
+    body += option(OPT_SHB_USERAPPL, application.encode()) + option(OPT_ENDOFOPT, b'')
+    return block(BLOCK_SHB, body)
+
+def interfaceDescription(linkType, name):
+    body = struct.pack('<HHI', linkType, 0, 0)
+    body += option(OPT_IF_NAME, name.encode()) + option(OPT_IF_TSRESOL, bytes([TSRESOL_MS])) + option(OPT_ENDOFOPT, b'')
+    return block(BLOCK_IDB, body)
+
+def enhancedPacket(interface, timestamp, data, flags, comment=None):
+    body = struct.pack('<IIIII', interface, timestamp >> 32, timestamp & 0xFFFFFFFF, len(data), len(data))
+    body += data + padding(len(data))
+    body += option(OPT_EPB_FLAGS, struct.pack('<I', flags))
+    if (comment is not None):
+        body += option(OPT_COMMENT, comment.encode())
+    body += option(OPT_ENDOFOPT, b'')
+    return block(BLOCK_EPB, body)
+
+def customBlock(interface, timestamp, direction, frameTicks, frame):
+    body = struct.pack('<IIIIBBHH', CUSTOM_BLOCK_PEN, interface, timestamp >> 32, timestamp & 0xFFFFFFFF,
+                       direction, 0, frameTicks, len(frame))
+    body += frame
+    body += padding(len(body))
+    return block(BLOCK_CUSTOM, body)
+
+def iso14443Packet(event, timestamp, data, reader=False):
+    (flags, hasParity) = ISO14443_EVENTS[event]
+    comment = None
+
+    if (reader and event in ISO14443_CODEC_EVENTS):
+        flags ^= EPB_FLAG_INBOUND | EPB_FLAG_OUTBOUND
+
+    if (hasParity):
+        (isValid, frame) = LogParser.stripParity(data)
+        if (not isValid):
+            flags |= EPB_FLAG_SYMBOL_ERROR
+            comment = "parity error, frame as logged"
+    else:
+        frame = data
+
+    pseudoEvent = ISO14443_EVENT_PCD_TO_PICC if flags & EPB_FLAG_OUTBOUND else ISO14443_EVENT_PICC_TO_PCD
+    packet = struct.pack('>BBH', 0, pseudoEvent, len(frame)) + frame
+    return enhancedPacket(0, timestamp, packet, flags, comment)
+
+def iterEntries(logStream, chunkSize=CHUNK_SIZE):
+    """Yield (event, absolute ms, data) for every entry, reading the log in chunks"""
+    pending = b''
+    elapsedMs = 0
+    lastTimestamp = 0
+
+    while True:
+        chunk = logStream.read(chunkSize)
+        if (not chunk):
+            return
+
+        buffer = pending + chunk
+        columns = LogParser.parseColumns(buffer)
+
+        for i in range(columns['count']):
+            event = columns['event'][i]
+            timestamp = columns['timestamp'][i]
+            offset = columns['offset'][i]
+
+            # The systick restarts with every boot
+            if (event == LOG_EVENT_BOOT):
+                lastTimestamp = 0
+            elapsedMs += (timestamp - lastTimestamp) % TIMESTAMP_MAX
+            lastTimestamp = timestamp
+
+            yield (event, elapsedMs, buffer[offset:offset + columns['length'][i]])
+
+        size = columns['size']
+        if (size + LogParser.LOG_HEADER_SIZE <= len(buffer) and buffer[size] == LogParser.LOG_EVENT_EMPTY):
+            # End of log
+            return
+        pending = buffer[size:]
+
+def export(logStream, pcapStream, startTime=0, reader=False):
+    """Convert the binary log in logStream to pcapng, returns the number of frames written.
+    reader tells whether codec frames before the first CONFIG SET entry are from reader mode"""
+    startMs = int(startTime * 1000)
+    frameCount = 0
+
+    pcapStream.write(sectionHeader("chamlog"))
+    pcapStream.write(interfaceDescription(LINKTYPE_ISO_14443, "Chameleon ISO14443A"))
+
+    for (event, elapsedMs, data) in iterEntries(logStream):
+        if (event == LOG_EVENT_CONFIG_SET):
+            reader = data.decode('ascii', 'replace') in READER_CONFIGURATIONS
+        elif (event in ISO14443_EVENTS):
+            pcapStream.write(iso14443Packet(event, startMs + elapsedMs, data, reader))
+            frameCount += 1
+        elif (event in ISO15693_EVENTS):
+            (frameTicks, frame) = iso15693.splitTimestamp(data)
+            pcapStream.write(customBlock(0, startMs + elapsedMs, ISO15693_EVENTS[event], frameTicks or 0, frame))
+            frameCount += 1
+
+    return frameCount
@@ -1,14 +1,18 @@
 # Import modules
 import Chameleon.Log
+import Chameleon.Capture
+import Chameleon.Pcapng
+import Chameleon.NDEF
 
 # Import classes
 from Chameleon.Device import Device
+from Chameleon.AsyncDevice import AsyncDevice
 from Chameleon.XModem import XModem
 
 #import Chameleon.Device
 
 MIN_SETTING = 1
-MAX_SETTING = 8
+MAX_SETTING = 32 # SETTINGS_COUNT of the firmware, see Settings.h
 VALID_SETTINGS = range(MIN_SETTING, MAX_SETTING + 1)
 
 USB_VID = 0x16D0
@@ -0,0 +1,170 @@
+/*
+ * logparser.c
+ *
+ *  Bulk parser for binary Chameleon logs, built as Chameleon._logparser.
+ *  Chameleon/LogParser.py implements the same interface in pure Python
+ *  and is used whenever this extension has not been built.
+ *
+ *  Log entry layout, see Firmware/Chameleon-Mini/Log.h:
+ *      event (1 byte) | data length (1 byte) | timestamp in ms (2 bytes, big endian) | data
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LOG_HEADER_SIZE     4
+#define LOG_EVENT_EMPTY     0x00
+
+/* Indexed by a 9 bit group (8 data bits + odd parity bit in bit 8), nonzero if the parity is valid */
+static uint8_t ParityValid[512];
+
+static void InitParityTable(void) {
+    for (unsigned Group = 0; Group < 512; Group++) {
+        unsigned Ones = 0;
+        for (unsigned Bit = 0; Bit < 9; Bit++)
+            Ones += (Group >> Bit) & 0x01;
+        ParityValid[Group] = Ones & 0x01;
+    }
+}
+
+/* parse(buffer) -> (count, consumed, events, lengths, timestamps, deltas, offsets)
+ * Columns are returned as bytes in native byte order: events/lengths uint8, timestamps/deltas uint16, offsets uint32 */
+static PyObject *LogParserParse(PyObject *Self, PyObject *Args) {
+    Py_buffer View;
+    PyObject *Result = NULL;
+
+    if (!PyArg_ParseTuple(Args, "y*", &View))
+        return NULL;
+
+    const uint8_t *Log = View.buf;
+    Py_ssize_t Size = View.len;
+
+    /* Every entry takes at least a header, this bounds the column sizes */
+    Py_ssize_t MaxCount = Size / LOG_HEADER_SIZE;
+    uint8_t *Events = PyMem_Malloc(MaxCount + 1);
+    uint8_t *Lengths = PyMem_Malloc(MaxCount + 1);
+    uint16_t *Timestamps = PyMem_Malloc((MaxCount + 1) * sizeof(uint16_t));
+    uint16_t *Deltas = PyMem_Malloc((MaxCount + 1) * sizeof(uint16_t));
+    uint32_t *Offsets = PyMem_Malloc((MaxCount + 1) * sizeof(uint32_t));
+
+    if (!Events || !Lengths || !Timestamps || !Deltas || !Offsets) {
+        PyErr_NoMemory();
+        goto out;
+    }
+
+    Py_ssize_t Count = 0;
+    Py_ssize_t Pos = 0;
+    uint16_t LastTimestamp = 0;
+
+    Py_BEGIN_ALLOW_THREADS
+    while (Pos + LOG_HEADER_SIZE <= Size) {
+        uint8_t Event = Log[Pos];
+        uint8_t Length = Log[Pos + 1];
+        uint16_t Timestamp = (Log[Pos + 2] << 8) | Log[Pos + 3];
+
+        /* No more events, or the entry is cut off */
+        if (Event == LOG_EVENT_EMPTY || Pos + LOG_HEADER_SIZE + Length > Size)
+            break;
+
+        Events[Count] = Event;
+        Lengths[Count] = Length;
+        Timestamps[Count] = Timestamp;
+        Deltas[Count] = (uint16_t)(Timestamp - LastTimestamp);
+        Offsets[Count] = (uint32_t)(Pos + LOG_HEADER_SIZE);
+        LastTimestamp = Timestamp;
+
+        Count++;
+        Pos += LOG_HEADER_SIZE + Length;
+    }
+    Py_END_ALLOW_THREADS
+
+    Result = Py_BuildValue("nny#y#y#y#y#", Count, Pos,
+                           (const char *) Events, Count,
+                           (const char *) Lengths, Count,
+                           (const char *) Timestamps, Count * (Py_ssize_t) sizeof(uint16_t),
+                           (const char *) Deltas, Count * (Py_ssize_t) sizeof(uint16_t),
+                           (const char *) Offsets, Count * (Py_ssize_t) sizeof(uint32_t));
+
+out:
+    PyMem_Free(Events);
+    PyMem_Free(Lengths);
+    PyMem_Free(Timestamps);
+    PyMem_Free(Deltas);
+    PyMem_Free(Offsets);
+    PyBuffer_Release(&View);
+    return Result;
+}
+
+/* stripParity(data) -> (valid, data)
+ * Splits the frame into 9 bit groups, leftover bits are ignored. On a parity error the input is returned unchanged. */
+static PyObject *LogParserStripParity(PyObject *Self, PyObject *Args) {
+    Py_buffer View;
+
+    if (!PyArg_ParseTuple(Args, "y*", &View))
+        return NULL;
+
+    const uint8_t *Data = View.buf;
+    Py_ssize_t ByteCount = View.len;
+
+    /* Short frame, no parity bit */
+    if (ByteCount == 1) {
+        PyObject *Result = Py_BuildValue("Oy#", Py_True, (const char *) Data, ByteCount);
+        PyBuffer_Release(&View);
+        return Result;
+    }
+
+    Py_ssize_t GroupCount = (ByteCount * 8) / 9;
+    PyObject *Stripped = PyBytes_FromStringAndSize(NULL, GroupCount);
+
+    if (Stripped == NULL) {
+        PyBuffer_Release(&View);
+        return NULL;
+    }
+
+    uint8_t *Out = (uint8_t *) PyBytes_AS_STRING(Stripped);
+    int Valid = 1;
+
+    for (Py_ssize_t Group = 0; Group < GroupCount; Group++) {
+        Py_ssize_t BitPos = Group * 9;
+        Py_ssize_t BytePos = BitPos / 8;
+        /* A group spans at most two bytes, the last group of a frame always ends within it */
+        unsigned Window = Data[BytePos] | ((BytePos + 1 < ByteCount) ? (Data[BytePos + 1] << 8) : 0);
+        unsigned Bits = (Window >> (BitPos % 8)) & 0x1FF;
+
+        if (!ParityValid[Bits]) {
+            Valid = 0;
+            break;
+        }
+
+        Out[Group] = (uint8_t) Bits;
+    }
+
+    PyObject *Result;
+
+    if (Valid) {
+        Result = Py_BuildValue("ON", Py_True, Stripped);
+    } else {
+        Py_DECREF(Stripped);
+        Result = Py_BuildValue("Oy#", Py_False, (const char *) Data, ByteCount);
+    }
+
+    PyBuffer_Release(&View);
+    return Result;
+}
+
+static PyMethodDef LogParserMethods[] = {
+    { "parse", LogParserParse, METH_VARARGS, "Split a binary log into columns" },
+    { "stripParity", LogParserStripParity, METH_VARARGS, "Validate and remove the parity bits of a sniffed frame" },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef LogParserModule = {
+    PyModuleDef_HEAD_INIT, "_logparser", "Bulk parser for binary Chameleon logs", -1, LogParserMethods
+};
+
+PyMODINIT_FUNC PyInit__logparser(void) {
+    InitParityTable();
+    return PyModule_Create(&LogParserModule);
+}
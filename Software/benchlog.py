@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+#
+# Benchmark for the binary log parser, reports entries/sec
+# for the native and the pure Python implementation.
+
+import argparse
+import io
+import os
+import random
+import struct
+import time
+import Chameleon.Log
+import Chameleon.LogParser as LogParser
+
+def addParity(frame):
+    # Append an odd parity bit to every byte, the same way sniffed frames are logged
+    bits = 0
+    for i, byte in enumerate(frame):
+        parity = 0 if bin(byte).count('1') % 2 else 1
+        bits |= (byte | (parity << 8)) << (i * 9)
+    return bits.to_bytes((len(frame) * 9 + 7) // 8, 'little')
+
+def syntheticLog(entryCount):
+    # Sniffer traffic mixed with some plain entries, timestamps wrap around
+    random.seed(0)
+    log = bytearray()
+    timestamp = 0
+    for i in range(entryCount):
+        timestamp = (timestamp + random.randint(0, 40)) & 0xFFFF
+        if (i % 4 == 3):
+            event, data = 0x40, os.urandom(random.randint(0, 16))
+        else:
+            event, data = random.choice((0x45, 0x47)), addParity(os.urandom(random.randint(1, 18)))
+        log += struct.pack('>BBH', event, len(data), timestamp) + data
+    return bytes(log)
+
+def measure(name, func, entryCount, repeat):
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        func()
+        duration = time.perf_counter() - start
+        best = duration if best is None else min(best, duration)
+    print("{:<32} {:>12.0f} entries/s".format(name, entryCount / best))
+
+def stripAll(buffer, columns, stripParity):
+    for i in range(columns['count']):
+        if (columns['event'][i] in Chameleon.Log.SNIFF_PARITY_EVENTS):
+            offset = columns['offset'][i]
+            stripParity(buffer[offset:offset + columns['length'][i]])
+
+def main():
+    argParser = argparse.ArgumentParser(description="Benchmarks the binary Chameleon log parser")
+    argParser.add_argument("logfiles", metavar="LOGFILE", nargs='*', help="binary logs, a synthetic one is used if none given")
+    argParser.add_argument("-n", "--entries", type=int, default=100000, help="entries in the synthetic log")
+    argParser.add_argument("-r", "--repeat", type=int, default=3)
+    args = argParser.parse_args()
+
+    logs = [(name, open(name, "rb").read()) for name in args.logfiles]
+    if (len(logs) == 0):
+        logs = [("synthetic", syntheticLog(args.entries))]
+
+    print("native parser {}".format("available" if LogParser.NATIVE else "not built, see setup.py"))
+
+    for name, buffer in logs:
+        entryCount = LogParser.parseColumns(buffer)['count']
+        print("{}: {} bytes, {} entries".format(name, len(buffer), entryCount))
+
+        implementations = [("python", LogParser.pyParse, LogParser.pyStripParity)]
+        if (LogParser.NATIVE):
+            implementations.insert(0, ("native", LogParser.parse, LogParser.stripParity))
+
+        for implName, parse, stripParity in implementations:
+            columns = LogParser.parseColumns(buffer, parse)
+            measure(implName + " columns", lambda: LogParser.parseColumns(buffer, parse), entryCount, args.repeat)
+            measure(implName + " parity strip", lambda: stripAll(buffer, columns, stripParity), entryCount, args.repeat)
+
+        measure("parseBinary", lambda: Chameleon.Log.parseBinary(io.BytesIO(buffer)), entryCount, args.repeat)
+
+if __name__ == "__main__":
+    main()
@@ -30,6 +30,16 @@ def formatText(log):
 
     return text
 
+def parseEventType(text):
+    # Event types are given by number or by the name chamlog prints
+    try:
+        return int(text, 0)
+    except ValueError:
+        for eventType, event in Chameleon.Log.eventTypes.items():
+            if (event['name'] == text.upper()):
+                return eventType
+    raise argparse.ArgumentTypeError("Unknown event type {}".format(text))
+
 def formatJSON(log):
     text = json.dumps(log, sort_keys=True, indent=4)
     
@@ -54,6 +64,12 @@ def main():
     argParser.add_argument("-c", "--clear", dest="clear", action='store_true', help="Clear Chameleon's log memory when using -p")
     argParser.add_argument("-m", "--mode", dest="mode", metavar="LOGMODE", help="Additionally set Chameleon's log mode after reading it's memory")
     argParser.add_argument("-v", "--verbose", dest="verbose", action='store_true', default=0)
+    argParser.add_argument("-o", "--capture", dest="capture", metavar="CAPTUREFILE", help="Save the log as indexed capture file for fast filtering")
+    argParser.add_argument("-w", "--pcapng", dest="pcapng", metavar="PCAPFILE", help="Export the sniffed and codec frames as pcapng instead of printing the log")
+    argParser.add_argument("-r", "--reader", dest="reader", action='store_true', help="With -w, export codec frames logged before the first CONFIG SET entry as reader mode frames")
+    argParser.add_argument("-s", "--start", dest="start", type=int, metavar="MS", help="Only show entries logged at or after MS since the start of the log")
+    argParser.add_argument("-e", "--end", dest="end", type=int, metavar="MS", help="Only show entries logged before MS since the start of the log")
+    argParser.add_argument("-x", "--event", dest="events", action='append', type=parseEventType, metavar="EVENT", help="Only show entries of this event type, by name or number. Can be given multiple times")
 
     args = argParser.parse_args()
 	
@@ -71,9 +87,11 @@ def main():
             if (chameleon.connect(args.port)):
                 chameleon.cmdLogMode("LIVE")
 
+                # Entries split across reads are completed by the following ones
+                decoder = Chameleon.Log.StreamDecoder(args.decode)
+
                 while True:
-                    stream = io.BytesIO(chameleon.read())
-                    log = Chameleon.Log.parseBinary(stream, args.decode)
+                    log = decoder.feed(chameleon.read())
                     if (len(log) > 0):
                         print(outputTypes[args.type](log))
       
@@ -98,8 +116,33 @@ def main():
             else:
                 sys.exit(2)
                 
-        # Parse actual logfile
-        log = Chameleon.Log.parseBinary(handle, args.decode)
+        if (args.capture is not None):
+            # A capture file given with -f is indexed again from the log it contains
+            if (Chameleon.Capture.isCapture(handle)):
+                log = Chameleon.Capture.Capture(handle).logStream().read()
+            else:
+                log = handle.read()
+            with open(args.capture, "wb") as captureHandle:
+                Chameleon.Capture.write(captureHandle, log)
+            handle.seek(0)
+
+        if (args.pcapng is not None):
+            # Stream straight into the pcapng file
+            if (Chameleon.Capture.isCapture(handle)):
+                handle = Chameleon.Capture.Capture(handle).logStream()
+            with open(args.pcapng, "wb") as pcapHandle:
+                frameCount = Chameleon.Pcapng.export(handle, pcapHandle, reader=args.reader)
+            print("{} frames written to {}".format(frameCount, args.pcapng))
+            return
+
+        if (args.start is None and args.end is None and args.events is None and not Chameleon.Capture.isCapture(handle)):
+            # Parse actual logfile
+            log = Chameleon.Log.parseBinary(handle, args.decode)
+        else:
+            # Seek to the matching entries through the capture index
+            capture = Chameleon.Capture.Capture(handle)
+            entries = capture.select(args.start, args.end, args.events)
+            log = Chameleon.Log.StreamDecoder(args.decode).feed(b''.join(capture.entry(n) for n in entries))
 
         # Print to console using chosen output type
         print(outputTypes[args.type](log))
@@ -5,7 +5,11 @@
 
 import argparse
 import Chameleon
+import concurrent.futures
+import io
+import os
 import sys
+import threading
 import datetime
 
 def verboseLog(text):
@@ -46,6 +50,10 @@ def cmdGetUID(chameleon, arg):
 def cmdIdentify(chameleon, arg):
     return "{}".format(chameleon.cmdIdentify()['response'])
 
+def cmdInventory(chameleon, arg):
+    result = chameleon.cmdInventory()
+    return "\n".join([result['response']] + result['cards'])
+
 def cmdDumpMFU(chameleon, arg):
     return "{}".format(chameleon.cmdDumpMFU()['response'])
 
@@ -72,11 +80,44 @@ def cmdDownload(chameleon, arg):
         bytesReceived = chameleon.cmdDownloadDump(fileHandle)
         return "{} Bytes successfully written to {}".format(bytesReceived, arg)
 
+def ndefSlot(chameleon, arg):
+    """Active configuration and the NDEF message compiled from the record descriptions"""
+    config = chameleon.cmdConfig()['response']
+    message = Chameleon.NDEF.encodeMessage([Chameleon.NDEF.parseRecord(spec) for spec in arg])
+    return config, message
+
+def cmdNdef(chameleon, arg):
+    config, message = ndefSlot(chameleon, arg)
+    uid = bytes.fromhex(chameleon.cmdUID()['response'])
+    image = Chameleon.NDEF.buildImage(config, message, uid)
+    bytesSent = chameleon.cmdUploadDump(io.BytesIO(image))
+    return "{} Bytes NDEF image with {} records uploaded as {}".format(bytesSent, len(arg), config)
+
+def cmdNdefUpdate(chameleon, arg):
+    config, message = ndefSlot(chameleon, arg)
+    bytesSent = chameleon.cmdNdefUpdate(io.BytesIO(Chameleon.NDEF.dataArea(config, message)))
+    if (bytesSent is None):
+        return "NDEF update failed, {} does not support it".format(config)
+    return "{} Bytes NDEF data area with {} records updated".format(bytesSent, len(arg))
+
 def cmdLog(chameleon, arg):
+    if (arg.endswith(Chameleon.Capture.CAPTURE_EXTENSION)):
+        # Store as indexed capture file
+        logHandle = io.BytesIO()
+        chameleon.cmdDownloadLog(logHandle)
+        with open(arg, 'wb') as fileHandle:
+            entryCount = Chameleon.Capture.write(fileHandle, logHandle.getvalue())
+            return "{} Entries successfully written to {}".format(entryCount, arg)
+
     with open(arg, 'wb') as fileHandle:
         bytesReceived = chameleon.cmdDownloadLog(fileHandle)
         return "{} Bytes successfully written to {}".format(bytesReceived, arg)
 
+def cmdNonces(chameleon, arg):
+    with open(arg, 'wb') as fileHandle:
+        bytesReceived = chameleon.cmdDownloadNonces(fileHandle)
+        return "{} Bytes successfully written to {}".format(bytesReceived, arg)
+
 def cmdLogMode(chameleon, arg):
     result = chameleon.cmdLogMode(arg)
 
@@ -186,6 +227,90 @@ def cmdClear(chameleon, arg):
     chameleon.cmdClear()
     return "Slot has been cleared"
 
+# Jumptable for the commands given on the command line
+cmdFuncs = {
+    "setting"   : cmdSetting,
+    "info"      : cmdInfo,
+    "uid"       : cmdUID,
+    "getuid"    : cmdGetUID,
+    "identify"  : cmdIdentify,
+    "inventory" : cmdInventory,
+    "dumpmfu"   : cmdDumpMFU,
+    "config"    : cmdConfig,
+    "upload"    : cmdUpload,
+    "download"  : cmdDownload,
+    "ndef"      : cmdNdef,
+    "ndefupdate": cmdNdefUpdate,
+    "log"       : cmdLog,
+    "nonces"    : cmdNonces,
+    "logmode"   : cmdLogMode,
+    "lbutton"   : cmdLButton,
+    "lbutton_long" : cmdLButtonLong,
+    "rbutton_long" : cmdRButtonLong,
+    "rbutton"   : cmdRButton,
+    "gled"      : cmdGreenLED,
+    "rled"      : cmdRedLED,
+    "threshold" : cmdThreshold,
+    "upgrade"   : cmdUpgrade,
+    "clear"     : cmdClear,
+}
+
+# Commands writing a file, every device of a fleet gets its own one
+FILE_OUTPUT_CMDS = ["download", "log", "nonces"]
+
+def fleetArg(cmd, arg, port, index):
+    if (cmd not in FILE_OUTPUT_CMDS or arg is None):
+        return arg
+
+    portName = os.path.basename(port)
+    if ("{" in arg):
+        return arg.format(port=portName, index=index)
+
+    (root, ext) = os.path.splitext(arg)
+    return "{}_{}{}".format(root, portName, ext)
+
+def fleetWorker(port, index, cmdList, verboseFunc, printLock):
+    chameleon = Chameleon.Device(verboseFunc)
+
+    if (not chameleon.connect(port)):
+        return (False, "Unable to establish communication")
+
+    try:
+        for (cmd, arg) in cmdList:
+            result = cmdFuncs[cmd](chameleon, fleetArg(cmd, arg, port, index))
+            with printLock:
+                print("[{}] [{}] {}".format(port, cmd, result))
+        return (True, "Done")
+    except SystemExit:
+        # Upgrade mode, the device is gone
+        return (True, "Device changed into Upgrade Mode")
+    except Exception as e:
+        return (False, "Failed: {}".format(e))
+    finally:
+        chameleon.disconnect()
+
+def runFleet(ports, cmdList, verboseFunc):
+    # One worker per port, the devices are independent of each other
+    printLock = threading.Lock()
+    results = {}
+
+    print("Running on {} devices: {}".format(len(ports), ", ".join(ports)))
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=max(1, len(ports))) as executor:
+        futures = { executor.submit(fleetWorker, port, index, cmdList, verboseFunc, printLock): port for index, port in enumerate(ports) }
+        for future in concurrent.futures.as_completed(futures):
+            port = futures[future]
+            results[port] = future.result()
+            with printLock:
+                print("[{}] {}".format(port, results[port][1]))
+
+    failed = [port for port in ports if not results[port][0]]
+    print("{} of {} devices succeeded".format(len(ports) - len(failed), len(ports)))
+    for port in failed:
+        print("  {}: {}".format(port, results[port][1]))
+
+    return len(failed) == 0
+
 # Custom class for argparse
 class CmdListAction(argparse.Action):
     def __init__(self, option_strings, dest, default=False, required=False,
@@ -205,18 +330,25 @@ def main():
     argParser = argparse.ArgumentParser(description="Controls the Chameleon through the command line")
     argParser.add_argument("-v",    "--verbose",    dest="verbose",     action="store_true",    default=0,          help="output verbose")
     argParser.add_argument("-p",    "--port",       dest="port",        metavar="COMPORT",                          help="specify device's comport")
+    argParser.add_argument("-F",    "--fleet",      dest="fleet",       metavar="COMPORT", nargs='*',               help="run the commands concurrently on the given comports, or on all connected Chameleons. "
+                                                                                                                        "Downloaded files get the port appended to their name, or replace {port} and {index} in it")
 
     # Add the commands using custom action that populates a list in the order the arguments are given
     cmdArgGroup = argParser.add_argument_group(title="Chameleon commands", description="These arguments can appear multiple times and are executed in the order they are given on the command line. "
                                                                                        "Some of these arguments can be used with '" + Chameleon.Device.SUGGEST_CHAR + "' as parameter to get a list of suggestions.")
     cmdArgGroup.add_argument("-u",  "--upload",      dest="upload",      action=CmdListAction, metavar="DUMPFILE",   help="upload a card dump")
     cmdArgGroup.add_argument("-d",  "--download",    dest="download",    action=CmdListAction, metavar="DUMPFILE",   help="download a card dump")
-    cmdArgGroup.add_argument("-l",  "--log",         dest="log",         action=CmdListAction, metavar="LOGFILE",    help="download the device log")
+    cmdArgGroup.add_argument("-N",  "--ndef",        dest="ndef",        action=CmdListAction, metavar="RECORD", nargs='+', help="compile the records into an NDEF image for the current configuration and UID and upload it. "
+                                                                                                                    "RECORD is uri:URI, text:TEXT, vcard:FILE or wifi:SSID[,KEY[,OPEN|WPA|WPA2]]")
+    cmdArgGroup.add_argument("-NU", "--ndefupdate",  dest="ndefupdate",  action=CmdListAction, metavar="RECORD", nargs='+', help="replace only the NDEF message of the current slot, keeping UID, lock and configuration pages")
+    cmdArgGroup.add_argument("-l",  "--log",         dest="log",         action=CmdListAction, metavar="LOGFILE",    help="download the device log, as indexed capture if LOGFILE ends with .chc")
+    cmdArgGroup.add_argument("-n",  "--nonces",      dest="nonces",      action=CmdListAction, metavar="NONCEFILE",  help="download the collected nested nonces")
     cmdArgGroup.add_argument("-i",  "--info",        dest="info",        action=CmdListAction, nargs=0,              help="retrieve the version information")
     cmdArgGroup.add_argument("-s",  "--setting",     dest="setting",     action=CmdListAction, nargs='?', type=int, choices=Chameleon.VALID_SETTINGS, help="retrieve or set the current setting")
     cmdArgGroup.add_argument("-U",  "--uid",         dest="uid",         action=CmdListAction, nargs='?',            help="retrieve or set the current UID")
     cmdArgGroup.add_argument("-gu",  "--getuid",         dest="getuid",         action=CmdListAction, nargs='?',            help="retrieve UID of device in range")
     cmdArgGroup.add_argument("-I",  "--identify",         dest="identify",         action=CmdListAction, nargs='?',            help="identify device in range")
+    cmdArgGroup.add_argument("-inv", "--inventory",   dest="inventory",   action=CmdListAction, nargs=0,              help="list UID, ATQA and SAK of all cards in range")
     cmdArgGroup.add_argument("-D",  "--dumpmfu",    dest="dumpmfu",    action=CmdListAction, nargs='?',  help="dump information about card in range")
     cmdArgGroup.add_argument("-c",  "--config",      dest="config",      action=CmdListAction, metavar="CFGNAME", nargs='?', help="retrieve or set the current configuration")
     cmdArgGroup.add_argument("-lm",  "--logmode",    dest="logmode",     action=CmdListAction, metavar="LOGMODE", nargs='?', help="retrieve or set the current log mode")
@@ -237,35 +369,23 @@ def main():
     else:
         verboseFunc = None
 
+    if (args.fleet is not None):
+        ports = args.fleet if len(args.fleet) > 0 else Chameleon.Device.listDevices()
+        if (len(ports) == 0):
+            print("No Chameleons found")
+            sys.exit(2)
+
+        if (not runFleet(ports, getattr(args, "cmdList", []), verboseFunc)):
+            sys.exit(2)
+        sys.exit(0)
+
     # Instantiate device object and connect
     chameleon = Chameleon.Device(verboseFunc)
 
     if (args.port):
         if (chameleon.connect(args.port)):
-            # Generate a jumptable and execute all commands in the order they are given on the command line
-            cmdFuncs = {
-                "setting"   : cmdSetting,
-                "info"      : cmdInfo,
-                "uid"       : cmdUID,
-                "getuid"    : cmdGetUID,
-                "identify"  : cmdIdentify,
-                "dumpmfu"   : cmdDumpMFU,
-                "config"    : cmdConfig,
-                "upload"    : cmdUpload,
-                "download"  : cmdDownload,
-                "log"       : cmdLog,
-                "logmode"   : cmdLogMode,
-                "lbutton"   : cmdLButton,
-		        "lbutton_long" : cmdLButtonLong,
-		        "rbutton_long" : cmdRButtonLong,
-                "rbutton"   : cmdRButton,
-                "gled"      : cmdGreenLED,
-                "rled"      : cmdRedLED,
-                "threshold" : cmdThreshold,
-                "upgrade"   : cmdUpgrade,
-                "clear"     : cmdClear,
-            }
 
+            # Execute all commands in the order they are given on the command line
             if hasattr(args, "cmdList"):
                 for (cmd, arg) in args.cmdList:
                     result = cmdFuncs[cmd](chameleon, arg)
@@ -0,0 +1,32 @@
+#!/usr/bin/env python3
+#
+# Builds the optional native log parser:
+#   python3 setup.py build_ext --inplace
+# Without it, Chameleon.LogParser falls back to pure Python.
+
+from setuptools import setup, Extension
+from setuptools.command.build_ext import build_ext
+
+class OptionalBuildExt(build_ext):
+    """Do not fail the installation when there is no C compiler around"""
+    def run(self):
+        try:
+            build_ext.run(self)
+        except Exception as e:
+            print("warning: native log parser not built, using pure Python ({})".format(e))
+
+    def build_extension(self, ext):
+        try:
+            build_ext.build_extension(self, ext)
+        except Exception as e:
+            print("warning: native log parser not built, using pure Python ({})".format(e))
+
+setup(
+    name="Chameleon",
+    description="Tools for the ChameleonMini",
+    packages=["Chameleon"],
+    scripts=["chamtool.py", "chamlog.py"],
+    install_requires=["pyserial", "crcmod"],
+    ext_modules=[Extension("Chameleon._logparser", sources=["Chameleon/logparser.c"])],
+    cmdclass={"build_ext": OptionalBuildExt},
+)